@@ -0,0 +1,21 @@
+########################################################################
+# Fails if the object file OBJECT defines a weak symbol, run with
+#   cmake -DNM=<nm> -DOBJECT=<object> -P CheckKernelSymbols.cmake
+# Inline functions and template instances are weak (W, V) or unique
+# (u) symbols, see the instruction set kernels in lib/CMakeLists.txt.
+########################################################################
+execute_process(
+    COMMAND ${NM} ${OBJECT}
+    OUTPUT_VARIABLE symbols
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${NM} failed on ${OBJECT}")
+endif(NOT result EQUAL 0)
+
+string(REGEX MATCHALL "[^\n]* [WVu] [^\n]*" weak "${symbols}")
+if(weak)
+    string(REPLACE ";" "\n" weak "${weak}")
+    message(FATAL_ERROR "${OBJECT} is built for another instruction set "
+        "and must not instantiate inline code, its weak symbols:\n${weak}")
+endif(weak)
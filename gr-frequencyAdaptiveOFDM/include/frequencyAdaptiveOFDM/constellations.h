@@ -34,6 +34,19 @@ namespace gr {
       typedef boost::shared_ptr<gr::frequencyAdaptiveOFDM::constellation_bpsk> sptr;
       static sptr make();
 
+      /*!
+       * \brief Max-log LLRs of n symbols.
+       *
+       * Writes one LLR per bit of decision_maker(), in the same order
+       * and positive if a 1 is more likely. The LLRs of a symbol are
+       * scaled with its entry of csi, the channel power over the noise
+       * variance of its carrier. csi may be NULL to weight all symbols
+       * the same. The 16QAM and 64QAM LLRs are computed in closed form
+       * per axis, so this is much cheaper than searching the points.
+       */
+      virtual void demap_soft(const gr_complex *symbols, const float *csi,
+                              float *llr, int n) = 0;
+
     protected:
       constellation_bpsk();
     };
@@ -44,6 +57,10 @@ namespace gr {
       typedef boost::shared_ptr<gr::frequencyAdaptiveOFDM::constellation_qpsk> sptr;
       static sptr make();
 
+      //! Max-log LLRs of n symbols, see constellation_bpsk::demap_soft()
+      virtual void demap_soft(const gr_complex *symbols, const float *csi,
+                              float *llr, int n) = 0;
+
     protected:
       constellation_qpsk();
     };
@@ -54,6 +71,10 @@ namespace gr {
       typedef boost::shared_ptr<gr::frequencyAdaptiveOFDM::constellation_16qam> sptr;
       static sptr make();
 
+      //! Max-log LLRs of n symbols, see constellation_bpsk::demap_soft()
+      virtual void demap_soft(const gr_complex *symbols, const float *csi,
+                              float *llr, int n) = 0;
+
     protected:
       constellation_16qam();
     };
@@ -64,6 +85,10 @@ namespace gr {
       typedef boost::shared_ptr<gr::frequencyAdaptiveOFDM::constellation_64qam> sptr;
       static sptr make();
 
+      //! Max-log LLRs of n symbols, see constellation_bpsk::demap_soft()
+      virtual void demap_soft(const gr_complex *symbols, const float *csi,
+                              float *llr, int n) = 0;
+
     protected:
       constellation_64qam();
     };
@@ -33,7 +33,20 @@ namespace gr {
     {
      public:
       typedef boost::shared_ptr<decode_mac> sptr;
-      static sptr make(bool log, bool debugbool, bool debug_rx_err);
+      /*!
+       * \param soft expect signed 8 bit LLRs from the frame equalizer
+       * (48 carriers with MAX_BITS_PER_CARRIER slots each) and decode them
+       * with the soft decision Viterbi decoder.
+       * \param batch_size maximum number of hard decision frames that are
+       * decoded together. Frames that are complete within one call of
+       * the scheduler and have the same puncturing and length run through
+       * the Viterbi decoder at once. 1 decodes every frame on its own.
+       * \param windows number of threads a long frame is decoded with when
+       * it is not batched. The trellis is split into windows that overlap
+       * by 96 bits. 1 decodes serially.
+       */
+      static sptr make(bool log, bool debugbool, bool debug_rx_err, bool soft = false,
+                       int batch_size = 32, int windows = 1);
     };
 
   } // namespace frequencyAdaptiveOFDM
@@ -0,0 +1,81 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016   Samuel Rey <samuel.rey.escudero@gmail.com>
+ *                  Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZE_AND_DECODE_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZE_AND_DECODE_H
+
+#include <frequencyAdaptiveOFDM/api.h>
+#include <frequencyAdaptiveOFDM/frame_equalizer.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    /*!
+     * \brief frame_equalizer and decode_mac in one block.
+     *
+     * Equalizes the OFDM symbols of a frame into a frame buffer and
+     * decodes the frame in place once its last symbol is in. The PDUs
+     * are the ones of decode_mac. frame_equalizer and decode_mac stay
+     * for debugging, i.e. to look at the symbols in between.
+     */
+    class FREQUENCYADAPTIVEOFDM_API equalize_and_decode : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<equalize_and_decode> sptr;
+      /*!
+       * \param soft decode the LLRs of the equalizer with the soft
+       * decision Viterbi decoder.
+       * \param windows number of threads a long frame is decoded with,
+       * see decode_mac.
+       * \param threads number of threads that receive frames in parallel,
+       * each one equalizes and decodes a complete frame. The PDUs still
+       * leave the block in the order the frames arrived. 0 receives the
+       * frames in the work function. Every thread keeps its own SNR
+       * statistics for the "snr" of the PDUs.
+       */
+      static sptr make(Equalizer algo, double freq, double bw, bool log,
+                        bool debug, bool debug_parity, bool debug_rx_err,
+                        bool soft = false, int windows = 1, int threads = 0);
+      virtual void set_algorithm(Equalizer algo) = 0;
+      virtual void set_bandwidth(double bw) = 0;
+      virtual void set_frequency(double freq) = 0;
+      /*!
+       * Smoothing of the STA equalizer: alpha weights the new channel
+       * estimate against the old one, beta is the number of neighbouring
+       * carriers on each side that are averaged.
+       */
+      virtual void set_sta_smoothing(double alpha, int beta) = 0;
+      /*!
+       * The "symbols" port publishes a snapshot of the equalized symbols
+       * every period data symbols instead of every symbol: a histogram
+       * and the EVM per resource block of every decimation-th symbol and
+       * a few of them as scatter points, see rb_const_demux. Nothing is
+       * collected while the port is not connected.
+       */
+      virtual void set_constellation_tap(int decimation, int period) = 0;
+    };
+
+  } // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZE_AND_DECODE_H */
@@ -40,11 +40,37 @@ namespace gr {
     {
      public:
       typedef boost::shared_ptr<frame_equalizer> sptr;
+      /*!
+       * \param delay_file CSV file with one line per OFDM symbol: the
+       * symbol of the frame, the ms since the last symbol and whether it
+       * starts a frame. Empty writes none.
+       * \param soft output one signed 8 bit LLR per coded bit (48 carriers
+       * with MAX_BITS_PER_CARRIER slots each) instead of the hard decided
+       * constellation indices, see decode_mac.
+       * \param trace_file file for the records of the frame tracer, the
+       * latency of every received frame through the stages of the
+       * receiver. Empty leaves the tracer to the GNU Radio config.
+       */
       static sptr make(Equalizer algo, double freq, double bw,
-                        bool log, bool debug, bool debug_parity, char* delay_file);
+                        bool log, bool debug, bool debug_parity, char* delay_file,
+                        bool soft = false, const char* trace_file = "");
       virtual void set_algorithm(Equalizer algo) = 0;
       virtual void set_bandwidth(double bw) = 0;
       virtual void set_frequency(double freq) = 0;
+      /*!
+       * Smoothing of the STA equalizer: alpha weights the new channel
+       * estimate against the old one, beta is the number of neighbouring
+       * carriers on each side that are averaged.
+       */
+      virtual void set_sta_smoothing(double alpha, int beta) = 0;
+      /*!
+       * The "symbols" port publishes a snapshot of the equalized symbols
+       * every period data symbols instead of every symbol: a histogram
+       * and the EVM per resource block of every decimation-th symbol and
+       * a few of them as scatter points, see rb_const_demux. Nothing is
+       * collected while the port is not connected.
+       */
+      virtual void set_constellation_tap(int decimation, int period) = 0;
     };
 
   } // namespace frequencyAdaptiveOFDM
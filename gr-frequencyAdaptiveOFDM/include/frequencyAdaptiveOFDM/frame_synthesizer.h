@@ -0,0 +1,52 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016   Samuel Rey <samuel.rey.escudero@gmail.com>
+ *                  Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_SYNTHESIZER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_SYNTHESIZER_H
+
+#include <frequencyAdaptiveOFDM/api.h>
+#include <gnuradio/block.h>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    /*!
+     * \brief Takes PDUs and emits the time domain baseband of the frames.
+     *
+     * Replaces the chain of mapper, packet header generator, chunks to
+     * symbols, tagged stream mux, carrier allocator, IFFT and cyclic
+     * prefixer of the TX hierarchy with one block and produces the same
+     * samples. Each frame starts with the packet_len, psdu_len, encoding
+     * and puncturing tags of the mapper, packet_len counts the samples.
+     */
+    class FREQUENCYADAPTIVEOFDM_API frame_synthesizer : virtual public gr::block
+    {
+     public:
+      typedef boost::shared_ptr<frame_synthesizer> sptr;
+      static sptr make(bool debug_enc, std::vector<int> pilots_enc, bool debug,
+                        char* tx_enc_f);
+    };
+
+  } // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_SYNTHESIZER_H */
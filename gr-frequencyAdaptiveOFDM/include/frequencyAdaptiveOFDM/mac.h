@@ -42,7 +42,9 @@ namespace gr {
                           bool debug,
                           char* tx_packets_f);
 
-        virtual void sendAck(uint8_t ra[], int *psdu_size) = 0;
+        virtual void sendBlockAck(uint8_t ra[], uint16_t ssn, uint64_t bitmap) = 0;
+        virtual void ackReceived() = 0;
+        virtual void blockAckReceived(uint8_t ta[], uint16_t ssn, uint64_t bitmap) = 0;
       };
 
   } // namespace frequencyAdaptiveOFDM
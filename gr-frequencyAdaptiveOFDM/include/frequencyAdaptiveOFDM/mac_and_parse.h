@@ -97,7 +97,10 @@ namespace gr {
       virtual unsigned long getTimestamp() = 0;
       //virtual void setAckReceived(bool received) = 0;
 
-      virtual void sendAck(uint8_t ra[], int *psdu_size) = 0;
+      virtual void sendBlockAck(uint8_t ra[], uint16_t ssn, uint64_t bitmap) = 0;
+      // ACKs for the data frames of mac
+      virtual void ackReceived() = 0;
+      virtual void blockAckReceived(uint8_t ta[], uint16_t ssn, uint64_t bitmap) = 0;
       virtual void decrease_encoding() = 0;
 
       bool check_mac(std::vector<uint8_t> mac);
@@ -48,8 +48,17 @@ namespace gr {
     {
      public:
       typedef boost::shared_ptr<mapper> sptr;
+      /*!
+       * \param packed_bits scramble, encode and puncture the frame on
+       * 64 bit words instead of one bit per byte. The output is the same.
+       * \param workers number of threads that encode the queued PDUs ahead
+       * of the output. Up to two frames per worker are kept ready and
+       * leave the block in the order the PDUs arrived. 0 encodes each PDU
+       * in the scheduler thread when the previous frame is out.
+       */
       static sptr make(bool debug_enc, std::vector<int> pilots_enc, bool debug,
-                        bool log, char* tx_enc_f);
+                        bool log, char* tx_enc_f, bool packed_bits = true,
+                        int workers = 0);
     };
 
   } // namespace frequencyAdaptiveOFDM
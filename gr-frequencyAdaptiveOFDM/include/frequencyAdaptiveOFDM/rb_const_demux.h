@@ -29,8 +29,11 @@ namespace gr {
   namespace frequencyAdaptiveOFDM {
 
     /*
-     *  Take an OFDM frame and separate the symbols from the
-     *  different resource blocks.
+     *  Take a snapshot of the constellation tap of frame_equalizer or
+     *  equalize_and_decode and separate it into the resource blocks.
+     *  rb1 to rb4 get a PDU with the scatter points of the resource
+     *  block and a dict with its "evm", "histogram" and the number of
+     *  "symbols" in the snapshot.
      */
     class FREQUENCYADAPTIVEOFDM_API rb_const_demux : virtual public gr::block
     {
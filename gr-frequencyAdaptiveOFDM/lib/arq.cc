@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "arq.h"
+#include "counters.h"
+#include <boost/bind.hpp>
+#include <stdexcept>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+namespace {
+
+inline uint16_t
+seq_add(uint16_t seq, int n) {
+	return (seq + n) & (SEQ_MODULO - 1);
+}
+
+// how far b is ahead of a
+inline int
+seq_diff(uint16_t b, uint16_t a) {
+	return (b - a) & (SEQ_MODULO - 1);
+}
+
+// b is behind a
+inline bool
+seq_before(uint16_t b, uint16_t a) {
+	return seq_diff(b, a) >= SEQ_MODULO / 2;
+}
+
+} // namespace
+
+const int arq_sender::TICK;
+const int arq_sender::WHEEL_SLOTS;
+
+arq_sender::arq_sender(int window, int timeout, int retries, send_fn send, bar_fn bar) :
+	d_window(window),
+	d_timeout((timeout + TICK - 1) / TICK),
+	d_retries(retries),
+	d_send(send),
+	d_bar(bar),
+	d_base(ARQ_FIRST_SEQ),
+	d_next(ARQ_FIRST_SEQ),
+	d_generation(0),
+	d_now(0),
+	d_stop(false) {
+
+	if(window < 1 || window > ARQ_MAX_WINDOW) {
+		throw std::invalid_argument("ARQ: window has to be between 1 and 64");
+	}
+	if(timeout <= 0 || retries < 0) {
+		throw std::invalid_argument("ARQ: timeout has to be positive and retries not negative");
+	}
+
+	for(int i = 0; i < ARQ_MAX_WINDOW; i++) {
+		d_frames[i].done = true;
+		d_frames[i].retries = 0;
+		d_frames[i].generation = 0;
+	}
+	d_thread = new boost::thread(boost::bind(&arq_sender::run, this));
+}
+
+arq_sender::~arq_sender() {
+	{
+		gr::thread::scoped_lock lock(d_mutex);
+		d_stop = true;
+	}
+	d_window_cond.notify_all();
+	d_timer_cond.notify_one();
+	d_thread->join();
+	delete d_thread;
+}
+
+bool
+arq_sender::submit(const char *msdu, int size) {
+	std::vector<char> data(msdu, msdu + size);
+	uint16_t seq;
+	{
+		gr::thread::scoped_lock lock(d_mutex);
+		while(!d_stop && in_flight() >= d_window) {
+			d_window_cond.wait(lock);
+		}
+		if(d_stop) {
+			return false;
+		}
+
+		seq = d_next;
+		frame &f = d_frames[seq % ARQ_MAX_WINDOW];
+		f.done = false;
+		f.retries = 0;
+		f.msdu = data;
+		d_next = seq_add(d_next, 1);
+		arm(seq);
+	}
+	d_send(seq, false, data);
+	return true;
+}
+
+void
+arq_sender::ack() {
+	gr::thread::scoped_lock lock(d_mutex);
+	// with more frames outstanding the ACK might be for a later one and
+	// an earlier one would never be sent again
+	if(in_flight() != 1) {
+		return;
+	}
+	done(d_base);
+	advance();
+}
+
+void
+arq_sender::block_ack(uint16_t ssn, uint64_t bitmap) {
+	gr::thread::scoped_lock lock(d_mutex);
+	int n = in_flight();
+	for(int i = 0; i < n; i++) {
+		uint16_t seq = seq_add(d_base, i);
+		int bit = seq_diff(seq, ssn);
+		// the receiver moved its window past the frame
+		if(seq_before(seq, ssn)) {
+			done(seq);
+		} else if(bit < 64 && ((bitmap >> bit) & 1)) {
+			done(seq);
+		}
+	}
+	advance();
+}
+
+int
+arq_sender::outstanding() {
+	gr::thread::scoped_lock lock(d_mutex);
+	return in_flight();
+}
+
+int
+arq_sender::in_flight() const {
+	return seq_diff(d_next, d_base);
+}
+
+bool
+arq_sender::is_outstanding(uint16_t seq) const {
+	return seq_diff(seq, d_base) < in_flight();
+}
+
+void
+arq_sender::arm(uint16_t seq) {
+	frame &f = d_frames[seq % ARQ_MAX_WINDOW];
+	// timers of an earlier transmission no longer match
+	f.generation = ++d_generation;
+	timer t = {seq, f.generation, d_now + d_timeout};
+	d_wheel[t.expires % WHEEL_SLOTS].push_back(t);
+}
+
+void
+arq_sender::done(uint16_t seq) {
+	frame &f = d_frames[seq % ARQ_MAX_WINDOW];
+	f.done = true;
+	f.msdu.clear();
+}
+
+void
+arq_sender::advance() {
+	bool moved = false;
+	while(in_flight() && d_frames[d_base % ARQ_MAX_WINDOW].done) {
+		d_base = seq_add(d_base, 1);
+		moved = true;
+	}
+	if(moved) {
+		d_window_cond.notify_all();
+	}
+}
+
+bool
+arq_sender::tick(std::vector<resend> &resends) {
+	d_now++;
+	bool dropped = false;
+
+	std::vector<timer> expired;
+	expired.swap(d_wheel[d_now % WHEEL_SLOTS]);
+	for(size_t i = 0; i < expired.size(); i++) {
+		const timer &t = expired[i];
+		// a lap of the wheel or more to go
+		if(t.expires > d_now) {
+			d_wheel[d_now % WHEEL_SLOTS].push_back(t);
+			continue;
+		}
+		frame &f = d_frames[t.seq % ARQ_MAX_WINDOW];
+		if(!is_outstanding(t.seq) || f.done || f.generation != t.generation) {
+			continue;
+		}
+		if(f.retries < d_retries) {
+			f.retries++;
+			arm(t.seq);
+			resend r = {t.seq, f.msdu};
+			resends.push_back(r);
+			counters::instance().add(counters::TX_RETRIES);
+		} else {
+			done(t.seq);
+			dropped = true;
+			counters::instance().add(counters::TX_DROPPED);
+		}
+	}
+	advance();
+	return dropped;
+}
+
+void
+arq_sender::run() {
+	gr::thread::scoped_lock lock(d_mutex);
+	boost::system_time next = boost::get_system_time();
+
+	while(!d_stop) {
+		next += boost::posix_time::microseconds(TICK);
+		while(!d_stop && boost::get_system_time() < next) {
+			d_timer_cond.timed_wait(lock, next);
+		}
+		if(d_stop) {
+			break;
+		}
+
+		std::vector<resend> resends;
+		bool dropped = tick(resends);
+		if(resends.empty() && !dropped) {
+			continue;
+		}
+		uint16_t ssn = d_base;
+
+		lock.unlock();
+		for(size_t i = 0; i < resends.size(); i++) {
+			d_send(resends[i].seq, true, resends[i].msdu);
+		}
+		if(dropped) {
+			d_bar(ssn);
+		}
+		lock.lock();
+	}
+}
+
+reorder_buffer::reorder_buffer(int window) :
+	d_window(window),
+	d_started(false),
+	d_start(ARQ_FIRST_SEQ) {
+
+	if(window < 1 || window > ARQ_MAX_WINDOW) {
+		throw std::invalid_argument("ARQ: window has to be between 1 and 64");
+	}
+	for(int i = 0; i < ARQ_MAX_WINDOW; i++) {
+		d_present[i] = false;
+	}
+}
+
+bool
+reorder_buffer::receive(uint16_t seq, bool retry, const char *data, int size,
+		std::vector<std::vector<char> > &out) {
+	if(!d_started) {
+		d_started = true;
+		if(seq_diff(seq, d_start) >= d_window) {
+			d_start = seq;
+		}
+	}
+
+	if(seq_before(seq, d_start)) {
+		if(retry) {
+			return false;
+		}
+		// hand on what is left of the old sequence and start over
+		for(int i = 0; i < d_window; i++) {
+			step(out);
+		}
+		d_start = seq;
+	} else if(seq_diff(seq, d_start) >= d_window) {
+		release(seq_add(seq, 1 - d_window), out);
+	}
+
+	int slot = seq % ARQ_MAX_WINDOW;
+	if(d_present[slot]) {
+		return false;
+	}
+	d_present[slot] = true;
+	d_frames[slot].assign(data, data + size);
+
+	while(d_present[d_start % ARQ_MAX_WINDOW]) {
+		step(out);
+	}
+	return true;
+}
+
+void
+reorder_buffer::release(uint16_t ssn, std::vector<std::vector<char> > &out) {
+	if(!d_started) {
+		d_started = true;
+		d_start = ssn;
+		return;
+	}
+	if(seq_before(ssn, d_start)) {
+		return;
+	}
+
+	// beyond the window there is nothing buffered
+	int n = seq_diff(ssn, d_start);
+	for(int i = 0; i < n && i < d_window; i++) {
+		step(out);
+	}
+	d_start = ssn;
+
+	while(d_present[d_start % ARQ_MAX_WINDOW]) {
+		step(out);
+	}
+}
+
+uint64_t
+reorder_buffer::bitmap() const {
+	uint64_t bits = 0;
+	for(int i = 0; i < d_window; i++) {
+		if(d_present[seq_add(d_start, i) % ARQ_MAX_WINDOW]) {
+			bits |= uint64_t(1) << i;
+		}
+	}
+	return bits;
+}
+
+void
+reorder_buffer::step(std::vector<std::vector<char> > &out) {
+	int slot = d_start % ARQ_MAX_WINDOW;
+	if(d_present[slot]) {
+		out.push_back(std::vector<char>());
+		out.back().swap(d_frames[slot]);
+		d_present[slot] = false;
+	}
+	d_start = seq_add(d_start, 1);
+}
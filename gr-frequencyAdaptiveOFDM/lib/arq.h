@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_ARQ_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_ARQ_H
+
+#include <gnuradio/thread/thread.h>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <stdint.h>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+// 12 bit sequence numbers of the MAC header
+static const int SEQ_MODULO = 4096;
+// frames a Block ACK bitmap covers
+static const int ARQ_MAX_WINDOW = 64;
+// sequence number of the first frame of a sender
+static const uint16_t ARQ_FIRST_SEQ = 0;
+
+/* Selective repeat ARQ of the sending side.
+ *
+ * submit() gives the MSDU the next sequence number, sends it and arms
+ * its timeout. Up to window frames are outstanding, submit() blocks
+ * while the window is full. A timer wheel with slots of TICK us, run by
+ * a thread of its own, sends a frame again when its timeout expires, at
+ * most retries times. Then the frame is given up and a Block ACK
+ * Request moves the window of the receiver past it.
+ *
+ * block_ack() takes the starting sequence number and the bitmap of a
+ * Block ACK, every frame before the starting sequence number is done as
+ * well. ack() takes a plain ACK, which carries no sequence number, as
+ * the ACK of the only outstanding frame. It is ignored while more than
+ * one frame is outstanding, the Block ACK tells which ones arrived.
+ *
+ * The callbacks are called without the lock held, from the thread of
+ * submit() or from the timer thread. Retransmissions and frames given
+ * up are counted as TX_RETRIES and TX_DROPPED.
+ */
+class arq_sender
+{
+public:
+	// sequence number, retry, MSDU
+	typedef boost::function<void (uint16_t, bool, const std::vector<char> &)> send_fn;
+	// starting sequence number of the Block ACK Request
+	typedef boost::function<void (uint16_t)> bar_fn;
+
+	// timeout in us
+	arq_sender(int window, int timeout, int retries, send_fn send, bar_fn bar);
+	~arq_sender();
+
+	// returns false if the sender stopped while waiting for the window
+	bool submit(const char *msdu, int size);
+	void ack();
+	void block_ack(uint16_t ssn, uint64_t bitmap);
+
+	// frames that are neither acknowledged nor given up
+	int outstanding();
+
+	// us per slot of the timer wheel
+	static const int TICK = 1000;
+	static const int WHEEL_SLOTS = 256;
+
+private:
+	struct frame {
+		bool done;
+		int retries;
+		uint32_t generation;
+		std::vector<char> msdu;
+	};
+
+	struct timer {
+		uint16_t seq;
+		uint32_t generation;
+		uint64_t expires;  // tick
+	};
+
+	struct resend {
+		uint16_t seq;
+		std::vector<char> msdu;
+	};
+
+	int d_window;
+	uint64_t d_timeout;  // ticks
+	int d_retries;
+	send_fn d_send;
+	bar_fn d_bar;
+
+	// d_mutex protects everything below
+	gr::thread::mutex d_mutex;
+	gr::thread::condition_variable d_window_cond;
+	gr::thread::condition_variable d_timer_cond;
+	frame d_frames[ARQ_MAX_WINDOW];  // by sequence number
+	uint16_t d_base;  // oldest outstanding
+	uint16_t d_next;
+	uint32_t d_generation;
+	std::vector<timer> d_wheel[WHEEL_SLOTS];
+	uint64_t d_now;  // tick
+	bool d_stop;
+	boost::thread *d_thread;
+
+	int in_flight() const;
+	bool is_outstanding(uint16_t seq) const;
+	void arm(uint16_t seq);
+	void done(uint16_t seq);
+	void advance();
+	// returns true if frames were given up
+	bool tick(std::vector<resend> &resends);
+	void run();
+};
+
+/* Receive window of one source. Frames are handed on in the order of
+ * their sequence numbers, a frame waits for the missing ones before it
+ * until a frame window or more ahead arrives or a Block ACK Request
+ * releases it. ssn() and bitmap() are what a Block ACK reports.
+ *
+ * The window starts at ARQ_FIRST_SEQ, so the first frames of a sender
+ * wait for a lost frame 0 like any other. If the first frame received is
+ * a window or more away from it, the sender was running before and the
+ * window starts at that frame.
+ */
+class reorder_buffer
+{
+public:
+	reorder_buffer(int window = ARQ_MAX_WINDOW);
+
+	// appends the frames that are in order now to out, returns false
+	// for a frame that was received before. A first transmission (no
+	// retry) behind the window means the sender started again.
+	bool receive(uint16_t seq, bool retry, const char *data, int size,
+			std::vector<std::vector<char> > &out);
+	// Block ACK Request, hands on every frame before ssn
+	void release(uint16_t ssn, std::vector<std::vector<char> > &out);
+
+	uint16_t ssn() const { return d_start; }
+	// bit i is set if frame ssn() + i was received
+	uint64_t bitmap() const;
+
+private:
+	int d_window;
+	bool d_started;
+	uint16_t d_start;
+	bool d_present[ARQ_MAX_WINDOW];
+	std::vector<char> d_frames[ARQ_MAX_WINDOW];
+
+	void step(std::vector<std::vector<char> > &out);
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_ARQ_H */
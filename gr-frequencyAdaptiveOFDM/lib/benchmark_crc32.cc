@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the CRC-32 of boost with slicing-by-8 and the PCLMULQDQ
+ * kernel for the frame sizes of the MAC, then the bit wise descrambler
+ * followed by boost with the fused descrambler of decode_mac.
+ *
+ * usage: benchmark-crc32 [iterations]
+ */
+#include "utils.h"
+#include "crc32.h"
+
+#include <boost/crc.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+static double
+now_us() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// keeps the compiler from dropping the loops
+static volatile uint32_t sink;
+
+static void
+run_crc(const uint8_t *data, int len, int iterations) {
+	double start = now_us();
+	for(int i = 0; i < iterations; i++) {
+		boost::crc_32_type result;
+		result.process_bytes(data, len);
+		sink = result.checksum();
+	}
+	double boost_us = (now_us() - start) / iterations;
+
+	start = now_us();
+	for(int i = 0; i < iterations; i++) {
+		sink = ~crc32_slicing8(0xffffffff, data, len);
+	}
+	double slicing_us = (now_us() - start) / iterations;
+
+	std::printf("%4d bytes  boost %7.3f us  slicing-by-8 %7.3f us (%5.1fx)",
+			len, boost_us, slicing_us, boost_us / slicing_us);
+
+	if(crc32_has_pclmul()) {
+		start = now_us();
+		for(int i = 0; i < iterations; i++) {
+			sink = crc32(data, len);
+		}
+		double pclmul_us = (now_us() - start) / iterations;
+		std::printf("  pclmul %7.3f us (%5.1fx)", pclmul_us, boost_us / pclmul_us);
+	}
+	std::printf("\n");
+}
+
+static void
+run_descramble(int psdu_size, int iterations) {
+	std::vector<int> encoding(4, QAM64);
+	ofdm_param ofdm(encoding, P_3_4);
+	frame_param frame(ofdm, psdu_size);
+
+	static char psdu[MAX_PSDU_SIZE];
+	static char data_bits[MAX_ENCODED_BITS];
+	static char scrambled[MAX_ENCODED_BITS];
+	static uint8_t out_bytes[MAX_PSDU_SIZE + 2];
+
+	for(int i = 0; i < psdu_size - 4; i++) {
+		psdu[i] = std::rand();
+	}
+	uint32_t fcs = crc32((uint8_t *) psdu, psdu_size - 4);
+	std::memcpy(psdu + psdu_size - 4, &fcs, 4);
+	std::memset(data_bits, 0, frame.n_data_bits);
+	generate_bits(psdu, data_bits, frame);
+	scramble(data_bits, scrambled, frame, 93);
+	const uint8_t *decoded = (const uint8_t *) scrambled;
+
+	// the bit wise descrambler of decode_mac and boost
+	bool ok = true;
+	double start = now_us();
+	for(int k = 0; k < iterations; k++) {
+		int state = 0;
+		std::memset(out_bytes, 0, psdu_size + 2);
+		for(int i = 0; i < 7; i++) {
+			if(decoded[i]) {
+				state |= 1 << (6 - i);
+			}
+		}
+		out_bytes[0] = state;
+		for(int i = 7; i < psdu_size * 8 + 16; i++) {
+			int feedback = (!!(state & 64)) ^ (!!(state & 8));
+			out_bytes[i / 8] |= (feedback ^ (decoded[i] & 1)) << (i % 8);
+			state = ((state << 1) & 0x7e) | feedback;
+		}
+		boost::crc_32_type result;
+		result.process_bytes(out_bytes + 2, psdu_size);
+		ok &= result.checksum() == CRC32_RESIDUE;
+	}
+	double bitwise_us = (now_us() - start) / iterations;
+
+	start = now_us();
+	for(int k = 0; k < iterations; k++) {
+		ok &= descramble_crc(decoded, out_bytes, frame) == CRC32_RESIDUE;
+	}
+	double fused_us = (now_us() - start) / iterations;
+
+	std::printf("%4d bytes  bit wise + boost %7.2f us  fused %7.2f us (%5.1fx)  %s\n",
+			psdu_size, bitwise_us, fused_us, bitwise_us / fused_us,
+			ok ? "ok" : "CRC MISMATCH");
+}
+
+int
+main(int argc, char **argv) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+	static uint8_t data[MAX_PSDU_SIZE];
+	for(int i = 0; i < MAX_PSDU_SIZE; i++) {
+		data[i] = std::rand();
+	}
+
+	// ACK, short data frame and the largest PSDU
+	const int sizes[] = { 10, 64, 256, MAX_PSDU_SIZE };
+	for(int i = 0; i < 4; i++) {
+		run_crc(data, sizes[i], iterations);
+	}
+	std::printf("\n");
+	for(int i = 1; i < 4; i++) {
+		run_descramble(sizes[i], iterations / 4);
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * Compares the max-log LLRs of a nearest point search over the points of
+ * the constellation blocks with the closed form of demap_soft() for one
+ * OFDM symbol of 48 data carriers, in symbols per second on one core.
+ *
+ * usage: benchmark-demapper [iterations]
+ */
+#include "constellations_impl.h"
+#include "demapper.h"
+#include "utils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+static double
+now_us() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// keeps the compiler from dropping the loops
+static volatile float sink;
+
+// for every bit the closest point with a 0 and the closest with a 1
+static void
+demap_search(const std::vector<gr_complex> &points, int bits,
+		const gr_complex *symbols, const float *csi, float *llr, int n) {
+	for(int i = 0; i < n; i++) {
+		for(int b = 0; b < bits; b++) {
+			float d[2] = { 1e30f, 1e30f };
+			for(size_t p = 0; p < points.size(); p++) {
+				float dist = std::norm(symbols[i] - points[p]);
+				int bit = (p >> b) & 1;
+				d[bit] = std::min(d[bit], dist);
+			}
+			*llr++ = (d[0] - d[1]) * csi[i];
+		}
+	}
+}
+
+template<class C> static void
+run(const char *name, boost::shared_ptr<C> constellation, int encoding,
+		int iterations) {
+	const int n = 48;
+	const int bits = demap_bits(encoding);
+	const std::vector<gr_complex> points = constellation->points();
+
+	gr_complex symbols[n];
+	float csi[n];
+	for(int i = 0; i < n; i++) {
+		float noise_re = (std::rand() / float(RAND_MAX) - 0.5f) * 0.3f;
+		float noise_im = (std::rand() / float(RAND_MAX) - 0.5f) * 0.3f;
+		symbols[i] = points[std::rand() % points.size()] + gr_complex(noise_re, noise_im);
+		csi[i] = 10 + std::rand() % 90;
+	}
+
+	float search_llr[n * 6];
+	float closed_llr[n * 6];
+
+	double start = now_us();
+	for(int k = 0; k < iterations; k++) {
+		demap_search(points, bits, symbols, csi, search_llr, n);
+		sink = search_llr[k % (n * bits)];
+	}
+	double search_us = (now_us() - start) / iterations;
+
+	start = now_us();
+	for(int k = 0; k < iterations; k++) {
+		constellation->demap_soft(symbols, csi, closed_llr, n);
+		sink = closed_llr[k % (n * bits)];
+	}
+	double closed_us = (now_us() - start) / iterations;
+
+	bool ok = true;
+	for(int i = 0; i < n * bits; i++) {
+		float tolerance = 1e-3f * (1 + std::abs(search_llr[i]));
+		ok &= std::abs(search_llr[i] - closed_llr[i]) < tolerance;
+	}
+
+	std::printf("%-6s  search %8.2f Msym/s  closed form %8.2f Msym/s (%5.1fx)  %s\n",
+			name, n / search_us, n / closed_us, search_us / closed_us,
+			ok ? "ok" : "MISMATCH");
+}
+
+int
+main(int argc, char **argv) {
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+	run("BPSK", constellation_bpsk::make(), BPSK, iterations);
+	run("QPSK", constellation_qpsk::make(), QPSK, iterations);
+	run("16QAM", constellation_16qam::make(), QAM16, iterations / 4);
+	run("64QAM", constellation_64qam::make(), QAM64, iterations / 16);
+	return 0;
+}
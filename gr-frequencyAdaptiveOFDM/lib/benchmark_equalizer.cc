@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measures the nanoseconds per data symbol of the four equalizers for
+ * frames with one modulation and with a mix of modulations over the
+ * resource blocks. The reference divides each carrier by the LS channel
+ * estimate and calls decision_maker() of the constellation for it, like
+ * the equalizers did before; its decisions are compared with LS.
+ *
+ * usage: benchmark-equalizer [symbols]
+ */
+#include "utils.h"
+#include "equalizer/base.h"
+#include "equalizer/comb.h"
+#include "equalizer/lms.h"
+#include "equalizer/ls.h"
+#include "equalizer/sta.h"
+#include <frequencyAdaptiveOFDM/constellations.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+static double
+now_us() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// keeps the compiler from dropping the loops
+static volatile uint8_t sink;
+
+static float
+gauss() {
+	float u = (std::rand() + 1.0f) / (RAND_MAX + 2.0f);
+	float v = std::rand() / (RAND_MAX + 1.0f);
+	return std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * v);
+}
+
+// two long training symbols and then data symbols through a frequency
+// selective channel with some noise
+static void
+make_frame(std::vector<gr_complex> &frame, int n_sym) {
+	gr_complex h[64];
+	for(int k = 0; k < 64; k++) {
+		h[k] = gr_complex(1 + 0.3f * gauss(), 0.3f * gauss());
+	}
+	frame.resize(64 * n_sym);
+	for(int s = 0; s < n_sym; s++) {
+		for(int k = 0; k < 64; k++) {
+			gr_complex x = equalizer::base::LONG[k];
+			if(s >= 2) {
+				x = gr_complex((std::rand() % 8 - 3.5f) / 5, (std::rand() % 8 - 3.5f) / 5);
+			}
+			if(s >= 2 && (k == 11 || k == 25 || k == 39 || k == 53)) {
+				x = equalizer::base::POLARITY[(s - 2) % 127];
+			}
+			frame[64 * s + k] = x * h[k] + gr_complex(gauss(), gauss()) * 0.02f;
+		}
+	}
+}
+
+// division by H and a virtual decision_maker() call per carrier
+static double
+run_reference(const std::vector<gr_complex> &frame, const std::vector<int> &encoding,
+		std::vector<uint8_t> &bits) {
+	gr::digital::constellation_sptr mod[4];
+	for(int r = 0; r < 4; r++) {
+		switch(encoding[r]) {
+		case BPSK:  mod[r] = constellation_bpsk::make(); break;
+		case QPSK:  mod[r] = constellation_qpsk::make(); break;
+		case QAM16: mod[r] = constellation_16qam::make(); break;
+		default:    mod[r] = constellation_64qam::make(); break;
+		}
+	}
+
+	gr_complex H[64];
+	for(int i = 0; i < 64; i++) {
+		if(equalizer::base::LONG[i] != gr_complex(0, 0)) {
+			H[i] = (frame[i] + frame[64 + i]) / (equalizer::base::LONG[i] * gr_complex(2, 0));
+		}
+	}
+
+	int n_sym = frame.size() / 64;
+	bits.resize(48 * n_sym);
+	double start = now_us();
+	for(int s = 2; s < n_sym; s++) {
+		const gr_complex *in = &frame[64 * s];
+		for(int c = 0; c < 48; c++) {
+			int i = equalizer::base::DATA_CARRIERS[c];
+			gr_complex symbol = in[i] / H[i];
+			bits[48 * s + c] = mod[c / 12]->decision_maker(&symbol);
+		}
+	}
+	return (now_us() - start) * 1000 / (n_sym - 2);
+}
+
+static double
+run_equalizer(equalizer::base *eq, const std::vector<gr_complex> &frame,
+		const std::vector<int> &encoding, std::vector<uint8_t> &bits) {
+	// the equalizers work in place on the training symbols
+	std::vector<gr_complex> in(frame);
+	int n_sym = frame.size() / 64;
+	gr_complex symbols[48];
+	bits.resize(48 * n_sym);
+
+	eq->set_encoding(encoding);
+	eq->new_frame();
+	eq->equalize(&in[0], 0, symbols, &bits[0]);
+	eq->equalize(&in[64], 1, symbols, &bits[48]);
+	// the data symbols update the SNR statistics like in a valid frame
+	eq->accept_frame();
+
+	double start = now_us();
+	for(int s = 2; s < n_sym; s++) {
+		eq->equalize(&in[64 * s], s, symbols, &bits[48 * s]);
+	}
+	double ns = (now_us() - start) * 1000 / (n_sym - 2);
+	sink = bits[48 * (n_sym - 1)];
+	return ns;
+}
+
+int
+main(int argc, char **argv) {
+	int n_sym = 100000;
+	if(argc > 1) {
+		n_sym = std::atoi(argv[1]);
+	}
+	if(n_sym < 3) {
+		std::fprintf(stderr, "usage: %s [symbols > 2]\n", argv[0]);
+		return 1;
+	}
+
+	std::srand(42);
+	std::vector<gr_complex> frame;
+	make_frame(frame, n_sym);
+
+	const char *names[] = { "BPSK", "QPSK", "16QAM", "64QAM", "mixed" };
+	const int encodings[][4] = {
+		{ BPSK, BPSK, BPSK, BPSK },
+		{ QPSK, QPSK, QPSK, QPSK },
+		{ QAM16, QAM16, QAM16, QAM16 },
+		{ QAM64, QAM64, QAM64, QAM64 },
+		{ QAM16, BPSK, QAM64, QPSK },
+	};
+
+	equalizer::ls ls;
+	equalizer::lms lms;
+	equalizer::sta sta;
+	equalizer::comb comb;
+
+	std::printf("ns per data symbol, %d symbols\n", n_sym - 2);
+	for(int e = 0; e < 5; e++) {
+		std::vector<int> encoding(encodings[e], encodings[e] + 4);
+		std::vector<uint8_t> ref_bits, bits;
+
+		double ref_ns = run_reference(frame, encoding, ref_bits);
+		double ls_ns = run_equalizer(&ls, frame, encoding, bits);
+		bool same = std::memcmp(&ref_bits[96], &bits[96], ref_bits.size() - 96) == 0;
+
+		std::printf("%-5s  reference %6.0f  LS %6.0f (%5.1fx)  LMS %6.0f  STA %6.0f  COMB %6.0f  %s\n",
+				names[e], ref_ns, ls_ns, ref_ns / ls_ns,
+				run_equalizer(&lms, frame, encoding, bits),
+				run_equalizer(&sta, frame, encoding, bits),
+				run_equalizer(&comb, frame, encoding, bits),
+				same ? "ok" : "MISMATCH");
+	}
+	return 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Decodes a 1500 byte 64QAM 3/4 frame with every Viterbi kernel the CPU
+ * supports and prints the time per frame and the decoded throughput.
+ * Then compares the frame rate of the single and the batch decoder for a
+ * burst of short and long frames.
+ * Last, decodes a long BPSK 1/2 frame in parallel windows and prints the
+ * latency for each number of windows and the bit errors for each overlap.
+ *
+ * usage: benchmark-viterbi-decoder [frames]
+ */
+#include "utils.h"
+#include "viterbi_decoder/viterbi_decoder.h"
+#include "viterbi_decoder/viterbi_decoder_soft.h"
+#include "viterbi_decoder/viterbi_decoder_batch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+static double
+now_us() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static void
+run(const char *name, base &decoder, ofdm_param &ofdm, frame_param &frame,
+		uint8_t *in, const uint8_t *ref, int frames) {
+
+	const base::isa_t isas[] = { base::ISA_GENERIC, base::ISA_SSE2,
+			base::ISA_AVX2, base::ISA_AVX512BW };
+
+	for(int k = 0; k < 4; k++) {
+		if(!decoder.set_isa(isas[k])) {
+			continue;
+		}
+
+		bool match = !std::memcmp(decoder.decode(&ofdm, &frame, in), ref,
+				frame.n_data_bits - frame.n_pad);
+
+		double start = now_us();
+		for(int i = 0; i < frames; i++) {
+			decoder.decode(&ofdm, &frame, in);
+		}
+		double us = (now_us() - start) / frames;
+
+		std::printf("%-5s %-9s %8.1f us/frame %8.1f Mbit/s  %s\n",
+				name, base::isa_name(isas[k]), us,
+				frame.n_data_bits / us, match ? "ok" : "MISMATCH");
+	}
+}
+
+static void
+run_batch(int psdu_size, int frames) {
+	const int n = viterbi_decoder_batch::MAX_BATCH;
+
+	std::vector<int> encoding(4, QAM64);
+	ofdm_param ofdm(encoding, P_3_4);
+	frame_param frame(ofdm, psdu_size);
+
+	static char data_bits[MAX_ENCODED_BITS];
+	static char encoded[2 * MAX_ENCODED_BITS];
+	static char punctured[n][MAX_ENCODED_BITS];
+	uint8_t *in[n];
+
+	for(int f = 0; f < n; f++) {
+		for(int i = 0; i < frame.n_data_bits; i++) {
+			data_bits[i] = std::rand() & 1;
+		}
+		reset_tail_bits(data_bits, frame);
+		convolutional_encoding(data_bits, encoded, frame);
+		puncturing(encoded, punctured[f], frame, ofdm);
+		in[f] = (uint8_t *) punctured[f];
+	}
+
+	static viterbi_decoder single;
+	double start = now_us();
+	for(int i = 0; i < frames; i += n) {
+		for(int f = 0; f < n; f++) {
+			single.decode(&ofdm, &frame, in[f]);
+		}
+	}
+	double us = (now_us() - start) / frames;
+	std::printf("%4d byte frames, single %-9s %8.2f us/frame %10.0f frames/s\n",
+			psdu_size, base::isa_name(single.isa()), us, 1e6 / us);
+
+	static viterbi_decoder_batch batch;
+	const base::isa_t isas[] = { base::ISA_GENERIC, base::ISA_SSE2,
+			base::ISA_AVX2, base::ISA_AVX512BW };
+
+	for(int k = 0; k < 4; k++) {
+		if(!batch.set_isa(isas[k])) {
+			continue;
+		}
+
+		start = now_us();
+		for(int i = 0; i < frames; i += n) {
+			batch.decode(&ofdm, &frame, in, n);
+		}
+		us = (now_us() - start) / frames;
+		std::printf("%4d byte frames, batch  %-9s %8.2f us/frame %10.0f frames/s\n",
+				psdu_size, base::isa_name(isas[k]), us, 1e6 / us);
+	}
+}
+
+static void
+run_windows(int frames) {
+	std::vector<int> encoding(4, BPSK);
+	ofdm_param ofdm(encoding, P_1_2);
+	frame_param frame(ofdm, 1528);
+
+	static char data_bits[MAX_ENCODED_BITS];
+	static char encoded[2 * MAX_ENCODED_BITS];
+	static char punctured[MAX_ENCODED_BITS];
+	static uint8_t soft_bits[MAX_ENCODED_BITS];
+
+	for(int i = 0; i < frame.n_data_bits; i++) {
+		data_bits[i] = std::rand() & 1;
+	}
+	reset_tail_bits(data_bits, frame);
+	convolutional_encoding(data_bits, encoded, frame);
+	puncturing(encoded, punctured, frame, ofdm);
+
+	for(int i = 0; i < frame.n_encoded_bits; i++) {
+		int8_t llr = std::rand() % 128 - 20;
+		soft_bits[i] = punctured[i] ? llr : -llr;
+	}
+
+	int n_bits = frame.n_data_bits - frame.n_pad;
+	std::printf("\n1528 byte frame, BPSK 1/2, %d data bits, %d frames\n",
+			frame.n_data_bits, frames);
+
+	static viterbi_decoder_soft soft;
+	std::vector<uint8_t> serial(n_bits);
+	soft.set_windows(1);
+	std::memcpy(&serial[0], soft.decode(&ofdm, &frame, soft_bits), n_bits);
+
+	int serial_errors = 0;
+	for(int i = 0; i < n_bits; i++) {
+		serial_errors += serial[i] != data_bits[i];
+	}
+
+	const int windows[] = { 1, 2, 3, 4, 6, 8 };
+	for(int k = 0; k < 6; k++) {
+		soft.set_windows(windows[k]);
+		soft.decode(&ofdm, &frame, soft_bits);
+
+		double start = now_us();
+		for(int i = 0; i < frames; i++) {
+			soft.decode(&ofdm, &frame, soft_bits);
+		}
+		double us = (now_us() - start) / frames;
+		std::printf("soft %-9s %d windows %8.1f us/frame\n",
+				base::isa_name(soft.isa()), windows[k], us);
+	}
+
+	std::printf("bit errors, serial %d\n", serial_errors);
+	const int overlaps[] = { 0, 24, 48, 96, 192 };
+	for(int k = 0; k < 5; k++) {
+		soft.set_windows(8, overlaps[k]);
+		uint8_t *decoded = soft.decode(&ofdm, &frame, soft_bits);
+
+		int errors = 0;
+		int diff = 0;
+		for(int i = 0; i < n_bits; i++) {
+			errors += decoded[i] != data_bits[i];
+			diff += decoded[i] != serial[i];
+		}
+		std::printf("8 windows, overlap %3d: %4d bit errors, %4d differ from serial\n",
+				overlaps[k], errors, diff);
+	}
+}
+
+int
+main(int argc, char **argv) {
+	int frames = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+	std::vector<int> encoding(4, QAM64);
+	ofdm_param ofdm(encoding, P_3_4);
+	frame_param frame(ofdm, 1500);
+
+	static char data_bits[MAX_ENCODED_BITS];
+	static char encoded[2 * MAX_ENCODED_BITS];
+	static char punctured[MAX_ENCODED_BITS];
+	static uint8_t hard_bits[MAX_ENCODED_BITS];
+	static uint8_t soft_bits[MAX_ENCODED_BITS];
+
+	std::srand(1);
+	for(int i = 0; i < frame.n_data_bits; i++) {
+		data_bits[i] = std::rand() & 1;
+	}
+	reset_tail_bits(data_bits, frame);
+	convolutional_encoding(data_bits, encoded, frame);
+	puncturing(encoded, punctured, frame, ofdm);
+
+	// noisy soft bits, the hard bits are their signs
+	for(int i = 0; i < frame.n_encoded_bits; i++) {
+		int8_t llr = std::rand() % 128 - 24;
+		soft_bits[i] = punctured[i] ? llr : -llr;
+		hard_bits[i] = (int8_t) soft_bits[i] > 0;
+	}
+
+	std::printf("1500 byte frame, 64QAM 3/4, %d data bits, %d frames\n",
+			frame.n_data_bits, frames);
+
+	static viterbi_decoder hard;
+	static viterbi_decoder_soft soft;
+	std::vector<uint8_t> ref(frame.n_data_bits);
+
+	// the SSE2 kernel is the reference if it is available
+	if(!hard.set_isa(base::ISA_SSE2)) {
+		hard.set_isa(base::ISA_GENERIC);
+	}
+	std::memcpy(&ref[0], hard.decode(&ofdm, &frame, hard_bits), frame.n_data_bits);
+	run("hard", hard, ofdm, frame, hard_bits, &ref[0], frames);
+
+	if(!soft.set_isa(base::ISA_SSE2)) {
+		soft.set_isa(base::ISA_GENERIC);
+	}
+	std::memcpy(&ref[0], soft.decode(&ofdm, &frame, soft_bits), frame.n_data_bits);
+	run("soft", soft, ofdm, frame, soft_bits, &ref[0], frames);
+
+	std::printf("\nbursts of %d frames, 64QAM 3/4\n", viterbi_decoder_batch::MAX_BATCH);
+	run_batch(14, 50 * frames);
+	run_batch(100, 10 * frames);
+	run_batch(1500, frames);
+
+	run_windows(frames);
+
+	return 0;
+}
@@ -44,15 +44,18 @@ namespace gr {
           io_signature::make(1, 1, sizeof(char)),
           io_signature::make(1, 1, sizeof(gr_complex)), "packet_len") {
 
-      d_bpsk = constellation_bpsk::make();
-      d_qpsk = constellation_qpsk::make();
-      d_16qam = constellation_16qam::make();
-      d_64qam = constellation_64qam::make();
-
-      d_mapping[0] = d_bpsk;
-      d_mapping[1] = d_bpsk;
-      d_mapping[2] = d_bpsk;
-      d_mapping[3] = d_bpsk;
+      digital::constellation_sptr constellations[4];
+      constellations[BPSK] = constellation_bpsk::make();
+      constellations[QPSK] = constellation_qpsk::make();
+      constellations[QAM16] = constellation_16qam::make();
+      constellations[QAM64] = constellation_64qam::make();
+
+      for (int e = 0; e < 4; e++) {
+        std::vector<gr_complex> points = constellations[e]->points();
+        for (int v = 0; v < 64; v++) {
+          d_points[e][v] = points[v % points.size()];
+        }
+      }
     }
 
     chunks_to_symbols_impl::~chunks_to_symbols_impl() { }
@@ -66,13 +69,12 @@ namespace gr {
       const unsigned char *in = (unsigned char*)input_items[0];
       gr_complex *out = (gr_complex*)output_items[0];
 
+      // tags are only at the start of the packet
       std::vector<tag_t> tags;
       bool encoding_found = false;
       bool punct_found = false;
       std::vector<int> encoding;
-      int puncturing;
-      get_tags_in_range(tags, 0, nitems_read(0),
-          nitems_read(0) + ninput_items[0]);
+      get_tags_in_range(tags, 0, nitems_read(0), nitems_read(0) + 1);
 
       for (int i = 0; i < tags.size(); i++){
         if(pmt::eq(tags[i].key, pmt::mp("encoding"))) {
@@ -80,7 +82,6 @@ namespace gr {
           encoding = pmt::s32vector_elements(tags[i].value);
         } else if(pmt::eq(tags[i].key, pmt::mp("puncturing"))){
           punct_found = true;
-          puncturing = pmt::to_long(tags[i].value);
         }
       }
 
@@ -88,36 +89,17 @@ namespace gr {
           throw std::runtime_error("no encoding or puncturing in input stream");
       }
 
-      for (int i = 0; i < 4; i++){
-        switch (encoding[i]) {
-        case BPSK:
-          d_mapping[i] = d_bpsk;
-          break;
-        case QPSK:
-          d_mapping[i] = d_qpsk;
-          break;
-        case QAM16:
-          d_mapping[i] = d_16qam;
-          break;
-        case QAM64:
-          d_mapping[i] = d_64qam;
-          break;
-        default:
-          throw std::invalid_argument("wrong encoding");
-          break;
+      if (encoding != d_encoding) {
+        for (int i = 0; i < 4; i++){
+          if (encoding[i] < BPSK || encoding[i] > QAM64) {
+            throw std::invalid_argument("wrong encoding");
+          }
+          std::copy(d_points[encoding[i]], d_points[encoding[i]] + 64, d_lut + 64 * i);
         }
+        d_encoding = encoding;
       }
-        
-      int rb_index;
-      ofdm_param ofdm(encoding, puncturing);
-      boost::shared_ptr<gr::digital::constellation> mapping;
-      for(int i = 0; i < ninput_items[0]; i++) {
-        rb_index = ofdm.rb_index_from_symbols(i);
-        if (rb_index < 0)
-          throw std::invalid_argument("CHUNKS_TO_SYMBS: wrong rb index");
-        mapping = d_mapping[rb_index];
-        mapping->map_to_points(in[i], out + i);
-      }
+
+      map_symbols(in, out, ninput_items[0], d_lut);
 
       return ninput_items[0];
     }
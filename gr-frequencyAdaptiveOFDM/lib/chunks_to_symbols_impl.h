@@ -23,6 +23,7 @@
 
 #include <frequencyAdaptiveOFDM/chunks_to_symbols.h>
 #include <frequencyAdaptiveOFDM/constellations.h>
+#include "utils.h"
 
 namespace gr {
   namespace frequencyAdaptiveOFDM {
@@ -30,11 +31,11 @@ namespace gr {
     class chunks_to_symbols_impl : public chunks_to_symbols
     {
      private:
-        boost::shared_ptr<gr::digital::constellation> d_mapping[4];
-        constellation_bpsk::sptr d_bpsk;
-        constellation_qpsk::sptr d_qpsk;
-        constellation_16qam::sptr d_16qam;
-        constellation_64qam::sptr d_64qam;
+        // points of each encoding for all 64 symbol values
+        gr_complex d_points[4][64];
+        // points of the resource blocks of the current encoding
+        gr_complex d_lut[SYMBOL_LUT_SIZE];
+        std::vector<int> d_encoding;
 
      public:
       chunks_to_symbols_impl();
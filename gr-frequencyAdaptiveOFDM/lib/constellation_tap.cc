@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "constellation_tap.h"
+#include "equalizer/slicer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+namespace {
+
+// error and reference power of the 12 carriers of a resource block
+template<int ENC> void
+rb_error(const gr_complex *symbols, double &error, double &power) {
+	for(int i = 0; i < 12; i++) {
+		unsigned int bits = equalizer::slicer<ENC>::decide(symbols[i].real(), symbols[i].imag());
+		gr_complex point = equalizer::slicer<ENC>::point(bits);
+		error += std::norm(symbols[i] - point);
+		power += std::norm(point);
+	}
+}
+
+inline int
+bin(float x) {
+	const int BINS = constellation_tap::BINS;
+	int b = int((x + constellation_tap::RANGE) * (BINS / (2 * constellation_tap::RANGE)));
+	return std::min(std::max(b, 0), BINS - 1);
+}
+
+} // namespace
+
+const float constellation_tap::RANGE = 1.5f;
+
+constellation_tap::constellation_tap(int decimation, int period) {
+	set_rate(decimation, period);
+}
+
+void
+constellation_tap::check_rate(int decimation, int period) {
+	if(decimation < 1) {
+		throw std::invalid_argument("CONSTELLATION TAP: decimation has to be at least 1");
+	}
+	if(period < 1) {
+		throw std::invalid_argument("CONSTELLATION TAP: period has to be at least 1");
+	}
+}
+
+void
+constellation_tap::set_rate(int decimation, int period) {
+	check_rate(decimation, period);
+	d_decimation = decimation;
+	d_period = period;
+	reset();
+}
+
+void
+constellation_tap::reset() {
+	d_skipped = 0;
+	d_symbols = 0;
+	d_next_scatter = 0;
+	std::memset(d_histogram, 0, sizeof(d_histogram));
+	std::memset(d_error, 0, sizeof(d_error));
+	std::memset(d_power, 0, sizeof(d_power));
+}
+
+bool
+constellation_tap::add(const gr_complex *symbols, const std::vector<int> &encoding) {
+	if(++d_skipped < d_decimation) {
+		return false;
+	}
+	d_skipped = 0;
+
+	for(int rb = 0; rb < 4; rb++) {
+		const gr_complex *s = symbols + 12 * rb;
+		switch(encoding[rb]) {
+		case BPSK:
+			rb_error<BPSK>(s, d_error[rb], d_power[rb]);
+			break;
+		case QPSK:
+			rb_error<QPSK>(s, d_error[rb], d_power[rb]);
+			break;
+		case QAM16:
+			rb_error<QAM16>(s, d_error[rb], d_power[rb]);
+			break;
+		default:
+			rb_error<QAM64>(s, d_error[rb], d_power[rb]);
+			break;
+		}
+
+		for(int i = 0; i < 12; i++) {
+			d_histogram[rb][bin(s[i].imag()) * BINS + bin(s[i].real())]++;
+			d_scatter[rb][(d_next_scatter + i) % SCATTER] = s[i];
+		}
+	}
+	d_next_scatter = (d_next_scatter + 12) % SCATTER;
+
+	return ++d_symbols >= d_period;
+}
+
+pmt::pmt_t
+constellation_tap::snapshot() {
+	float evm[4];
+	for(int rb = 0; rb < 4; rb++) {
+		evm[rb] = d_power[rb] > 0 ? std::sqrt(d_error[rb] / d_power[rb]) : 0;
+	}
+
+	// the oldest scatter point of each resource block first
+	int n = std::min(SCATTER, 12 * d_symbols);
+	int first = n < SCATTER ? 0 : d_next_scatter;
+	std::vector<gr_complex> scatter(4 * n);
+	for(int rb = 0; rb < 4; rb++) {
+		for(int i = 0; i < n; i++) {
+			scatter[rb * n + i] = d_scatter[rb][(first + i) % SCATTER];
+		}
+	}
+
+	pmt::pmt_t dict = pmt::make_dict();
+	dict = pmt::dict_add(dict, pmt::mp("symbols"), pmt::from_long(d_symbols));
+	dict = pmt::dict_add(dict, pmt::mp("evm"), pmt::init_f32vector(4, evm));
+	dict = pmt::dict_add(dict, pmt::mp("histogram"),
+			pmt::init_u32vector(4 * BINS * BINS, &d_histogram[0][0]));
+	dict = pmt::dict_add(dict, pmt::mp("bins"), pmt::from_long(BINS));
+	dict = pmt::dict_add(dict, pmt::mp("range"), pmt::from_double(RANGE));
+
+	reset();
+	return pmt::cons(dict, pmt::init_c32vector(scatter.size(), scatter));
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_CONSTELLATION_TAP_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_CONSTELLATION_TAP_H
+
+#include <gnuradio/gr_complex.h>
+#include <pmt/pmt.h>
+#include <stdint.h>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Telemetry of the equalized data carriers for the "symbols" port of the
+ * receivers. Every decimation-th data symbol goes into a 2D histogram
+ * and the EVM of each resource block and the last SCATTER carriers of a
+ * resource block are kept for a scatter plot. After period of these
+ * symbols snapshot() hands out everything in one PDU and starts over.
+ * The state lives in fixed arrays, so add() does not allocate.
+ *
+ * The PDU is (dict . c32vector). The vector has the scatter points, the
+ * same number for each resource block and one resource block after the
+ * other. The dict has
+ *   "symbols"    number of symbols in the snapshot
+ *   "evm"        f32vector with the RMS EVM of the 4 resource blocks
+ *   "histogram"  u32vector of 4 * BINS * BINS counts, resource block,
+ *                then imaginary and real part, over [-RANGE, RANGE]
+ *   "bins", "range"
+ */
+class constellation_tap {
+public:
+	constellation_tap(int decimation = DEFAULT_DECIMATION,
+			int period = DEFAULT_PERIOD);
+
+	// decimation and period >= 1, starts over
+	void set_rate(int decimation, int period);
+	// throws std::invalid_argument for values out of range
+	static void check_rate(int decimation, int period);
+
+	void reset();
+
+	// the 48 data carriers of a symbol and the encoding of the resource
+	// blocks, true if a snapshot is due
+	bool add(const gr_complex *symbols, const std::vector<int> &encoding);
+
+	// PDU of the symbols since the last snapshot
+	pmt::pmt_t snapshot();
+
+	static const int BINS = 32;
+	static const float RANGE;
+	static const int SCATTER = 48;
+	static const int DEFAULT_DECIMATION = 4;
+	static const int DEFAULT_PERIOD = 250;
+
+private:
+	int d_decimation;
+	int d_period;
+	int d_skipped;
+	int d_symbols;
+
+	uint32_t d_histogram[4][BINS * BINS];
+	double d_error[4];
+	double d_power[4];
+	gr_complex d_scatter[4][SCATTER];
+	int d_next_scatter;
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_CONSTELLATION_TAP_H */
@@ -23,6 +23,8 @@
 #endif
 
 #include "constellations_impl.h"
+#include "demapper.h"
+#include "equalizer/slicer.h"
 
 namespace gr {
   namespace frequencyAdaptiveOFDM {
@@ -51,6 +53,12 @@ namespace gr {
       return (real(*sample) > 0);
     }
 
+    void
+    constellation_bpsk_impl::demap_soft(const gr_complex *symbols, const float *csi,
+                                          float *llr, int n) {
+      ::demap_soft(BPSK, symbols, csi, llr, n);
+    }
+
 
     /**********************************************************/
 
@@ -83,6 +91,12 @@ namespace gr {
       return 2*(imag(*sample)>0) + (real(*sample)>0);
     }
 
+    void
+    constellation_qpsk_impl::demap_soft(const gr_complex *symbols, const float *csi,
+                                          float *llr, int n) {
+      ::demap_soft(QPSK, symbols, csi, llr, n);
+    }
+
 
     /**********************************************************/
 
@@ -126,17 +140,13 @@ namespace gr {
     unsigned int
     constellation_16qam_impl::decision_maker(const gr_complex *sample)
     {
-      unsigned int ret = 0;
-      const float level = sqrt(float(0.1));
-      float re = sample->real();
-      float im = sample->imag();
-
-      ret |= re > 0;
-      ret |= (std::abs(re) < (2*level)) << 1;
-      ret |= (im > 0) << 2;
-      ret |= (std::abs(im) < (2*level)) << 3;
+      return equalizer::slicer<QAM16>::decide(sample->real(), sample->imag());
+    }
 
-      return ret;
+    void
+    constellation_16qam_impl::demap_soft(const gr_complex *symbols, const float *csi,
+                                          float *llr, int n) {
+      ::demap_soft(QAM16, symbols, csi, llr, n);
     }
 
 
@@ -228,19 +238,13 @@ namespace gr {
 
     unsigned int
     constellation_64qam_impl::decision_maker(const gr_complex *sample) {
-      unsigned int ret = 0;
-      const float level = sqrt(float(1/42.0));
-      float re = sample->real();
-      float im = sample->imag();
-
-      ret |= re > 0;
-      ret |= (std::abs(re) < (4*level)) << 1;
-      ret |= (std::abs(re) < (6*level) && std::abs(re) > (2*level)) << 2;
-      ret |= (im > 0) << 3;
-      ret |= (std::abs(im) < (4*level)) << 4;
-      ret |= (std::abs(im) < (6*level) && std::abs(im) > (2*level)) << 5;
+      return equalizer::slicer<QAM64>::decide(sample->real(), sample->imag());
+    }
 
-      return ret;
+    void
+    constellation_64qam_impl::demap_soft(const gr_complex *symbols, const float *csi,
+                                          float *llr, int n) {
+      ::demap_soft(QAM64, symbols, csi, llr, n);
     }
 
   } /* namespace frequencyAdaptiveOFDM */
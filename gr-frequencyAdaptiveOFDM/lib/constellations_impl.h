@@ -33,6 +33,8 @@ namespace gr {
       ~constellation_bpsk_impl();
 
       unsigned int decision_maker(const gr_complex *sample);
+      void demap_soft(const gr_complex *symbols, const float *csi,
+                      float *llr, int n);
     };
 
 
@@ -43,6 +45,8 @@ namespace gr {
       ~constellation_qpsk_impl();
 
       unsigned int decision_maker(const gr_complex *sample);
+      void demap_soft(const gr_complex *symbols, const float *csi,
+                      float *llr, int n);
     };
 
 
@@ -54,6 +58,8 @@ namespace gr {
       ~constellation_16qam_impl();
 
       unsigned int decision_maker(const gr_complex *sample);
+      void demap_soft(const gr_complex *symbols, const float *csi,
+                      float *llr, int n);
     };
 
 
@@ -66,6 +72,8 @@ namespace gr {
       ~constellation_64qam_impl();
 
       unsigned int decision_maker(const gr_complex *sample);
+      void demap_soft(const gr_complex *symbols, const float *csi,
+                      float *llr, int n);
     };
     
 
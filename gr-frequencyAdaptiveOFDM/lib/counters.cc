@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "counters.h"
+#include <gnuradio/prefs.h>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <sys/time.h>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+namespace {
+
+const char *counter_names[counters::N_COUNTERS] = {
+	"frames_detected", "parity_errors", "crc_errors", "sync_losses",
+	"tx_packets", "rx_packets", "tx_retries", "tx_dropped", "rx_duplicates"
+};
+
+const char *gauge_names[counters::N_GAUGES] = {
+	"rx_snr", "rx_per"
+};
+
+// in the order of Encoding and Puncturing
+const char *encoding_names[counters::N_ENCODINGS] = {
+	"bpsk", "qpsk", "qam16", "qam64"
+};
+const char *puncturing_names[counters::N_PUNCTURINGS] = {
+	"1_2", "3_4", "2_3"
+};
+
+double
+wall_time() {
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+} // namespace
+
+counters::counters() :
+	ring_writer(thread_rings::make_fn()),
+	d_file(NULL) {
+
+	reset();
+}
+
+counters::~counters() {
+	stop();
+}
+
+counters&
+counters::instance() {
+	// never destroyed, blocks might detach after static destruction
+	static counters *c = new counters();
+	return *c;
+}
+
+void
+counters::attached(const std::string &file) {
+	if(!running()) {
+		start();
+	}
+}
+
+void
+counters::detached() {
+	stop();
+}
+
+void
+counters::set(gauge g, double value) {
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	__atomic_store_n(&d_gauges[g], bits, __ATOMIC_RELAXED);
+}
+
+double
+counters::get(gauge g) const {
+	uint64_t bits = __atomic_load_n(&d_gauges[g], __ATOMIC_RELAXED);
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void
+counters::add_frame(const std::vector<int> &encoding, int puncturing,
+		const std::vector<double> &snr) {
+	if(puncturing >= 0 && puncturing < N_PUNCTURINGS) {
+		for(size_t i = 0; i < encoding.size(); i++) {
+			if(encoding[i] >= 0 && encoding[i] < N_ENCODINGS) {
+				__atomic_fetch_add(&d_resource_blocks[encoding[i]][puncturing], 1, __ATOMIC_RELAXED);
+			}
+		}
+	}
+	if(!snr.empty()) {
+		double sum = 0;
+		for(size_t i = 0; i < snr.size(); i++) {
+			sum += snr[i];
+		}
+		set(RX_SNR, sum / snr.size());
+	}
+}
+
+uint64_t
+counters::resource_blocks(int encoding, int puncturing) const {
+	return __atomic_load_n(&d_resource_blocks[encoding][puncturing], __ATOMIC_RELAXED);
+}
+
+void
+counters::watch(counter c, const std::string &file) {
+	if(file.empty()) {
+		return;
+	}
+	gr::thread::scoped_lock lock(d_mutex);
+	for(size_t i = 0; i < d_watched.size(); i++) {
+		if(d_watched[i].file == file) {
+			d_watched[i].c = c;
+			return;
+		}
+	}
+	watched w;
+	w.c = c;
+	w.file = file;
+	d_watched.push_back(w);
+}
+
+void
+counters::reset() {
+	for(int i = 0; i < N_COUNTERS; i++) {
+		__atomic_store_n(&d_counters[i], 0, __ATOMIC_RELAXED);
+	}
+	for(int i = 0; i < N_GAUGES; i++) {
+		set(gauge(i), 0);
+	}
+	for(int e = 0; e < N_ENCODINGS; e++) {
+		for(int p = 0; p < N_PUNCTURINGS; p++) {
+			__atomic_store_n(&d_resource_blocks[e][p], 0, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+std::string
+counters::header() const {
+	std::ostringstream s;
+	s << "time";
+	for(int i = 0; i < N_COUNTERS; i++) {
+		s << "," << counter_names[i];
+	}
+	for(int e = 0; e < N_ENCODINGS; e++) {
+		for(int p = 0; p < N_PUNCTURINGS; p++) {
+			s << ",rb_" << encoding_names[e] << "_" << puncturing_names[p];
+		}
+	}
+	for(int i = 0; i < N_GAUGES; i++) {
+		s << "," << gauge_names[i];
+	}
+	return s.str();
+}
+
+std::string
+counters::snapshot() const {
+	std::ostringstream s;
+	s.setf(std::ios::fixed);
+	s.precision(3);
+	s << wall_time();
+	for(int i = 0; i < N_COUNTERS; i++) {
+		s << "," << get(counter(i));
+	}
+	for(int e = 0; e < N_ENCODINGS; e++) {
+		for(int p = 0; p < N_PUNCTURINGS; p++) {
+			s << "," << resource_blocks(e, p);
+		}
+	}
+	s.precision(2);
+	for(int i = 0; i < N_GAUGES; i++) {
+		s << "," << get(gauge(i));
+	}
+	return s.str();
+}
+
+void
+counters::drain() {
+	if(d_file) {
+		std::fprintf(d_file, "%s\n", snapshot().c_str());
+		std::fflush(d_file);
+	}
+	for(size_t i = 0; i < d_watched.size(); i++) {
+		FILE *f = std::fopen(d_watched[i].file.c_str(), "w");
+		if(f) {
+			std::fprintf(f, "%llu\n", (unsigned long long) get(d_watched[i].c));
+			std::fclose(f);
+		}
+	}
+}
+
+const char*
+counters::name(counter c) {
+	return counter_names[c];
+}
+
+const char*
+counters::name(gauge g) {
+	return gauge_names[g];
+}
+
+void
+counters::start() {
+	reset();
+
+	gr::prefs *prefs = gr::prefs::singleton();
+	std::string file = prefs->get_string("frequencyAdaptiveOFDM", "counters_file", "");
+	double interval = prefs->get_double("frequencyAdaptiveOFDM", "counters_interval", 1.0);
+	if(interval < 0.001) {
+		throw std::invalid_argument("COUNTERS: interval has to be at least 1 ms");
+	}
+
+	gr::thread::scoped_lock lock(d_mutex);
+	if(!file.empty()) {
+		d_file = std::fopen(file.c_str(), "w");
+		if(!d_file) {
+			throw std::invalid_argument("COUNTERS: can not open " + file);
+		}
+		std::fprintf(d_file, "%s\n", header().c_str());
+	}
+	start_writer(int(interval * 1000));
+}
+
+void
+counters::stopped() {
+	d_watched.clear();
+	if(d_file) {
+		std::fclose(d_file);
+		d_file = NULL;
+	}
+}
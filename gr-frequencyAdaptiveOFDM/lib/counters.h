@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_COUNTERS_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_COUNTERS_H
+
+#include "ring_writer.h"
+#include <frequencyAdaptiveOFDM/mapper.h>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Counters and gauges of the PHY and MAC, shared by all blocks of the
+ * process. Updating one is an atomic add or store, so the blocks count
+ * every frame without touching the file system, there are no rings.
+ * While blocks are attached, the ring_writer takes a snapshot at a
+ * fixed interval and
+ *
+ *  - appends it as a CSV line to the file of
+ *
+ *      [frequencyAdaptiveOFDM]
+ *      counters_file = /tmp/freq_counters.csv
+ *      counters_interval = 1.0
+ *
+ *    in the GNU Radio config, with a header line naming the columns
+ *  - rewrites the files of watch() with the value of their counter,
+ *    like the packet count files of mac and parse_mac did per packet.
+ *
+ * The counters start at zero when the first block attaches.
+ */
+class counters : public ring_writer
+{
+public:
+	enum counter {
+		FRAMES_DETECTED,  // wifi_start tags
+		PARITY_ERRORS,    // signal fields with a wrong parity
+		CRC_ERRORS,       // frames with a wrong checksum
+		SYNC_LOSSES,      // frames cut off by the next one
+		TX_PACKETS,       // data frames sent by mac
+		RX_PACKETS,       // data frames for us in parse_mac, no duplicates
+		TX_RETRIES,       // data frames sent again by the ARQ of mac
+		TX_DROPPED,       // data frames mac gave up after the last retry
+		RX_DUPLICATES,    // data frames parse_mac received before
+		N_COUNTERS
+	};
+
+	enum gauge {
+		RX_SNR,  // mean SNR of the resource blocks of the last frame, dB
+		RX_PER,  // packet error rate of parse_mac, %
+		N_GAUGES
+	};
+
+	static const int N_ENCODINGS = 4;
+	static const int N_PUNCTURINGS = 3;
+
+	counters();
+	~counters();
+
+	static counters& instance();
+	// reference counting for the blocks, see ring_writer
+	void attach() {
+		attach_block("");
+	}
+
+	void add(counter c, uint64_t n = 1) {
+		__atomic_fetch_add(&d_counters[c], n, __ATOMIC_RELAXED);
+	}
+	uint64_t get(counter c) const {
+		return __atomic_load_n(&d_counters[c], __ATOMIC_RELAXED);
+	}
+	void set(gauge g, double value);
+	double get(gauge g) const;
+
+	// a received frame: counts its resource blocks per encoding and
+	// puncturing and sets RX_SNR from the SNR (dB) of each
+	void add_frame(const std::vector<int> &encoding, int puncturing,
+			const std::vector<double> &snr);
+	uint64_t resource_blocks(int encoding, int puncturing) const;
+
+	// the writer keeps file at the value of c, until the last block
+	// detaches
+	void watch(counter c, const std::string &file);
+
+	void reset();
+	// CSV columns and the current values. flush() writes the snapshot to
+	// the file and the watched files now.
+	std::string header() const;
+	std::string snapshot() const;
+
+	static const char* name(counter c);
+	static const char* name(gauge g);
+
+private:
+	struct watched {
+		counter c;
+		std::string file;
+	};
+
+	void start();
+	void attached(const std::string &file);
+	void detached();
+	// writes the snapshot
+	void drain();
+	void stopped();
+
+	uint64_t d_counters[N_COUNTERS];
+	uint64_t d_gauges[N_GAUGES];  // bits of the double
+	uint64_t d_resource_blocks[N_ENCODINGS][N_PUNCTURINGS];
+
+	// d_mutex protects everything below
+	std::vector<watched> d_watched;
+	FILE *d_file;
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_COUNTERS_H */
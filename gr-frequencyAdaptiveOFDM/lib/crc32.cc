@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "crc32.h"
+#include "utils.h"
+
+#include <cstring>
+
+namespace {
+
+// slicing-by-8 tables of the reflected polynomial 0xEDB88320, table[k]
+// is the CRC of a byte followed by k zero bytes
+struct crc32_tables {
+	uint32_t table[8][256];
+	bool pclmul;
+
+	crc32_tables();
+};
+
+crc32_tables::crc32_tables() {
+	for(int b = 0; b < 256; b++) {
+		uint32_t crc = b;
+		for(int i = 0; i < 8; i++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+		table[0][b] = crc;
+	}
+	for(int b = 0; b < 256; b++) {
+		for(int k = 1; k < 8; k++) {
+			table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+		}
+	}
+
+	pclmul = cpu_supports(CPU_PCLMUL);
+}
+
+const crc32_tables tables;
+
+} // namespace
+
+uint32_t
+crc32_word(uint32_t crc, uint64_t word) {
+	word ^= crc;
+	return tables.table[7][word & 0xff] ^
+		tables.table[6][(word >> 8) & 0xff] ^
+		tables.table[5][(word >> 16) & 0xff] ^
+		tables.table[4][(word >> 24) & 0xff] ^
+		tables.table[3][(word >> 32) & 0xff] ^
+		tables.table[2][(word >> 40) & 0xff] ^
+		tables.table[1][(word >> 48) & 0xff] ^
+		tables.table[0][word >> 56];
+}
+
+uint32_t
+crc32_slicing8(uint32_t crc, const uint8_t *data, int len) {
+	while(len >= 8) {
+		// little endian load
+		uint64_t word;
+		std::memcpy(&word, data, 8);
+		crc = crc32_word(crc, word);
+		data += 8;
+		len -= 8;
+	}
+	while(len > 0) {
+		crc = (crc >> 8) ^ tables.table[0][(crc ^ *data) & 0xff];
+		data++;
+		len--;
+	}
+	return crc;
+}
+
+bool
+crc32_has_pclmul() {
+	return tables.pclmul;
+}
+
+uint32_t
+crc32_update(uint32_t crc, const uint8_t *data, int len) {
+#ifdef FREQUENCYADAPTIVEOFDM_PCLMUL
+	if(tables.pclmul && len >= 64) {
+		int folded = len & ~15;
+		crc = crc32_pclmul(crc, data, folded);
+		data += folded;
+		len -= folded;
+	}
+#endif
+	return crc32_slicing8(crc, data, len);
+}
+
+uint32_t
+crc32(const uint8_t *data, int len) {
+	return ~crc32_update(0xffffffff, data, len);
+}
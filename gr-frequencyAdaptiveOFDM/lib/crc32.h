@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_CRC32_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_CRC32_H
+
+#include <stdint.h>
+
+/**
+ * CRC-32 of IEEE 802.3, the FCS of 802.11 frames. Gives the same
+ * checksum as boost::crc_32_type.
+ *
+ * On x86 it folds 64 bytes at a time with carry-less multiplications
+ * (PCLMULQDQ) if the CPU supports them, otherwise it runs slicing-by-8,
+ * eight table lookups per 64 bit word. The tables are built when the
+ * library is loaded.
+ */
+uint32_t crc32(const uint8_t *data, int len);
+
+/**
+ * Kernels on the running CRC register, i.e. without the initial and the
+ * final inversion. crc32(d, n) is ~crc32_update(0xffffffff, d, n).
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, int len);
+
+uint32_t crc32_slicing8(uint32_t crc, const uint8_t *data, int len);
+
+// one 64 bit word, the bytes in little endian order
+uint32_t crc32_word(uint32_t crc, uint64_t word);
+
+bool crc32_has_pclmul();
+
+#ifdef FREQUENCYADAPTIVEOFDM_PCLMUL
+// built with -mpclmul -msse4.1, only call it if crc32_has_pclmul()
+uint32_t crc32_pclmul(uint32_t crc, const uint8_t *data, int len);
+#endif
+
+// remainder of the CRC register over a frame followed by its FCS
+#define CRC32_RESIDUE 0x2144DF1C
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_CRC32_H */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * CRC-32 by folding with carry-less multiplications, see "Fast CRC
+ * Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+ * (Intel, 2009). Four 128 bit lanes are folded 64 bytes forward per
+ * round, then folded into one lane, reduced to 64 bits and finally to
+ * the 32 bit CRC with a Barrett reduction.
+ */
+#include "crc32.h"
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+namespace {
+
+// x^(k * 32) mod P(x), bit reflected, for the fold distances
+const uint64_t k1k2[2] __attribute__ ((aligned(16))) = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+const uint64_t k3k4[2] __attribute__ ((aligned(16))) = { 0x01751997d0ULL, 0x00ccaa009eULL };
+const uint64_t k5k0[2] __attribute__ ((aligned(16))) = { 0x0163cd6124ULL, 0x0000000000ULL };
+// P(x) and floor(x^64 / P(x)), bit reflected
+const uint64_t poly[2] __attribute__ ((aligned(16))) = { 0x01db710641ULL, 0x01f7011641ULL };
+
+inline __m128i
+fold(__m128i x, __m128i k, __m128i next) {
+	__m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+	__m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+	return _mm_xor_si128(_mm_xor_si128(hi, lo), next);
+}
+
+} // namespace
+
+// len is a multiple of 16 and at least 64
+uint32_t
+crc32_pclmul(uint32_t crc, const uint8_t *data, int len) {
+	__m128i x1 = _mm_loadu_si128((const __m128i *) (data + 0x00));
+	__m128i x2 = _mm_loadu_si128((const __m128i *) (data + 0x10));
+	__m128i x3 = _mm_loadu_si128((const __m128i *) (data + 0x20));
+	__m128i x4 = _mm_loadu_si128((const __m128i *) (data + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+	data += 64;
+	len -= 64;
+
+	__m128i k = _mm_load_si128((const __m128i *) k1k2);
+	while(len >= 64) {
+		x1 = fold(x1, k, _mm_loadu_si128((const __m128i *) (data + 0x00)));
+		x2 = fold(x2, k, _mm_loadu_si128((const __m128i *) (data + 0x10)));
+		x3 = fold(x3, k, _mm_loadu_si128((const __m128i *) (data + 0x20)));
+		x4 = fold(x4, k, _mm_loadu_si128((const __m128i *) (data + 0x30)));
+		data += 64;
+		len -= 64;
+	}
+
+	// four lanes into one, then the remaining 16 byte blocks
+	k = _mm_load_si128((const __m128i *) k3k4);
+	x1 = fold(x1, k, x2);
+	x1 = fold(x1, k, x3);
+	x1 = fold(x1, k, x4);
+	while(len >= 16) {
+		x1 = fold(x1, k, _mm_loadu_si128((const __m128i *) data));
+		data += 16;
+		len -= 16;
+	}
+
+	// 128 to 64 bits
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	__m128i x2r = _mm_clmulepi64_si128(x1, k, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2r);
+	k = _mm_loadl_epi64((const __m128i *) k5k0);
+	x2r = _mm_srli_si128(x1, 4);
+	x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00);
+	x1 = _mm_xor_si128(x1, x2r);
+
+	// Barrett reduction to 32 bits
+	k = _mm_load_si128((const __m128i *) poly);
+	x2r = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+	x2r = _mm_clmulepi64_si128(_mm_and_si128(x2r, mask32), k, 0x00);
+	x1 = _mm_xor_si128(x1, x2r);
+	return _mm_extract_epi32(x1, 1);
+}
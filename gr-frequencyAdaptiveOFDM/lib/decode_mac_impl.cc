@@ -26,46 +26,60 @@
 #include "decode_mac_impl.h"
 
 #include <gnuradio/io_signature.h>
-#include <boost/crc.hpp>
-#include <fstream>
-
-#define LINKTYPE_IEEE802_11 105 /* http://www.tcpdump.org/linktypes.html */
+#include <iomanip>
 
 namespace gr {
   namespace frequencyAdaptiveOFDM {
 
     decode_mac::sptr
-    decode_mac::make(bool log, bool debug, bool debug_rx_err)
+    decode_mac::make(bool log, bool debug, bool debug_rx_err, bool soft, int batch_size,
+                      int windows)
     {
       return gnuradio::get_initial_sptr
-        (new decode_mac_impl(log, debug, debug_rx_err));
+        (new decode_mac_impl(log, debug, debug_rx_err, soft, batch_size, windows));
     }
 
     /*
      * The private constructor
      */
-    decode_mac_impl::decode_mac_impl(bool log, bool debug, bool debug_rx_err):
+    decode_mac_impl::decode_mac_impl(bool log, bool debug, bool debug_rx_err, bool soft, int batch_size,
+                                     int windows):
      block("decode_mac",
-              gr::io_signature::make(1, 1, 48),
+              gr::io_signature::make(1, 1, soft ? SOFT_SYMBOL_SIZE : 48),
               gr::io_signature::make(0, 0, 0)),
       d_log(log),
       d_debug(debug),
       d_debug_rx_err(debug_rx_err),
+      d_soft(soft),
+      d_item_size(soft ? SOFT_SYMBOL_SIZE : 48),
       d_snr(std::vector<double>(4,0)),
       d_nom_freq(0.0),
       d_freq_offset(0.0),
+      d_trace(0),
       d_ofdm(std::vector<int>(4, BPSK), P_1_2),
       d_frame(d_ofdm, 0),
+      d_decoder("DECODE_MAC", log, debug, debug_rx_err, windows),
+      d_batch_size(batch_size),
+      d_batch_count(0),
       d_frame_complete(true)
     {
+      if(batch_size < 1 || batch_size > viterbi_decoder_batch::MAX_BATCH) {
+        throw std::invalid_argument("DECODE_MAC: batch size has to be between 1 and 32");
+      }
+
       message_port_register_out(pmt::mp("out"));
 
-      nSinq = 0;
+      frame_tracer::instance().attach();
+      counters::instance().attach();
+      logger::instance().attach();
     }
 
 
     decode_mac_impl::~decode_mac_impl()
     {
+      logger::instance().detach();
+      counters::instance().detach();
+      frame_tracer::instance().detach();
     }
 
 
@@ -92,12 +106,9 @@ namespace gr {
         if(tags.size()) {
           if (d_frame_complete == false) {
             if (d_debug || d_debug_rx_err) {
-              std::cout << "Warning: starting to receive new frame before old frame was complete" << std::endl;
+              lout(WARN) << "DECODE_MAC: starting to receive new frame before old frame was complete" << std::endl;
             }
-            std::fstream sinqLog_fstream("/tmp/freq_contador_rx.csv", std::ofstream::out);
-            nSinq++;
-            sinqLog_fstream << nSinq << std::endl;
-            sinqLog_fstream.close();
+            counters::instance().add(counters::SYNC_LOSSES);
 
             dout << "Already copied " << copied << " out of " << d_frame.n_sym << " symbols of last frame" << std::endl;
           }
@@ -110,6 +121,7 @@ namespace gr {
           d_snr = pmt::f64vector_elements(pmt::dict_ref(dict, pmt::mp("snr"), pmt::init_f64vector(0,0)));
           d_nom_freq = pmt::to_double(pmt::dict_ref(dict, pmt::mp("freq"), pmt::from_double(0)));
           d_freq_offset = pmt::to_double(pmt::dict_ref(dict, pmt::mp("freq_offset"), pmt::from_double(0)));
+          d_trace = pmt::to_uint64(pmt::dict_ref(dict, pmt::mp("trace"), pmt::from_uint64(0)));
 
           ofdm_param ofdm = ofdm_param(encoding, puncturing);
           frame_param frame = frame_param(ofdm, len_data);
@@ -120,10 +132,11 @@ namespace gr {
             d_frame = frame;
             copied = 0;
 
-            if (d_debug){
-              std::cout << "DECODE_MAC: frame start -- len " << len_data << std::endl;
-              d_frame.print();
-              d_ofdm.print();
+            if (LOG_ENABLED(DEBUG) && d_debug){
+              std::ostream &out = LOG_STREAM(DEBUG);
+              out << "DECODE_MAC: frame start -- len " << len_data << std::endl;
+              d_frame.print(out);
+              d_ofdm.print(out);
             }
           } else {
             dout << "DECOE_MAC: Dropping frame which is too large (symbols or bits)" << std::endl;
@@ -131,21 +144,37 @@ namespace gr {
         }
 
         if(copied < d_frame.n_sym) {
-          std::memcpy(d_rx_symbols + (copied * 48), in, 48);
+          if(d_soft) {
+            std::memcpy(d_rx_llr + (copied * SOFT_SYMBOL_SIZE), in, SOFT_SYMBOL_SIZE);
+          } else {
+            std::memcpy(d_rx_symbols + (copied * 48), in, 48);
+          }
           copied++;
 
-          if(copied == d_frame.n_sym) {
+          if(copied == d_frame.n_sym && d_batch_size > 1 && !d_soft) {
+            // keep going, the batch is decoded when it is full or at the
+            // end of this call
+            dout << "received complete frame - queuing" << std::endl;
+            queue_frame();
+            d_frame_complete = true;
+            if(d_batch_count == d_batch_size) {
+              decode_batch();
+            }
+          } else if(copied == d_frame.n_sym) {
             dout << "received complete frame - decoding" << std::endl;
             decode();
-            in += 48;
+            in += d_item_size;
             i++;
             d_frame_complete = true;
             break;
           }
         }
-        in += 48;
+        in += d_item_size;
         i++;
       }
+      if(d_batch_count) {
+        decode_batch();
+      }
       consume(0, i);
       return 0;
     }
@@ -153,99 +182,94 @@ namespace gr {
 
     void
     decode_mac_impl::decode(){
-      // Received symbols
-      if (d_log) {
-        print_bytes("DECODE_MAC: splited symbols:", (char*)d_rx_symbols, d_frame.n_sym * 48);
-      }
-
-      regroup_symbols();
-      if (d_log) {
-        print_bytes("DECODE_MAC: interleaved data:", (char*)d_rx_bits, d_frame.n_encoded_bits);
-      }
+      gather_bits(d_depunctured);
 
-      interleave((char*)d_rx_bits, (char*) d_deinterleaved_bits, d_frame, d_ofdm, true);
-      if (d_log) {
-        print_bytes("DECODE_MAC: puncttured and coded data:", (char*)d_deinterleaved_bits, d_frame.n_encoded_bits);
+      pmt::pmt_t pdu = d_decoder.decode(d_depunctured, d_soft, d_ofdm, d_frame,
+          d_snr, d_nom_freq, d_freq_offset, d_trace);
+      if(!pmt::is_null(pdu)) {
+        message_port_pub(pmt::mp("out"), pdu);
       }
+    }
 
-      uint8_t *decoded = d_decoder.decode(&d_ofdm, &d_frame, d_deinterleaved_bits);
-      if (d_log) {
-        print_bytes("DECODE_MAC: scrambled data:", (char*)decoded, d_frame.n_data_bits);
-      }
+    void
+    decode_mac_impl::queue_frame(){
+      rx_frame &f = d_batch[d_batch_count];
+
+      gather_bits(f.bits);
+
+      f.ofdm = d_ofdm;
+      f.frame = d_frame;
+      f.snr = d_snr;
+      f.nom_freq = d_nom_freq;
+      f.freq_offset = d_freq_offset;
+      f.trace = d_trace;
+      d_batch_count++;
+    }
 
-      descramble(decoded);
-      if (d_log) {
-        print_bytes("DECODE_MAC: generated bits (without 0s at the head):", (char*)out_bytes, d_frame.psdu_size*8);
-      }
+    void
+    decode_mac_impl::decode_batch(){
+      pmt::pmt_t pdus[viterbi_decoder_batch::MAX_BATCH];
+      bool decoded[viterbi_decoder_batch::MAX_BATCH] = { false };
+      uint8_t *in[viterbi_decoder_batch::MAX_BATCH];
+      int index[viterbi_decoder_batch::MAX_BATCH];
+
+      for(int i = 0; i < d_batch_count; i++) {
+        if(decoded[i]) {
+          continue;
+        }
 
-      // skip service field
-      boost::crc_32_type result;
-      result.process_bytes(out_bytes + 2, d_frame.psdu_size);
-      if(result.checksum() != 558161692) {
-        if (d_debug || d_debug_rx_err){
-          std::cout << "WARNING: DECODE MAC: checksum wrong -- dropping\n";
+        // frames with the same puncturing and length share the trellis
+        int n = 0;
+        for(int j = i; j < d_batch_count; j++) {
+          if(!decoded[j] && d_batch[j].ofdm.punct == d_batch[i].ofdm.punct &&
+              d_batch[j].frame.n_data_bits == d_batch[i].frame.n_data_bits) {
+            decoded[j] = true;
+            in[n] = d_batch[j].bits;
+            index[n] = j;
+            n++;
+          }
         }
-        return;
-      }
 
-      // create PDU
-      pmt::pmt_t blob = pmt::make_blob(out_bytes + 2, d_frame.psdu_size - 4);
-      pmt::pmt_t enc = pmt::init_s32vector(4, d_ofdm.resource_blocks_e);
-      pmt::pmt_t punct = pmt::from_long(d_ofdm.punct);
-      pmt::pmt_t dict = pmt::make_dict();
-      dict = pmt::dict_add(dict, pmt::mp("encoding"), enc);
-      dict = pmt::dict_add(dict, pmt::mp("puncturing"), punct);
-      dict = pmt::dict_add(dict, pmt::mp("snr"), pmt::init_f64vector(4, d_snr));
-      dict = pmt::dict_add(dict, pmt::mp("nomfreq"), pmt::from_double(d_nom_freq));
-      dict = pmt::dict_add(dict, pmt::mp("freqofs"), pmt::from_double(d_freq_offset));
-      dict = pmt::dict_add(dict, pmt::mp("dlt"), pmt::from_long(LINKTYPE_IEEE802_11));
-      message_port_pub(pmt::mp("out"), pmt::cons(dict, blob));
-    }
+        dout << "DECODE_MAC: decoding " << n << " frame(s) at once" << std::endl;
+        if(n == 1) {
+          rx_frame &f = d_batch[i];
+          pdus[i] = d_decoder.decode(f.bits, false, f.ofdm, f.frame, f.snr,
+              f.nom_freq, f.freq_offset, f.trace);
+          continue;
+        }
 
-    void
-    decode_mac_impl::regroup_symbols(){
-      int bpsc;
-      int regrouped = 0;
-      int rb_index;
-
-      for(int i = 0; i < d_frame.n_sym * 48; i++) {
-        rb_index = d_ofdm.rb_index_from_symbols(i);
-        if (rb_index < 0)
-          throw std::invalid_argument("DECODE_MAC: wrong rb index");
-
-        bpsc = d_ofdm.n_bpcrb[rb_index];
-        for(int k = 0; k < bpsc; k++) {
-          d_rx_bits[regrouped] = !!(d_rx_symbols[i] & (1 << k));
-          regrouped++;
+        d_batch_decoder.decode_depunctured(&d_batch[i].ofdm, &d_batch[i].frame, in, n);
+        for(int k = 0; k < n; k++) {
+          frame_tracer::instance().stamp(d_batch[index[k]].trace, frame_tracer::VITERBI);
+        }
+        for(int k = 0; k < n; k++) {
+          rx_frame &f = d_batch[index[k]];
+          pdus[index[k]] = d_decoder.make_pdu(d_batch_decoder.decoded(k),
+              f.ofdm, f.frame, f.snr, f.nom_freq, f.freq_offset, f.trace);
         }
       }
-    }
-
-    void
-    decode_mac_impl::descramble (uint8_t *decoded_bits){
-      int state = 0;
-      std::memset(out_bytes, 0, d_frame.psdu_size+2);
 
-      for(int i = 0; i < 7; i++) {
-        if(decoded_bits[i]) {
-          state |= 1 << (6 - i);
+      // publish in the order of reception
+      for(int i = 0; i < d_batch_count; i++) {
+        if(!pmt::is_null(pdus[i])) {
+          message_port_pub(pmt::mp("out"), pdus[i]);
         }
       }
-      out_bytes[0] = state;
-
-      int feedback;
-      int bit;
+      d_batch_count = 0;
+    }
 
-      for(int i = 7; i < d_frame.psdu_size*8+16; i++) {
-        feedback = ((!!(state & 64))) ^ (!!(state & 8));
-        bit = feedback ^ (decoded_bits[i] & 0x1);
-        out_bytes[i/8] |= bit << (i%8);
-        state = ((state << 1) & 0x7e) | feedback;
+    void
+    decode_mac_impl::gather_bits(uint8_t *depunctured){
+      if(d_soft) {
+        d_decoder.gather_soft(d_rx_llr, d_ofdm, d_frame, depunctured);
+      } else {
+        d_decoder.gather_hard(d_rx_symbols, d_ofdm, d_frame, depunctured);
       }
     }
 
     void
     decode_mac_impl::print_output(){
+      const uint8_t *out_bytes = d_decoder.out_bytes();
       dout << std::endl;
       dout << "psdu size: " << d_frame.psdu_size << std::endl;
       for(int i = 2; i < d_frame.psdu_size+2; i++) {
@@ -25,7 +25,10 @@
 #include <frequencyAdaptiveOFDM/decode_mac.h>
 
 #include "utils.h"
-#include "viterbi_decoder/viterbi_decoder.h"
+#include "psdu_decoder.h"
+#include "viterbi_decoder/viterbi_decoder_batch.h"
+#include "frame_tracer.h"
+#include "counters.h"
 
 
 namespace gr {
@@ -34,29 +37,49 @@ namespace gr {
     class decode_mac_impl : public decode_mac
     {
      private:
+      // depunctured frame waiting for the batch decoder
+      struct rx_frame {
+        rx_frame() : ofdm(std::vector<int>(4, BPSK), P_1_2), frame(ofdm, 0) {}
+
+        ofdm_param ofdm;
+        frame_param frame;
+        std::vector<double> snr;
+        double nom_freq;
+        double freq_offset;
+        uint64_t trace;
+        uint8_t bits[MAX_DEPUNCTURED_BITS + (TRACEBACK_MAX + 1) * 16];
+      };
+
       bool d_debug;
       bool d_log;
       bool d_debug_rx_err;
+      bool d_soft;
+      int d_item_size;
 
       frame_param d_frame;
       ofdm_param d_ofdm;
       std::vector<double> d_snr;  // dB
       double d_nom_freq;  // nominal frequency, Hz
       double d_freq_offset;  // frequency offset, Hz
-      viterbi_decoder d_decoder;
+      uint64_t d_trace;  // frame_tracer id
+      psdu_decoder d_decoder;
+      viterbi_decoder_batch d_batch_decoder;
+
+      int d_batch_size;
+      int d_batch_count;
+      rx_frame d_batch[viterbi_decoder_batch::MAX_BATCH];
 
       uint8_t d_rx_symbols[48 * MAX_SYM];
-      uint8_t d_rx_bits[MAX_ENCODED_BITS];
-      uint8_t d_deinterleaved_bits[MAX_ENCODED_BITS];
-      uint8_t out_bytes[MAX_PSDU_SIZE + 2]; // 2 for signal field
+      int8_t d_rx_llr[SOFT_SYMBOL_SIZE * MAX_SYM];
+      // Viterbi input and the flush behind it
+      uint8_t d_depunctured[MAX_DEPUNCTURED_BITS + (TRACEBACK_MAX + 1) * 16];
 
       int copied;
       bool d_frame_complete;
 
-      int nSinq;
-
      public:
-      decode_mac_impl(bool log, bool debug, bool debug_rx_err);
+      decode_mac_impl(bool log, bool debug, bool debug_rx_err, bool soft, int batch_size,
+                      int windows);
       ~decode_mac_impl();
 
       int general_work(int noutput_items,
@@ -64,9 +87,10 @@ namespace gr {
            gr_vector_const_void_star &input_items,
            gr_vector_void_star &output_items);
 
-      void regroup_symbols();
+      void gather_bits(uint8_t *depunctured);
       void decode();
-      void descramble (uint8_t *decoded_bits);
+      void queue_frame();
+      void decode_batch();
       void print_output();
     };
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "demapper.h"
+#include "demapper_avx2.h"
+#include "utils.h"
+#include <cmath>
+
+namespace {
+
+const bool demap_soft_avx2_supported = cpu_supports(CPU_AVX2);
+
+inline float
+copysign_of(float value, float x) {
+	return x < 0 ? -value : value;
+}
+
+// LLRs of one axis of a PAM with points at +-l, +-3l, ... without the
+// csi, returns the number of bits
+inline int
+axis_llr(int encoding, float x, float l, float *llr) {
+	float a = std::abs(x);
+	switch(encoding) {
+	case BPSK:
+	case QPSK:
+		llr[0] = 4 * l * x;
+		return 1;
+	case QAM16:
+		llr[0] = 4 * l * (x + copysign_of(std::max(a - 2 * l, 0.0f), x));
+		llr[1] = 4 * l * (2 * l - a);
+		return 2;
+	default:
+		llr[0] = 4 * l * (x + copysign_of(std::max(a - 2 * l, 0.0f)
+				+ std::max(a - 4 * l, 0.0f) + std::max(a - 6 * l, 0.0f), x));
+		llr[1] = 4 * l * (4 * l - a + std::max(2 * l - a, 0.0f) - std::max(a - 6 * l, 0.0f));
+		llr[2] = 4 * l * (2 * l - std::abs(a - 4 * l));
+		return 3;
+	}
+}
+
+} // namespace
+
+// sqrt(0.5), sqrt(0.1) and sqrt(1/42) as constants, the table is ready
+// before any static initializer
+const float PAM_LEVEL[4] = { 1.0f, 0.70710678f, 0.31622777f, 0.15430335f };
+
+int
+demap_bits(int encoding) {
+	static const int BITS[4] = { 1, 2, 4, 6 };
+	return BITS[encoding & 3];
+}
+
+void
+demap_soft_generic(int encoding, const gr_complex *symbols, const float *csi,
+		float *llr, int n) {
+	encoding &= 3;
+	const float l = PAM_LEVEL[encoding];
+	const int bits = demap_bits(encoding);
+
+	for(int i = 0; i < n; i++) {
+		int k = axis_llr(encoding, symbols[i].real(), l, llr);
+		if(encoding != BPSK) {
+			axis_llr(encoding, symbols[i].imag(), l, llr + k);
+		}
+		if(csi) {
+			for(int b = 0; b < bits; b++) {
+				llr[b] *= csi[i];
+			}
+		}
+		llr += bits;
+	}
+}
+
+void
+demap_soft(int encoding, const gr_complex *symbols, const float *csi,
+		float *llr, int n) {
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	if(demap_soft_avx2_supported) {
+		int done = demap_soft_avx2(demap_bits(encoding), PAM_LEVEL[encoding & 3],
+				(const float *) symbols, csi, llr, n);
+		symbols += done;
+		csi = csi ? csi + done : NULL;
+		llr += done * demap_bits(encoding);
+		n -= done;
+	}
+#endif
+	demap_soft_generic(encoding, symbols, csi, llr, n);
+}
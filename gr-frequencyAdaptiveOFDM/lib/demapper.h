@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_DEMAPPER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_DEMAPPER_H
+
+#include <gnuradio/gr_complex.h>
+
+/**
+ * Max-log LLRs of the Gray mapped square constellations of the
+ * constellation blocks. Each axis of 16QAM and 64QAM is a PAM whose
+ * LLRs are piecewise linear in the sample, so they are computed in
+ * closed form instead of searching the closest point with a 0 and a 1
+ * for every bit. The LLR of a bit is (d0^2 - d1^2) * csi, with d0 and d1
+ * the distances to these points, so a positive value favours a 1.
+ *
+ * encoding is BPSK, QPSK, QAM16 or QAM64. Each symbol gets the bits of
+ * decision_maker() in the same order, the sign and the magnitude bits of
+ * the real part followed by the ones of the imaginary part (1, 2, 4 or
+ * 6 per symbol). csi is |H|^2 / noise variance per symbol, NULL weights
+ * all symbols with 1.
+ *
+ * On x86 there is an AVX2 kernel, see demapper_avx2.h. It is picked at
+ * runtime if the CPU supports it.
+ */
+void demap_soft(int encoding, const gr_complex *symbols, const float *csi,
+		float *llr, int n);
+
+void demap_soft_generic(int encoding, const gr_complex *symbols,
+		const float *csi, float *llr, int n);
+
+// LLRs per symbol of an encoding
+int demap_bits(int encoding);
+
+// half the distance between two points of an axis, by encoding
+extern const float PAM_LEVEL[4];
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_DEMAPPER_H */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * AVX2 kernel of demap_soft(), eight symbols at a time. The real and
+ * imaginary parts are split into two registers, the LLRs of each bit are
+ * computed for all eight and then interleaved into the output order.
+ * bits is 1, 2, 4 or 6 for BPSK, QPSK, 16QAM and 64QAM.
+ */
+#include "demapper_avx2.h"
+#include <immintrin.h>
+
+namespace {
+
+inline __m256
+abs8(__m256 x) {
+	return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+}
+
+// value with the sign of x, value is not negative
+inline __m256
+copysign8(__m256 value, __m256 x) {
+	return _mm256_or_ps(value, _mm256_and_ps(x, _mm256_set1_ps(-0.0f)));
+}
+
+// LLRs of one axis, see axis_llr() in demapper.cc
+inline int
+axis8(int bits, __m256 x, __m256 l, __m256 *llr) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 two = _mm256_set1_ps(2);
+	const __m256 four = _mm256_set1_ps(4);
+	const __m256 six = _mm256_set1_ps(6);
+	__m256 scale = _mm256_mul_ps(four, l);
+	__m256 a = abs8(x);
+
+	if(bits <= 2) {
+		llr[0] = _mm256_mul_ps(scale, x);
+		return 1;
+	}
+
+	__m256 l2 = _mm256_mul_ps(two, l);
+	__m256 above2 = _mm256_max_ps(_mm256_sub_ps(a, l2), zero);
+	if(bits == 4) {
+		llr[0] = _mm256_mul_ps(scale, _mm256_add_ps(x, copysign8(above2, x)));
+		llr[1] = _mm256_mul_ps(scale, _mm256_sub_ps(l2, a));
+		return 2;
+	}
+
+	__m256 l4 = _mm256_mul_ps(four, l);
+	__m256 l6 = _mm256_mul_ps(six, l);
+	__m256 above4 = _mm256_max_ps(_mm256_sub_ps(a, l4), zero);
+	__m256 above6 = _mm256_max_ps(_mm256_sub_ps(a, l6), zero);
+	__m256 below2 = _mm256_max_ps(_mm256_sub_ps(l2, a), zero);
+	__m256 outer = _mm256_add_ps(_mm256_add_ps(above2, above4), above6);
+	llr[0] = _mm256_mul_ps(scale, _mm256_add_ps(x, copysign8(outer, x)));
+	llr[1] = _mm256_mul_ps(scale, _mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(l4, a), below2), above6));
+	llr[2] = _mm256_mul_ps(scale, _mm256_sub_ps(l2, abs8(_mm256_sub_ps(a, l4))));
+	return 3;
+}
+
+} // namespace
+
+int
+demap_soft_avx2(int bits, float level, const float *symbols, const float *csi,
+		float *llr, int n) {
+	const __m256 l = _mm256_set1_ps(level);
+	const float *in = symbols;
+
+	int i = 0;
+	for(; i + 8 <= n; i += 8) {
+		// r0 i0 r1 i1 r2 i2 r3 i3 and r4 i4 ... r7 i7
+		__m256 v0 = _mm256_loadu_ps(in + 2 * i);
+		__m256 v1 = _mm256_loadu_ps(in + 2 * i + 8);
+		// r0 r1 r4 r5 r2 r3 r6 r7 -> r0 ... r7
+		__m256 re = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+		__m256 im = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+		re = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(re), _MM_SHUFFLE(3, 1, 2, 0)));
+		im = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(im), _MM_SHUFFLE(3, 1, 2, 0)));
+
+		__m256 planes[6];
+		int k = axis8(bits, re, l, planes);
+		if(bits > 1) {
+			axis8(bits, im, l, planes + k);
+		}
+		if(csi) {
+			__m256 w = _mm256_loadu_ps(csi + i);
+			for(int b = 0; b < bits; b++) {
+				planes[b] = _mm256_mul_ps(planes[b], w);
+			}
+		}
+
+		// bit b of symbol s goes to llr[s * bits + b]
+		float out[6][8] __attribute__ ((aligned(32)));
+		for(int b = 0; b < bits; b++) {
+			_mm256_store_ps(out[b], planes[b]);
+		}
+		for(int s = 0; s < 8; s++) {
+			for(int b = 0; b < bits; b++) {
+				*llr++ = out[b][s];
+			}
+		}
+	}
+	return i;
+}
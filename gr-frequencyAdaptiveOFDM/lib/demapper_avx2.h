@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_DEMAPPER_AVX2_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_DEMAPPER_AVX2_H
+
+/**
+ * AVX2 kernel of demap_soft() in demapper.h, built with -mavx2 in
+ * demapper_avx2.cc, only call it if the CPU supports AVX2. The symbols
+ * are pairs of real and imaginary part, bits is demap_bits() and level
+ * PAM_LEVEL of the encoding. It demaps eight symbols at a time and
+ * returns the number of symbols done, the rest is left to the caller.
+ */
+int demap_soft_avx2(int bits, float level, const float *symbols,
+		const float *csi, float *llr, int n);
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_DEMAPPER_AVX2_H */
@@ -0,0 +1,252 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016   Samuel Rey <samuel.rey.escudero@gmail.com>
+ *                  Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "equalize_and_decode_impl.h"
+#include "equalizer/sta.h"
+#include <gnuradio/io_signature.h>
+#include <boost/bind.hpp>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    equalize_and_decode::sptr
+    equalize_and_decode::make(Equalizer algo, double freq, double bw, bool log,
+                    bool debug, bool debug_parity, bool debug_rx_err, bool soft,
+                    int windows, int threads) {
+      return gnuradio::get_initial_sptr
+        (new equalize_and_decode_impl(algo, freq, bw, log, debug, debug_parity,
+                                      debug_rx_err, soft, windows, threads));
+    }
+
+    equalize_and_decode_impl::equalize_and_decode_impl(Equalizer algo, double freq,
+                    double bw, bool log, bool debug, bool debug_parity,
+                    bool debug_rx_err, bool soft, int windows, int threads) :
+      gr::block("equalize_and_decode",
+          gr::io_signature::make(1, 1, 64 * sizeof(gr_complex)),
+          gr::io_signature::make(0, 0, 0)),
+      d_decoder(algo, freq, bw, log, debug, debug_parity, debug_rx_err, soft, windows),
+      d_engine(NULL),
+      d_job(NULL),
+      d_tap_enabled(false),
+      d_algo(algo), d_freq(freq), d_bw(bw),
+      d_sta_alpha(equalizer::sta::DEFAULT_ALPHA),
+      d_sta_beta(equalizer::sta::DEFAULT_BETA),
+      d_debug(debug), d_debug_rx_err(debug_rx_err) {
+
+      if(threads < 0) {
+        throw std::invalid_argument("EQUALIZE_AND_DECODE: number of threads can not be negative");
+      }
+      if(threads > 0) {
+        d_engine = new rx_engine(threads,
+            boost::bind(&equalize_and_decode_impl::deliver, this, _1),
+            algo, freq, bw, log, debug, debug_parity, debug_rx_err, soft, windows);
+      }
+
+      message_port_register_out(pmt::mp("out"));
+      message_port_register_out(pmt::mp("symbols"));
+
+      frame_tracer::instance().attach();
+      counters::instance().attach();
+      logger::instance().attach();
+    }
+
+    equalize_and_decode_impl::~equalize_and_decode_impl() {
+      delete d_engine;
+      logger::instance().detach();
+      counters::instance().detach();
+      frame_tracer::instance().detach();
+    }
+
+    void
+    equalize_and_decode_impl::set_algorithm(Equalizer algo) {
+      gr::thread::scoped_lock lock(d_mutex);
+      d_decoder.set_algorithm(algo);
+      d_algo = algo;
+    }
+
+    void
+    equalize_and_decode_impl::set_bandwidth(double bw) {
+      gr::thread::scoped_lock lock(d_mutex);
+      d_decoder.set_bandwidth(bw);
+      d_bw = bw;
+    }
+
+    void
+    equalize_and_decode_impl::set_frequency(double freq) {
+      gr::thread::scoped_lock lock(d_mutex);
+      d_decoder.set_frequency(freq);
+      d_freq = freq;
+    }
+
+    void
+    equalize_and_decode_impl::set_sta_smoothing(double alpha, int beta) {
+      gr::thread::scoped_lock lock(d_mutex);
+      d_decoder.set_sta_smoothing(alpha, beta);
+      d_sta_alpha = alpha;
+      d_sta_beta = beta;
+    }
+
+    void
+    equalize_and_decode_impl::set_constellation_tap(int decimation, int period) {
+      gr::thread::scoped_lock lock(d_tap_mutex);
+      d_tap.set_rate(decimation, period);
+    }
+
+    int
+    equalize_and_decode_impl::general_work (int noutput_items,
+        gr_vector_int &ninput_items,
+        gr_vector_const_void_star &input_items,
+        gr_vector_void_star &output_items) {
+
+      gr::thread::scoped_lock lock(d_mutex);
+
+      const gr_complex *in = (const gr_complex *) input_items[0];
+
+      if(d_engine) {
+        work_threaded(ninput_items[0], in);
+      } else {
+        work_inline(ninput_items[0], in);
+      }
+      consume(0, ninput_items[0]);
+      return 0;
+    }
+
+    void
+    equalize_and_decode_impl::work_inline(int ninput, const gr_complex *in) {
+      gr_complex symbols[48];
+
+      for(int i = 0; i < ninput; i++) {
+        get_tags_in_window(tags, 0, i, i + 1, pmt::string_to_symbol("wifi_start"));
+
+        // new frame
+        if(tags.size()) {
+          counters::instance().add(counters::FRAMES_DETECTED);
+          if(d_decoder.frame_valid()) {
+            counters::instance().add(counters::SYNC_LOSSES);
+            if(d_debug || d_debug_rx_err) {
+              lout(WARN) << "EQUALIZE_AND_DECODE: starting to receive new frame before old frame was complete" << std::endl;
+            }
+          }
+          d_decoder.new_frame(pmt::to_double(tags.front().value),
+              frame_tracer::instance().new_frame());
+          d_tap_enabled = !pmt::is_null(message_subscribers(pmt::mp("symbols")));
+        }
+
+        frame_decoder::symbol_type type = d_decoder.push(in + i * 64, symbols);
+        if(d_tap_enabled && (type == frame_decoder::DATA || type == frame_decoder::LAST)) {
+          tap(symbols, d_decoder.frame_encoding());
+        }
+        if(type == frame_decoder::LAST) {
+          dout << "received complete frame - decoding" << std::endl;
+          pmt::pmt_t pdu = d_decoder.decode();
+          if(!pmt::is_null(pdu)) {
+            message_port_pub(pmt::mp("out"), pdu);
+          }
+        }
+      }
+    }
+
+    void
+    equalize_and_decode_impl::work_threaded(int ninput, const gr_complex *in) {
+      gr_complex symbols[48];
+
+      for(int i = 0; i < ninput; i++) {
+        get_tags_in_window(tags, 0, i, i + 1, pmt::string_to_symbol("wifi_start"));
+
+        // new frame
+        if(tags.size()) {
+          counters::instance().add(counters::FRAMES_DETECTED);
+          if(d_job) {
+            counters::instance().add(counters::SYNC_LOSSES);
+            if(d_debug || d_debug_rx_err) {
+              lout(WARN) << "EQUALIZE_AND_DECODE: starting to receive new frame before old frame was complete" << std::endl;
+            }
+            d_engine->release(d_job);
+          }
+          double cfo = pmt::to_double(tags.front().value);
+          uint64_t trace = frame_tracer::instance().new_frame();
+          // the workers trace the frame, this one only looks for its end
+          d_decoder.new_frame(cfo);
+
+          // waits if the threads are behind
+          d_job = d_engine->acquire();
+          d_job->algo = d_algo;
+          d_job->freq = d_freq;
+          d_job->bw = d_bw;
+          d_job->sta_alpha = d_sta_alpha;
+          d_job->sta_beta = d_sta_beta;
+          d_job->cfo = cfo;
+          d_job->trace = trace;
+          d_job->tap = !pmt::is_null(message_subscribers(pmt::mp("symbols")));
+        }
+
+        // not interesting -> skip
+        if(!d_job) {
+          continue;
+        }
+
+        d_job->samples.insert(d_job->samples.end(), in + i * 64, in + (i + 1) * 64);
+        d_job->n_symbols++;
+
+        // the signal field tells where the frame ends
+        if(d_job->n_symbols <= 4) {
+          d_decoder.push(in + i * 64, symbols);
+          if(d_job->n_symbols == 4 && !d_decoder.frame_valid()) {
+            d_engine->release(d_job);
+            d_job = NULL;
+          }
+          continue;
+        }
+
+        if(d_job->n_symbols == 4 + d_decoder.symbols()) {
+          dout << "received complete frame - decoding" << std::endl;
+          d_job->encoding = d_decoder.frame_encoding();
+          d_engine->submit(d_job);
+          d_job = NULL;
+        }
+      }
+    }
+
+    void
+    equalize_and_decode_impl::deliver(rx_job &job) {
+      for(size_t s = 0; s < job.symbols.size(); s += 48) {
+        tap(&job.symbols[s], job.encoding);
+      }
+      if(!pmt::is_null(job.pdu)) {
+        message_port_pub(pmt::mp("out"), job.pdu);
+      }
+    }
+
+    void
+    equalize_and_decode_impl::tap(const gr_complex *symbols,
+                                  const std::vector<int> &encoding) {
+      gr::thread::scoped_lock lock(d_tap_mutex);
+      if(d_tap.add(symbols, encoding)) {
+        message_port_pub(pmt::mp("symbols"), d_tap.snapshot());
+      }
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
@@ -0,0 +1,89 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016   Samuel Rey <samuel.rey.escudero@gmail.com>
+ *                  Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZE_AND_DECODE_IMPL_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZE_AND_DECODE_IMPL_H
+
+#include <frequencyAdaptiveOFDM/equalize_and_decode.h>
+#include "frame_decoder.h"
+#include "rx_engine.h"
+#include "constellation_tap.h"
+#include "frame_tracer.h"
+#include "counters.h"
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    class equalize_and_decode_impl : public equalize_and_decode
+    {
+     public:
+      equalize_and_decode_impl(Equalizer algo, double freq, double bw, bool log,
+                    bool debug, bool debug_parity, bool debug_rx_err, bool soft,
+                    int windows, int threads);
+      ~equalize_and_decode_impl();
+
+      void set_algorithm(Equalizer algo);
+      void set_bandwidth(double bw);
+      void set_frequency(double freq);
+      void set_sta_smoothing(double alpha, int beta);
+      void set_constellation_tap(int decimation, int period);
+
+      int general_work(int noutput_items,
+           gr_vector_int &ninput_items,
+           gr_vector_const_void_star &input_items,
+           gr_vector_void_star &output_items);
+
+    private:
+      void work_inline(int ninput, const gr_complex *in);
+      void work_threaded(int ninput, const gr_complex *in);
+      void deliver(rx_job &job);
+      void tap(const gr_complex *symbols, const std::vector<int> &encoding);
+
+      // receives the frames in work_inline(), with the rx_engine it only
+      // decodes the signal field to find the end of the frame
+      frame_decoder d_decoder;
+      rx_engine *d_engine;
+      // frame that is collected for the rx_engine
+      rx_job *d_job;
+
+      gr::thread::mutex d_mutex;
+      std::vector<gr::tag_t> tags;
+
+      // telemetry of the "symbols" port, only fed if it has subscribers.
+      // The rx_engine delivers on its threads, so it has its own mutex.
+      constellation_tap d_tap;
+      bool d_tap_enabled;
+      gr::thread::mutex d_tap_mutex;
+
+      Equalizer d_algo;
+      double d_freq;  // Hz
+      double d_bw;  // Hz
+      double d_sta_alpha;
+      int d_sta_beta;
+      bool d_debug;
+      bool d_debug_rx_err;
+    };
+
+  } // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZE_AND_DECODE_IMPL_H */
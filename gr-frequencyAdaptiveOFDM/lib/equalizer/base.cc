@@ -16,70 +16,210 @@
  */
 
 #include "base.h"
+#include "kernels.h"
+#include "utils.h"
+#include "demapper.h"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 
 using namespace gr::frequencyAdaptiveOFDM::equalizer;
 
-std::vector<double>
-base::resource_blocks_snr() {
-	return d_resource_block_snr;
+namespace {
+
+const bool equalizer_avx2_supported = cpu_supports(CPU_AVX2);
+
+} // namespace
+
+base::base() :
+	d_keep_frame_errors(false), d_ltf_valid(false), d_frame_accepted(false) {
+	set_encoding(std::vector<int>(4, BPSK));
 }
 
-std::vector<double>
-base::min_rb_snr(){
-	return d_min_rb_snr;
+void
+base::new_frame() {
+	d_ltf_valid = false;
+	d_frame_accepted = false;
+	d_frame_errors.clear();
 }
 
-int
-base::rb_index_from_carrier(int n_carrier) {
-	if ((n_carrier == 32) || (n_carrier < 6) || (n_carrier > 58)){
-		return -1;
-	} else if (n_carrier < 19) {
-		return 0;
-	} else if (n_carrier < 32) {
-		return 1;
-	} else if (n_carrier < 46) {
-		return 2;
-	} else if (n_carrier < 59) {
-		return 3;
+void
+base::accept_frame() {
+	if(d_ltf_valid) {
+		d_stats.add(d_ltf_error);
+		if(d_keep_frame_errors) {
+			d_frame_errors.insert(d_frame_errors.end(), d_ltf_error, d_ltf_error + 48);
+		}
 	}
+	d_ltf_valid = false;
+	d_frame_accepted = true;
 }
 
 void
-base::estimate_channel_state(gr_complex *in) {
-	std::vector<double> rb_signal = std::vector<double>(4,0);
-	std::vector<double> rb_noise = std::vector<double>(4,0);
-	double signal, noise, carrier_snr = 0;
-	int index;
+base::set_encoding(const std::vector<int> &encoding) {
+	static const slice_fn SLICE[4] = {
+		slice<BPSK>, slice<QPSK>, slice<QAM16>, slice<QAM64> };
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	static const slice_fn SLICE_AVX2[4] = {
+		slice_bpsk_avx2, slice_qpsk_avx2, slice_qam16_avx2, slice_qam64_avx2 };
+#endif
+	static const points_fn POINTS[4] = {
+		points<BPSK>, points<QPSK>, points<QAM16>, points<QAM64> };
 
-	d_resource_block_snr = std::vector<double>(4,0);
-	d_min_rb_snr = std::vector<double>(4,1000);
+	for(int r = 0; r < 4; r++) {
+		int enc = encoding[r] & 3;
+		d_slice[r] = SLICE[enc];
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+		if(equalizer_avx2_supported) {
+			d_slice[r] = SLICE_AVX2[enc];
+		}
+#endif
+		d_points[r] = POINTS[enc];
+	}
+}
 
-	for(int i = 0; i < 64; i++) {
-		index = rb_index_from_carrier(i);
-		if (index == -1){
-			continue;
-		} else if (index < -1) {
-			throw std::runtime_error("wrong index");
+void
+base::invert_channel() {
+	for(int c = 0; c < 48; c++) {
+		gr_complex h = d_H[DATA_CARRIERS[c]];
+		float n = std::norm(h);
+		d_csi[c] = n;
+		d_inv_re[c] = h.real() / n;
+		d_inv_im[c] = -h.imag() / n;
+	}
+}
+
+void
+base::equalize_data(const gr_complex *in, gr_complex *symbols, uint8_t *bits) {
+	for(int c = 0; c < 48; c++) {
+		d_x_re[c] = in[DATA_CARRIERS[c]].real();
+		d_x_im[c] = in[DATA_CARRIERS[c]].imag();
+	}
+
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	if(equalizer_avx2_supported) {
+		multiply_avx2(d_x_re, d_x_im, d_inv_re, d_inv_im, d_y_re, d_y_im);
+		for(int r = 0; r < 4; r++) {
+			d_slice[r](d_y_re + 12 * r, d_y_im + 12 * r, bits + 12 * r, 12);
+		}
+		interleave_avx2(d_y_re, d_y_im, (float *) symbols);
+	} else
+#endif
+	{
+		for(int c = 0; c < 48; c++) {
+			d_y_re[c] = d_x_re[c] * d_inv_re[c] - d_x_im[c] * d_inv_im[c];
+			d_y_im[c] = d_x_re[c] * d_inv_im[c] + d_x_im[c] * d_inv_re[c];
+		}
+		for(int r = 0; r < 4; r++) {
+			d_slice[r](d_y_re + 12 * r, d_y_im + 12 * r, bits + 12 * r, 12);
 		}
+		for(int c = 0; c < 48; c++) {
+			symbols[c] = gr_complex(d_y_re[c], d_y_im[c]);
+		}
+	}
+
+	for(int r = 0; r < 4; r++) {
+		d_points[r](bits + 12 * r, d_decisions + 12 * r, 12);
+	}
+	if(d_frame_accepted) {
+		float error[48];
+		carrier_stats::error_power(symbols, d_decisions, error);
+		d_stats.add(error);
+		if(d_keep_frame_errors) {
+			d_frame_errors.insert(d_frame_errors.end(), error, error + 48);
+		}
+	}
+}
 
-		noise = std::pow(std::abs(d_H[i] - in[i]), 2);
-		signal = std::pow(std::abs(d_H[i] + in[i]), 2);
-		carrier_snr = signal / noise / 2;
-		if (carrier_snr <= d_min_rb_snr[index]){
-			d_min_rb_snr[index] = carrier_snr;
+const double base::NO_ESTIMATE = 42;
+
+std::vector<double>
+base::rb_snr() const {
+	std::vector<double> snr(4, NO_ESTIMATE);
+	if(d_stats.count()) {
+		d_stats.rb_snr(&snr[0]);
+	}
+	return snr;
+}
+
+const carrier_stats&
+base::statistics() const {
+	return d_stats;
+}
+
+const std::vector<float>&
+base::frame_errors() const {
+	return d_frame_errors;
+}
+
+void
+base::set_keep_frame_errors(bool keep) {
+	d_keep_frame_errors = keep;
+	d_frame_errors.clear();
+}
+
+static inline int8_t
+quantize_llr(float llr) {
+	if(llr > 127) {
+		return 127;
+	} else if(llr < -127) {
+		return -127;
+	}
+	return (int8_t) (llr + (llr > 0 ? 0.5f : -0.5f));
+}
+
+void
+base::soft_bits(const gr_complex *symbols, const std::vector<int> &encoding, int8_t *llr) {
+	// the densest constellation of the frame sets the scale, so that its
+	// points are SOFT_SCALE away from the decision thresholds. demap_soft()
+	// gives 4 level^2 csi there.
+	float min_level = 1;
+	for(int r = 0; r < 4; r++) {
+		min_level = std::min(min_level, PAM_LEVEL[encoding[r]]);
+	}
+
+	float mean_csi = 0;
+	for(int c = 0; c < 48; c++) {
+		mean_csi += d_csi[c];
+	}
+	mean_csi /= 48;
+	if(mean_csi <= 0) {
+		mean_csi = 1;
+	}
+	float scale = SOFT_SCALE / (4 * min_level * min_level * mean_csi);
+
+	std::memset(llr, 0, SOFT_SYMBOL_SIZE);
+	float bits[12 * MAX_BITS_PER_CARRIER];
+	for(int r = 0; r < 4; r++) {
+		int enc = encoding[r];
+		int n = demap_bits(enc);
+		demap_soft(enc, symbols + 12 * r, d_csi + 12 * r, bits, 12);
+		for(int c = 0; c < 12; c++) {
+			for(int k = 0; k < n; k++) {
+				llr[(12 * r + c) * MAX_BITS_PER_CARRIER + k] = quantize_llr(bits[c * n + k] * scale);
+			}
 		}
+	}
+}
 
-		rb_noise[index] += noise;
-		rb_signal[index] += signal;
-		d_H[i] += in[i];
-		d_H[i] /= LONG[i] * gr_complex(2, 0);
+void
+base::estimate_channel_state(gr_complex *in) {
+	// d_H is the first copy, the carriers of both copies are x * H + n
+	for(int c = 0; c < 48; c++) {
+		int i = DATA_CARRIERS[c];
+		float noise = std::norm(d_H[i] - in[i]);
+		float signal = std::norm(d_H[i] + in[i]);
+		// noise / signal is 2 var(n) / 4 |H|^2, the error power of the
+		// equalized carrier is var(n) / |H|^2
+		d_ltf_error[c] = 2 * noise / signal;
 	}
+	d_ltf_valid = true;
 
-	for (int i = 0; i < d_resource_block_snr.size(); i++) {
-		d_resource_block_snr[i] = 10 * std::log10(rb_signal[i] / rb_noise[i] / 2);
-		d_min_rb_snr[i] = 10 * std::log10(d_min_rb_snr[i]);
+	for(int i = 0; i < 64; i++) {
+		if(LONG[i] != gr_complex(0, 0)) {
+			d_H[i] = (d_H[i] + in[i]) / (LONG[i] * gr_complex(2, 0));
+		}
 	}
 }
 
@@ -93,6 +233,13 @@ const gr_complex base::LONG[] = {
 	 0,  0,  0,  0
 };
 
+const int base::DATA_CARRIERS[48] = {
+	 6,  7,  8,  9, 10, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 26, 27, 28, 29, 30, 31,
+	33, 34, 35, 36, 37, 38, 40, 41, 42, 43, 44, 45,
+	46, 47, 48, 49, 50, 51, 52, 54, 55, 56, 57, 58
+};
+
 const gr_complex base::POLARITY[127] = {
 	 1, 1, 1, 1,-1,-1,-1, 1,-1,-1,-1,-1, 1, 1,-1, 1,
 	-1,-1, 1, 1,-1, 1, 1,-1, 1, 1, 1, 1, 1, 1,-1, 1,
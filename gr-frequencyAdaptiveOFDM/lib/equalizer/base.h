@@ -19,8 +19,10 @@
 #ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_BASE_H
 #define INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_BASE_H
 
+#include "carrier_stats.h"
+#include "slicer.h"
 #include <gnuradio/gr_complex.h>
-#include <gnuradio/digital/constellation.h>
+#include <vector>
 
 namespace gr {
 namespace frequencyAdaptiveOFDM {
@@ -28,23 +30,86 @@ namespace equalizer {
 
 class base {
 public:
+	base();
 	virtual ~base() {};
-	virtual void equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, boost::shared_ptr<gr::digital::constellation> mod[4]) = 0;
+	virtual void equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits) = 0;
 
-	std::vector<double> resource_blocks_snr();
-	std::vector<double> min_rb_snr();
+	// modulations of the resource blocks, selects the slicers for the
+	// following symbols
+	void set_encoding(const std::vector<int> &encoding);
+
+	// A frame starts. Its long training sequence and data symbols only
+	// go into the statistics once accept_frame() says that the signal
+	// field is valid, so false detections do not spoil them.
+	void new_frame();
+	void accept_frame();
+
+	// effective SNR (dB) of the resource blocks from the running
+	// statistics of the carriers, NO_ESTIMATE before the first symbol
+	std::vector<double> rb_snr() const;
+	const carrier_stats& statistics() const;
+	static const double NO_ESTIMATE;
+	// error powers the current frame added to the statistics, 48 per
+	// symbol starting with the long training sequence. They are only
+	// kept after set_keep_frame_errors(true), empty otherwise.
+	const std::vector<float>& frame_errors() const;
+	void set_keep_frame_errors(bool keep);
+
+	// Max-log LLRs of the last equalized symbols from demap_soft(),
+	// quantized to 8 bit. Every carrier gets MAX_BITS_PER_CARRIER slots,
+	// slot k is bit k of the constellation index and a positive value
+	// favours a 1. The LLRs are weighted with the channel state of the
+	// carrier and unused slots are set to 0.
+	void soft_bits(const gr_complex *symbols, const std::vector<int> &encoding, int8_t *llr);
 
 	static const gr_complex POLARITY[127];
+	static const gr_complex LONG[64];
+	// the 48 data carriers in the order of the symbols, 12 per resource
+	// block
+	static const int DATA_CARRIERS[48];
 
 protected:
-	static const gr_complex LONG[64];
-	
-	std::vector<double> d_resource_block_snr;
-	std::vector<double> d_min_rb_snr;
 	gr_complex d_H[64];
+	// |H|^2 of the 48 data carriers used to equalize the last symbol
+	float d_csi[48];
+	// constellation points of the hard decisions of the last symbol
+	gr_complex d_decisions[48];
 
-	int rb_index_from_carrier(int n_carrier);
+	// channel estimate from the two copies of the long training
+	// sequence, their difference is the noise of the frame
 	void estimate_channel_state(gr_complex *in);
+
+	// 1/H and |H|^2 of the data carriers from d_H
+	void invert_channel();
+	// symbols = in / H for the data carriers, their hard decisions and
+	// the constellation points of them in d_decisions. The decision
+	// errors go into the statistics if the frame was accepted.
+	void equalize_data(const gr_complex *in, gr_complex *symbols, uint8_t *bits);
+	// a / b without the inf and nan handling of the complex division
+	static inline gr_complex divide(gr_complex a, gr_complex b) {
+		return a * std::conj(b) / std::norm(b);
+	}
+
+private:
+	// data carriers as real and imaginary parts, the received symbol x,
+	// 1/H and the equalized symbol y
+	float d_x_re[48];
+	float d_x_im[48];
+	float d_inv_re[48];
+	float d_inv_im[48];
+	float d_y_re[48];
+	float d_y_im[48];
+
+	slice_fn d_slice[4];
+	points_fn d_points[4];
+
+	carrier_stats d_stats;
+	// error power of the long training sequence of the current frame
+	float d_ltf_error[48];
+	std::vector<float> d_frame_errors;
+	bool d_keep_frame_errors;
+	bool d_ltf_valid;
+	bool d_frame_accepted;
 };
 
 } /* namespace channel_estimation */
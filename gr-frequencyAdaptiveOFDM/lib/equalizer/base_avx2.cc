@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2015 Samuel Rey <samuel.rey.escudero@gmail.com>
+ *						Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * AVX2 kernels of the equalizers, eight carriers per register. The
+ * decisions are the ones of slicer.h, a template argument is the number
+ * of bits per carrier.
+ */
+#include "kernels.h"
+#include <immintrin.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+namespace equalizer {
+
+namespace {
+
+// sqrt of the SSE unit, rounds like std::sqrt(float)
+static inline float
+level(float square) {
+	return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(square)));
+}
+
+// bit if the mask is set
+static inline __m256i
+bit(__m256 mask, int value) {
+	return _mm256_and_si256(_mm256_castps_si256(mask), _mm256_set1_epi32(value));
+}
+
+static inline __m256
+abs8(__m256 x) {
+	return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+}
+
+template<int BITS> inline __m256i
+decide8(__m256 re, __m256 im);
+
+template<> inline __m256i
+decide8<1>(__m256 re, __m256) {
+	const __m256 zero = _mm256_setzero_ps();
+	return bit(_mm256_cmp_ps(re, zero, _CMP_GT_OQ), 1);
+}
+
+template<> inline __m256i
+decide8<2>(__m256 re, __m256 im) {
+	const __m256 zero = _mm256_setzero_ps();
+	return _mm256_or_si256(bit(_mm256_cmp_ps(re, zero, _CMP_GT_OQ), 1),
+			bit(_mm256_cmp_ps(im, zero, _CMP_GT_OQ), 2));
+}
+
+template<> inline __m256i
+decide8<4>(__m256 re, __m256 im) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 t2 = _mm256_set1_ps(2 * level(float(0.1)));
+	__m256i r = bit(_mm256_cmp_ps(re, zero, _CMP_GT_OQ), 1);
+	r = _mm256_or_si256(r, bit(_mm256_cmp_ps(abs8(re), t2, _CMP_LT_OQ), 2));
+	r = _mm256_or_si256(r, bit(_mm256_cmp_ps(im, zero, _CMP_GT_OQ), 4));
+	return _mm256_or_si256(r, bit(_mm256_cmp_ps(abs8(im), t2, _CMP_LT_OQ), 8));
+}
+
+// sign and the two magnitude bits of one axis of 64QAM
+static inline __m256i
+qam64_axis(__m256 x, int shift) {
+	const float l = level(float(1/42.0));
+	const __m256 t2 = _mm256_set1_ps(2 * l);
+	const __m256 t4 = _mm256_set1_ps(4 * l);
+	const __m256 t6 = _mm256_set1_ps(6 * l);
+	__m256 a = abs8(x);
+	__m256i r = bit(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ), 1 << shift);
+	r = _mm256_or_si256(r, bit(_mm256_cmp_ps(a, t4, _CMP_LT_OQ), 2 << shift));
+	return _mm256_or_si256(r, bit(_mm256_and_ps(_mm256_cmp_ps(a, t6, _CMP_LT_OQ),
+			_mm256_cmp_ps(a, t2, _CMP_GT_OQ)), 4 << shift));
+}
+
+template<> inline __m256i
+decide8<6>(__m256 re, __m256 im) {
+	return _mm256_or_si256(qam64_axis(re, 0), qam64_axis(im, 3));
+}
+
+// the low byte of eight 32 bit values
+static inline void
+store8(__m256i v, uint8_t *out) {
+	__m128i w = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	_mm_storel_epi64((__m128i *) out, _mm_packus_epi16(w, w));
+}
+
+template<int BITS> inline void
+slice(const float *re, const float *im, uint8_t *bits, int n) {
+	int i = 0;
+	for(; i + 8 <= n; i += 8) {
+		store8(decide8<BITS>(_mm256_loadu_ps(re + i), _mm256_loadu_ps(im + i)), bits + i);
+	}
+	if(i == n) {
+		return;
+	}
+	// the rest overlaps with the last full register, a resource block
+	// has 12 carriers, or goes through a register padded with zeros
+	if(n >= 8) {
+		i = n - 8;
+		store8(decide8<BITS>(_mm256_loadu_ps(re + i), _mm256_loadu_ps(im + i)), bits + i);
+		return;
+	}
+	float r[8] = { 0 };
+	float m[8] = { 0 };
+	uint8_t b[8];
+	for(int k = 0; k < n; k++) {
+		r[k] = re[k];
+		m[k] = im[k];
+	}
+	store8(decide8<BITS>(_mm256_loadu_ps(r), _mm256_loadu_ps(m)), b);
+	for(int k = 0; k < n; k++) {
+		bits[k] = b[k];
+	}
+}
+
+} /* namespace */
+
+void
+slice_bpsk_avx2(const float *re, const float *im, uint8_t *bits, int n) {
+	slice<1>(re, im, bits, n);
+}
+
+void
+slice_qpsk_avx2(const float *re, const float *im, uint8_t *bits, int n) {
+	slice<2>(re, im, bits, n);
+}
+
+void
+slice_qam16_avx2(const float *re, const float *im, uint8_t *bits, int n) {
+	slice<4>(re, im, bits, n);
+}
+
+void
+slice_qam64_avx2(const float *re, const float *im, uint8_t *bits, int n) {
+	slice<6>(re, im, bits, n);
+}
+
+void
+multiply_avx2(const float *x_re, const float *x_im,
+		const float *h_re, const float *h_im, float *y_re, float *y_im) {
+	for(int i = 0; i < 48; i += 8) {
+		__m256 xr = _mm256_loadu_ps(x_re + i);
+		__m256 xi = _mm256_loadu_ps(x_im + i);
+		__m256 hr = _mm256_loadu_ps(h_re + i);
+		__m256 hi = _mm256_loadu_ps(h_im + i);
+		_mm256_storeu_ps(y_re + i, _mm256_sub_ps(_mm256_mul_ps(xr, hr), _mm256_mul_ps(xi, hi)));
+		_mm256_storeu_ps(y_im + i, _mm256_add_ps(_mm256_mul_ps(xr, hi), _mm256_mul_ps(xi, hr)));
+	}
+}
+
+void
+interleave_avx2(const float *re, const float *im, float *out) {
+	for(int i = 0; i < 48; i += 8) {
+		__m256 r = _mm256_loadu_ps(re + i);
+		__m256 m = _mm256_loadu_ps(im + i);
+		__m256 lo = _mm256_unpacklo_ps(r, m);
+		__m256 hi = _mm256_unpackhi_ps(r, m);
+		_mm256_storeu_ps(out + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(out + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+}
+
+} /* namespace equalizer */
+} /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
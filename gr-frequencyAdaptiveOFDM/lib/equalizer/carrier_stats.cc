@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2015 Samuel Rey <samuel.rey.escudero@gmail.com>
+ *						Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "carrier_stats.h"
+#include <cmath>
+#include <cstring>
+
+#ifdef FREQUENCYADAPTIVEOFDM_MSSE2
+#include <emmintrin.h>
+#endif
+
+using namespace gr::frequencyAdaptiveOFDM::equalizer;
+
+carrier_stats::carrier_stats() {
+	reset();
+}
+
+void
+carrier_stats::reset() {
+	std::memset(d_mean, 0, sizeof(d_mean));
+	std::memset(d_var, 0, sizeof(d_var));
+	d_count = 0;
+}
+
+void
+carrier_stats::add(const float *error_power) {
+	// the first symbols get equal weights, later ones 1 / WINDOW
+	d_count++;
+	float w = 1.0f / (d_count < WINDOW ? d_count : WINDOW);
+
+#ifdef FREQUENCYADAPTIVEOFDM_MSSE2
+	__m128 weight = _mm_set1_ps(w);
+	__m128 keep = _mm_set1_ps(1 - w);
+	for(int c = 0; c < 48; c += 4) {
+		__m128 mean = _mm_load_ps(d_mean + c);
+		__m128 delta = _mm_sub_ps(_mm_loadu_ps(error_power + c), mean);
+		__m128 step = _mm_mul_ps(weight, delta);
+		_mm_store_ps(d_mean + c, _mm_add_ps(mean, step));
+		__m128 var = _mm_add_ps(_mm_load_ps(d_var + c), _mm_mul_ps(step, delta));
+		_mm_store_ps(d_var + c, _mm_mul_ps(keep, var));
+	}
+#else
+	for(int c = 0; c < 48; c++) {
+		float delta = error_power[c] - d_mean[c];
+		d_mean[c] += w * delta;
+		d_var[c] = (1 - w) * (d_var[c] + w * delta * delta);
+	}
+#endif
+}
+
+void
+carrier_stats::error_power(const gr_complex *symbols, const gr_complex *points,
+		float *power) {
+#ifdef FREQUENCYADAPTIVEOFDM_MSSE2
+	const float *s = (const float *) symbols;
+	const float *p = (const float *) points;
+	for(int c = 0; c < 48; c += 4) {
+		// two carriers per register, split into real and imaginary parts
+		__m128 e0 = _mm_sub_ps(_mm_loadu_ps(s + 2 * c), _mm_loadu_ps(p + 2 * c));
+		__m128 e1 = _mm_sub_ps(_mm_loadu_ps(s + 2 * c + 4), _mm_loadu_ps(p + 2 * c + 4));
+		__m128 re = _mm_shuffle_ps(e0, e1, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 im = _mm_shuffle_ps(e0, e1, _MM_SHUFFLE(3, 1, 3, 1));
+		_mm_storeu_ps(power + c, _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+	}
+#else
+	for(int c = 0; c < 48; c++) {
+		power[c] = std::norm(symbols[c] - points[c]);
+	}
+#endif
+}
+
+void
+carrier_stats::snr(float *snr_db) const {
+	for(int c = 0; c < 48; c++) {
+		snr_db[c] = -10 * std::log10(d_mean[c]);
+	}
+}
+
+void
+carrier_stats::evm(float *evm) const {
+	for(int c = 0; c < 48; c++) {
+		evm[c] = std::sqrt(d_mean[c]);
+	}
+}
+
+void
+carrier_stats::rb_snr(double *snr_db) const {
+	for(int r = 0; r < 4; r++) {
+		double sum = 0;
+		for(int c = 12 * r; c < 12 * r + 12; c++) {
+			sum += d_mean[c];
+		}
+		snr_db[r] = 10 * std::log10(12 / sum);
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2015 Samuel Rey <samuel.rey.escudero@gmail.com>
+ *						Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_CARRIER_STATS_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_CARRIER_STATS_H
+
+#include <gnuradio/gr_complex.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+namespace equalizer {
+
+/* Running statistics of the error power of the 48 data carriers. Every
+ * data symbol adds the distance of the equalized carriers to their hard
+ * decisions, the long training sequence adds the noise of its two
+ * copies. Mean and variance are averaged exponentially over the last
+ * WINDOW symbols, so they follow the channel from frame to frame. The
+ * constellations have unit energy, so 1 / mean is the SNR of a carrier
+ * and sqrt(mean) its EVM.
+ */
+class carrier_stats {
+public:
+	carrier_stats();
+
+	void reset();
+
+	// adds the error power of the 48 data carriers of one symbol
+	void add(const float *error_power);
+
+	// |symbols - points|^2 of the 48 data carriers
+	static void error_power(const gr_complex *symbols,
+			const gr_complex *points, float *power);
+
+	// number of symbols added since the last reset
+	int count() const { return d_count; }
+	const float* mean() const { return d_mean; }
+	const float* variance() const { return d_var; }
+
+	// SNR (dB) and RMS EVM of the 48 data carriers
+	void snr(float *snr_db) const;
+	void evm(float *evm) const;
+
+	// effective SNR (dB) of the 4 resource blocks, the inverse of the
+	// mean error power of their 12 carriers. Weak carriers dominate it
+	// like they dominate the bit errors of the resource block.
+	void rb_snr(double *snr_db) const;
+
+	static const int WINDOW = 32;
+
+private:
+	float d_mean[48] __attribute__ ((aligned(16)));
+	float d_var[48] __attribute__ ((aligned(16)));
+	int d_count;
+};
+
+} /* namespace equalizer */
+} /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_CARRIER_STATS_H */
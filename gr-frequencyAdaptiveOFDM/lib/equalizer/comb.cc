@@ -20,7 +20,7 @@
 
 using namespace gr::frequencyAdaptiveOFDM::equalizer;
 
-void comb::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, boost::shared_ptr<gr::digital::constellation> mod[4]) {
+void comb::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits) {
 	gr_complex pilot[4];
 
 	if(n < 2) {
@@ -28,8 +28,6 @@ void comb::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, b
 		pilot[1] = -in[25];
 		pilot[2] =  in[39];
 		pilot[3] =  in[53];
-		d_resource_block_snr = std::vector<double>(4,42);
-		d_min_rb_snr = std::vector<double>(4,42);
 	} else {
 		gr_complex p = POLARITY[(n - 2) % 127];
 		pilot[0] = in[11] *  p;
@@ -39,7 +37,6 @@ void comb::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, b
 	}
 
 	gr_complex avg = (pilot[0] + pilot[1] + pilot[2] + pilot[3]) / gr_complex(4, 0);
-	int c = 0;
 	for(int i = 0; i < 64; i++) {
 		gr_complex H;
 		if(i <= 11) {
@@ -59,21 +56,8 @@ void comb::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, b
 		} else {
 			d_H[i] = gr_complex(1-alpha, 0) * d_H[i] + gr_complex(alpha, 0) * H;
 		}
-
-		if( (i == 11) || (i == 25) || (i == 32) || (i == 39) || (i == 53) || (i < 6) || ( i > 58)) {
-			continue;
-		} else {
-			symbols[c] = in[i] / d_H[i];
-			if (i < 19) {
-				bits[c] = mod[0]->decision_maker(&symbols[c]);
-			} else if (i < 32) {
-				bits[c] = mod[1]->decision_maker(&symbols[c]);
-			} else if (i < 46) {
-				bits[c] = mod[2]->decision_maker(&symbols[c]);
-			} else if (i < 59) {
-				bits[c] = mod[3]->decision_maker(&symbols[c]);
-			}
-			c++;
-		}
 	}
+
+	invert_channel();
+	equalize_data(in, symbols, bits);
 }
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2015 Samuel Rey <samuel.rey.escudero@gmail.com>
+ *						Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_KERNELS_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_KERNELS_H
+
+#include <stdint.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+namespace equalizer {
+
+/* AVX2 kernels of the equalizers, built with -mavx2 in base_avx2.cc and
+ * only used if the CPU supports it, see lib/CMakeLists.txt. Carriers are
+ * given as real and imaginary parts.
+ */
+
+// hard decisions of n carriers, the same as slice<ENC>() of slicer.h
+void slice_bpsk_avx2(const float *re, const float *im, uint8_t *bits, int n);
+void slice_qpsk_avx2(const float *re, const float *im, uint8_t *bits, int n);
+void slice_qam16_avx2(const float *re, const float *im, uint8_t *bits, int n);
+void slice_qam64_avx2(const float *re, const float *im, uint8_t *bits, int n);
+
+// y = x * h for the 48 data carriers
+void multiply_avx2(const float *x_re, const float *x_im,
+		const float *h_re, const float *h_im, float *y_re, float *y_im);
+
+// the 48 data carriers back to complex samples, out holds real and
+// imaginary part of each
+void interleave_avx2(const float *re, const float *im, float *out);
+
+} /* namespace equalizer */
+} /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_KERNELS_H */
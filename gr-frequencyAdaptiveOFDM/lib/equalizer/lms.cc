@@ -22,37 +22,19 @@
 
 using namespace gr::frequencyAdaptiveOFDM::equalizer;
 
-void lms::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, boost::shared_ptr<gr::digital::constellation> mod[4]) {
+void lms::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits) {
 	if(n == 0) {
 		std::memcpy(d_H, in, 64 * sizeof(gr_complex));
 	} else if(n == 1) {
 		estimate_channel_state(in);
 	} else {
-		int c = 0;
-		for(int i = 0; i < 64; i++) {
-			if( (i == 11) || (i == 25) || (i == 32) || (i == 39) || (i == 53) || (i < 6) || ( i > 58)) {
-				continue;
-			} else {
-				symbols[c] = in[i] / d_H[i];
-				gr_complex point;
+		invert_channel();
+		equalize_data(in, symbols, bits);
 
-				if (i < 19) {
-					bits[c] = mod[0]->decision_maker(&symbols[c]);
-					mod[0]->map_to_points(bits[c], &point);
-				} else if (i < 32) {
-					bits[c] = mod[1]->decision_maker(&symbols[c]);
-					mod[1]->map_to_points(bits[c], &point);
-				} else if (i < 46) {
-					bits[c] = mod[2]->decision_maker(&symbols[c]);
-					mod[2]->map_to_points(bits[c], &point);
-				} else if (i < 59) {
-					bits[c] = mod[3]->decision_maker(&symbols[c]);
-					mod[3]->map_to_points(bits[c], &point);
-				}
-
-				d_H[i] = gr_complex(1-alpha,0) * d_H[i] + gr_complex(alpha,0) * in[i] / point;
-				c++;
-			}
+		const float a = alpha;
+		for(int c = 0; c < 48; c++) {
+			int i = DATA_CARRIERS[c];
+			d_H[i] = (1 - a) * d_H[i] + a * divide(in[i], d_decisions[c]);
 		}
 	}
 }
@@ -22,30 +22,14 @@
 
 using namespace gr::frequencyAdaptiveOFDM::equalizer;
 
-void ls::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, boost::shared_ptr<gr::digital::constellation> mod[4]) {
+void ls::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits) {
 	if(n == 0) {
 		std::memcpy(d_H, in, 64 * sizeof(gr_complex));
 	} else if(n == 1) {
 		estimate_channel_state(in);
+		// the channel is fixed for the frame
+		invert_channel();
 	} else {
-
-		int c = 0;
-		for(int i = 0; i < 64; i++) {
-			if( (i == 11) || (i == 25) || (i == 32) || (i == 39) || (i == 53) || (i < 6) || ( i > 58)) {
-				continue;
-			} else {
-				symbols[c] = in[i] / d_H[i];
-				if (i < 19) {
-					bits[c] = mod[0]->decision_maker(&symbols[c]);
-				} else if (i < 32) {
-					bits[c] = mod[1]->decision_maker(&symbols[c]);
-				} else if (i < 46) {
-					bits[c] = mod[2]->decision_maker(&symbols[c]);
-				} else if (i < 59) {
-					bits[c] = mod[3]->decision_maker(&symbols[c]);
-				}
-				c++;
-			}
-		}
+		equalize_data(in, symbols, bits);
 	}
 }
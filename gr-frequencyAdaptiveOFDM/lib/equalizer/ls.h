@@ -28,7 +28,7 @@ namespace equalizer {
 
 class ls: public base {
 public:
-	virtual void equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, boost::shared_ptr<gr::digital::constellation> mod[4]);
+	virtual void equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits);
 };
 
 } /* namespace channel_estimation */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2015 Samuel Rey <samuel.rey.escudero@gmail.com>
+ *						Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_SLICER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_SLICER_H
+
+#include "utils.h"
+#include <cmath>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+namespace equalizer {
+
+/* Hard decisions and constellation points of the modulations, the
+ * same as decision_maker() and map_to_points() of the constellation
+ * blocks. The equalizers pick one slicer per resource block when the
+ * frame starts instead of calling the constellation for every carrier.
+ */
+template<int ENC> struct slicer;
+
+template<> struct slicer<BPSK> {
+	static inline unsigned int decide(float re, float) {
+		return re > 0;
+	}
+	static inline gr_complex point(unsigned int bits) {
+		return gr_complex(bits & 1 ? 1 : -1, 0);
+	}
+};
+
+template<> struct slicer<QPSK> {
+	static inline unsigned int decide(float re, float im) {
+		return 2 * (im > 0) + (re > 0);
+	}
+	static inline gr_complex point(unsigned int bits) {
+		const float level = std::sqrt(float(0.5));
+		return gr_complex(bits & 1 ? level : -level, bits & 2 ? level : -level);
+	}
+};
+
+template<> struct slicer<QAM16> {
+	static inline unsigned int decide(float re, float im) {
+		const float level = std::sqrt(float(0.1));
+		return (re > 0)
+			| ((std::abs(re) < (2 * level)) << 1)
+			| ((im > 0) << 2)
+			| ((std::abs(im) < (2 * level)) << 3);
+	}
+	// sign and inner bit of one axis
+	static inline float axis(unsigned int bits) {
+		const float level = std::sqrt(float(0.1));
+		float x = bits & 2 ? level : 3 * level;
+		return bits & 1 ? x : -x;
+	}
+	static inline gr_complex point(unsigned int bits) {
+		return gr_complex(axis(bits), axis(bits >> 2));
+	}
+};
+
+template<> struct slicer<QAM64> {
+	static inline unsigned int decide(float re, float im) {
+		const float level = std::sqrt(float(1/42.0));
+		float ar = std::abs(re);
+		float ai = std::abs(im);
+		return (re > 0)
+			| ((ar < (4 * level)) << 1)
+			| ((ar < (6 * level) && ar > (2 * level)) << 2)
+			| ((im > 0) << 3)
+			| ((ai < (4 * level)) << 4)
+			| ((ai < (6 * level) && ai > (2 * level)) << 5);
+	}
+	// sign and the two magnitude bits of one axis
+	static inline float axis(unsigned int bits) {
+		const float level = std::sqrt(float(1/42.0));
+		static const float MAGNITUDE[4] = { 7, 1, 5, 3 };
+		float x = MAGNITUDE[(bits >> 1) & 3] * level;
+		return bits & 1 ? x : -x;
+	}
+	static inline gr_complex point(unsigned int bits) {
+		return gr_complex(axis(bits), axis(bits >> 3));
+	}
+};
+
+// hard decisions of n carriers given as real and imaginary parts, the
+// AVX2 versions are in kernels.h
+typedef void (*slice_fn)(const float *re, const float *im, uint8_t *bits, int n);
+
+template<int ENC> void
+slice(const float *re, const float *im, uint8_t *bits, int n) {
+	for(int i = 0; i < n; i++) {
+		bits[i] = slicer<ENC>::decide(re[i], im[i]);
+	}
+}
+
+// constellation points of n hard decisions
+typedef void (*points_fn)(const uint8_t *bits, gr_complex *points, int n);
+
+template<int ENC> struct point_table {
+	gr_complex point[64];
+	point_table() {
+		for(int i = 0; i < 64; i++) {
+			point[i] = slicer<ENC>::point(i);
+		}
+	}
+};
+
+template<int ENC> void
+points(const uint8_t *bits, gr_complex *points, int n) {
+	static const point_table<ENC> table;
+	for(int i = 0; i < n; i++) {
+		points[i] = table.point[bits[i] & 63];
+	}
+}
+
+} /* namespace equalizer */
+} /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_EQUALIZER_SLICER_H */
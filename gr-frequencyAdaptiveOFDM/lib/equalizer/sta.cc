@@ -16,12 +16,38 @@
  */
 
 #include "sta.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 using namespace gr::frequencyAdaptiveOFDM::equalizer;
 
-void sta::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, boost::shared_ptr<gr::digital::constellation> mod[4]) {
+const double sta::DEFAULT_ALPHA = 0.5;
+const int sta::DEFAULT_BETA = 2;
+
+sta::sta(double alpha, int beta) {
+	set_smoothing(alpha, beta);
+}
+
+void
+sta::check_smoothing(double alpha, int beta) {
+	if(alpha < 0 || alpha > 1) {
+		throw std::invalid_argument("STA: alpha has to be between 0 and 1");
+	}
+	if(beta < 0) {
+		throw std::invalid_argument("STA: beta can not be negative");
+	}
+}
+
+void
+sta::set_smoothing(double alpha, int beta) {
+	check_smoothing(alpha, beta);
+	d_alpha = alpha;
+	d_beta = beta;
+}
+
+void sta::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits) {
 	if(n == 0) {
 		std::memcpy(d_H, in, 64 * sizeof(gr_complex));
 
@@ -29,7 +55,6 @@ void sta::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, bo
 		estimate_channel_state(in);
 	} else {
 
-		gr_complex H_update[64];
 		gr_complex H[64];
 
 		gr_complex p = POLARITY[(n - 2) % 127];
@@ -39,47 +64,35 @@ void sta::equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, bo
 		H[39] = in[39] *  p;
 		H[53] = in[53] * -p;
 
-		int c = 0;
-		for(int i = 0; i < 64; i++) {
-			if( (i == 11) || (i == 25) || (i == 32) || (i == 39) || (i == 53) || (i < 6) || ( i > 58)) {
-				continue;
-			} else {
-				symbols[c] = in[i] / d_H[i];
-				gr_complex point;
+		invert_channel();
+		equalize_data(in, symbols, bits);
 
-				if (i < 19) {
-					bits[c] = mod[0]->decision_maker(&symbols[c]);
-					mod[0]->map_to_points(bits[c], &point);
-				} else if (i < 32) {
-					bits[c] = mod[1]->decision_maker(&symbols[c]);
-					mod[1]->map_to_points(bits[c], &point);
-				} else if (i < 46) {
-					bits[c] = mod[2]->decision_maker(&symbols[c]);
-					mod[2]->map_to_points(bits[c], &point);
-				} else if (i < 59) {
-					bits[c] = mod[3]->decision_maker(&symbols[c]);
-					mod[3]->map_to_points(bits[c], &point);
-				}
-				H[i] = in[i] / point;
-				c++;
-			}
+		for(int c = 0; c < 48; c++) {
+			int i = DATA_CARRIERS[c];
+			H[i] = divide(in[i], d_decisions[c]);
 		}
 
-		for(int i = 0; i < 64; i++) {
-			int n = 0;
-			gr_complex s = 0;
-			for(int k = i-beta; k <= i+beta; k++) {
-				if((k == 32) || (k < 6) || ( k > 58)) {
-					continue;
-				}
-				n++;
-				s += H[k];
-			}
-			H_update[i] = s / gr_complex(n, 0);
+		// prefix sums of the estimates and the number of used carriers,
+		// the window of carrier i is sum[hi] - sum[lo]
+		gr_complex sum[65];
+		int used[65];
+		sum[0] = 0;
+		used[0] = 0;
+		for(int k = 0; k < 64; k++) {
+			bool valid = (k >= 6) && (k <= 58) && (k != 32);
+			sum[k + 1] = valid ? sum[k] + H[k] : sum[k];
+			used[k + 1] = used[k] + valid;
 		}
 
 		for(int i = 0; i < 64; i++) {
-			d_H[i] = gr_complex(1-alpha,0) * d_H[i] + gr_complex(alpha,0) * H_update[i];
+			int lo = std::max(i - d_beta, 0);
+			int hi = std::min(i + d_beta, 63) + 1;
+			int n = used[hi] - used[lo];
+			if(n == 0) {
+				continue;
+			}
+			gr_complex H_update = (sum[hi] - sum[lo]) / float(n);
+			d_H[i] = (1 - d_alpha) * d_H[i] + d_alpha * H_update;
 		}
 	}
 }
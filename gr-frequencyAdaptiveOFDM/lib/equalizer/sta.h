@@ -26,13 +26,26 @@ namespace gr {
 namespace frequencyAdaptiveOFDM {
 namespace equalizer {
 
+/* Spectral temporal averaging: the channel estimate of the data carriers
+ * from the decisions is averaged over beta neighbours on each side and
+ * then over time with weight alpha for the new estimate.
+ */
 class sta: public base {
 public:
-	virtual void equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits, boost::shared_ptr<gr::digital::constellation> mod[4]);
+	sta(double alpha = DEFAULT_ALPHA, int beta = DEFAULT_BETA);
+	virtual void equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits);
+
+	// alpha in [0, 1], beta >= 0
+	void set_smoothing(double alpha, int beta);
+	// throws std::invalid_argument for values out of range
+	static void check_smoothing(double alpha, int beta);
+
+	static const double DEFAULT_ALPHA;
+	static const int DEFAULT_BETA;
 
 private:
-	static const double alpha = 0.5;
-	static const int beta = 2;
+	float d_alpha;
+	int d_beta;
 };
 
 } /* namespace channel_estimation */
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "frame_decoder.h"
+#include "frame_tracer.h"
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+frame_decoder::frame_decoder(Equalizer algo, double freq, double bw,
+		bool log, bool debug, bool debug_parity, bool debug_rx_err,
+		bool soft, int windows) :
+	d_equalizer(algo, freq, bw, debug, debug_parity),
+	d_frame_valid(false),
+	d_ofdm(std::vector<int>(4, BPSK), P_1_2),
+	d_frame(d_ofdm, 0),
+	d_snr_symbols(0),
+	d_trace(0),
+	d_decoder("EQUALIZE_AND_DECODE", log, debug, debug_rx_err, windows),
+	d_debug(debug), d_soft(soft) {
+}
+
+void
+frame_decoder::set_algorithm(Equalizer algo) {
+	d_equalizer.set_algorithm(algo);
+}
+
+void
+frame_decoder::set_bandwidth(double bw) {
+	d_equalizer.set_bandwidth(bw);
+}
+
+void
+frame_decoder::set_frequency(double freq) {
+	d_equalizer.set_frequency(freq);
+}
+
+void
+frame_decoder::set_sta_smoothing(double alpha, int beta) {
+	d_equalizer.set_sta_smoothing(alpha, beta);
+}
+
+void
+frame_decoder::new_frame(double cfo, uint64_t trace) {
+	d_frame_valid = false;
+	d_trace = trace;
+	d_equalizer.new_frame(cfo);
+}
+
+frame_decoder::symbol_type
+frame_decoder::push(const gr_complex *in, gr_complex *symbols) {
+
+	int n = d_equalizer.current_symbol() - 4;
+
+	// not interesting -> skip
+	if(!d_equalizer.in_frame() || (n >= 0 && !d_frame_valid)) {
+		return SKIPPED;
+	}
+
+	if(n == -4) {
+		frame_tracer::instance().stamp(d_trace, frame_tracer::EQUALIZER);
+	}
+
+	// hard decisions go straight into the frame buffer
+	uint8_t *bits = d_soft || n < 0 ? d_bits : d_rx_symbols + n * 48;
+
+	if(d_equalizer.equalize(in, symbols, bits)) {
+		frame_tracer::instance().stamp(d_trace, frame_tracer::SIGNAL);
+		d_frame_valid = start_frame();
+	}
+
+	if(n < 0) {
+		return HEADER;
+	}
+
+	if(d_soft) {
+		d_equalizer.soft_bits(symbols, d_rx_llr + n * SOFT_SYMBOL_SIZE);
+	}
+	return n + 1 == d_frame.n_sym ? LAST : DATA;
+}
+
+bool
+frame_decoder::frame_valid() const {
+	return d_frame_valid;
+}
+
+int
+frame_decoder::symbols() const {
+	return d_frame.n_sym;
+}
+
+const std::vector<int>&
+frame_decoder::frame_encoding() const {
+	return d_ofdm.resource_blocks_e;
+}
+
+const std::vector<float>&
+frame_decoder::frame_errors() const {
+	return d_equalizer.frame_errors();
+}
+
+int
+frame_decoder::snr_symbols() const {
+	return d_snr_symbols;
+}
+
+void
+frame_decoder::set_keep_frame_errors(bool keep) {
+	d_equalizer.set_keep_frame_errors(keep);
+}
+
+void
+frame_decoder::set_count_snr(bool count) {
+	d_decoder.set_count_snr(count);
+}
+
+bool
+frame_decoder::start_frame() {
+	ofdm_param ofdm(d_equalizer.frame_encoding(), d_equalizer.frame_puncturing());
+	frame_param frame(ofdm, d_equalizer.frame_bytes());
+
+	// check for maximum frame size
+	if(frame.n_sym > MAX_SYM || frame.psdu_size > MAX_PSDU_SIZE) {
+		dout << "EQUALIZE_AND_DECODE: Dropping frame which is too large (symbols or bits)" << std::endl;
+		return false;
+	}
+
+	d_ofdm = ofdm;
+	d_frame = frame;
+	d_snr = d_equalizer.rb_snr();
+	d_snr_symbols = d_equalizer.frame_errors().size() / 48;
+
+	if (LOG_ENABLED(DEBUG) && d_debug){
+		std::ostream &out = LOG_STREAM(DEBUG);
+		out << "EQUALIZE_AND_DECODE: frame start -- len " << frame.psdu_size << std::endl;
+		d_frame.print(out);
+		d_ofdm.print(out);
+	}
+	return true;
+}
+
+pmt::pmt_t
+frame_decoder::decode() {
+	d_frame_valid = false;
+
+	if(d_soft) {
+		d_decoder.gather_soft(d_rx_llr, d_ofdm, d_frame, d_depunctured);
+	} else {
+		d_decoder.gather_hard(d_rx_symbols, d_ofdm, d_frame, d_depunctured);
+	}
+	return d_decoder.decode(d_depunctured, d_soft, d_ofdm, d_frame, d_snr,
+			d_equalizer.frequency(), d_equalizer.freq_offset(), d_trace);
+}
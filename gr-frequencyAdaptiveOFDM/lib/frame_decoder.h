@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_DECODER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_DECODER_H
+
+#include "ofdm_equalizer.h"
+#include "psdu_decoder.h"
+#include <pmt/pmt.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Receives one frame at a time: equalizes its symbols into a frame
+ * buffer and decodes the buffer once the last data symbol is in. This
+ * is the work of frame_equalizer and decode_mac without the stream in
+ * between. equalize_and_decode runs one of them in its work function
+ * and one per thread of the rx_engine.
+ */
+class frame_decoder
+{
+public:
+
+	// what push() did with a symbol
+	enum symbol_type {
+		SKIPPED,  // not part of a frame
+		HEADER,   // long training sequence or signal field
+		DATA,     // data symbol, the equalized carriers are valid
+		LAST      // last data symbol, the frame can be decoded
+	};
+
+	frame_decoder(Equalizer algo, double freq, double bw, bool log,
+			bool debug, bool debug_parity, bool debug_rx_err, bool soft,
+			int windows);
+
+	void set_algorithm(Equalizer algo);
+	void set_bandwidth(double bw);
+	void set_frequency(double freq);
+	void set_sta_smoothing(double alpha, int beta);
+
+	// drops the current frame, cfo is the estimation of sync_long and
+	// trace the frame_tracer id of the new one
+	void new_frame(double cfo, uint64_t trace = 0);
+
+	// equalizes the next symbol of the frame, symbols gets the 48 data
+	// carriers of it
+	symbol_type push(const gr_complex *in, gr_complex *symbols);
+
+	// true once the signal field was decoded and the frame fits into the
+	// frame buffer, symbols() is the number of data symbols then
+	bool frame_valid() const;
+	int symbols() const;
+	// encoding of the resource blocks of a valid frame
+	const std::vector<int>& frame_encoding() const;
+
+	// Error powers the frame added to the statistics of the carriers,
+	// 48 per symbol. The SNR of the PDU was taken after the first
+	// snr_symbols() of them. The rx_engine replays them on statistics
+	// of all its threads, as every thread only sees part of the frames.
+	// Only the rx_engine needs them, they are kept after
+	// set_keep_frame_errors(true).
+	const std::vector<float>& frame_errors() const;
+	int snr_symbols() const;
+	void set_keep_frame_errors(bool keep);
+	// whether decode() sets RX_SNR of counters
+	void set_count_snr(bool count);
+
+	// Viterbi decoding, descrambling and the CRC of a complete frame.
+	// Returns the PDU of decode_mac or PMT_NIL if the checksum is wrong.
+	pmt::pmt_t decode();
+
+private:
+	bool start_frame();
+
+	ofdm_equalizer d_equalizer;
+
+	// frame that is equalized, data symbols are only kept if it fits
+	// into the frame buffer
+	bool d_frame_valid;
+	ofdm_param d_ofdm;
+	frame_param d_frame;
+	std::vector<double> d_snr;  // dB
+	int d_snr_symbols;
+	uint64_t d_trace;
+
+	psdu_decoder d_decoder;
+
+	// frame buffer, hard decisions or LLRs of the data symbols
+	uint8_t d_rx_symbols[48 * MAX_SYM];
+	int8_t d_rx_llr[SOFT_SYMBOL_SIZE * MAX_SYM];
+	uint8_t d_bits[48];
+	// Viterbi input and the flush behind it
+	uint8_t d_depunctured[MAX_DEPUNCTURED_BITS + (TRACEBACK_MAX + 1) * 16];
+
+	bool d_debug;
+	bool d_soft;
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_DECODER_H */
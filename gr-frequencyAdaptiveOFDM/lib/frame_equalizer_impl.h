@@ -23,9 +23,10 @@
 #define INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_EQUALIZER_IMPL_H
 
 #include <frequencyAdaptiveOFDM/frame_equalizer.h>
-#include <frequencyAdaptiveOFDM/constellations.h>
-#include "equalizer/base.h"
-#include "viterbi_decoder/viterbi_decoder.h"
+#include "ofdm_equalizer.h"
+#include "constellation_tap.h"
+#include "frame_tracer.h"
+#include "counters.h"
 #include <sys/time.h>
 #include <fstream>
 
@@ -35,12 +36,14 @@ namespace gr {
     class frame_equalizer_impl : public frame_equalizer
     {
      public:
-      frame_equalizer_impl(Equalizer algo, double freq, double bw, bool log, bool debug, bool debug_parity, char* delay_file);
+      frame_equalizer_impl(Equalizer algo, double freq, double bw, bool log, bool debug, bool debug_parity, char* delay_file, bool soft, const char* trace_file);
       ~frame_equalizer_impl();
 
       void set_algorithm(Equalizer algo);
       void set_bandwidth(double bw);
       void set_frequency(double freq);
+      void set_sta_smoothing(double alpha, int beta);
+      void set_constellation_tap(int decimation, int period);
 
       void forecast (int noutput_items, gr_vector_int &ninput_items_required);
       int general_work(int noutput_items,
@@ -49,46 +52,27 @@ namespace gr {
            gr_vector_void_star &output_items);
 
     private:
-      bool parse_signal(uint8_t *signal);
-      bool decode_signal_field(uint8_t *rx_bits);
-
-      equalizer::base *d_equalizer;
+      ofdm_equalizer d_equalizer;
       gr::thread::mutex d_mutex;
       std::vector<gr::tag_t> tags;
-      int  d_current_symbol;
-      viterbi_decoder d_decoder;
-
-      // freq offset
-      double d_freq;  // Hz
-      double d_freq_offset_from_synclong;  // Hz, estimation from "sync_long" block
-      double d_bw;  // Hz
-      double d_er;
-      double d_epsilon0;
-      gr_complex d_prev_pilots[4];
-
-      int  d_frame_bytes;
-      int  d_frame_symbols;
-      std::vector<int>  d_frame_enc;
-      int d_frame_punct;
 
-      uint8_t d_deinterleaved[48*2];
-      gr_complex symbols[48];
+      uint8_t d_bits[48];
 
-      boost::shared_ptr<gr::digital::constellation> d_frame_mod[4];
-      constellation_bpsk::sptr d_bpsk;
-      constellation_qpsk::sptr d_qpsk;
-      constellation_16qam::sptr d_16qam;
-      constellation_64qam::sptr d_64qam;
+      // telemetry of the "symbols" port, only fed if it has subscribers
+      constellation_tap d_tap;
+      bool d_tap_enabled;
 
+      // time since the last symbol, one line per symbol in the delay file
       timeval last_time;
       std::ofstream delay_fstream;
 
+      // frame_tracer id of the frame
+      uint64_t d_trace;
+
       // Debug
       bool d_debug;
       bool d_log;
-      bool d_debug_parity;
-
-      static int interleaver_pattern[48];
+      bool d_soft;
     };
 
   } // namespace frequencyAdaptiveOFDM
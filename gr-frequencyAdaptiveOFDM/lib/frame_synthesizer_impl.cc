@@ -0,0 +1,181 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016   Samuel Rey <samuel.rey.escudero@gmail.com>
+ *                  Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "frame_synthesizer_impl.h"
+
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    frame_synthesizer::sptr
+    frame_synthesizer::make(bool debug_enc, std::vector<int> pilots_enc,
+                  bool debug, char* tx_enc_f)
+    {
+      return gnuradio::get_initial_sptr
+        (new frame_synthesizer_impl(debug_enc, pilots_enc, debug, tx_enc_f));
+    }
+
+    frame_synthesizer_impl::frame_synthesizer_impl(bool debug_enc,
+                              std::vector<int> pilots_enc, bool debug,
+                              char* tx_enc_f)
+      : gr::block("frame_synthesizer",
+          gr::io_signature::make(0, 0, 0),
+          gr::io_signature::make(1, 1, sizeof(gr_complex))),
+          d_debug_enc(debug_enc),
+          d_debug(debug),
+          d_scrambler(1),
+          d_samples_offset(0),
+          d_samples_len(0),
+          d_samples(ofdm_synthesizer::frame_samples(MAX_SYM)),
+          d_ofdm(pilots_enc, P_1_2)
+    {
+      message_port_register_in(pmt::mp("in"));
+      if (d_debug_enc) {
+        std::vector<int> enc;
+        int punct;
+
+        punct = pilots_enc[pilots_enc.size()-1];
+        pilots_enc.pop_back();
+        enc = pilots_enc;
+        d_ofdm = ofdm_param(enc, punct);
+
+        std::cout << "FRAME SYNTHESIZER DEBUG ENCODDING:\n";
+        d_ofdm.print_encoding();
+      }
+      if (tx_enc_f && *tx_enc_f) {
+        tx_enc_fstream.open(tx_enc_f, std::ofstream::out);
+      }
+    }
+
+    bool
+    frame_synthesizer_impl::read_pdu(pmt::pmt_t msg, ofdm_param &ofdm,
+          const char **psdu, int *psdu_length, bool *data_frame) {
+
+      if(!pmt::is_pair(msg)) {
+        return false;
+      }
+      dout << "FRAME SYNTHESIZER: received new message" << std::endl;
+
+      *psdu_length = pmt::blob_length(pmt::cdr(msg));
+      mac_header *h = (mac_header*)pmt::blob_data(pmt::cdr(msg));
+      *psdu = static_cast<const char*>(pmt::blob_data(pmt::cdr(msg)));
+      // Only write modulation of Data frames
+      *data_frame = ((h->frame_control >> 2) & 3) == 2;
+
+      pmt::pmt_t dict = pmt::car(msg);
+      std::vector<int> enc = pmt::s32vector_elements(pmt::dict_ref(dict, pmt::mp("encoding"), pmt::init_s32vector(0, 0)));
+      int punct = pmt::to_long(pmt::dict_ref(dict, pmt::mp("puncturing"), pmt::from_long(-1)));
+
+      ofdm = ofdm_param(enc, punct);
+      if (d_debug_enc) {
+        ofdm = d_ofdm;
+      }
+      frame_param frame(ofdm, *psdu_length);
+
+      if (d_debug){
+        dout << "FRAME SYNTHESIZER: frame and coding:";
+        frame.print();
+        ofdm.print();
+      }
+
+      if(frame.n_sym > MAX_SYM) {
+        std::cerr << "ERROR: FRAME SYNTHESIZER: packet too large, maximum number of symbols is " << MAX_SYM << std::endl;
+        return false;
+      }
+      return true;
+    }
+
+    void
+    frame_synthesizer_impl::add_frame_tags(int n_samples, int psdu_length,
+          ofdm_param &ofdm) {
+      pmt::pmt_t srcid = pmt::string_to_symbol(alias());
+      add_item_tag(0, nitems_written(0), pmt::mp("packet_len"),
+          pmt::from_long(n_samples), srcid);
+      add_item_tag(0, nitems_written(0), pmt::mp("psdu_len"),
+          pmt::from_long(psdu_length), srcid);
+      add_item_tag(0, nitems_written(0), pmt::mp("encoding"),
+          pmt::init_s32vector(4, ofdm.resource_blocks_e), srcid);
+      add_item_tag(0, nitems_written(0), pmt::mp("puncturing"),
+          pmt::from_long(ofdm.punct), srcid);
+    }
+
+    int
+    frame_synthesizer_impl::general_work(int noutput, gr_vector_int& ninput_items,
+          gr_vector_const_void_star& input_items,
+          gr_vector_void_star& output_items ) {
+
+      gr_complex *out = (gr_complex*)output_items[0];
+
+      while(!d_samples_offset) {
+        // sleep until a PDU arrives, see mapper
+        pmt::pmt_t msg(delete_head_blocking(pmt::intern("in"), PDU_WAIT_MS));
+
+        if(!msg.get()) {
+          return 0;
+        }
+
+        ofdm_param ofdm;
+        const char *psdu;
+        int psdu_length;
+        bool data_frame;
+        if(!read_pdu(msg, ofdm, &psdu, &psdu_length, &data_frame)) {
+          continue;
+        }
+        frame_param frame(ofdm, psdu_length);
+
+        d_samples_len = ofdm_synthesizer::frame_samples(frame.n_sym);
+
+        // straight into the output buffer if the frame fits
+        gr_complex *samples = noutput >= d_samples_len ? out : &d_samples[0];
+        d_synthesizer.synthesize(psdu, frame, ofdm, d_scrambler, samples);
+        d_scrambler = d_scrambler % 127 + 1;
+
+        add_frame_tags(d_samples_len, psdu_length, ofdm);
+        if (tx_enc_fstream.is_open() && data_frame){
+          tx_enc_fstream << ofdm.toFileFormat();
+        }
+
+        if(samples == out) {
+          dout << "FRAME SYNTHESIZER: frame synthesized\n";
+          return d_samples_len;
+        }
+        break;
+      }
+
+      int i = std::min(noutput, d_samples_len - d_samples_offset);
+      std::memcpy(out, &d_samples[d_samples_offset], i * sizeof(gr_complex));
+      d_samples_offset += i;
+
+      if(d_samples_offset == d_samples_len) {
+        d_samples_offset = 0;
+
+        dout << "FRAME SYNTHESIZER: frame synthesized\n";
+      }
+      return i;
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
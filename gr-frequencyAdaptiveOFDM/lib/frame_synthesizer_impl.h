@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016   Samuel Rey <samuel.rey.escudero@gmail.com>
+ *                  Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_SYNTHESIZER_IMPL_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_SYNTHESIZER_IMPL_H
+
+#include <frequencyAdaptiveOFDM/frame_synthesizer.h>
+#include "ofdm_synthesizer.h"
+#include <fstream>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    class frame_synthesizer_impl : public frame_synthesizer
+    {
+    private:
+      // longest wait for a PDU in one call of general_work
+      static const unsigned int PDU_WAIT_MS = 100;
+
+      bool d_debug_enc;
+      bool d_debug;
+      uint8_t d_scrambler;
+      int d_samples_offset;
+      int d_samples_len;
+
+      ofdm_synthesizer d_synthesizer;
+      // samples of a frame that did not fit into the output buffer
+      std::vector<gr_complex> d_samples;
+      ofdm_param d_ofdm;
+      std::ofstream tx_enc_fstream;
+
+      bool read_pdu(pmt::pmt_t msg, ofdm_param &ofdm, const char **psdu,
+                  int *psdu_length, bool *data_frame);
+      void add_frame_tags(int n_samples, int psdu_length, ofdm_param &ofdm);
+
+    public:
+      frame_synthesizer_impl(bool debug_enc, std::vector<int> pilots_enc,
+                  bool debug, char* tx_enc_f);
+
+      int general_work(int noutput_items,
+           gr_vector_int &ninput_items,
+           gr_vector_const_void_star &input_items,
+           gr_vector_void_star &output_items);
+    };
+
+  } // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_SYNTHESIZER_IMPL_H */
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "frame_tracer.h"
+#include <gnuradio/prefs.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <time.h>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+namespace {
+
+// ms between two runs of the writer
+const int WRITE_INTERVAL = 20;
+
+const char *stage_names[frame_tracer::N_STAGES] = {
+	"sync", "equalizer", "signal", "viterbi", "crc", "parse", "ack"
+};
+
+} // namespace
+
+frame_tracer::frame_tracer() :
+	ring_writer(&frame_tracer::make_ring),
+	d_file(NULL) {
+
+	for(int s = 0; s < N_STAGES; s++) {
+		d_histogram[s].resize(N_BUCKETS);
+		d_count[s] = 0;
+	}
+}
+
+frame_tracer::~frame_tracer() {
+	stop();
+}
+
+frame_tracer&
+frame_tracer::instance() {
+	// never destroyed, blocks might detach after static destruction
+	static frame_tracer *tracer = new frame_tracer();
+	return *tracer;
+}
+
+void
+frame_tracer::attached(const std::string &file) {
+	bool on = !file.empty();
+	std::string name = file;
+	gr::prefs *prefs = gr::prefs::singleton();
+	if(prefs->get_bool("frequencyAdaptiveOFDM", "trace", false)) {
+		on = true;
+		if(name.empty()) {
+			name = prefs->get_string("frequencyAdaptiveOFDM", "trace_file", "");
+		}
+	}
+	// a block whose file does not open is not attached
+	if(on && !running()) {
+		start(name);
+	}
+}
+
+void
+frame_tracer::detached() {
+	if(!running()) {
+		return;
+	}
+	stop();
+	std::cout << summary() << std::flush;
+}
+
+void
+frame_tracer::start(const std::string &file) {
+	gr::thread::scoped_lock lock(d_mutex);
+	if(running()) {
+		return;
+	}
+
+	if(!file.empty()) {
+		d_file = std::fopen(file.c_str(), "wb");
+		if(!d_file) {
+			throw std::invalid_argument("FRAME TRACER: can not open " + file);
+		}
+	}
+	for(int s = 0; s < N_STAGES; s++) {
+		std::fill(d_histogram[s].begin(), d_histogram[s].end(), 0);
+		d_count[s] = 0;
+	}
+	// records of an earlier run
+	d_rings.clear();
+	start_writer(WRITE_INTERVAL);
+}
+
+void
+frame_tracer::stopped() {
+	if(d_file) {
+		std::fclose(d_file);
+		d_file = NULL;
+	}
+}
+
+uint64_t
+frame_tracer::new_frame() {
+	if(!running()) {
+		return 0;
+	}
+	uint64_t t = now();
+	push(t, SYNC, 0, t);
+	return t;
+}
+
+void
+frame_tracer::push(uint64_t frame, stage s, uint32_t value, uint64_t time) {
+	thread_ring *r = d_rings.local();
+	char *p = r->reserve(sizeof(record));
+	if(!p) {
+		return;
+	}
+	record rec = {frame, time, uint32_t(s), value};
+	std::memcpy(p, &rec, sizeof(rec));
+	r->commit();
+}
+
+thread_ring*
+frame_tracer::make_ring(int thread) {
+	// a record and the header of the ring take 32 bytes
+	return new thread_ring(RING_SIZE * 32, thread);
+}
+
+void
+frame_tracer::drain() {
+	d_rings.visit(boost::bind(&frame_tracer::drain_ring, this, _1));
+}
+
+void
+frame_tracer::drain_ring(thread_ring &r) {
+	uint32_t size;
+	while(const char *p = r.front(&size)) {
+		record rec;
+		std::memcpy(&rec, p, sizeof(rec));
+		r.pop();
+
+		uint64_t latency = rec.time > rec.frame ? rec.time - rec.frame : 0;
+		d_histogram[rec.stage][bucket(latency)]++;
+		d_count[rec.stage]++;
+		if(d_file) {
+			std::fwrite(&rec, sizeof(rec), 1, d_file);
+		}
+	}
+}
+
+uint64_t
+frame_tracer::count(stage s) {
+	gr::thread::scoped_lock lock(d_mutex);
+	return d_count[s];
+}
+
+uint64_t
+frame_tracer::percentile(stage s, double p) {
+	gr::thread::scoped_lock lock(d_mutex);
+	return quantile(s, p);
+}
+
+uint64_t
+frame_tracer::quantile(int s, double p) {
+	if(!d_count[s]) {
+		return 0;
+	}
+	uint64_t rank = std::max(uint64_t(1), uint64_t(std::ceil(p * d_count[s])));
+	uint64_t n = 0;
+	for(int b = 0; b < N_BUCKETS; b++) {
+		n += d_histogram[s][b];
+		if(n >= rank) {
+			return bucket_value(b);
+		}
+	}
+	return bucket_value(N_BUCKETS - 1);
+}
+
+std::string
+frame_tracer::summary() {
+	uint64_t lost = dropped();
+
+	gr::thread::scoped_lock lock(d_mutex);
+	std::ostringstream s;
+	s << "FRAME TRACER: latency since sync (us)" << std::endl;
+	s << std::setw(10) << "stage" << std::setw(10) << "frames"
+		<< std::setw(12) << "p50" << std::setw(12) << "p99" << std::endl;
+	for(int i = EQUALIZER; i < N_STAGES; i++) {
+		s << std::setw(10) << stage_names[i] << std::setw(10) << d_count[i]
+			<< std::fixed << std::setprecision(1)
+			<< std::setw(12) << quantile(i, 0.5) / 1e3
+			<< std::setw(12) << quantile(i, 0.99) / 1e3 << std::endl;
+	}
+	s << "FRAME TRACER: " << d_count[SYNC] << " frames, " << lost << " records dropped" << std::endl;
+	return s.str();
+}
+
+uint64_t
+frame_tracer::now() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return uint64_t(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+const char*
+frame_tracer::stage_name(stage s) {
+	return stage_names[s];
+}
+
+int
+frame_tracer::bucket(uint64_t ns) {
+	if(ns < 16) {
+		return ns;
+	}
+	int e = 63 - __builtin_clzll(ns);
+	return (e - 3) * 16 + ((ns >> (e - 4)) & 15);
+}
+
+uint64_t
+frame_tracer::bucket_value(int b) {
+	if(b < 16) {
+		return b;
+	}
+	int shift = b / 16 - 1;
+	// middle of the bucket
+	return (uint64_t(16 + b % 16) << shift) + (uint64_t(1) << shift) / 2;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_TRACER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_TRACER_H
+
+#include "ring_writer.h"
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Latency of the received frames through the stages of the receiver.
+ *
+ * A frame is known by the time it was synchronized, new_frame() takes
+ * it and the blocks hand it on as "trace" in the wifi_start tag and in
+ * the PDU. Every stage stamps the frame with the monotonic clock into a
+ * thread_ring of the calling thread, which takes no lock and never
+ * waits: if the ring is full the record is dropped. The ring_writer
+ * empties the rings every few ms into a histogram of the latency since the sync per
+ * stage and, with a file, writes the records in binary:
+ *
+ *   uint64_t frame, time (ns), uint32_t stage, value
+ *
+ * value is 1 for a frame with a correct CRC, 0 otherwise.
+ *
+ * The blocks share instance(). It runs if the first block that attaches
+ * brings a file or with
+ *
+ *   [frequencyAdaptiveOFDM]
+ *   trace = True
+ *   trace_file = /tmp/frame_trace.bin
+ *
+ * in the GNU Radio config. The last block that detaches prints p50 and
+ * p99 of every stage. Without the tracer, a frame is 0 and stamping it
+ * costs a compare.
+ */
+class frame_tracer : public ring_writer
+{
+public:
+	enum stage {
+		SYNC,       // wifi_start tag
+		EQUALIZER,  // first symbol of the frame is equalized
+		SIGNAL,     // signal field decoded
+		VITERBI,    // data decoded
+		CRC,        // checksum verdict
+		PARSE,      // parse_mac has the PDU
+		ACK,        // ACK handed to the PHY
+		N_STAGES
+	};
+
+	frame_tracer();
+	~frame_tracer();
+
+	static frame_tracer& instance();
+	// reference counting for the blocks, see ring_writer
+	void attach(const std::string &file = "") {
+		attach_block(file);
+	}
+
+	// file may be empty, then only the histograms are kept
+	void start(const std::string &file);
+
+	// stamps SYNC, 0 if the tracer does not run
+	uint64_t new_frame();
+	void stamp(uint64_t frame, stage s, uint32_t value = 0) {
+		if(frame && running()) {
+			push(frame, s, value, now());
+		}
+	}
+
+	// latency since the sync in ns, of everything flushed so far
+	uint64_t count(stage s);
+	uint64_t percentile(stage s, double p);
+	std::string summary();
+
+	static uint64_t now();
+	static const char* stage_name(stage s);
+
+	// records per thread
+	static const int RING_SIZE = 1024;
+	// 16 buckets per power of two, about 6% resolution
+	static const int N_BUCKETS = 61 * 16;
+	static int bucket(uint64_t ns);
+	static uint64_t bucket_value(int b);
+
+private:
+	struct record {
+		uint64_t frame;
+		uint64_t time;
+		uint32_t stage;
+		uint32_t value;
+	};
+
+	void push(uint64_t frame, stage s, uint32_t value, uint64_t time);
+	static thread_ring* make_ring(int thread);
+	void attached(const std::string &file);
+	void detached();
+	void drain();
+	void stopped();
+	void drain_ring(thread_ring &r);
+	uint64_t quantile(int s, double p);
+
+	// d_mutex protects everything below
+	std::vector<uint64_t> d_histogram[N_STAGES];
+	uint64_t d_count[N_STAGES];
+	FILE *d_file;
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_FRAME_TRACER_H */
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "logger.h"
+#include <gnuradio/prefs.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <time.h>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+namespace {
+
+// ms between two runs of the writer
+const int WRITE_INTERVAL = 20;
+
+const char *level_names[logger::N_LEVELS] = {
+	"ERROR", "WARN", "INFO", "DEBUG", "TRACE"
+};
+
+// header of a message in the ring, followed by its tag and data
+struct record {
+	uint64_t time;
+	uint32_t size;  // bytes of tag and data
+	uint16_t tag;   // bytes of the tag
+	uint8_t level;
+	uint8_t type;
+};
+
+struct message {
+	uint64_t time;
+	int thread;
+	int level;
+	int type;
+	std::string tag;
+	std::string data;
+};
+
+bool
+earlier(const message &a, const message &b) {
+	return a.time < b.time;
+}
+
+uint64_t
+now() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return uint64_t(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+// copies the messages of a ring
+void
+collect(std::vector<message> *messages, thread_ring &r) {
+	uint32_t size;
+	while(const char *p = r.front(&size)) {
+		record rec;
+		std::memcpy(&rec, p, sizeof(rec));
+		message m;
+		m.time = rec.time;
+		m.thread = r.thread();
+		m.level = rec.level;
+		m.type = rec.type;
+		m.tag.assign(p + sizeof(rec), rec.tag);
+		m.data.assign(p + sizeof(rec) + rec.tag, rec.size - rec.tag);
+		messages->push_back(m);
+		r.pop();
+	}
+}
+
+} // namespace
+
+int
+logger::line_buf::overflow(int c) {
+	if(c == traits_type::eof()) {
+		return 0;
+	}
+	char ch = c;
+	xsputn(&ch, 1);
+	return c;
+}
+
+std::streamsize
+logger::line_buf::xsputn(const char *s, std::streamsize n) {
+	const char *end = s + n;
+	while(s != end) {
+		const char *nl = std::find(s, end, '\n');
+		d_line.append(s, nl);
+		if(nl == end) {
+			break;
+		}
+		d_logger->push(d_level, TEXT, "", d_line.data(), d_line.size());
+		d_line.clear();
+		s = nl + 1;
+	}
+	return n;
+}
+
+logger::logger() :
+	ring_writer(boost::bind(&logger::make_ring, this, _1)),
+	d_epoch(now()),
+	d_reported(0),
+	d_file(NULL) {
+}
+
+logger::~logger() {
+	stop();
+}
+
+logger&
+logger::instance() {
+	// never destroyed, blocks might log after static destruction
+	static logger *log = new logger();
+	return *log;
+}
+
+void
+logger::attached(const std::string &file) {
+	autostart();
+}
+
+void
+logger::detached() {
+	stop();
+}
+
+void
+logger::autostart() {
+	gr::prefs *prefs = gr::prefs::singleton();
+	start(prefs->get_string("frequencyAdaptiveOFDM", "log_file", ""));
+}
+
+void
+logger::start(const std::string &file) {
+	gr::thread::scoped_lock lock(d_mutex);
+	if(running()) {
+		return;
+	}
+
+	d_file = stdout;
+	if(!file.empty()) {
+		d_file = std::fopen(file.c_str(), "w");
+		if(!d_file) {
+			throw std::invalid_argument("LOGGER: can not open " + file);
+		}
+	}
+	start_writer(WRITE_INTERVAL);
+}
+
+void
+logger::stopped() {
+	if(d_file != stdout) {
+		std::fclose(d_file);
+	}
+	d_file = NULL;
+}
+
+std::ostream&
+logger::stream(level l) {
+	ring *r = local_ring();
+	r->buf.set_level(l);
+	return r->out;
+}
+
+void
+logger::bytes(level l, const std::string &tag, const char *data, int size) {
+	push(l, BYTES, tag, data, size);
+}
+
+void
+logger::push(level l, type t, const std::string &tag, const char *data, int size) {
+	if(!running()) {
+		autostart();
+	}
+	thread_ring *r = local_ring();
+
+	char *p = r->reserve(sizeof(record) + tag.size() + size);
+	if(!p) {
+		return;
+	}
+	record rec = {now(), uint32_t(tag.size() + size), uint16_t(tag.size()), uint8_t(l), uint8_t(t)};
+	std::memcpy(p, &rec, sizeof(rec));
+	std::memcpy(p + sizeof(rec), tag.data(), tag.size());
+	std::memcpy(p + sizeof(rec) + tag.size(), data, size);
+	r->commit();
+}
+
+logger::ring*
+logger::local_ring() {
+	return static_cast<ring*>(d_rings.local());
+}
+
+thread_ring*
+logger::make_ring(int thread) {
+	return new ring(this, thread);
+}
+
+void
+logger::drain() {
+	// without a file the messages wait in the rings for the next start
+	if(!d_file) {
+		return;
+	}
+
+	std::vector<message> messages;
+	d_rings.visit(boost::bind(&collect, &messages, _1));
+	uint64_t lost = d_rings.dropped();
+
+	std::stable_sort(messages.begin(), messages.end(), earlier);
+	for(size_t i = 0; i < messages.size(); i++) {
+		const message &m = messages[i];
+		std::fprintf(d_file, "%12.6f %-5s [%d] ", (m.time - d_epoch) / 1e9,
+				level_names[m.level], m.thread);
+		if(m.type == TEXT) {
+			std::fwrite(m.data.data(), 1, m.data.size(), d_file);
+			std::fputc('\n', d_file);
+			continue;
+		}
+		// like print_bytes did
+		std::fprintf(d_file, "%s\n", m.tag.c_str());
+		for(size_t b = 0; b < m.data.size(); b++) {
+			std::fprintf(d_file, "%02d ", int(m.data[b]));
+		}
+		std::fputs("\n\n", d_file);
+	}
+	if(lost > d_reported) {
+		std::fprintf(d_file, "LOGGER: %llu messages dropped\n",
+				(unsigned long long)(lost - d_reported));
+		d_reported = lost;
+	}
+	std::fflush(d_file);
+}
+
+const char*
+logger::level_name(level l) {
+	return level_names[l];
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_LOGGER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_LOGGER_H
+
+#include "ring_writer.h"
+#include <cstdio>
+#include <ostream>
+#include <stdint.h>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// highest level that is compiled in, 0 (error) to 4 (trace). Messages
+// above it cost nothing, not even the test of the debug flag.
+#ifndef FREQUENCYADAPTIVEOFDM_LOG_LEVEL
+#define FREQUENCYADAPTIVEOFDM_LOG_LEVEL 4
+#endif
+
+#define LOG_ENABLED(level) \
+	(gr::frequencyAdaptiveOFDM::logger::L_##level <= FREQUENCYADAPTIVEOFDM_LOG_LEVEL)
+#define LOG_STREAM(level) \
+	gr::frequencyAdaptiveOFDM::logger::instance().stream(gr::frequencyAdaptiveOFDM::logger::L_##level)
+// lout(WARN) << "..." << std::endl;
+#define lout(level) LOG_ENABLED(level) && LOG_STREAM(level)
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Log messages of the blocks without writing from their threads.
+ *
+ * stream() is an ostream of the calling thread, every line written to
+ * it is one message. The message is copied with a time stamp and its
+ * level into a thread_ring of the thread, which takes no lock and never
+ * waits: if the ring is full the message is dropped and counted. bytes() does
+ * the same for the dumps of print_bytes(), they are only formatted by
+ * the writer. The ring_writer empties the rings every few ms, sorts the
+ * messages by time and writes them as
+ *
+ *   <s since start> <level> [<thread>] <message>
+ *
+ * to stdout or to the file of
+ *
+ *   [frequencyAdaptiveOFDM]
+ *   log_file = /tmp/frequencyAdaptiveOFDM.log
+ *
+ * in the GNU Radio config. The writer starts with the first message or
+ * the first block that attaches, the last block that detaches writes
+ * what is left.
+ */
+class logger : public ring_writer
+{
+public:
+	enum level {
+		L_ERROR,
+		L_WARN,
+		L_INFO,
+		L_DEBUG,  // dout
+		L_TRACE,  // print_bytes
+		N_LEVELS
+	};
+
+	logger();
+	~logger();
+
+	static logger& instance();
+	// reference counting for the blocks, see ring_writer
+	void attach() {
+		attach_block("");
+	}
+
+	// file may be empty for stdout
+	void start(const std::string &file);
+
+	std::ostream& stream(level l);
+	void bytes(level l, const std::string &tag, const char *data, int size);
+
+	static const char* level_name(level l);
+
+	// bytes per thread, a message takes 24 bytes plus its text
+	static const int RING_SIZE = 1 << 20;
+
+private:
+	enum type {
+		TEXT,
+		BYTES
+	};
+
+	// collects a line of stream()
+	class line_buf : public std::streambuf
+	{
+	public:
+		line_buf(logger *log) : d_logger(log), d_level(L_INFO) {}
+		void set_level(level l) { d_level = l; }
+	protected:
+		int overflow(int c);
+		std::streamsize xsputn(const char *s, std::streamsize n);
+	private:
+		logger *d_logger;
+		level d_level;
+		std::string d_line;
+	};
+
+	// ring of a thread and its stream()
+	struct ring : public thread_ring {
+		line_buf buf;
+		std::ostream out;
+		ring(logger *log, int thread) : thread_ring(RING_SIZE, thread),
+			buf(log), out(&buf) {}
+	};
+
+	void push(level l, type t, const std::string &tag, const char *data, int size);
+	ring* local_ring();
+	thread_ring* make_ring(int thread);
+	void autostart();
+	void attached(const std::string &file);
+	void detached();
+	void drain();
+	void stopped();
+
+	uint64_t d_epoch;
+
+	// d_mutex protects everything below
+	uint64_t d_reported;
+	FILE *d_file;
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_LOGGER_H */
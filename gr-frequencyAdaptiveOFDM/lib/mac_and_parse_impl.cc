@@ -130,10 +130,19 @@ namespace gr {
     }
 
     void
-    mac_and_parse_impl::sendAck(uint8_t ra[], int *psdu_size) {
-      //needs to wait 10 usecs before sending ack.
+    mac_and_parse_impl::sendBlockAck(uint8_t ra[], uint16_t ssn, uint64_t bitmap) {
       usleep(SIFS);
-      d_mac->sendAck(ra, psdu_size);
+      d_mac->sendBlockAck(ra, ssn, bitmap);
+    }
+
+    void
+    mac_and_parse_impl::ackReceived() {
+      d_mac->ackReceived();
+    }
+
+    void
+    mac_and_parse_impl::blockAckReceived(uint8_t ta[], uint16_t ssn, uint64_t bitmap) {
+      d_mac->blockAckReceived(ta, ssn, bitmap);
     }
 
 /*
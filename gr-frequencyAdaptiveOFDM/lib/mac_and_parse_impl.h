@@ -48,7 +48,9 @@ namespace gr {
       void setEncoding(std::vector<int> pilots_enc, int puncturing);
       //void setAckReceived(bool received);
 
-      void sendAck(uint8_t ra[], int *psdu_size);
+      void sendBlockAck(uint8_t ra[], uint16_t ssn, uint64_t bitmap);
+      void ackReceived();
+      void blockAckReceived(uint8_t ta[], uint16_t ssn, uint64_t bitmap);
       void decrease_encoding();
 
     private:
@@ -25,18 +25,22 @@
 
 #include <gnuradio/io_signature.h>
 #include "mac_impl.h"
+#include "crc32.h"
+#include "counters.h"
 #include <gnuradio/block_detail.h>
+#include <gnuradio/prefs.h>
+#include <boost/bind.hpp>
 
 #if defined(__APPLE__)
 #include <architecture/byte_order.h>
 #define htole16(x) OSSwapHostToLittleInt16(x)
+#define htole64(x) OSSwapHostToLittleInt64(x)
 #else
 #include <endian.h>
 #endif
 
-#include <boost/crc.hpp>
+#include <cstring>
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 
 namespace gr {
@@ -53,8 +57,8 @@ namespace gr {
         block("mac",
           gr::io_signature::make(0, 0, 0),
           gr::io_signature::make(0, 0, 0)),
-        d_seq_nr(0),
-        d_debug(debug) {
+        d_debug(debug),
+        d_arq(NULL) {
 
       message_port_register_in(pmt::mp("app in"));
       message_port_register_out(pmt::mp("phy out"));
@@ -71,17 +75,32 @@ namespace gr {
       }
 
       d_mac_and_parse = m_and_p;
-      n_tx_packets = 0;
-      tx_packets_fn = tx_packets_f;
+      counters::instance().attach();
+      // the file with the number of sent packets, for QoS
+      if(tx_packets_f) {
+        counters::instance().watch(counters::TX_PACKETS, tx_packets_f);
+      }
 
       if (d_debug) {
         ofdm_param ofdm(d_mac_and_parse->getEncoding(), d_mac_and_parse->getPuncturing());
         ofdm.print();
       }
       pthread_mutex_init(&d_mutex, NULL);
+
+      // window of outstanding frames, ACK timeout in us and retries
+      gr::prefs *prefs = gr::prefs::singleton();
+      d_arq = new arq_sender(
+          prefs->get_long("frequencyAdaptiveOFDM", "arq_window", 16),
+          prefs->get_long("frequencyAdaptiveOFDM", "arq_timeout", TIMEOUT),
+          prefs->get_long("frequencyAdaptiveOFDM", "arq_retries", 7),
+          boost::bind(&mac_impl::sendDataMsg, this, _1, _2, _3),
+          boost::bind(&mac_impl::sendBlockAckRequest, this, _1));
     }
 
     mac_impl::~mac_impl() {
+      // stops the retransmissions before the rest goes
+      delete d_arq;
+      counters::instance().detach();
       pthread_mutex_destroy(&d_mutex);
     }
 
@@ -112,46 +131,20 @@ namespace gr {
         throw std::runtime_error("Frame too large (> 1500)");
       }
 
-      // make MAC frame
-      /*if (d_mac_and_parse->getAckReceived()) {
-        if (d_mac_and_parse->d_debug_ack){
-          timeval time_now;
-          gettimeofday(&time_now, NULL);
-          std::cout << "\t\tWARNING: MAC: ACK received after timeout: " <<
-          time_now.tv_sec << " sec " << time_now.tv_usec << " usec\n";
-        }
-        d_mac_and_parse->setAckReceived(false);
-      }*/
-      sendDataMsg(msdu, msg_len);
-      usleep(TIMEOUT);
-      /*if (!d_mac_and_parse->getAckReceived()) {
-        if (d_mac_and_parse->d_debug_ack){
-          timeval time_now;
-          gettimeofday(&time_now, NULL);
-          std::cout << "\t\t\t\tWARNING: MAC: ACK NOT received after timeout: " <<
-          time_now.tv_sec << " sec " << time_now.tv_usec << " usec\n";
-        }
-
-      }else{
-        d_mac_and_parse->setAckReceived(false);
-      }*/
-
-      if(tx_packets_fn != ""){
-        n_tx_packets++;
-        std::fstream tx_packets_fs(tx_packets_fn, std::ofstream::out);
-        tx_packets_fs << n_tx_packets << std::endl;
-        tx_packets_fs.close();
+      // only waits while the window of the ARQ is full
+      if(d_arq->submit(msdu, msg_len)) {
+        counters::instance().add(counters::TX_PACKETS);
       }
     }
 
     void
-    mac_impl::sendDataMsg(const char* msdu, size_t msg_len) {
+    mac_impl::sendDataMsg(uint16_t seq, bool retry, const std::vector<char> &msdu) {
       int psdu_length;
       timeval tv;
       unsigned long current_time;
 
       pthread_mutex_lock(&d_mutex);
-      generate_mac_data_frame(msdu, msg_len, &psdu_length);
+      generate_mac_data_frame(msdu.data(), msdu.size(), seq, retry, &psdu_length);
       gettimeofday(&tv, NULL);
       current_time = 1000000 * tv.tv_sec + tv.tv_usec;
 
@@ -171,19 +164,43 @@ namespace gr {
       if (d_mac_and_parse->d_debug_ack){
         timeval time_now;
         gettimeofday(&time_now, NULL);
-        std::cout << "MAC: Message sent: " <<
+        std::cout << "MAC: Message " << seq << (retry ? " sent again: " : " sent: ") <<
         time_now.tv_sec << " sec " << time_now.tv_usec << " usec\n";
       }
     }
 
     void
-    mac_impl::sendAck(uint8_t ra[], int *psdu_size) {
+    mac_impl::sendBlockAckRequest(uint16_t ssn) {
+      int psdu_length;
+      pthread_mutex_lock(&d_mutex);
+      generate_mac_block_ack_frame(d_dst_mac, ssn, NULL, &psdu_length);
+      send_message(psdu_length, ofdm_param(std::vector<int>(N_RB, BPSK), P_1_2));
+      pthread_mutex_unlock(&d_mutex);
+    }
+
+    void
+    mac_impl::sendBlockAck(uint8_t ra[], uint16_t ssn, uint64_t bitmap) {
+      int psdu_length;
       pthread_mutex_lock(&d_mutex);
-      generate_mac_ack_frame(ra, psdu_size);
-      send_message(*psdu_size, ofdm_param(std::vector<int>(N_RB, BPSK), P_1_2));
+      generate_mac_block_ack_frame(ra, ssn, &bitmap, &psdu_length);
+      send_message(psdu_length, ofdm_param(std::vector<int>(N_RB, BPSK), P_1_2));
       pthread_mutex_unlock(&d_mutex);
     }
 
+    void
+    mac_impl::ackReceived() {
+      d_arq->ack();
+    }
+
+    void
+    mac_impl::blockAckReceived(uint8_t ta[], uint16_t ssn, uint64_t bitmap) {
+      // Block ACKs of other stations are not for our frames
+      if(std::memcmp(ta, d_dst_mac, 6)) {
+        return;
+      }
+      d_arq->block_ack(ssn, bitmap);
+    }
+
     void
     mac_impl::send_message(int psdu_length, ofdm_param ofdm) {
       // dict
@@ -199,10 +216,10 @@ namespace gr {
     }
 
     void
-    mac_impl::generate_mac_data_frame(const char *msdu, int msdu_size, int *psdu_size) {
+    mac_impl::generate_mac_data_frame(const char *msdu, int msdu_size, uint16_t seq, bool retry, int *psdu_size) {
       // mac header
       mac_header header;
-      header.frame_control = 0x0008;
+      header.frame_control = retry ? 0x0808 : 0x0008;
       header.duration = 0x0000;
 
       for(int i = 0; i < 6; i++) {
@@ -213,12 +230,11 @@ namespace gr {
 
       header.seq_nr = 0;
       for (int i = 0; i < 12; i++) {
-        if(d_seq_nr & (1 << i)) {
+        if(seq & (1 << i)) {
           header.seq_nr |=  (1 << (i + 4));
         }
       }
       header.seq_nr = htole16(header.seq_nr);
-      d_seq_nr++;
 
       //header size is 24, plus 4 for FCS means 28 bytes
       *psdu_size = 28 + msdu_size;
@@ -228,28 +244,29 @@ namespace gr {
       //copy msdu into psdu
       memcpy(d_psdu + 24, msdu, msdu_size);
       //compute and store fcs
-      boost::crc_32_type result;
-      result.process_bytes(d_psdu, msdu_size + 24);
-
-      uint32_t fcs = result.checksum();
+      uint32_t fcs = crc32(d_psdu, msdu_size + 24);
       memcpy(d_psdu + msdu_size + 24, &fcs, sizeof(uint32_t));
     }
 
     void
-    mac_impl::generate_mac_ack_frame(uint8_t ra[], int *psdu_size){
-      mac_ack_header header;
-      header.frame_control = 0x00D4;
+    mac_impl::generate_mac_block_ack_frame(uint8_t ra[], uint16_t ssn, const uint64_t *bitmap, int *psdu_size){
+      mac_block_ack_header header;
+      // Block ACK or Block ACK Request
+      header.frame_control = bitmap ? 0x0094 : 0x0084;
       header.duration = 0x0000;
 
       for(int i = 0; i < 6; i++) {
         header.ra[i] = ra[i];
+        header.ta[i] = d_src_mac[i];
       }
-      *psdu_size = 10;
-      std::memcpy(d_psdu, &header, *psdu_size);
-      boost::crc_32_type result;
-      result.process_bytes(d_psdu, *psdu_size);
+      // compressed bitmap
+      header.control = htole16(0x0004);
+      header.ssn = htole16(ssn << 4);
+      header.bitmap = bitmap ? htole64(*bitmap) : 0;
 
-      uint32_t fcs = result.checksum();
+      *psdu_size = bitmap ? sizeof(header) : sizeof(header) - sizeof(header.bitmap);
+      std::memcpy(d_psdu, &header, *psdu_size);
+      uint32_t fcs = crc32(d_psdu, *psdu_size);
       memcpy(d_psdu + *psdu_size, &fcs, sizeof(uint32_t));
 
       // Plus 4bytes of FCS
@@ -24,6 +24,7 @@
 
 #include <frequencyAdaptiveOFDM/mac_and_parse.h>
 #include <frequencyAdaptiveOFDM/mac.h>
+#include "arq.h"
 
 namespace gr {
   namespace frequencyAdaptiveOFDM {
@@ -39,7 +40,9 @@ namespace gr {
                 char* tx_packets_f);
       ~mac_impl();
 
-      void sendAck(uint8_t ra[], int *psdu_size);
+      void sendBlockAck(uint8_t ra[], uint16_t ssn, uint64_t bitmap);
+      void ackReceived();
+      void blockAckReceived(uint8_t ta[], uint16_t ssn, uint64_t bitmap);
 
     private:
       mac_and_parse* d_mac_and_parse;
@@ -49,16 +52,15 @@ namespace gr {
       uint8_t d_dst_mac[6];
       uint8_t d_bss_mac[6];
       uint8_t d_psdu[1528];
-      uint16_t d_seq_nr;
 
-      // For meassuring QoS
-      char* tx_packets_fn;
-      long n_tx_packets;
       bool d_debug;
+      arq_sender *d_arq;
 
-      void generate_mac_data_frame(const char *msdu, int msdu_size, int *psdu_size);
-      void generate_mac_ack_frame(uint8_t ra[], int *psdu_size);
-      void sendDataMsg(const char* msdu, size_t msg_len);
+      void generate_mac_data_frame(const char *msdu, int msdu_size, uint16_t seq, bool retry, int *psdu_size);
+      // Block ACK Request without a bitmap
+      void generate_mac_block_ack_frame(uint8_t ra[], uint16_t ssn, const uint64_t *bitmap, int *psdu_size);
+      void sendDataMsg(uint16_t seq, bool retry, const std::vector<char> &msdu);
+      void sendBlockAckRequest(uint16_t ssn);
       void send_message(int psdu_length, ofdm_param ofdm);
       void app_in (pmt::pmt_t msg);
     };
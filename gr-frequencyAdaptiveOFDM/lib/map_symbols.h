@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_MAP_SYMBOLS_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_MAP_SYMBOLS_H
+
+#include <stdint.h>
+
+// constellation points of the symbol mapping, 64 for each resource block
+#define SYMBOL_LUT_SIZE (4 * 64)
+
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+// map_symbols() of utils.h with the points as pairs of real and
+// imaginary part, built with -mavx2 in map_symbols_avx2.cc, only call it
+// if the CPU supports AVX2
+void map_symbols_avx2(const uint8_t *symbols, float *out, int n, const float *lut);
+#endif
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_MAP_SYMBOLS_H */
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * AVX2 kernel of map_symbols(), gathers the points of four carriers of
+ * the same resource block at once. A point is a pair of floats, so one
+ * 64 bit integer.
+ */
+#include "map_symbols.h"
+#include <immintrin.h>
+#include <cstring>
+
+void map_symbols_avx2(const uint8_t *symbols, float *out, int n, const float *lut) {
+	const __m128i mask = _mm_set1_epi32(63);
+	const long long *points = (const long long *) lut;
+	int i = 0;
+
+	// a resource block has 12 carriers, so each group of 4 is in one
+	for(; i + 4 <= n; i += 4) {
+		int v;
+		std::memcpy(&v, symbols + i, 4);
+		__m128i idx = _mm_and_si128(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(v)), mask);
+		idx = _mm_add_epi32(idx, _mm_set1_epi32(64 * ((i % 48) / 12)));
+		_mm256_storeu_si256((__m256i *) (out + 2 * i), _mm256_i32gather_epi64(points, idx, 8));
+	}
+	for(; i < n; i++) {
+		((long long *) out)[i] = points[64 * ((i % 48) / 12) + (symbols[i] & 63)];
+	}
+}
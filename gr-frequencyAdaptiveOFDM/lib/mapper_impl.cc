@@ -25,6 +25,7 @@
 
 #include <gnuradio/io_signature.h>
 #include "mapper_impl.h"
+#include <boost/bind.hpp>
 
 
 namespace gr {
@@ -32,25 +33,33 @@ namespace gr {
 
     mapper::sptr
     mapper::make(bool debug_enc, std::vector<int> pilots_enc, bool debug,
-                  bool log, char* tx_enc_f)
+                  bool log, char* tx_enc_f, bool packed_bits, int workers)
     {
       return gnuradio::get_initial_sptr
-        (new mapper_impl(debug_enc, pilots_enc, debug, log, tx_enc_f));
+        (new mapper_impl(debug_enc, pilots_enc, debug, log, tx_enc_f, packed_bits,
+                         workers));
     }
 
     mapper_impl::mapper_impl(bool debug_enc, std::vector<int> pilots_enc,
-                              bool debug, bool log, char* tx_enc_f)
+                              bool debug, bool log, char* tx_enc_f,
+                              bool packed_bits, int workers)
       : gr::block("mapper",
           gr::io_signature::make(0, 0, 0),
           gr::io_signature::make(1, 1, sizeof(char))),
           d_symbols_offset(0),
-          d_symbols(NULL),
+          d_symbols_len(0),
           d_debug(debug),
           d_debug_enc(debug_enc),
           d_log(log),
-          d_ofdm(pilots_enc, P_1_2)
+          d_packed_bits(packed_bits),
+          d_ofdm(pilots_enc, P_1_2),
+          d_scrambler(1),
+          d_ring_head(0),
+          d_ring_count(0),
+          d_stop(false)
     {
       message_port_register_in(pmt::mp("in"));
+      logger::instance().attach();
       if (d_debug_enc) {
         std::vector<int> enc;
         int punct;
@@ -66,11 +75,26 @@ namespace gr {
       if (tx_enc_f != "") {
         tx_enc_fstream.open(tx_enc_f, std::ofstream::out);
       }
+
+      if (workers > 0) {
+        // two frames per worker, one being encoded and one ready
+        d_ring.resize(2 * workers);
+        d_worker_buffers.resize(workers);
+        for (int i = 0; i < workers; i++) {
+          d_workers.create_thread(boost::bind(&mapper_impl::encode_worker, this, i));
+        }
+      }
     }
 
     mapper_impl::~mapper_impl()
     {
-      free(d_symbols);
+      {
+        gr::thread::scoped_lock lock(d_ring_mutex);
+        d_stop = true;
+      }
+      d_queued_cond.notify_all();
+      d_workers.join_all();
+      logger::instance().detach();
     }
 
     void
@@ -87,138 +111,225 @@ namespace gr {
       dout << std::dec << std::endl;
     }
 
-    int
-    mapper_impl::general_work(int noutput, gr_vector_int& ninput_items,
-          gr_vector_const_void_star& input_items,
-          gr_vector_void_star& output_items ) {
+    void
+    mapper_impl::encode_packed(const char *psdu, char *interleaved_data,
+          frame_param &frame, ofdm_param &ofdm, char scrambler) {
+
+      uint64_t data_bits[MAX_PACKED_WORDS];
+      uint64_t scrambled_data[MAX_PACKED_WORDS];
+      uint64_t encoded_data[2 * MAX_PACKED_WORDS];
+      uint64_t punctured_data[MAX_PACKED_WORDS];
+      std::vector<char> bits(dlog ? frame.n_data_bits * 2 : 0);
+
+      generate_bits_packed(psdu, data_bits, frame);
+      if (dlog) {
+        unpack_bits(data_bits, &bits[0], frame.psdu_size*8+16);
+        print_bytes("MAPPER: generated data bits:", &bits[0], frame.psdu_size*8+16);
+      }
 
-      unsigned char *out = (unsigned char*)output_items[0];
+      scramble_packed(data_bits, scrambled_data, frame, scrambler);
+      reset_tail_bits_packed(scrambled_data, frame);
+      if (dlog) {
+        unpack_bits(scrambled_data, &bits[0], frame.n_data_bits);
+        print_bytes("MAPPER: scrambled data and reset tail:", &bits[0], frame.n_data_bits);
+      }
 
-      while(!d_symbols_offset) {
-        pmt::pmt_t msg(delete_head_nowait(pmt::intern("in")));
+      convolutional_encoding_packed(scrambled_data, encoded_data, frame);
+      if (dlog) {
+        unpack_bits(encoded_data, &bits[0], frame.n_data_bits*2);
+        print_bytes("MAPPER: encoded data:", &bits[0], frame.n_data_bits*2);
+      }
 
-        if(!msg.get()) {
-          return 0;
+      puncturing_packed(encoded_data, punctured_data, frame, ofdm);
+      if (dlog) {
+        unpack_bits(punctured_data, &bits[0], frame.n_encoded_bits);
+        print_bytes("MAPPER: punctured and coded data:", &bits[0], frame.n_encoded_bits);
+      }
+
+      // interleaving unpacks the bits again for the symbol split
+      interleave_packed(punctured_data, interleaved_data, frame, ofdm);
+      if (dlog) {
+        print_bytes("MAPPER: interleaved data:", interleaved_data, frame.n_encoded_bits);
+      }
+    }
+
+    void
+    mapper_impl::encode(const char *psdu, char *symbols, frame_param &frame,
+          ofdm_param &ofdm, char scrambler, frame_buffers &buf) {
+
+      if (d_packed_bits) {
+        encode_packed(psdu, buf.interleaved_data, frame, ofdm, scrambler);
+      } else {
+        //generate the WIFI data field, adding service field and pad bits,
+        //the pad bits are not written by generate_bits
+        std::memset(buf.data_bits, 0, frame.n_data_bits);
+        generate_bits(psdu, buf.data_bits, frame);
+        if (dlog) {
+          print_bytes("MAPPER: generated data bits:", buf.data_bits, frame.psdu_size*8+16);
         }
 
-        if(pmt::is_pair(msg)) {
-          dout << "MAPPER: received new message" << std::endl;
+        // scrambling
+        scramble(buf.data_bits, buf.scrambled_data, frame, scrambler);
 
-          int psdu_length = pmt::blob_length(pmt::cdr(msg));
-          mac_header *h = (mac_header*)pmt::blob_data(pmt::cdr(msg));
-          const char *psdu = static_cast<const char*>(pmt::blob_data(pmt::cdr(msg)));
+        // reset tail bits
+        reset_tail_bits(buf.scrambled_data, frame);
+        if (dlog) {
+          print_bytes("MAPPER: scrambled data and reset tail:", buf.scrambled_data, frame.n_data_bits);
+        }
 
-          pmt::pmt_t dict = pmt::car(msg);
-          std::vector<int> enc = pmt::s32vector_elements(pmt::dict_ref(dict, pmt::mp("encoding"), pmt::init_s32vector(0, 0)));
-          int punct = pmt::to_long(pmt::dict_ref(dict, pmt::mp("puncturing"), pmt::from_long(-1)));
+        // encoding
+        convolutional_encoding(buf.scrambled_data, buf.encoded_data, frame);
+        if (dlog) {
+          print_bytes("MAPPER: encoded data:", buf.encoded_data, frame.n_data_bits*2);
+        }
 
+        // puncturing
+        puncturing(buf.encoded_data, buf.punctured_data, frame, ofdm);
+        if (dlog) {
+          print_bytes("MAPPER: punctured and coded data:", buf.punctured_data, frame.n_encoded_bits);
+        }
 
-          // ############ INSERT MAC STUFF
-          ofdm_param ofdm(enc, punct);
-          if (d_debug_enc) {
-            ofdm = d_ofdm;
-          }
-          frame_param frame(ofdm, psdu_length);
+        // interleaving
+        interleave(buf.punctured_data, buf.interleaved_data, frame, ofdm);
+        if (dlog) {
+          print_bytes("MAPPER: interleaved data:", buf.interleaved_data, frame.n_encoded_bits);
+        }
+      }
 
-          if (d_debug){
-            dout << "MAPPER: frame and coding:";
-            frame.print();
-            ofdm.print();
-          }
+      // one byte per symbol
+      split_symbols(buf.interleaved_data, symbols, frame, ofdm);
+      if (dlog) {
+        print_bytes("MAPPER: splited symbols:", symbols, frame.n_sym * 48);
+      }
+    }
 
-          if(frame.n_sym > MAX_SYM) {
-            std::cerr << "ERROR: MAPPER: packet too large, maximum number of symbols is " << MAX_SYM << std::endl;
-            return 0;
-          }
+    bool
+    mapper_impl::read_pdu(pmt::pmt_t msg, ofdm_param &ofdm, const char **psdu,
+          int *psdu_length, bool *data_frame) {
 
-          //alloc memory for modulation steps
-          char *data_bits        = (char*)calloc(frame.n_data_bits, sizeof(char));
-          char *scrambled_data   = (char*)calloc(frame.n_data_bits, sizeof(char));
-          char *encoded_data     = (char*)calloc(frame.n_data_bits * 2, sizeof(char));
-          char *punctured_data   = (char*)calloc(frame.n_encoded_bits, sizeof(char));
-          char *interleaved_data = (char*)calloc(frame.n_encoded_bits, sizeof(char));
-          char *symbols          = (char*)calloc((frame.n_encoded_bits / ofdm.n_bpsc), sizeof(char));
-
-          //generate the WIFI data field, adding service field and pad bits
-          generate_bits(psdu, data_bits, frame);
-          if (d_log) {
-            print_bytes("MAPPER: generated data bits:", data_bits, frame.psdu_size*8+16);
-          }
+      if(!pmt::is_pair(msg)) {
+        return false;
+      }
+      dout << "MAPPER: received new message" << std::endl;
 
-          // scrambling
-          static uint8_t scrambler = 1;
-          scramble(data_bits, scrambled_data, frame, scrambler++);
-          if(scrambler > 127) {
-            scrambler = 1;
-          }
+      *psdu_length = pmt::blob_length(pmt::cdr(msg));
+      mac_header *h = (mac_header*)pmt::blob_data(pmt::cdr(msg));
+      *psdu = static_cast<const char*>(pmt::blob_data(pmt::cdr(msg)));
+      // Only write modulation of Data frames
+      *data_frame = ((h->frame_control >> 2) & 3) == 2;
 
-          // reset tail bits
-          reset_tail_bits(scrambled_data, frame);
-          if (d_log) {
-            print_bytes("MAPPER: scrambled data and reset tail:", scrambled_data, frame.n_data_bits);
-          }
+      pmt::pmt_t dict = pmt::car(msg);
+      std::vector<int> enc = pmt::s32vector_elements(pmt::dict_ref(dict, pmt::mp("encoding"), pmt::init_s32vector(0, 0)));
+      int punct = pmt::to_long(pmt::dict_ref(dict, pmt::mp("puncturing"), pmt::from_long(-1)));
 
-          // encoding
-          convolutional_encoding(scrambled_data, encoded_data, frame);
-          if (d_log) {
-            print_bytes("MAPPER: encoded data:", encoded_data, frame.n_data_bits*2);
-          }
 
-          // puncturing
-          puncturing(encoded_data, punctured_data, frame, ofdm);
-          if (d_log) {
-            print_bytes("MAPPER: punctured and coded data:", punctured_data, frame.n_encoded_bits);
-          }
+      // ############ INSERT MAC STUFF
+      ofdm = ofdm_param(enc, punct);
+      if (d_debug_enc) {
+        ofdm = d_ofdm;
+      }
+      frame_param frame(ofdm, *psdu_length);
 
-          // interleaving
-          interleave(punctured_data, interleaved_data, frame, ofdm);
-          if (d_log) {
-            print_bytes("MAPPER: interleaved data:", interleaved_data, frame.n_encoded_bits);
-          }
+      if (LOG_ENABLED(DEBUG) && d_debug){
+        std::ostream &out = LOG_STREAM(DEBUG);
+        out << "MAPPER: frame and coding:";
+        frame.print(out);
+        ofdm.print(out);
+      }
 
-          // one byte per symbol
-          split_symbols(interleaved_data, symbols, frame, ofdm);
-          if (d_log) {
-            print_bytes("MAPPER: splited symbols:", symbols, frame.n_sym * 48);
-          }
+      if(frame.n_sym > MAX_SYM) {
+        std::cerr << "ERROR: MAPPER: packet too large, maximum number of symbols is " << MAX_SYM << std::endl;
+        return false;
+      }
+      return true;
+    }
+
+    char
+    mapper_impl::next_scrambler() {
+      char seed = d_scrambler++;
+      if(d_scrambler > 127) {
+        d_scrambler = 1;
+      }
+      return seed;
+    }
+
+    void
+    mapper_impl::add_frame_tags(int n_symbols, int psdu_length, ofdm_param &ofdm) {
+      pmt::pmt_t key = pmt::string_to_symbol("packet_len");
+      pmt::pmt_t value = pmt::from_long(n_symbols);
+      pmt::pmt_t srcid = pmt::string_to_symbol(alias());
+      add_item_tag(0, nitems_written(0), key, value, srcid);
+
+      pmt::pmt_t psdu_bytes = pmt::from_long(psdu_length);
+      add_item_tag(0, nitems_written(0), pmt::mp("psdu_len"),
+          psdu_bytes, srcid);
+
+      pmt::pmt_t encoding = pmt::init_s32vector(4, ofdm.resource_blocks_e);
+      add_item_tag(0, nitems_written(0), pmt::mp("encoding"),
+          encoding, srcid);
+
+      pmt::pmt_t pmt_punct = pmt::from_long(ofdm.punct);
+      add_item_tag(0, nitems_written(0), pmt::mp("puncturing"),
+          pmt_punct, srcid);
+    }
+
+    void
+    mapper_impl::log_encoding(ofdm_param &ofdm, bool data_frame) {
+      if (tx_enc_fstream.is_open() && data_frame){
+        // buffered, the file is complete once the block is gone
+        tx_enc_fstream << ofdm.toFileFormat();
+      }
+    }
 
-          d_symbols_len = frame.n_sym * 48;
+    int
+    mapper_impl::general_work(int noutput, gr_vector_int& ninput_items,
+          gr_vector_const_void_star& input_items,
+          gr_vector_void_star& output_items ) {
 
-          d_symbols = (char*)calloc(d_symbols_len, 1);
-          std::memcpy(d_symbols, symbols, d_symbols_len);
+      unsigned char *out = (unsigned char*)output_items[0];
 
-          // add tags
-          pmt::pmt_t key = pmt::string_to_symbol("packet_len");
-          pmt::pmt_t value = pmt::from_long(d_symbols_len);
-          pmt::pmt_t srcid = pmt::string_to_symbol(alias());
-          add_item_tag(0, nitems_written(0), key, value, srcid);
+      if(d_ring.empty()) {
+        return work_serial(noutput, out);
+      }
+      return work_pipelined(noutput, out);
+    }
 
-          pmt::pmt_t psdu_bytes = pmt::from_long(psdu_length);
-          add_item_tag(0, nitems_written(0), pmt::mp("psdu_len"),
-              psdu_bytes, srcid);
+    int
+    mapper_impl::work_serial(int noutput, unsigned char *out) {
 
-          pmt::pmt_t encoding = pmt::init_s32vector(4, ofdm.resource_blocks_e);
-          add_item_tag(0, nitems_written(0), pmt::mp("encoding"),
-              encoding, srcid);
+      while(!d_symbols_offset) {
+        // Sleep until a PDU arrives instead of returning right away, the
+        // block has no inputs, so the scheduler would call it again at
+        // once. The timeout gives the scheduler the chance to stop it.
+        pmt::pmt_t msg(delete_head_blocking(pmt::intern("in"), PDU_WAIT_MS));
 
-          pmt::pmt_t pmt_punct = pmt::from_long(ofdm.punct);
-          add_item_tag(0, nitems_written(0), pmt::mp("puncturing"),
-              pmt_punct, srcid);
+        if(!msg.get()) {
+          return 0;
+        }
 
-          // Only write modulation of Data frames
-          if (tx_enc_fstream.is_open() && ((h->frame_control >> 2) & 3) == 2){
-            tx_enc_fstream << ofdm.toFileFormat();
-            tx_enc_fstream.flush();
-          }
+        ofdm_param ofdm;
+        const char *psdu;
+        int psdu_length;
+        bool data_frame;
+        if(!read_pdu(msg, ofdm, &psdu, &psdu_length, &data_frame)) {
+          continue;
+        }
+        frame_param frame(ofdm, psdu_length);
 
-          free(data_bits);
-          free(scrambled_data);
-          free(encoded_data);
-          free(punctured_data);
-          free(interleaved_data);
-          free(symbols);
-          break;
+        d_symbols_len = frame.n_sym * 48;
+
+        // straight into the output buffer if the frame fits
+        char *symbols = noutput >= d_symbols_len ? (char*)out : d_symbols;
+        encode(psdu, symbols, frame, ofdm, next_scrambler(), d_buffers);
+
+        add_frame_tags(d_symbols_len, psdu_length, ofdm);
+        log_encoding(ofdm, data_frame);
+
+        if(symbols == (char*)out) {
+          dout << "MAPPER: symbols mapped\n";
+          return d_symbols_len;
         }
+        break;
       }
 
       int i = std::min(noutput, d_symbols_len - d_symbols_offset);
@@ -227,13 +338,116 @@ namespace gr {
 
       if(d_symbols_offset == d_symbols_len) {
         d_symbols_offset = 0;
-        free(d_symbols);
-        d_symbols = 0;
 
         dout << "MAPPER: symbols mapped\n";
       }
       return i;
     }
 
+    bool
+    mapper_impl::queue_pdu(pmt::pmt_t msg) {
+      // the tail of the ring is FREE, nobody else touches it
+      tx_frame &f = d_ring[(d_ring_head + d_ring_count) % d_ring.size()];
+      const char *psdu;
+      if(!read_pdu(msg, f.ofdm, &psdu, &f.psdu_length, &f.data_frame)) {
+        return false;
+      }
+      std::memcpy(f.psdu, psdu, f.psdu_length);
+      f.scrambler = next_scrambler();
+
+      gr::thread::scoped_lock lock(d_ring_mutex);
+      f.state = tx_frame::QUEUED;
+      d_ring_count++;
+      d_queued_cond.notify_one();
+      return true;
+    }
+
+    int
+    mapper_impl::work_pipelined(int noutput, unsigned char *out) {
+
+      // hand everything that is queued to the workers while there is room
+      while(d_ring_count < (int)d_ring.size()) {
+        pmt::pmt_t msg;
+        if(d_ring_count) {
+          msg = delete_head_nowait(pmt::intern("in"));
+        } else {
+          // nothing in flight, sleep until a PDU arrives
+          msg = delete_head_blocking(pmt::intern("in"), PDU_WAIT_MS);
+        }
+        if(!msg.get()) {
+          break;
+        }
+        queue_pdu(msg);
+      }
+      if(!d_ring_count) {
+        return 0;
+      }
+
+      tx_frame &f = d_ring[d_ring_head];
+      {
+        gr::thread::scoped_lock lock(d_ring_mutex);
+        while(f.state != tx_frame::READY) {
+          if(!d_ready_cond.timed_wait(lock,
+                boost::posix_time::milliseconds(PDU_WAIT_MS))) {
+            return 0;
+          }
+        }
+      }
+
+      if(!d_symbols_offset) {
+        add_frame_tags(f.n_symbols, f.psdu_length, f.ofdm);
+        log_encoding(f.ofdm, f.data_frame);
+      }
+
+      int i = std::min(noutput, f.n_symbols - d_symbols_offset);
+      std::memcpy(out, f.symbols + d_symbols_offset, i);
+      d_symbols_offset += i;
+
+      if(d_symbols_offset == f.n_symbols) {
+        d_symbols_offset = 0;
+
+        gr::thread::scoped_lock lock(d_ring_mutex);
+        f.state = tx_frame::FREE;
+        d_ring_head = (d_ring_head + 1) % d_ring.size();
+        d_ring_count--;
+
+        dout << "MAPPER: symbols mapped\n";
+      }
+      return i;
+    }
+
+    void
+    mapper_impl::encode_worker(int index) {
+      gr::thread::scoped_lock lock(d_ring_mutex);
+      while(true) {
+        // oldest frame nobody works on yet
+        tx_frame *f = NULL;
+        for(int k = 0; k < d_ring_count && !f; k++) {
+          tx_frame &c = d_ring[(d_ring_head + k) % d_ring.size()];
+          if(c.state == tx_frame::QUEUED) {
+            f = &c;
+          }
+        }
+        if(d_stop) {
+          return;
+        }
+        if(!f) {
+          d_queued_cond.wait(lock);
+          continue;
+        }
+        f->state = tx_frame::ENCODING;
+        lock.unlock();
+
+        frame_param frame(f->ofdm, f->psdu_length);
+        f->n_symbols = frame.n_sym * 48;
+        encode(f->psdu, f->symbols, frame, f->ofdm, f->scrambler,
+            d_worker_buffers[index]);
+
+        lock.lock();
+        f->state = tx_frame::READY;
+        d_ready_cond.notify_one();
+      }
+    }
+
   } /* namespace frequencyAdaptiveOFDM */
 } /* namespace gr */
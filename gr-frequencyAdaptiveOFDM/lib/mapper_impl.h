@@ -25,7 +25,10 @@
 
 #include <frequencyAdaptiveOFDM/mapper.h>
 #include "utils.h"
+#include <gnuradio/thread/thread.h>
+#include <boost/thread/thread.hpp>
 #include <fstream>
+#include <vector>
 
 namespace gr {
   namespace frequencyAdaptiveOFDM {
@@ -33,18 +36,77 @@ namespace gr {
     class mapper_impl : public mapper
     {
     private:
+      // longest wait for a PDU in one call of general_work
+      static const unsigned int PDU_WAIT_MS = 100;
+
+      // working buffers of one frame, sized for the largest frame and
+      // reused for all of them
+      struct frame_buffers {
+        char data_bits[MAX_ENCODED_BITS];
+        char scrambled_data[MAX_ENCODED_BITS];
+        char encoded_data[2 * MAX_ENCODED_BITS];
+        char punctured_data[MAX_ENCODED_BITS];
+        char interleaved_data[MAX_ENCODED_BITS];
+      };
+
+      // frame in the ring of the encoding workers, a frame is FREE or
+      // READY while general_work owns it and QUEUED or ENCODING while a
+      // worker does
+      struct tx_frame {
+        enum { FREE, QUEUED, ENCODING, READY } state;
+        ofdm_param ofdm;
+        char psdu[MAX_PSDU_SIZE];
+        int psdu_length;
+        char scrambler;
+        bool data_frame;
+        int n_symbols;
+        char symbols[48 * MAX_SYM];
+
+        tx_frame() : state(FREE) {}
+      };
+
       bool d_debug_enc;
       bool d_debug;
       bool d_log;
-      char* d_symbols;
+      bool d_packed_bits;
       int d_symbols_offset;
       int d_symbols_len;
+
+      frame_buffers d_buffers;
+      // symbols of a frame that did not fit into the output buffer
+      char d_symbols[48 * MAX_SYM];
       ofdm_param d_ofdm;
+      // scrambler seed of the next frame, cycles through 1..127
+      uint8_t d_scrambler;
       std::ofstream tx_enc_fstream;
 
+      // encoding workers, frames leave the ring in the order they entered
+      std::vector<tx_frame> d_ring;
+      std::vector<frame_buffers> d_worker_buffers;
+      boost::thread_group d_workers;
+      gr::thread::mutex d_ring_mutex;
+      gr::thread::condition_variable d_queued_cond;
+      gr::thread::condition_variable d_ready_cond;
+      int d_ring_head;
+      int d_ring_count;
+      bool d_stop;
+
+      void encode(const char *psdu, char *symbols, frame_param &frame,
+                  ofdm_param &ofdm, char scrambler, frame_buffers &buf);
+      bool read_pdu(pmt::pmt_t msg, ofdm_param &ofdm, const char **psdu,
+                  int *psdu_length, bool *data_frame);
+      char next_scrambler();
+      void add_frame_tags(int n_symbols, int psdu_length, ofdm_param &ofdm);
+      void log_encoding(ofdm_param &ofdm, bool data_frame);
+
+      int work_serial(int noutput, unsigned char *out);
+      int work_pipelined(int noutput, unsigned char *out);
+      bool queue_pdu(pmt::pmt_t msg);
+      void encode_worker(int index);
+
     public:
       mapper_impl(bool debug_enc, std::vector<int> pilots_enc, bool debug,
-                  bool log, char* tx_enc_f);
+                  bool log, char* tx_enc_f, bool packed_bits, int workers);
       ~mapper_impl();
 
       int general_work(int noutput_items,
@@ -53,6 +115,8 @@ namespace gr {
            gr_vector_void_star &output_items);
 
       void print_message(const char *msg, size_t len);
+      void encode_packed(const char *psdu, char *interleaved_data,
+                  frame_param &frame, ofdm_param &ofdm, char scrambler);
     };
 
 
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ofdm_equalizer.h"
+#include "counters.h"
+#include "equalizer/comb.h"
+#include "equalizer/lms.h"
+#include "equalizer/ls.h"
+#include "equalizer/sta.h"
+#include <stdexcept>
+#ifdef FREQUENCYADAPTIVEOFDM_MSSE2
+#include <emmintrin.h>
+#endif
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+/* out[j] = in[j] * phase * step^j for the 64 carriers of a symbol. The
+ * phasor is advanced by a complex multiplication per carrier instead of
+ * an exp(), the drift over one symbol is in the order of the float
+ * precision.
+ */
+static void
+rotate_symbol(const gr_complex *in, gr_complex *out, gr_complex phase, gr_complex step) {
+#ifdef FREQUENCYADAPTIVEOFDM_MSSE2
+	// two carriers per register, re/im interleaved as in gr_complex
+	const __m128 sign = _mm_setr_ps(-1, 1, -1, 1);
+	gr_complex step2 = step * step;
+	gr_complex start[2] = { phase, phase * step };
+	__m128 ph = _mm_loadu_ps((const float *)start);
+	__m128 st_re = _mm_set1_ps(step2.real());
+	__m128 st_im = _mm_set1_ps(step2.imag());
+
+	for(int j = 0; j < 64; j += 2) {
+		__m128 x = _mm_loadu_ps((const float *)(in + j));
+		__m128 ph_re = _mm_shuffle_ps(ph, ph, _MM_SHUFFLE(2, 2, 0, 0));
+		__m128 ph_im = _mm_shuffle_ps(ph, ph, _MM_SHUFFLE(3, 3, 1, 1));
+		__m128 x_swap = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+		_mm_storeu_ps((float *)(out + j), _mm_add_ps(_mm_mul_ps(x, ph_re),
+				_mm_mul_ps(sign, _mm_mul_ps(x_swap, ph_im))));
+
+		__m128 ph_swap = _mm_shuffle_ps(ph, ph, _MM_SHUFFLE(2, 3, 0, 1));
+		ph = _mm_add_ps(_mm_mul_ps(ph, st_re), _mm_mul_ps(sign, _mm_mul_ps(ph_swap, st_im)));
+	}
+#else
+	for(int j = 0; j < 64; j++) {
+		out[j] = in[j] * phase;
+		phase *= step;
+	}
+#endif
+}
+
+ofdm_equalizer::ofdm_equalizer(Equalizer algo, double freq, double bw,
+		bool debug, bool debug_parity) :
+	d_equalizer(NULL), d_current_symbol(0), d_freq(freq),
+	d_freq_offset_from_synclong(0.0), d_bw(bw), d_er(0), d_epsilon0(0),
+	d_frame_bytes(0), d_frame_symbols(0), d_frame_enc(4, BPSK),
+	d_frame_punct(P_1_2), d_signal_ofdm(std::vector<int>(4, BPSK), P_1_2),
+	d_signal_frame(d_signal_ofdm, 0), d_frame_mod(4, BPSK),
+	d_sta_alpha(equalizer::sta::DEFAULT_ALPHA),
+	d_sta_beta(equalizer::sta::DEFAULT_BETA), d_keep_frame_errors(false),
+	d_debug(debug),
+	d_debug_parity(debug_parity) {
+
+	set_algorithm(algo);
+}
+
+ofdm_equalizer::~ofdm_equalizer() {
+	delete d_equalizer;
+}
+
+void
+ofdm_equalizer::set_algorithm(Equalizer algo) {
+	delete d_equalizer;
+	dout << "FRAME EQ: Algorithm set to: ";
+	switch(algo) {
+
+	case COMB:
+		dout << "Comb" << std::endl;
+		d_equalizer = new equalizer::comb();
+		break;
+	case LS:
+		dout << "LS" << std::endl;
+		d_equalizer = new equalizer::ls();
+		break;
+	case LMS:
+		dout << "LMS" << std::endl;
+		d_equalizer = new equalizer::lms();
+		break;
+	case STA:
+		dout << "STA" << std::endl;
+		d_equalizer = new equalizer::sta(d_sta_alpha, d_sta_beta);
+		break;
+	default:
+		throw std::runtime_error("Algorithm not implemented");
+	}
+	d_equalizer->set_encoding(d_frame_mod);
+	d_equalizer->set_keep_frame_errors(d_keep_frame_errors);
+}
+
+void
+ofdm_equalizer::set_sta_smoothing(double alpha, int beta) {
+	equalizer::sta::check_smoothing(alpha, beta);
+	equalizer::sta *sta = dynamic_cast<equalizer::sta*>(d_equalizer);
+	if(sta) {
+		sta->set_smoothing(alpha, beta);
+	}
+	d_sta_alpha = alpha;
+	d_sta_beta = beta;
+}
+
+void
+ofdm_equalizer::set_bandwidth(double bw) {
+	d_bw = bw;
+}
+
+void
+ofdm_equalizer::set_frequency(double freq) {
+	d_freq = freq;
+}
+
+void
+ofdm_equalizer::new_frame(double cfo) {
+	d_current_symbol = 0;
+	d_frame_symbols = 0;
+	d_frame_mod.assign(4, BPSK);
+	d_equalizer->set_encoding(d_frame_mod);
+	d_equalizer->new_frame();
+
+	d_freq_offset_from_synclong = cfo * d_bw / (2 * M_PI);
+	d_epsilon0 = cfo * d_bw / (2 * M_PI * d_freq);
+	d_er = 0;
+
+	dout << "FRAME EQ: new frame. Epsilon: " << d_epsilon0 << std::endl;
+}
+
+bool
+ofdm_equalizer::in_frame() const {
+	return d_current_symbol <= d_frame_symbols + 3;
+}
+
+int
+ofdm_equalizer::current_symbol() const {
+	return d_current_symbol;
+}
+
+bool
+ofdm_equalizer::equalize(const gr_complex *in, gr_complex *symbols, uint8_t *bits) {
+
+	gr_complex current_symbol[64];
+
+	// sampling offset, phase of carrier j is (j - 32) * phi
+	double phi = 2*M_PI*d_current_symbol*80*(d_epsilon0 + d_er)/64;
+	gr_complex w7 = gr_complex(std::polar(1.0, 7 * phi));
+	gr_complex w21 = gr_complex(std::polar(1.0, 21 * phi));
+	gr_complex pilots[4] = {
+		in[11] * conj(w21),
+		in[25] * conj(w7),
+		in[39] * w7,
+		in[53] * w21 };
+
+	gr_complex p = equalizer::base::POLARITY[(d_current_symbol - 2) % 127];
+
+	double beta;
+	if(d_current_symbol < 2) {
+		beta = arg(
+				pilots[0] -
+				pilots[1] +
+				pilots[2] +
+				pilots[3]);
+
+	} else {
+		beta = arg(
+				(pilots[0] *  p) +
+				(pilots[2] *  p) +
+				(pilots[1] *  p) +
+				(pilots[3] * -p));
+	}
+
+	double er = arg(
+			(conj(d_prev_pilots[0]) * pilots[0] *  p) +
+			(conj(d_prev_pilots[1]) * pilots[1] *  p) +
+			(conj(d_prev_pilots[2]) * pilots[2] *  p) +
+			(conj(d_prev_pilots[3]) * pilots[3] * -p));
+
+	er *= d_bw / (2 * M_PI * d_freq * 80);
+
+	d_prev_pilots[0] = pilots[0] *  p;
+	d_prev_pilots[1] = pilots[1] *  p;
+	d_prev_pilots[2] = pilots[2] *  p;
+	d_prev_pilots[3] = pilots[3] * -p;
+
+	// compensate sampling offset and residual frequency offset in one pass
+	rotate_symbol(in, current_symbol, gr_complex(std::polar(1.0, -32 * phi - beta)),
+			gr_complex(std::polar(1.0, phi)));
+
+	// update estimate of residual frequency offset
+	if(d_current_symbol >= 2) {
+		double alpha = 0.1;
+		d_er = (1-alpha) * d_er + alpha * er;
+	}
+
+	// the signal field is kept internally
+	if((d_current_symbol == 2) || (d_current_symbol == 3)) {
+		bits = d_signal_bits + (d_current_symbol - 2) * 48;
+	} else if(d_current_symbol < 2) {
+		bits = d_signal_bits;
+	}
+	// do equalization
+	d_equalizer->equalize(current_symbol, d_current_symbol,
+			symbols, bits);
+
+	bool signal = d_current_symbol == 3 && decode_signal_field(d_signal_bits);
+	if(signal) {
+		d_equalizer->accept_frame();
+	}
+	if(signal && LOG_ENABLED(DEBUG) && d_debug) {
+		std::ostream &out = LOG_STREAM(DEBUG);
+		out << "FRAME EQ: frame coding:" << std::endl;
+		ofdm_param ofdm(d_frame_enc, d_frame_punct);
+		ofdm.print(out);
+	}
+
+	d_current_symbol++;
+	return signal;
+}
+
+void
+ofdm_equalizer::soft_bits(const gr_complex *symbols, int8_t *llr) {
+	d_equalizer->soft_bits(symbols, d_frame_enc, llr);
+}
+
+int
+ofdm_equalizer::frame_bytes() const {
+	return d_frame_bytes;
+}
+
+int
+ofdm_equalizer::frame_symbols() const {
+	return d_frame_symbols;
+}
+
+const std::vector<int>&
+ofdm_equalizer::frame_encoding() const {
+	return d_frame_enc;
+}
+
+int
+ofdm_equalizer::frame_puncturing() const {
+	return d_frame_punct;
+}
+
+std::vector<double>
+ofdm_equalizer::rb_snr() const {
+	return d_equalizer->rb_snr();
+}
+
+const std::vector<float>&
+ofdm_equalizer::frame_errors() const {
+	return d_equalizer->frame_errors();
+}
+
+void
+ofdm_equalizer::set_keep_frame_errors(bool keep) {
+	d_equalizer->set_keep_frame_errors(keep);
+	d_keep_frame_errors = keep;
+}
+
+double
+ofdm_equalizer::frequency() const {
+	return d_freq;
+}
+
+double
+ofdm_equalizer::freq_offset() const {
+	return d_freq_offset_from_synclong;
+}
+
+bool
+ofdm_equalizer::decode_signal_field(uint8_t *rx_bits) {
+	d_signal_frame.to_header_param();
+
+	interleave((char*)rx_bits, (char*)d_deinterleaved, d_signal_frame, d_signal_ofdm, true);
+	uint8_t *decoded_bits = d_decoder.decode(&d_signal_ofdm, &d_signal_frame, d_deinterleaved);
+	return parse_signal(decoded_bits);
+}
+
+bool
+ofdm_equalizer::parse_signal(uint8_t *decoded_bits) {
+	for (int i = 0; i < 4; i++){
+		d_frame_enc[i] = 0;
+	}
+	d_frame_punct = P_1_2;
+
+	d_frame_bytes = 0;
+	bool parity = false;
+	for(int i = 0; i < 21; i++) {
+		parity ^= decoded_bits[i];
+
+		if((i < 2) && decoded_bits[i]) {
+			d_frame_enc[0] = d_frame_enc[0] | (1 << i);
+		}else if(i < 4 && decoded_bits[i]){
+			d_frame_enc[1] = d_frame_enc[1] | (1 << (i-2));
+		}else if(i < 6 && decoded_bits[i]){
+			d_frame_enc[2] = d_frame_enc[2] | (1 << (i-4));
+		}else if(i < 8 && decoded_bits[i]){
+			d_frame_enc[3] = d_frame_enc[3] | (1 << (i-6));
+		}else if (i == 8) {
+			d_frame_punct = decoded_bits[i];
+		}
+
+		if(decoded_bits[i] && (i > 8) && (i < 21)) {
+			d_frame_bytes = d_frame_bytes | (1 << (i-9));
+		}
+	}
+
+	if(parity != decoded_bits[21]) {
+		if (d_debug || d_debug_parity){
+			lout(WARN) << "FRAME EQUALIZER: wrong parity" << std::endl;
+		}
+		counters::instance().add(counters::PARITY_ERRORS);
+		return false;
+	}
+
+	bool all_mod_64QAM = true;
+	for(int i = 0; i < 4; i++){
+		if(d_frame_enc[i] < BPSK || d_frame_enc[i] > QAM64){
+			lout(ERROR) << "FRAME EQUALIZER: wrong modulation found" << std::endl;
+			return false;
+		}
+		if(d_frame_enc[i] != QAM64){
+			all_mod_64QAM = false;
+		}
+	}
+	d_frame_mod = d_frame_enc;
+	d_equalizer->set_encoding(d_frame_mod);
+
+	if (all_mod_64QAM && d_frame_punct == P_1_2) {
+		d_frame_punct = P_2_3;
+	}
+
+	ofdm_param ofdm_received(d_frame_enc, d_frame_punct);
+	frame_param frame_received(ofdm_received, d_frame_bytes);
+	d_frame_symbols = frame_received.n_sym;
+	return true;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_OFDM_EQUALIZER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_OFDM_EQUALIZER_H
+
+#include <frequencyAdaptiveOFDM/frame_equalizer.h>
+#include "equalizer/base.h"
+#include "viterbi_decoder/viterbi_decoder.h"
+#include "utils.h"
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Equalizes the OFDM symbols of a frame, one at a time: compensates the
+ * sampling and residual frequency offset with the pilots, estimates the
+ * channel with the selected algorithm and decodes the signal field.
+ * Symbols 0 and 1 are the long training sequence, 2 and 3 the signal
+ * field and the data symbols follow. Used by frame_equalizer and
+ * frame_decoder, their users hold the lock for the setters.
+ */
+class ofdm_equalizer
+{
+public:
+
+	ofdm_equalizer(Equalizer algo, double freq, double bw, bool debug,
+			bool debug_parity);
+	~ofdm_equalizer();
+
+	void set_algorithm(Equalizer algo);
+	void set_bandwidth(double bw);
+	void set_frequency(double freq);
+	// smoothing of the STA equalizer, kept when the algorithm changes
+	void set_sta_smoothing(double alpha, int beta);
+
+	// starts a frame, cfo is the frequency offset estimated by sync_long
+	// in rad per sample
+	void new_frame(double cfo);
+
+	// symbols up to the last data symbol of a frame with a valid signal
+	// field are part of the frame, the others can be skipped
+	bool in_frame() const;
+	int current_symbol() const;
+
+	// equalizes the next symbol of the frame into the 48 data carriers and
+	// their hard decisions, bits are only written for data symbols.
+	// Returns true after the signal field was decoded and is valid.
+	bool equalize(const gr_complex *in, gr_complex *symbols, uint8_t *bits);
+
+	// LLRs of the last equalized data symbol, see equalizer::base
+	void soft_bits(const gr_complex *symbols, int8_t *llr);
+
+	// signal field of the current frame
+	int frame_bytes() const;
+	int frame_symbols() const;
+	const std::vector<int>& frame_encoding() const;
+	int frame_puncturing() const;
+
+	// effective SNR (dB) of the resource blocks, see equalizer::base
+	std::vector<double> rb_snr() const;
+	// error powers of the current frame, see equalizer::base, kept
+	// when the algorithm changes
+	const std::vector<float>& frame_errors() const;
+	void set_keep_frame_errors(bool keep);
+	double frequency() const;
+	double freq_offset() const;
+
+private:
+	bool decode_signal_field(uint8_t *rx_bits);
+	bool parse_signal(uint8_t *signal);
+
+	equalizer::base *d_equalizer;
+	int d_current_symbol;
+	viterbi_decoder d_decoder;
+
+	// freq offset
+	double d_freq;  // Hz
+	double d_freq_offset_from_synclong;  // Hz, estimation from "sync_long" block
+	double d_bw;  // Hz
+	double d_er;
+	double d_epsilon0;
+	gr_complex d_prev_pilots[4];
+
+	int d_frame_bytes;
+	int d_frame_symbols;
+	std::vector<int> d_frame_enc;
+	int d_frame_punct;
+
+	// parameters of the signal field, one set per instance as the
+	// equalizers of the rx_engine run in parallel
+	ofdm_param d_signal_ofdm;
+	frame_param d_signal_frame;
+
+	uint8_t d_deinterleaved[48*2];
+	uint8_t d_signal_bits[48*2];
+
+	// modulations the symbols are sliced with
+	std::vector<int> d_frame_mod;
+
+	double d_sta_alpha;
+	int d_sta_beta;
+	bool d_keep_frame_errors;
+
+	bool d_debug;
+	bool d_debug_parity;
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_OFDM_EQUALIZER_H */
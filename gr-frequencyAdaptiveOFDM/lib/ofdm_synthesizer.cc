@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ofdm_synthesizer.h"
+#include "signal_field_impl.h"
+#include "equalizer/base.h"
+#include <frequencyAdaptiveOFDM/constellations.h>
+#include <gnuradio/fft/fft.h>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+namespace {
+
+// sync words of the carrier allocator, index i is carrier i - 32
+const float SHORT[64] = {
+	 0,  0,  0,  0,  0,  0,  0,  0,  1,  0,  0,  0, -1,  0,  0,  0,
+	 1,  0,  0,  0, -1,  0,  0,  0, -1,  0,  0,  0,  1,  0,  0,  0,
+	 0,  0,  0,  0, -1,  0,  0,  0, -1,  0,  0,  0,  1,  0,  0,  0,
+	 1,  0,  0,  0,  1,  0,  0,  0,  1,  0,  0,  0,  0,  0,  0,  0
+};
+
+const gr_complex LONG_ROTATED[64] = {
+	gr_complex( 0,  0), gr_complex( 0,  0), gr_complex( 0,  0), gr_complex( 0,  0),
+	gr_complex( 0,  0), gr_complex( 0,  0), gr_complex(-1,  0), gr_complex( 0,  1),
+	gr_complex(-1,  0), gr_complex( 0,  1), gr_complex(-1,  0), gr_complex( 0,  1),
+	gr_complex(-1,  0), gr_complex( 0, -1), gr_complex( 1,  0), gr_complex( 0,  1),
+	gr_complex( 1,  0), gr_complex( 0, -1), gr_complex(-1,  0), gr_complex( 0,  1),
+	gr_complex( 1,  0), gr_complex( 0,  1), gr_complex( 1,  0), gr_complex( 0,  1),
+	gr_complex( 1,  0), gr_complex( 0,  1), gr_complex(-1,  0), gr_complex( 0, -1),
+	gr_complex( 1,  0), gr_complex( 0, -1), gr_complex(-1,  0), gr_complex( 0,  1),
+	gr_complex( 0,  0), gr_complex( 0, -1), gr_complex( 1,  0), gr_complex( 0, -1),
+	gr_complex( 1,  0), gr_complex( 0, -1), gr_complex( 1,  0), gr_complex( 0,  1),
+	gr_complex(-1,  0), gr_complex( 0, -1), gr_complex( 1,  0), gr_complex( 0, -1),
+	gr_complex(-1,  0), gr_complex( 0,  1), gr_complex( 1,  0), gr_complex( 0,  1),
+	gr_complex( 1,  0), gr_complex( 0,  1), gr_complex( 1,  0), gr_complex( 0,  1),
+	gr_complex(-1,  0), gr_complex( 0, -1), gr_complex( 1,  0), gr_complex( 0,  1),
+	gr_complex( 1,  0), gr_complex( 0, -1), gr_complex(-1,  0), gr_complex( 0,  0),
+	gr_complex( 0,  0), gr_complex( 0,  0), gr_complex( 0,  0), gr_complex( 0,  0)
+};
+
+const float LONG[64] = {
+	 0,  0,  0,  0,  0,  0,  1,  1, -1, -1,  1,  1, -1,  1, -1,  1,
+	 1,  1,  1,  1,  1, -1, -1,  1,  1, -1,  1, -1,  1,  1,  1,  1,
+	 0,  1, -1, -1,  1,  1, -1,  1, -1,  1, -1, -1, -1, -1, -1,  1,
+	 1, -1, -1,  1, -1,  1, -1,  1,  1,  1,  1,  0,  0,  0,  0,  0
+};
+
+// pilots of the first symbol, later symbols multiply them with the polarity
+const int PILOT_CARRIERS[4] = { -21, -7, 7, 21 };
+const float PILOTS[4] = { 1, 1, 1, -1 };
+
+// IFFT window of the hierarchy
+const float SCALE = 1 / std::sqrt(52.0f);
+
+// rolloff flank of the cyclic prefixer, the first sample of a symbol is
+// half of itself and half of the first sample of the previous symbol
+const float FLANK = 0.5f;
+
+}
+
+ofdm_synthesizer::ofdm_synthesizer() {
+
+	std::vector<int> occupied = occupied_carriers()[0];
+	for(int i = 0; i < 48; i++) {
+		d_data_bins[i] = (occupied[i] + FFT_LEN) % FFT_LEN;
+	}
+	for(int i = 0; i < 4; i++) {
+		d_pilot_bins[i] = (PILOT_CARRIERS[i] + FFT_LEN) % FFT_LEN;
+	}
+
+	gr::digital::constellation_sptr constellations[4];
+	constellations[BPSK] = constellation_bpsk::make();
+	constellations[QPSK] = constellation_qpsk::make();
+	constellations[QAM16] = constellation_16qam::make();
+	constellations[QAM64] = constellation_64qam::make();
+
+	for(int e = 0; e < 4; e++) {
+		std::vector<gr_complex> points = constellations[e]->points();
+		for(int v = 0; v < 64; v++) {
+			d_points[e][v] = points[v % points.size()] * SCALE;
+		}
+	}
+
+	d_freq = (gr_complex*)fftwf_malloc(sizeof(gr_complex) * FFT_LEN * MAX_FRAME_SYMBOLS);
+	d_time = (gr_complex*)fftwf_malloc(sizeof(gr_complex) * FFT_LEN * MAX_FRAME_SYMBOLS);
+	if(!d_freq || !d_time) {
+		throw std::runtime_error("ofdm_synthesizer: fftwf_malloc failed");
+	}
+
+	{
+		// the planner of FFTW is not thread safe, share the lock of the
+		// FFT blocks of GNU Radio
+		gr::fft::planner::scoped_lock lock(gr::fft::planner::mutex());
+
+		int len = FFT_LEN;
+		d_plan_batch = fftwf_plan_many_dft(1, &len, FFT_BATCH,
+				reinterpret_cast<fftwf_complex*>(d_freq), NULL, 1, FFT_LEN,
+				reinterpret_cast<fftwf_complex*>(d_time), NULL, 1, FFT_LEN,
+				FFTW_BACKWARD, FFTW_MEASURE);
+		d_plan_single = fftwf_plan_dft_1d(FFT_LEN,
+				reinterpret_cast<fftwf_complex*>(d_freq),
+				reinterpret_cast<fftwf_complex*>(d_time),
+				FFTW_BACKWARD, FFTW_MEASURE);
+	}
+	if(!d_plan_batch || !d_plan_single) {
+		throw std::runtime_error("ofdm_synthesizer: could not create FFTW plans");
+	}
+
+	// planning overwrites the buffers, the carriers that are never
+	// written have to be 0
+	std::memset(d_freq, 0, sizeof(gr_complex) * FFT_LEN * MAX_FRAME_SYMBOLS);
+
+	std::vector<std::vector<gr_complex> > sync = sync_words();
+	for(int s = 0; s < N_SYNC_SYMBOLS; s++) {
+		for(int i = 0; i < FFT_LEN; i++) {
+			d_freq[s * FFT_LEN + (i + FFT_LEN / 2) % FFT_LEN] = sync[s][i] * SCALE;
+		}
+	}
+	ifft(N_SYNC_SYMBOLS);
+	std::memcpy(d_sync, d_time, sizeof(d_sync));
+	std::memset(d_freq, 0, sizeof(gr_complex) * FFT_LEN * N_SYNC_SYMBOLS);
+}
+
+ofdm_synthesizer::~ofdm_synthesizer() {
+	gr::fft::planner::scoped_lock lock(gr::fft::planner::mutex());
+	fftwf_destroy_plan(d_plan_batch);
+	fftwf_destroy_plan(d_plan_single);
+	fftwf_free(d_freq);
+	fftwf_free(d_time);
+}
+
+std::vector<std::vector<int> >
+ofdm_synthesizer::occupied_carriers() {
+	// [-26, 26] without DC and the pilots
+	std::vector<int> carriers;
+	for(int c = -26; c <= 26; c++) {
+		if(c == 0 || c == -21 || c == -7 || c == 7 || c == 21) {
+			continue;
+		}
+		carriers.push_back(c);
+	}
+	return std::vector<std::vector<int> >(1, carriers);
+}
+
+std::vector<std::vector<gr_complex> >
+ofdm_synthesizer::sync_words() {
+	const gr_complex short_point = gr_complex(1, 1) * std::sqrt(13 / 6.0f);
+	std::vector<std::vector<gr_complex> > words(N_SYNC_SYMBOLS,
+			std::vector<gr_complex>(FFT_LEN));
+	for(int i = 0; i < FFT_LEN; i++) {
+		words[0][i] = SHORT[i] * short_point;
+		words[1][i] = SHORT[i] * short_point;
+		words[2][i] = LONG_ROTATED[i];
+		words[3][i] = LONG[i];
+	}
+	return words;
+}
+
+int
+ofdm_synthesizer::frame_samples(int n_sym) {
+	return (N_SYNC_SYMBOLS + N_SIGNAL_SYMBOLS + n_sym) * SYMBOL_LEN + 1;
+}
+
+void
+ofdm_synthesizer::encode(const char *psdu, frame_param &frame, ofdm_param &ofdm,
+		char scrambler) {
+
+	generate_bits_packed(psdu, d_data_bits, frame);
+	scramble_packed(d_data_bits, d_scrambled_data, frame, scrambler);
+	reset_tail_bits_packed(d_scrambled_data, frame);
+	convolutional_encoding_packed(d_scrambled_data, d_encoded_data, frame);
+	puncturing_packed(d_encoded_data, d_punctured_data, frame, ofdm);
+	interleave_packed(d_punctured_data, d_interleaved_data, frame, ofdm);
+	split_symbols(d_interleaved_data, d_symbols, frame, ofdm);
+}
+
+void
+ofdm_synthesizer::set_encoding(const std::vector<int> &encoding) {
+	if(encoding == d_encoding) {
+		return;
+	}
+	for(int i = 0; i < 4; i++) {
+		if(encoding[i] < BPSK || encoding[i] > QAM64) {
+			throw std::invalid_argument("wrong encoding");
+		}
+		std::copy(d_points[encoding[i]], d_points[encoding[i]] + 64, d_lut + 64 * i);
+	}
+	d_encoding = encoding;
+}
+
+void
+ofdm_synthesizer::ifft(int n_symbols) {
+	int i = 0;
+	for(; i + FFT_BATCH <= n_symbols; i += FFT_BATCH) {
+		fftwf_execute_dft(d_plan_batch,
+				reinterpret_cast<fftwf_complex*>(d_freq + i * FFT_LEN),
+				reinterpret_cast<fftwf_complex*>(d_time + i * FFT_LEN));
+	}
+	for(; i < n_symbols; i++) {
+		fftwf_execute_dft(d_plan_single,
+				reinterpret_cast<fftwf_complex*>(d_freq + i * FFT_LEN),
+				reinterpret_cast<fftwf_complex*>(d_time + i * FFT_LEN));
+	}
+}
+
+int
+ofdm_synthesizer::append_cyclic_prefix(const gr_complex *symbol, gr_complex *out,
+		gr_complex &delay) {
+	std::memcpy(out, symbol + FFT_LEN - CP_LEN, sizeof(gr_complex) * CP_LEN);
+	std::memcpy(out + CP_LEN, symbol, sizeof(gr_complex) * FFT_LEN);
+	out[0] = out[0] * FLANK + delay;
+	delay = symbol[0] * FLANK;
+	return SYMBOL_LEN;
+}
+
+void
+ofdm_synthesizer::synthesize(const char *psdu, frame_param &frame, ofdm_param &ofdm,
+		char scrambler, gr_complex *out) {
+
+	encode(psdu, frame, ofdm, scrambler);
+	set_encoding(ofdm.resource_blocks_e);
+	map_symbols((const uint8_t*)d_symbols, d_mapped, frame.n_sym * 48, d_lut);
+
+	char header[48 * N_SIGNAL_SYMBOLS];
+	signal_field_impl::generate_signal_field(header, frame, ofdm);
+
+	// signal field and data symbols, the pilot polarity starts with the
+	// first symbol of the signal field
+	int n_symbols = N_SIGNAL_SYMBOLS + frame.n_sym;
+	for(int s = 0; s < n_symbols; s++) {
+		gr_complex *bins = d_freq + s * FFT_LEN;
+		if(s < N_SIGNAL_SYMBOLS) {
+			const char *bits = header + 48 * s;
+			for(int c = 0; c < 48; c++) {
+				bins[d_data_bins[c]] = bits[c] ? SCALE : -SCALE;
+			}
+		} else {
+			const gr_complex *points = d_mapped + 48 * (s - N_SIGNAL_SYMBOLS);
+			for(int c = 0; c < 48; c++) {
+				bins[d_data_bins[c]] = points[c];
+			}
+		}
+		gr_complex p = equalizer::base::POLARITY[s % 127] * SCALE;
+		for(int i = 0; i < 4; i++) {
+			bins[d_pilot_bins[i]] = p * PILOTS[i];
+		}
+	}
+	ifft(n_symbols);
+
+	gr_complex delay = 0;
+	for(int s = 0; s < N_SYNC_SYMBOLS; s++) {
+		out += append_cyclic_prefix(d_sync[s], out, delay);
+	}
+	for(int s = 0; s < n_symbols; s++) {
+		out += append_cyclic_prefix(d_time + s * FFT_LEN, out, delay);
+	}
+	*out = delay;
+}
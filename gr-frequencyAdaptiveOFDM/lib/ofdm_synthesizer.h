@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_OFDM_SYNTHESIZER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_OFDM_SYNTHESIZER_H
+
+#include "utils.h"
+#include <fftw3.h>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+// sync words, signal field and data symbols of a frame
+#define N_SYNC_SYMBOLS 4
+#define N_SIGNAL_SYMBOLS 2
+#define MAX_FRAME_SYMBOLS (N_SYNC_SYMBOLS + N_SIGNAL_SYMBOLS + MAX_SYM)
+
+/* Generates the time domain baseband of a frame in one pass. The samples
+ * are the ones of the TX hierarchy, i.e. mapper, packet header generator,
+ * chunks to symbols, tagged stream mux, carrier allocator, IFFT and
+ * cyclic prefixer: the 4 sync words, 2 BPSK symbols of the signal field
+ * and the data symbols with the per resource block constellations and
+ * the pilots of the carrier allocator, each symbol with 16 samples of
+ * cyclic prefix and a rolloff of 2, followed by the tail of the last one.
+ *
+ * The sync words are transformed once. The symbols of the frame are
+ * written into one frequency domain buffer and transformed with a batched
+ * FFTW plan.
+ */
+class ofdm_synthesizer
+{
+public:
+
+	ofdm_synthesizer();
+	~ofdm_synthesizer();
+
+	// number of samples of a frame with n_sym data symbols
+	static int frame_samples(int n_sym);
+
+	// writes the frame_samples(frame.n_sym) samples of the frame to out
+	void synthesize(const char *psdu, frame_param &frame, ofdm_param &ofdm,
+			char scrambler, gr_complex *out);
+
+private:
+
+	// parameters of the carrier allocator of the TX hierarchy, index i
+	// of a sync word is carrier i - 32
+	static std::vector<std::vector<int> > occupied_carriers();
+	static std::vector<std::vector<gr_complex> > sync_words();
+
+	// symbols transformed by one execution of the batched plan
+	static const int FFT_BATCH = 16;
+	static const int FFT_LEN = 64;
+	static const int CP_LEN = 16;
+	static const int SYMBOL_LEN = FFT_LEN + CP_LEN;
+
+	// FFT bins of the data and pilot carriers
+	int d_data_bins[48];
+	int d_pilot_bins[4];
+
+	// points of each encoding for all 64 symbol values, scaled like the
+	// IFFT window of the hierarchy
+	gr_complex d_points[4][64];
+	gr_complex d_lut[SYMBOL_LUT_SIZE];
+	std::vector<int> d_encoding;
+
+	// time domain of the sync words
+	gr_complex d_sync[N_SYNC_SYMBOLS][FFT_LEN];
+
+	// signal field and data symbols, fftwf_malloc'ed
+	gr_complex *d_freq;
+	gr_complex *d_time;
+	fftwf_plan d_plan_batch;
+	fftwf_plan d_plan_single;
+
+	uint64_t d_data_bits[MAX_PACKED_WORDS];
+	uint64_t d_scrambled_data[MAX_PACKED_WORDS];
+	uint64_t d_encoded_data[2 * MAX_PACKED_WORDS];
+	uint64_t d_punctured_data[MAX_PACKED_WORDS];
+	char d_interleaved_data[MAX_ENCODED_BITS];
+	char d_symbols[48 * MAX_SYM];
+	gr_complex d_mapped[48 * MAX_SYM];
+
+	void encode(const char *psdu, frame_param &frame, ofdm_param &ofdm,
+			char scrambler);
+	void set_encoding(const std::vector<int> &encoding);
+	void ifft(int n_symbols);
+	int append_cyclic_prefix(const gr_complex *symbol, gr_complex *out,
+			gr_complex &delay);
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_OFDM_SYNTHESIZER_H */
@@ -25,18 +25,22 @@
 
 #include <gnuradio/io_signature.h>
 #include "parse_mac_impl.h"
+#include "frame_tracer.h"
+#include "counters.h"
 #include <gnuradio/block_detail.h>
+#include <gnuradio/prefs.h>
 
 #if defined(__APPLE__)
 #include <architecture/byte_order.h>
 #define htole16(x) OSSwapHostToLittleInt16(x)
+#define le16toh(x) OSSwapLittleToHostInt16(x)
+#define le64toh(x) OSSwapLittleToHostInt64(x)
 #else
 #include <endian.h>
 #endif
 
 #include <boost/crc.hpp>
 #include <iostream>
-#include <fstream>
 #include <stdexcept>
 
 
@@ -54,7 +58,8 @@ namespace gr {
           gr::io_signature::make(0, 0, 0),
           gr::io_signature::make(0, 0, 0)),
         d_last_seq_no(-1),
-        d_debug(debug) {
+        d_debug(debug),
+        d_arq_window(gr::prefs::singleton()->get_long("frequencyAdaptiveOFDM", "arq_window", 16)) {
 
       message_port_register_in(pmt::mp("phy in"));
       message_port_register_out(pmt::mp("per"));
@@ -63,16 +68,25 @@ namespace gr {
       set_msg_handler(pmt::mp("phy in"), boost::bind(&parse_mac_impl::phy_in, this, _1));
 
       d_mac_and_parse = m_and_p;
-      n_rx_packets = 0;
-      rx_packets_fn = rx_packets_f;
 
       for(int i = 0; i < 6; i++) {
         d_src_mac[i] = src_mac[i];
       }
       if(!d_mac_and_parse->check_mac(src_mac)) throw std::invalid_argument("wrong mac address size");
+      frame_tracer::instance().attach();
+      counters::instance().attach();
+      logger::instance().attach();
+      // the file with the number of received packets, for QoS
+      if(rx_packets_f) {
+        counters::instance().watch(counters::RX_PACKETS, rx_packets_f);
+      }
     }
 
-    parse_mac_impl::~parse_mac_impl() {}
+    parse_mac_impl::~parse_mac_impl() {
+      logger::instance().detach();
+      counters::instance().detach();
+      frame_tracer::instance().detach();
+    }
 
 
     void
@@ -89,6 +103,8 @@ namespace gr {
       }
 
       pmt::pmt_t dict = pmt::car(msg);
+      uint64_t trace = pmt::to_uint64(pmt::dict_ref(dict, pmt::mp("trace"), pmt::from_uint64(0)));
+      frame_tracer::instance().stamp(trace, frame_tracer::PARSE);
       d_snr = pmt::f64vector_elements(pmt::dict_ref(dict, pmt::mp("snr"), pmt::init_f64vector(0,0)));
       std::vector<int> enc = pmt::s32vector_elements(pmt::dict_ref(dict,
                               pmt::mp("encoding"), pmt::init_s32vector(0, 0)));
@@ -124,20 +140,17 @@ namespace gr {
         case 2:
           dout << " (DATA)" << std::endl;
           parse_data((char*)h, data_len);
-          parse_body((char*)pmt::blob_data(msg), h, data_len);
-          int psdu_length;
-          d_mac_and_parse->sendAck(h->addr2, &psdu_length);
-
-          // Measuring delay
-          /*timeval time_now;
-          gettimeofday(&time_now, NULL);
-          std::cerr << "\t\tPARSE: DATA message: " << time_now.tv_sec << " seg " << time_now.tv_usec << " us\n";*/
-
-          if(rx_packets_fn != ""){
-            n_rx_packets++;
-            std::fstream rx_packets_fs(rx_packets_fn, std::ofstream::out);
-            rx_packets_fs << n_rx_packets << std::endl;
-            rx_packets_fs.close();
+          {
+          bool accepted = parse_body((char*)pmt::blob_data(msg), h, data_len);
+          // acknowledges the receive window, not only this frame
+          reorder_buffer &window = reorder(h->addr2);
+          d_mac_and_parse->sendBlockAck(h->addr2, window.ssn(), window.bitmap());
+          frame_tracer::instance().stamp(trace, frame_tracer::ACK);
+
+          // duplicates are counted as RX_DUPLICATES
+          if(accepted) {
+            counters::instance().add(counters::RX_PACKETS);
+          }
           }
           // Only send the received information if its from a data package
           send_frame_data(enc, punct);
@@ -319,10 +332,15 @@ namespace gr {
       dout << "mac 3: ";
       print_mac_address(h->addr3, true);
 
+      // a retransmission is not a new frame
+      if(h->frame_control & 0x0800) {
+        return;
+      }
       d_100_rx_packets += seq_no - d_last_seq_no;
       d_lost_packets += seq_no - d_last_seq_no - 1;
       float per = d_lost_packets / float(d_100_rx_packets);
       dout << "instantaneous PER: " << per << std::endl;
+      counters::instance().set(counters::RX_PER, per * 100);
 
       pmt::pmt_t pdu = pmt::make_f32vector(1, per * 100);
       message_port_pub(pmt::mp("per"), pmt::cons( pmt::PMT_NIL, pdu ));
@@ -336,20 +354,49 @@ namespace gr {
 
     void
     parse_mac_impl::process_ack() {
-      //dout << ": ACK received";
-      //d_mac_and_parse->setAckReceived(true);
-      if (d_mac_and_parse->d_debug_ack) {
-        dout << "\n";
+      d_mac_and_parse->ackReceived();
+      if (LOG_ENABLED(DEBUG) && d_mac_and_parse->d_debug_ack) {
         timeval time_now;
         gettimeofday(&time_now, NULL);
-        std::cout << "\t\tPARSE: ACK received: " <<
+        LOG_STREAM(DEBUG) << "PARSE: ACK received: " <<
         time_now.tv_sec << " sec " << time_now.tv_usec << " usec\n";
       }
+    }
+
+    void
+    parse_mac_impl::process_block_ack(char *buf, int length) {
+      if(length < int(sizeof(mac_block_ack_header))) {
+        dout << " too short for a Block ACK";
+        return;
+      }
+      mac_block_ack_header *h = (mac_block_ack_header*)buf;
+      uint16_t ssn = le16toh(h->ssn) >> 4;
+      uint64_t bitmap = le64toh(h->bitmap);
+      d_mac_and_parse->blockAckReceived(h->ta, ssn, bitmap);
 
-      // Measuring delay
-      /*timeval time_now;
-      gettimeofday(&time_now, NULL);
-      std::cerr << "\t\t\t\tPARSE: ACK message: " << time_now.tv_sec << " seg " << time_now.tv_usec << " us\n";*/
+      if (LOG_ENABLED(DEBUG) && d_mac_and_parse->d_debug_ack) {
+        timeval time_now;
+        gettimeofday(&time_now, NULL);
+        LOG_STREAM(DEBUG) << "PARSE: Block ACK received, ssn " << ssn << " bitmap " <<
+        std::hex << bitmap << std::dec << ": " <<
+        time_now.tv_sec << " sec " << time_now.tv_usec << " usec\n";
+      }
+    }
+
+    void
+    parse_mac_impl::process_block_ack_request(char *buf, int length) {
+      mac_block_ack_header *h = (mac_block_ack_header*)buf;
+      if(length < int(sizeof(mac_block_ack_header) - sizeof(h->bitmap))) {
+        dout << " too short for a Block ACK Request";
+        return;
+      }
+
+      // the sender gave up the frames before ssn
+      reorder_buffer &window = reorder(h->ta);
+      std::vector<std::vector<char> > frames;
+      window.release(le16toh(h->ssn) >> 4, frames);
+      deliver(frames);
+      d_mac_and_parse->sendBlockAck(h->ta, window.ssn(), window.bitmap());
     }
 
     void
@@ -363,9 +410,11 @@ namespace gr {
           break;
         case 8:
           dout << "Block ACK Requrest";
+          process_block_ack_request(buf, length);
           break;
         case 9:
           dout << "Block ACK";
+          process_block_ack(buf, length);
           break;
         case 10:
           dout << "PS Poll";
@@ -396,16 +445,54 @@ namespace gr {
       print_mac_address(h->addr1, true);
     }
 
-    void
+    bool
     parse_mac_impl::parse_body(char* frame, mac_header *h, int data_len){
+      int header_len;
       // DATA
       if((((h->frame_control) >> 2) & 63) == 2) {
-        print_ascii(frame + 24, data_len - 24);
-        send_data(frame + 24, data_len - 24);
+        header_len = 24;
       // QoS Data
       } else if((((h->frame_control) >> 2) & 63) == 34) {
-        print_ascii(frame + 26, data_len - 26);
-        send_data(frame + 26, data_len - 26);
+        header_len = 26;
+      } else {
+        return true;
+      }
+      if(data_len < header_len) {
+        return true;
+      }
+
+      // in the order of the sequence numbers
+      std::vector<std::vector<char> > frames;
+      bool retry = h->frame_control & 0x0800;
+      bool accepted = reorder(h->addr2).receive(le16toh(h->seq_nr) >> 4, retry,
+            frame + header_len, data_len - header_len, frames);
+      if(!accepted) {
+        dout << "duplicate frame, not handed on" << std::endl;
+        counters::instance().add(counters::RX_DUPLICATES);
+      }
+      deliver(frames);
+      return accepted;
+    }
+
+    reorder_buffer&
+    parse_mac_impl::reorder(uint8_t *addr) {
+      uint64_t key = 0;
+      for(int i = 0; i < 6; i++) {
+        key = (key << 8) | addr[i];
+      }
+      std::map<uint64_t, reorder_buffer>::iterator it = d_reorder.find(key);
+      if(it == d_reorder.end()) {
+        it = d_reorder.insert(std::make_pair(key, reorder_buffer(d_arq_window))).first;
+      }
+      return it->second;
+    }
+
+    void
+    parse_mac_impl::deliver(std::vector<std::vector<char> > &frames) {
+      for(size_t i = 0; i < frames.size(); i++) {
+        std::vector<char> &f = frames[i];
+        print_ascii(f.data(), f.size());
+        send_data(f.data(), f.size());
       }
     }
 
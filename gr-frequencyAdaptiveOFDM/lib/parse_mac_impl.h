@@ -24,6 +24,8 @@
 
 #include <frequencyAdaptiveOFDM/mac_and_parse.h>
 #include <frequencyAdaptiveOFDM/parse_mac.h>
+#include "arq.h"
+#include <map>
 
 
 namespace gr {
@@ -45,11 +47,12 @@ namespace gr {
       uint8_t d_src_mac[6];
       int d_last_seq_no;
 
-      // For meassuring QoS
-      char* rx_packets_fn;
-      long n_rx_packets;
       bool d_debug;
 
+      // ARQ receive window per source address
+      int d_arq_window;
+      std::map<uint64_t, reorder_buffer> d_reorder;
+
       // Intantaneous PER
       int d_lost_packets;
       int d_100_rx_packets;
@@ -61,9 +64,14 @@ namespace gr {
       void send_data(char* buf, int length);
       void parse_management(char *buf, int length);
       void process_ack();
+      void process_block_ack(char *buf, int length);
+      void process_block_ack_request(char *buf, int length);
+      reorder_buffer& reorder(uint8_t *addr);
+      void deliver(std::vector<std::vector<char> > &frames);
       void parse_data(char *buf, int length);
       void parse_control(char *buf, int length);
-      void parse_body(char* frame, mac_header *h, int data_len);
+      // returns false for a frame that was received before
+      bool parse_body(char* frame, mac_header *h, int data_len);
       void decide_encoding();
       void phy_in (pmt::pmt_t msg);
     };
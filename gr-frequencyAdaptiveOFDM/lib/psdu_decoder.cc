@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "psdu_decoder.h"
+#include "crc32.h"
+#include "frame_tracer.h"
+#include "counters.h"
+#include <cstring>
+#include <stdexcept>
+
+#define LINKTYPE_IEEE802_11 105 /* http://www.tcpdump.org/linktypes.html */
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+psdu_decoder::psdu_decoder(const std::string &name, bool log, bool debug,
+		bool debug_rx_err, int windows) :
+	d_name(name),
+	d_log(log),
+	d_debug(debug),
+	d_debug_rx_err(debug_rx_err),
+	d_count_snr(true) {
+
+	if(windows < 1) {
+		throw std::invalid_argument(name + ": number of Viterbi windows has to be positive");
+	}
+	d_decoder.set_windows(windows);
+	d_soft_decoder.set_windows(windows);
+}
+
+void
+psdu_decoder::gather_hard(const uint8_t *symbols, ofdm_param &ofdm,
+		frame_param &frame, uint8_t *depunctured) {
+	if (dlog) {
+		print_bytes(d_name + ": splited symbols:", (char*)symbols, frame.n_sym * 48);
+	}
+
+	// regroup, deinterleave and depuncture in one pass
+	rx_gather_hard(symbols, depunctured, frame, get_rx_gather_table(ofdm));
+	// flush the trellis with zeros, not with the bits of an older frame
+	std::memset(depunctured + 2 * frame.n_data_bits, 0, (TRACEBACK_MAX + 1) * 16);
+
+	if (dlog) {
+		print_bytes(d_name + ": depunctured data:", (char*)depunctured, 2 * frame.n_data_bits);
+	}
+}
+
+void
+psdu_decoder::gather_soft(const int8_t *llr, ofdm_param &ofdm,
+		frame_param &frame, uint8_t *depunctured) {
+	rx_gather_soft(llr, depunctured, frame, get_rx_gather_table(ofdm));
+	std::memset(depunctured + 2 * frame.n_data_bits, 0, (TRACEBACK_MAX + 1) * 16);
+}
+
+pmt::pmt_t
+psdu_decoder::decode(uint8_t *depunctured, bool soft, ofdm_param &ofdm,
+		frame_param &frame, const std::vector<double> &snr,
+		double nom_freq, double freq_offset, uint64_t trace) {
+	uint8_t *decoded;
+	if(soft) {
+		decoded = d_soft_decoder.decode_depunctured(&ofdm, &frame, depunctured);
+	} else {
+		decoded = d_decoder.decode_depunctured(&ofdm, &frame, depunctured);
+	}
+	frame_tracer::instance().stamp(trace, frame_tracer::VITERBI);
+
+	return make_pdu(decoded, ofdm, frame, snr, nom_freq, freq_offset, trace);
+}
+
+pmt::pmt_t
+psdu_decoder::make_pdu(const uint8_t *decoded, ofdm_param &ofdm,
+		frame_param &frame, const std::vector<double> &snr,
+		double nom_freq, double freq_offset, uint64_t trace) {
+	if (dlog) {
+		print_bytes(d_name + ": scrambled data:", (char*)decoded, frame.n_data_bits);
+	}
+
+	// CRC over the PSDU, skips the service field
+	uint32_t crc = descramble_crc(decoded, d_out_bytes, frame);
+	if (dlog) {
+		print_bytes(d_name + ": generated bits (without 0s at the head):", (char*)d_out_bytes, frame.psdu_size*8);
+	}
+
+	frame_tracer::instance().stamp(trace, frame_tracer::CRC, crc == CRC32_RESIDUE);
+	if(crc != CRC32_RESIDUE) {
+		if (d_debug || d_debug_rx_err){
+			lout(WARN) << d_name << ": checksum wrong -- dropping\n";
+		}
+		counters::instance().add(counters::CRC_ERRORS);
+		return pmt::PMT_NIL;
+	}
+	counters::instance().add_frame(ofdm.resource_blocks_e, ofdm.punct,
+			d_count_snr ? snr : std::vector<double>());
+
+	// create PDU
+	pmt::pmt_t blob = pmt::make_blob(d_out_bytes + 2, frame.psdu_size - 4);
+	pmt::pmt_t dict = pmt::make_dict();
+	dict = pmt::dict_add(dict, pmt::mp("encoding"), pmt::init_s32vector(4, ofdm.resource_blocks_e));
+	dict = pmt::dict_add(dict, pmt::mp("puncturing"), pmt::from_long(ofdm.punct));
+	dict = pmt::dict_add(dict, pmt::mp("snr"), pmt::init_f64vector(4, snr));
+	dict = pmt::dict_add(dict, pmt::mp("nomfreq"), pmt::from_double(nom_freq));
+	dict = pmt::dict_add(dict, pmt::mp("freqofs"), pmt::from_double(freq_offset));
+	dict = pmt::dict_add(dict, pmt::mp("dlt"), pmt::from_long(LINKTYPE_IEEE802_11));
+	if(trace) {
+		dict = pmt::dict_add(dict, pmt::mp("trace"), pmt::from_uint64(trace));
+	}
+	return pmt::cons(dict, blob);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_PSDU_DECODER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_PSDU_DECODER_H
+
+#include "utils.h"
+#include "viterbi_decoder/viterbi_decoder.h"
+#include "viterbi_decoder/viterbi_decoder_soft.h"
+#include <pmt/pmt.h>
+#include <string>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* From the frame buffer of a complete frame to its PDU: regrouping,
+ * deinterleaving and depuncturing, Viterbi decoding, descrambling and
+ * the CRC. decode_mac and frame_decoder both decode with it, the name
+ * prefixes their log messages.
+ */
+class psdu_decoder
+{
+public:
+	psdu_decoder(const std::string &name, bool log, bool debug,
+			bool debug_rx_err, int windows);
+
+	// Viterbi input of the hard decisions or LLRs of a frame, zeros
+	// behind it to flush the trellis
+	void gather_hard(const uint8_t *symbols, ofdm_param &ofdm,
+			frame_param &frame, uint8_t *depunctured);
+	void gather_soft(const int8_t *llr, ofdm_param &ofdm,
+			frame_param &frame, uint8_t *depunctured);
+
+	// Viterbi decoding of gathered bits, then make_pdu()
+	pmt::pmt_t decode(uint8_t *depunctured, bool soft, ofdm_param &ofdm,
+			frame_param &frame, const std::vector<double> &snr,
+			double nom_freq, double freq_offset, uint64_t trace);
+
+	// Descrambles the bits of the Viterbi decoder and checks the CRC.
+	// Returns the PDU with the PSDU and the dict of the frame or PMT_NIL
+	// if the checksum is wrong, both counted in counters.
+	pmt::pmt_t make_pdu(const uint8_t *decoded, ofdm_param &ofdm,
+			frame_param &frame, const std::vector<double> &snr,
+			double nom_freq, double freq_offset, uint64_t trace);
+
+	// whether make_pdu() sets RX_SNR of counters from the SNR of the frame
+	void set_count_snr(bool count) { d_count_snr = count; }
+
+	// signal field and PSDU of the last frame of make_pdu()
+	const uint8_t* out_bytes() const { return d_out_bytes; }
+
+private:
+	std::string d_name;
+	bool d_log;
+	bool d_debug;
+	bool d_debug_rx_err;
+	bool d_count_snr;
+
+	viterbi_decoder d_decoder;
+	viterbi_decoder_soft d_soft_decoder;
+	uint8_t d_out_bytes[MAX_PSDU_SIZE + 2]; // 2 for signal field
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_PSDU_DECODER_H */
@@ -0,0 +1,157 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_arq.h"
+#include "arq.h"
+#include "counters.h"
+#include <boost/bind.hpp>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    // what the ARQ of t2 sends, sequence number and retry
+    static std::vector<std::pair<int, bool> > arq_sent;
+    static std::vector<int> arq_requests;
+
+    static void
+    arq_send(uint16_t seq, bool retry, const std::vector<char> &)
+    {
+      arq_sent.push_back(std::make_pair(int(seq), retry));
+    }
+
+    static void
+    arq_request(uint16_t ssn)
+    {
+      arq_requests.push_back(ssn);
+    }
+
+    void
+    qa_arq::t1()
+    {
+      std::vector<std::vector<char> > out;
+      char data[] = {'a', 'b', 'c'};
+
+      reorder_buffer window(4);
+      CPPUNIT_ASSERT(window.receive(0, false, data, 1, out));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), out.size());
+      // 2 waits for 1
+      CPPUNIT_ASSERT(window.receive(2, false, data + 2, 1, out));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), out.size());
+      CPPUNIT_ASSERT_EQUAL(uint16_t(1), window.ssn());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(2), window.bitmap());
+      CPPUNIT_ASSERT(!window.receive(2, true, data + 2, 1, out));
+      CPPUNIT_ASSERT(window.receive(1, true, data + 1, 1, out));
+      CPPUNIT_ASSERT_EQUAL(size_t(3), out.size());
+      CPPUNIT_ASSERT_EQUAL('b', out[1][0]);
+      CPPUNIT_ASSERT_EQUAL('c', out[2][0]);
+      CPPUNIT_ASSERT(!window.receive(0, true, data, 1, out));
+
+      // a window ahead moves the window, the Block ACK Request releases
+      CPPUNIT_ASSERT(window.receive(8, false, data, 1, out));
+      CPPUNIT_ASSERT_EQUAL(uint16_t(5), window.ssn());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(8), window.bitmap());
+      window.release(9, out);
+      CPPUNIT_ASSERT_EQUAL(size_t(4), out.size());
+      CPPUNIT_ASSERT_EQUAL(uint16_t(9), window.ssn());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), window.bitmap());
+
+      // the sequence numbers wrap, a new sender starts over
+      window.release(4095, out);
+      CPPUNIT_ASSERT_EQUAL(uint16_t(9), window.ssn());
+      CPPUNIT_ASSERT(window.receive(0, false, data, 1, out));
+      CPPUNIT_ASSERT_EQUAL(size_t(5), out.size());
+      CPPUNIT_ASSERT_EQUAL(uint16_t(1), window.ssn());
+    }
+
+    void
+    qa_arq::t2()
+    {
+      char data[] = {'a'};
+      uint64_t retries = counters::instance().get(counters::TX_RETRIES);
+      uint64_t dropped = counters::instance().get(counters::TX_DROPPED);
+      arq_sent.clear();
+      arq_requests.clear();
+      {
+        arq_sender arq(2, 20000, 1, boost::bind(arq_send, _1, _2, _3),
+            boost::bind(arq_request, _1));
+        CPPUNIT_ASSERT(arq.submit(data, 1));
+        CPPUNIT_ASSERT(arq.submit(data, 1));
+        CPPUNIT_ASSERT_EQUAL(2, arq.outstanding());
+        // 1 is acknowledged, the window waits for 0
+        arq.block_ack(0, 2);
+        CPPUNIT_ASSERT_EQUAL(2, arq.outstanding());
+        // a plain ACK does not tell which frame it is for
+        arq.ack();
+        CPPUNIT_ASSERT_EQUAL(2, arq.outstanding());
+        arq.block_ack(0, 1);
+        CPPUNIT_ASSERT_EQUAL(0, arq.outstanding());
+
+        // with a single frame outstanding it is for that one
+        CPPUNIT_ASSERT(arq.submit(data, 1));
+        arq.ack();
+        CPPUNIT_ASSERT_EQUAL(0, arq.outstanding());
+
+        // 3 is never acknowledged
+        CPPUNIT_ASSERT(arq.submit(data, 1));
+        usleep(200000);
+        CPPUNIT_ASSERT_EQUAL(0, arq.outstanding());
+      }
+      CPPUNIT_ASSERT_EQUAL(size_t(5), arq_sent.size());
+      CPPUNIT_ASSERT(arq_sent[3] == std::make_pair(3, false));
+      CPPUNIT_ASSERT(arq_sent[4] == std::make_pair(3, true));
+      CPPUNIT_ASSERT_EQUAL(size_t(1), arq_requests.size());
+      CPPUNIT_ASSERT_EQUAL(4, arq_requests[0]);
+      CPPUNIT_ASSERT_EQUAL(retries + 1, counters::instance().get(counters::TX_RETRIES));
+      CPPUNIT_ASSERT_EQUAL(dropped + 1, counters::instance().get(counters::TX_DROPPED));
+    }
+
+    void
+    qa_arq::t3()
+    {
+      std::vector<std::vector<char> > out;
+      char data[] = {'a', 'b'};
+
+      // frame 0 is lost, 1 waits for its retransmission
+      reorder_buffer window(4);
+      CPPUNIT_ASSERT(window.receive(1, false, data + 1, 1, out));
+      CPPUNIT_ASSERT_EQUAL(size_t(0), out.size());
+      CPPUNIT_ASSERT_EQUAL(uint16_t(0), window.ssn());
+      CPPUNIT_ASSERT_EQUAL(uint64_t(2), window.bitmap());
+      CPPUNIT_ASSERT(window.receive(0, true, data, 1, out));
+      CPPUNIT_ASSERT_EQUAL(size_t(2), out.size());
+      CPPUNIT_ASSERT_EQUAL('a', out[0][0]);
+      CPPUNIT_ASSERT_EQUAL('b', out[1][0]);
+      CPPUNIT_ASSERT_EQUAL(uint16_t(2), window.ssn());
+
+      // a sender that was running before starts the window at its frame
+      reorder_buffer late(4);
+      CPPUNIT_ASSERT(late.receive(700, false, data, 1, out));
+      CPPUNIT_ASSERT_EQUAL(size_t(3), out.size());
+      CPPUNIT_ASSERT_EQUAL(uint16_t(701), late.ssn());
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_constellation_tap.h"
+#include "constellation_tap.h"
+#include "utils.h"
+#include <stdexcept>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    void
+    qa_constellation_tap::t1()
+    {
+      // every 2nd symbol, snapshot after 3 of them
+      constellation_tap tap(2, 3);
+      std::vector<int> encoding(4, BPSK);
+
+      gr_complex symbols[48];
+      for(int i = 0; i < 48; i++) {
+        symbols[i] = gr_complex(i < 12 ? 1 : 1.1f, 0);
+      }
+      for(int i = 0; i < 5; i++) {
+        CPPUNIT_ASSERT(!tap.add(symbols, encoding));
+      }
+      CPPUNIT_ASSERT(tap.add(symbols, encoding));
+
+      pmt::pmt_t pdu = tap.snapshot();
+      pmt::pmt_t dict = pmt::car(pdu);
+      CPPUNIT_ASSERT_EQUAL(3L, pmt::to_long(pmt::dict_ref(dict, pmt::mp("symbols"), pmt::PMT_NIL)));
+      CPPUNIT_ASSERT_EQUAL(size_t(4 * 36), pmt::c32vector_elements(pmt::cdr(pdu)).size());
+
+      const std::vector<float> evm = pmt::f32vector_elements(pmt::dict_ref(dict, pmt::mp("evm"), pmt::PMT_NIL));
+      CPPUNIT_ASSERT_EQUAL(0.0f, evm[0]);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(0.1, evm[1], 1e-5);
+
+      // each resource block counts its 12 carriers of the 3 symbols
+      const std::vector<uint32_t> hist = pmt::u32vector_elements(pmt::dict_ref(dict, pmt::mp("histogram"), pmt::PMT_NIL));
+      const int n = constellation_tap::BINS * constellation_tap::BINS;
+      for(int rb = 0; rb < 4; rb++) {
+        uint32_t sum = 0;
+        for(int i = 0; i < n; i++) {
+          sum += hist[rb * n + i];
+        }
+        CPPUNIT_ASSERT_EQUAL(uint32_t(36), sum);
+      }
+
+      // starts over
+      pdu = tap.snapshot();
+      CPPUNIT_ASSERT_EQUAL(0L, pmt::to_long(pmt::dict_ref(pmt::car(pdu), pmt::mp("symbols"), pmt::PMT_NIL)));
+      CPPUNIT_ASSERT_THROW(tap.set_rate(0, 1), std::invalid_argument);
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_counters.h"
+#include "counters.h"
+#include "utils.h"
+#include <algorithm>
+#include <string>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    void
+    qa_counters::t1()
+    {
+      counters c;
+      c.add(counters::CRC_ERRORS);
+      c.add(counters::CRC_ERRORS, 2);
+      c.set(counters::RX_PER, 12.5);
+
+      std::vector<int> encoding(4, QAM16);
+      encoding[0] = BPSK;
+      std::vector<double> snr(4, 10);
+      snr[3] = 14;
+      c.add_frame(encoding, P_3_4, snr);
+
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), c.get(counters::CRC_ERRORS));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), c.get(counters::SYNC_LOSSES));
+      CPPUNIT_ASSERT_EQUAL(12.5, c.get(counters::RX_PER));
+      CPPUNIT_ASSERT_EQUAL(11.0, c.get(counters::RX_SNR));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), c.resource_blocks(BPSK, P_3_4));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(3), c.resource_blocks(QAM16, P_3_4));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), c.resource_blocks(QAM16, P_1_2));
+
+      // one value per column
+      std::string header = c.header();
+      std::string line = c.snapshot();
+      CPPUNIT_ASSERT_EQUAL(std::count(header.begin(), header.end(), ','),
+          std::count(line.begin(), line.end(), ','));
+      CPPUNIT_ASSERT(line.find(",3,") != std::string::npos);
+
+      c.reset();
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), c.get(counters::CRC_ERRORS));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), c.resource_blocks(QAM16, P_3_4));
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
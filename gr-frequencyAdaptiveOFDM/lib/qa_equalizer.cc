@@ -0,0 +1,651 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_equalizer.h"
+#include "utils.h"
+#include "equalizer/carrier_stats.h"
+#include "equalizer/kernels.h"
+#include "equalizer/ls.h"
+#include "equalizer/slicer.h"
+#include "equalizer/sta.h"
+#include "crc32.h"
+#include "frame_decoder.h"
+#include "rx_engine.h"
+#include <frequencyAdaptiveOFDM/signal_field.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    static float
+    gauss()
+    {
+      float u = (std::rand() + 1.0f) / (RAND_MAX + 2.0f);
+      float v = std::rand() / (RAND_MAX + 1.0f);
+      return std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * v);
+    }
+
+    static const double FREQ = 5.89e9;
+    static const double BW = 10e6;
+
+    // PSDU with random bytes and a valid FCS
+    static std::vector<uint8_t>
+    make_psdu(int len)
+    {
+      std::vector<uint8_t> psdu(len);
+      for(int i = 0; i < len - 4; i++) {
+        psdu[i] = std::rand();
+      }
+      uint32_t fcs = crc32(&psdu[0], len - 4);
+      std::memcpy(&psdu[len - 4], &fcs, 4);
+      return psdu;
+    }
+
+    // Carriers of a frame after the FFT of the receiver, 64 per symbol:
+    // the two long training symbols, the signal field and the data
+    // symbols with the pilots, over a flat channel with 40 dB SNR.
+    static std::vector<gr_complex>
+    make_frame(const std::vector<uint8_t> &psdu, ofdm_param &ofdm, char scrambler)
+    {
+      static const equalizer::points_fn POINTS[4] = {
+        equalizer::points<BPSK>, equalizer::points<QPSK>,
+        equalizer::points<QAM16>, equalizer::points<QAM64> };
+      static char data_bits[MAX_ENCODED_BITS];
+      static char scrambled[MAX_ENCODED_BITS];
+      static char encoded[2 * MAX_ENCODED_BITS];
+      static char punctured[MAX_ENCODED_BITS];
+      static char interleaved[MAX_ENCODED_BITS];
+      static uint8_t symbols[48 * MAX_SYM];
+
+      frame_param frame(ofdm, psdu.size());
+      std::memset(data_bits, 0, frame.n_data_bits);
+      generate_bits((const char*)&psdu[0], data_bits, frame);
+      scramble(data_bits, scrambled, frame, scrambler);
+      reset_tail_bits(scrambled, frame);
+      convolutional_encoding(scrambled, encoded, frame);
+      puncturing(encoded, punctured, frame, ofdm);
+      interleave(punctured, interleaved, frame, ofdm);
+      split_symbols(interleaved, (char*)symbols, frame, ofdm);
+
+      std::vector<tag_t> tags(3);
+      tags[0].key = pmt::mp("encoding");
+      tags[0].value = pmt::init_s32vector(4, ofdm.resource_blocks_e);
+      tags[1].key = pmt::mp("psdu_len");
+      tags[1].value = pmt::from_long(psdu.size());
+      tags[2].key = pmt::mp("puncturing");
+      tags[2].value = pmt::from_long(ofdm.punct);
+      unsigned char header[96];
+      signal_field::make()->header_formatter(psdu.size(), header, tags);
+
+      const float sigma = std::sqrt(0.0001f / 2);
+      std::vector<gr_complex> in(64 * (4 + frame.n_sym));
+      for(int s = 0; s < 4 + frame.n_sym; s++) {
+        gr_complex *carriers = &in[64 * s];
+        if(s < 2) {
+          std::copy(equalizer::base::LONG, equalizer::base::LONG + 64, carriers);
+          continue;
+        }
+
+        gr_complex points[48];
+        if(s < 4) {
+          for(int c = 0; c < 48; c++) {
+            points[c] = header[48 * (s - 2) + c] ? 1 : -1;
+          }
+        } else {
+          for(int r = 0; r < 4; r++) {
+            POINTS[ofdm.resource_blocks_e[r]](symbols + 48 * (s - 4) + 12 * r,
+                points + 12 * r, 12);
+          }
+        }
+        for(int c = 0; c < 48; c++) {
+          carriers[equalizer::base::DATA_CARRIERS[c]] = points[c];
+        }
+        gr_complex p = equalizer::base::POLARITY[(s - 2) % 127];
+        carriers[11] = p;
+        carriers[25] = p;
+        carriers[39] = p;
+        carriers[53] = -p;
+      }
+      for(size_t i = 0; i < in.size(); i++) {
+        if(in[i] != gr_complex(0, 0)) {
+          in[i] += gr_complex(gauss(), gauss()) * sigma;
+        }
+      }
+      return in;
+    }
+
+    // PDUs the rx_engine of t4 delivers
+    static std::vector<pmt::pmt_t> delivered;
+
+    static void
+    deliver(rx_job &job)
+    {
+      delivered.push_back(job.pdu);
+    }
+
+    // ofdm_equalizer::equalize() as it was with an exp() per carrier for
+    // the sampling offset and one for the residual frequency offset
+    class exp_equalizer
+    {
+    public:
+      exp_equalizer(double cfo)
+        : d_n(0), d_epsilon0(cfo * BW / (2 * M_PI * FREQ)), d_er(0)
+      {
+        for(int i = 0; i < 4; i++) {
+          d_prev_pilots[i] = 0;
+        }
+        d_ls.set_encoding(std::vector<int>(4, BPSK));
+        d_ls.new_frame();
+      }
+
+      void
+      equalize(const gr_complex *in, gr_complex *symbols, uint8_t *bits)
+      {
+        gr_complex current_symbol[64];
+        std::memcpy(current_symbol, in, 64 * sizeof(gr_complex));
+
+        for(int j = 0; j < 64; j++) {
+          current_symbol[j] *= exp(gr_complex(0, 2*M_PI*d_n*80*(d_epsilon0 + d_er)*(j-32)/64));
+        }
+
+        gr_complex p = equalizer::base::POLARITY[(d_n - 2) % 127];
+        double beta;
+        if(d_n < 2) {
+          beta = arg(current_symbol[11] - current_symbol[25] +
+              current_symbol[39] + current_symbol[53]);
+        } else {
+          beta = arg((current_symbol[11] * p) + (current_symbol[39] * p) +
+              (current_symbol[25] * p) + (current_symbol[53] * -p));
+        }
+        double er = arg(
+            (conj(d_prev_pilots[0]) * current_symbol[11] *  p) +
+            (conj(d_prev_pilots[1]) * current_symbol[25] *  p) +
+            (conj(d_prev_pilots[2]) * current_symbol[39] *  p) +
+            (conj(d_prev_pilots[3]) * current_symbol[53] * -p));
+        er *= BW / (2 * M_PI * FREQ * 80);
+
+        d_prev_pilots[0] = current_symbol[11] *  p;
+        d_prev_pilots[1] = current_symbol[25] *  p;
+        d_prev_pilots[2] = current_symbol[39] *  p;
+        d_prev_pilots[3] = current_symbol[53] * -p;
+
+        for(int j = 0; j < 64; j++) {
+          current_symbol[j] *= exp(gr_complex(0, -beta));
+        }
+        if(d_n >= 2) {
+          d_er = 0.9 * d_er + 0.1 * er;
+        }
+
+        d_ls.equalize(current_symbol, d_n, symbols, bits);
+        d_n++;
+      }
+
+      void set_encoding(const std::vector<int> &encoding) { d_ls.set_encoding(encoding); }
+
+    private:
+      equalizer::ls d_ls;
+      int d_n;
+      double d_epsilon0;
+      double d_er;
+      gr_complex d_prev_pilots[4];
+    };
+
+    // sta::equalize() as it was, every carrier averages the used carriers
+    // of its window with a loop over the window
+    class window_sta : public equalizer::base
+    {
+    public:
+      window_sta(float alpha, int beta) : d_alpha(alpha), d_beta(beta) {}
+
+      void
+      equalize(gr_complex *in, int n, gr_complex *symbols, uint8_t *bits)
+      {
+        if(n == 0) {
+          std::memcpy(d_H, in, 64 * sizeof(gr_complex));
+        } else if(n == 1) {
+          estimate_channel_state(in);
+        } else {
+          gr_complex H_update[64];
+          gr_complex H[64];
+
+          gr_complex p = POLARITY[(n - 2) % 127];
+          H[11] = in[11] *  p;
+          H[25] = in[25] *  p;
+          H[39] = in[39] *  p;
+          H[53] = in[53] * -p;
+
+          invert_channel();
+          equalize_data(in, symbols, bits);
+
+          for(int c = 0; c < 48; c++) {
+            int i = DATA_CARRIERS[c];
+            H[i] = divide(in[i], d_decisions[c]);
+          }
+
+          for(int i = 0; i < 64; i++) {
+            int n = 0;
+            gr_complex s = 0;
+            for(int k = i - d_beta; k <= i + d_beta; k++) {
+              if((k == 32) || (k < 6) || (k > 58)) {
+                continue;
+              }
+              n++;
+              s += H[k];
+            }
+            H_update[i] = s / gr_complex(n, 0);
+          }
+
+          for(int i = 0; i < 64; i++) {
+            d_H[i] = gr_complex(1 - d_alpha, 0) * d_H[i] + gr_complex(d_alpha, 0) * H_update[i];
+          }
+        }
+      }
+
+      const gr_complex* channel() const { return d_H; }
+
+    private:
+      float d_alpha;
+      int d_beta;
+    };
+
+    // the channel estimate of sta
+    class sta_probe : public equalizer::sta
+    {
+    public:
+      sta_probe(double alpha, int beta) : equalizer::sta(alpha, beta) {}
+      const gr_complex* channel() const { return d_H; }
+    };
+
+    void
+    qa_equalizer::t1()
+    {
+      // the error power of the kernel is |s - p|^2 and the running mean
+      // and variance follow a constant input
+      gr_complex symbols[48];
+      gr_complex points[48];
+      float power[48];
+      for(int c = 0; c < 48; c++) {
+        symbols[c] = gr_complex(gauss(), gauss());
+        points[c] = gr_complex(gauss(), gauss());
+      }
+      equalizer::carrier_stats::error_power(symbols, points, power);
+      for(int c = 0; c < 48; c++) {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(std::norm(symbols[c] - points[c]), power[c], 1e-5);
+      }
+
+      equalizer::carrier_stats stats;
+      for(int i = 0; i < 3 * equalizer::carrier_stats::WINDOW; i++) {
+        stats.add(power);
+      }
+      CPPUNIT_ASSERT_EQUAL(3 * equalizer::carrier_stats::WINDOW, stats.count());
+      for(int c = 0; c < 48; c++) {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(power[c], stats.mean()[c], 1e-5);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0, stats.variance()[c], 1e-5);
+      }
+    }
+
+    void
+    qa_equalizer::t2()
+    {
+      // QPSK frames over a flat channel with 20 dB SNR per carrier. The
+      // LS estimate averages the two copies of the long training
+      // sequence, its error adds half the noise to the equalized
+      // carriers, so the effective SNR is 20 - 10 log10(1.5) dB.
+      const float sigma = std::sqrt(0.01f / 2);
+      const gr_complex h(0.6f, -0.8f);
+      equalizer::ls ls;
+      ls.set_encoding(std::vector<int>(4, QPSK));
+
+      gr_complex in[64];
+      gr_complex symbols[48];
+      uint8_t bits[48];
+      for(int frame = 0; frame < 10; frame++) {
+        ls.new_frame();
+        for(int n = 0; n < 20; n++) {
+          for(int i = 0; i < 64; i++) {
+            gr_complex x = equalizer::base::LONG[i];
+            if(n >= 2) {
+              x = gr_complex(std::rand() % 2 ? 1 : -1, std::rand() % 2 ? 1 : -1) / std::sqrt(2.0f);
+            }
+            in[i] = x * h + gr_complex(gauss(), gauss()) * sigma;
+          }
+          ls.equalize(in, n, symbols, bits);
+          if(n == 3) {
+            ls.accept_frame();
+          }
+        }
+      }
+      std::vector<double> snr = ls.rb_snr();
+      for(int r = 0; r < 4; r++) {
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(20 - 10 * std::log10(1.5), snr[r], 1);
+      }
+
+      // frames that are not accepted do not change the statistics
+      int count = ls.statistics().count();
+      ls.new_frame();
+      for(int n = 0; n < 20; n++) {
+        for(int i = 0; i < 64; i++) {
+          in[i] = gr_complex(gauss(), gauss());
+        }
+        ls.equalize(in, n, symbols, bits);
+      }
+      CPPUNIT_ASSERT_EQUAL(count, ls.statistics().count());
+    }
+
+    void
+    qa_equalizer::t3()
+    {
+      // A known frame gives the same PDU in frame_decoder, the receiver
+      // of equalize_and_decode, and in decode_mac, which decodes the
+      // symbols of frame_equalizer. Both go through psdu_decoder.
+      static uint8_t rx_symbols[48 * MAX_SYM];
+      static int8_t rx_llr[SOFT_SYMBOL_SIZE * MAX_SYM];
+      static uint8_t depunctured[MAX_DEPUNCTURED_BITS + (TRACEBACK_MAX + 1) * 16];
+
+      std::srand(31);
+      const int enc[] = { QPSK, QAM16, BPSK, QAM64 };
+      ofdm_param ofdm(std::vector<int>(enc, enc + 4), P_3_4);
+      std::vector<uint8_t> psdu = make_psdu(250);
+      std::vector<gr_complex> in = make_frame(psdu, ofdm, 23);
+      int n_symbols = in.size() / 64;
+
+      for(int soft = 0; soft < 2; soft++) {
+        gr_complex symbols[48];
+        uint8_t bits[48];
+
+        frame_decoder rx(LS, FREQ, BW, false, false, false, false, soft, 1);
+        pmt::pmt_t pdu = pmt::PMT_NIL;
+        rx.new_frame(0);
+        for(int s = 0; s < n_symbols; s++) {
+          if(rx.push(&in[64 * s], symbols) == frame_decoder::LAST) {
+            pdu = rx.decode();
+          }
+        }
+
+        // the frame buffer of decode_mac after frame_equalizer
+        ofdm_equalizer eq(LS, FREQ, BW, false, false);
+        psdu_decoder decoder("DECODE_MAC", false, false, false, 1);
+        std::vector<double> snr;
+        eq.new_frame(0);
+        for(int s = 0; s < n_symbols; s++) {
+          int n = s - 4;
+          if(eq.equalize(&in[64 * s], symbols, n < 0 ? bits : rx_symbols + 48 * n)) {
+            snr = eq.rb_snr();
+          }
+          if(soft && n >= 0) {
+            eq.soft_bits(symbols, rx_llr + n * SOFT_SYMBOL_SIZE);
+          }
+        }
+        ofdm_param rx_ofdm(eq.frame_encoding(), eq.frame_puncturing());
+        frame_param rx_frame(rx_ofdm, eq.frame_bytes());
+        CPPUNIT_ASSERT_EQUAL(n_symbols - 4, rx_frame.n_sym);
+        if(soft) {
+          decoder.gather_soft(rx_llr, rx_ofdm, rx_frame, depunctured);
+        } else {
+          decoder.gather_hard(rx_symbols, rx_ofdm, rx_frame, depunctured);
+        }
+        pmt::pmt_t ref = decoder.decode(depunctured, soft, rx_ofdm, rx_frame,
+            snr, eq.frequency(), eq.freq_offset(), 0);
+
+        CPPUNIT_ASSERT(pmt::is_pair(ref));
+        CPPUNIT_ASSERT(pmt::equal(ref, pdu));
+        pmt::pmt_t blob = pmt::cdr(pdu);
+        CPPUNIT_ASSERT_EQUAL(psdu.size() - 4, pmt::blob_length(blob));
+        CPPUNIT_ASSERT(std::memcmp(&psdu[0], pmt::blob_data(blob), psdu.size() - 4) == 0);
+      }
+    }
+
+    void
+    qa_equalizer::t4()
+    {
+      // The rx_engine delivers the frames in the order they were
+      // submitted, with the PDUs and the SNR of one frame_decoder that
+      // receives all of them, as equalize_and_decode does without threads.
+      const int punctures[] = { P_1_2, P_3_4 };
+      std::vector<std::vector<gr_complex> > frames;
+
+      std::srand(37);
+      for(int i = 0; i < 24; i++) {
+        std::vector<int> encoding(4);
+        for(int r = 0; r < 4; r++) {
+          encoding[r] = std::rand() % 4;
+        }
+        ofdm_param ofdm(encoding, punctures[std::rand() % 2]);
+        std::vector<uint8_t> psdu = make_psdu(30 + std::rand() % 400);
+        frames.push_back(make_frame(psdu, ofdm, 1 + i));
+      }
+
+      std::vector<pmt::pmt_t> inline_pdus;
+      frame_decoder rx(LS, FREQ, BW, false, false, false, false, false, 1);
+      for(size_t i = 0; i < frames.size(); i++) {
+        gr_complex symbols[48];
+        pmt::pmt_t pdu = pmt::PMT_NIL;
+        rx.new_frame(0);
+        for(size_t s = 0; s < frames[i].size() / 64; s++) {
+          if(rx.push(&frames[i][64 * s], symbols) == frame_decoder::LAST) {
+            pdu = rx.decode();
+          }
+        }
+        CPPUNIT_ASSERT(pmt::is_pair(pdu));
+        inline_pdus.push_back(pdu);
+      }
+      // only the rx_engine keeps the errors of the frames
+      CPPUNIT_ASSERT(rx.frame_errors().empty());
+
+      delivered.clear();
+      {
+        rx_engine engine(3, deliver, LS, FREQ, BW, false, false, false,
+            false, false, 1);
+        for(size_t i = 0; i < frames.size(); i++) {
+          rx_job *job = engine.acquire();
+          job->algo = LS;
+          job->freq = FREQ;
+          job->bw = BW;
+          job->sta_alpha = equalizer::sta::DEFAULT_ALPHA;
+          job->sta_beta = equalizer::sta::DEFAULT_BETA;
+          job->cfo = 0;
+          job->trace = 0;
+          job->samples = frames[i];
+          job->n_symbols = frames[i].size() / 64;
+          engine.submit(job);
+        }
+      }
+
+      CPPUNIT_ASSERT_EQUAL(inline_pdus.size(), delivered.size());
+      for(size_t i = 0; i < delivered.size(); i++) {
+        CPPUNIT_ASSERT(pmt::equal(pmt::cdr(inline_pdus[i]), pmt::cdr(delivered[i])));
+
+        pmt::pmt_t key = pmt::mp("snr");
+        std::vector<double> snr = pmt::f64vector_elements(
+            pmt::dict_ref(pmt::car(inline_pdus[i]), key, pmt::PMT_NIL));
+        std::vector<double> engine_snr = pmt::f64vector_elements(
+            pmt::dict_ref(pmt::car(delivered[i]), key, pmt::PMT_NIL));
+        for(int r = 0; r < 4; r++) {
+          CPPUNIT_ASSERT_DOUBLES_EQUAL(snr[r], engine_snr[r], 1e-6);
+        }
+      }
+    }
+
+    void
+    qa_equalizer::t5()
+    {
+      // the AVX2 slicers decide like the scalar ones for any number of
+      // carriers, also less than one register
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+      if(!cpu_supports(CPU_AVX2)) {
+        return;
+      }
+      const equalizer::slice_fn scalar[4] = { equalizer::slice<BPSK>,
+          equalizer::slice<QPSK>, equalizer::slice<QAM16>, equalizer::slice<QAM64> };
+      const equalizer::slice_fn avx2[4] = { equalizer::slice_bpsk_avx2,
+          equalizer::slice_qpsk_avx2, equalizer::slice_qam16_avx2,
+          equalizer::slice_qam64_avx2 };
+
+      std::srand(41);
+      float re[48], im[48];
+      uint8_t ref[48], bits[48 + 1];
+      for(int enc = 0; enc < 4; enc++) {
+        for(int n = 1; n <= 48; n++) {
+          for(int i = 0; i < n; i++) {
+            re[i] = gauss();
+            im[i] = gauss();
+          }
+          bits[n] = 0xaa;
+          scalar[enc](re, im, ref, n);
+          avx2[enc](re, im, bits, n);
+          CPPUNIT_ASSERT(std::memcmp(ref, bits, n) == 0);
+          CPPUNIT_ASSERT_EQUAL(0xaa, int(bits[n]));
+        }
+      }
+#endif
+    }
+
+    void
+    qa_equalizer::t6()
+    {
+      // The sampling offset of a frequency offset grows over the frame.
+      // Over MAX_SYM symbols the phasor recurrence of ofdm_equalizer gives
+      // the carriers of one exp() per carrier, up to the float precision.
+      const double cfo = 0.1;
+      const double epsilon = cfo * BW / (2 * M_PI * FREQ);
+
+      std::srand(47);
+      ofdm_param ofdm(std::vector<int>(4, BPSK), P_1_2);
+      std::vector<uint8_t> psdu = make_psdu(MAX_PSDU_SIZE);
+      std::vector<gr_complex> in = make_frame(psdu, ofdm, 29);
+      int n_symbols = in.size() / 64;
+      CPPUNIT_ASSERT_EQUAL(MAX_SYM + 4, n_symbols);
+
+      for(int s = 0; s < n_symbols; s++) {
+        double phi = 2 * M_PI * s * 80 * epsilon / 64;
+        for(int j = 0; j < 64; j++) {
+          in[64 * s + j] *= gr_complex(std::polar(1.0, 0.3 - (j - 32) * phi));
+        }
+      }
+
+      ofdm_equalizer eq(LS, FREQ, BW, false, false);
+      exp_equalizer ref(cfo);
+      eq.new_frame(cfo);
+      for(int s = 0; s < n_symbols; s++) {
+        gr_complex symbols[48];
+        gr_complex expected[48];
+        uint8_t bits[48];
+        uint8_t expected_bits[48];
+        eq.equalize(&in[64 * s], symbols, bits);
+        ref.equalize(&in[64 * s], expected, expected_bits);
+        if(s == 3) {
+          CPPUNIT_ASSERT_EQUAL(int(psdu.size()), eq.frame_bytes());
+          ref.set_encoding(ofdm.resource_blocks_e);
+        }
+        for(int c = 0; c < 48; c++) {
+          CPPUNIT_ASSERT(std::abs(symbols[c] - expected[c]) < 2e-5);
+        }
+        if(s >= 4) {
+          CPPUNIT_ASSERT(std::memcmp(bits, expected_bits, 48) == 0);
+        }
+      }
+    }
+
+    void
+    qa_equalizer::t7()
+    {
+      // The prefix sums of sta give the symbols, bits and channel estimate
+      // of the sliding window on random channels and data. Carriers
+      // without a used carrier in their window (the guards and with
+      // beta = 0 the DC carrier) were 0 / 0 before and keep their estimate
+      // now, they are never equalized.
+      const float sigma = std::sqrt(0.01f / 2);
+      const float alphas[] = { 0.5f, 0.1f, 1.0f };
+      const int betas[] = { 0, 1, 2, 5, 8 };
+
+      std::srand(53);
+      for(int a = 0; a < 3; a++) {
+        for(int b = 0; b < 5; b++) {
+          sta_probe sta(alphas[a], betas[b]);
+          window_sta ref(alphas[a], betas[b]);
+          std::vector<int> encoding(4);
+          for(int r = 0; r < 4; r++) {
+            encoding[r] = std::rand() % 4;
+          }
+          sta.set_encoding(encoding);
+          ref.set_encoding(encoding);
+
+          gr_complex h[64];
+          for(int i = 0; i < 64; i++) {
+            h[i] = gr_complex(gauss(), gauss());
+          }
+
+          gr_complex in[64];
+          gr_complex ltf[64];
+          for(int n = 0; n < 40; n++) {
+            for(int i = 0; i < 64; i++) {
+              gr_complex x = equalizer::base::LONG[i];
+              if(n >= 2) {
+                x = gr_complex(gauss(), gauss());
+              }
+              in[i] = x * h[i] + gr_complex(gauss(), gauss()) * sigma;
+            }
+
+            gr_complex symbols[48];
+            gr_complex expected[48];
+            uint8_t bits[48];
+            uint8_t expected_bits[48];
+            sta.equalize(in, n, symbols, bits);
+            ref.equalize(in, n, expected, expected_bits);
+            if(n == 1) {
+              std::memcpy(ltf, sta.channel(), sizeof(ltf));
+            }
+            if(n < 2) {
+              continue;
+            }
+
+            for(int c = 0; c < 48; c++) {
+              CPPUNIT_ASSERT(std::abs(symbols[c] - expected[c]) <= 1e-4 * std::abs(expected[c]) + 1e-5);
+            }
+            CPPUNIT_ASSERT(std::memcmp(bits, expected_bits, 48) == 0);
+
+            for(int i = 0; i < 64; i++) {
+              gr_complex H = sta.channel()[i];
+              gr_complex H_ref = ref.channel()[i];
+              bool empty = true;
+              for(int k = i - betas[b]; k <= i + betas[b]; k++) {
+                if(k >= 6 && k <= 58 && k != 32) {
+                  empty = false;
+                }
+              }
+              CPPUNIT_ASSERT_EQUAL(empty, bool(std::isnan(H_ref.real())));
+              if(empty) {
+                CPPUNIT_ASSERT(H == ltf[i]);
+              } else {
+                CPPUNIT_ASSERT(std::abs(H - H_ref) <= 1e-4 * std::abs(H_ref) + 1e-5);
+              }
+            }
+          }
+        }
+      }
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_frame_tracer.h"
+#include "frame_tracer.h"
+#include <cmath>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    void
+    qa_frame_tracer::t1()
+    {
+      // histogram buckets are within 1/16 of the value
+      const uint64_t values[] = { 0, 15, 16, 17, 1000, 123456, 987654321 };
+      for(int i = 0; i < 7; i++) {
+        uint64_t v = frame_tracer::bucket_value(frame_tracer::bucket(values[i]));
+        CPPUNIT_ASSERT(std::abs(double(v) - double(values[i])) <= values[i] / 16.0);
+      }
+      CPPUNIT_ASSERT(frame_tracer::bucket(~uint64_t(0)) < frame_tracer::N_BUCKETS);
+
+      frame_tracer tracer;
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), tracer.new_frame());
+
+      tracer.start("");
+      for(int i = 0; i < 100; i++) {
+        uint64_t frame = tracer.new_frame();
+        CPPUNIT_ASSERT(frame);
+        tracer.stamp(frame, frame_tracer::VITERBI);
+        tracer.stamp(frame, frame_tracer::CRC, 1);
+      }
+      tracer.flush();
+      CPPUNIT_ASSERT_EQUAL(uint64_t(100), tracer.count(frame_tracer::SYNC));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(100), tracer.count(frame_tracer::CRC));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), tracer.count(frame_tracer::ACK));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), tracer.percentile(frame_tracer::SYNC, 0.99));
+      CPPUNIT_ASSERT(tracer.percentile(frame_tracer::CRC, 0.5) <= tracer.percentile(frame_tracer::CRC, 0.99));
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), tracer.dropped());
+
+      // frames that are not traced cost nothing
+      tracer.stamp(0, frame_tracer::ACK);
+      tracer.stop();
+      tracer.stamp(1, frame_tracer::ACK);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(0), tracer.count(frame_tracer::ACK));
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
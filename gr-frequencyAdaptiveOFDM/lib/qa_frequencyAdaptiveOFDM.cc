@@ -26,13 +26,33 @@
  */
 
 #include "qa_frequencyAdaptiveOFDM.h"
+#include "qa_arq.h"
+#include "qa_constellation_tap.h"
+#include "qa_counters.h"
+#include "qa_equalizer.h"
+#include "qa_frame_tracer.h"
+#include "qa_logger.h"
+#include "qa_mapper.h"
+#include "qa_ofdm_synthesizer.h"
 #include "qa_signal_field.h"
+#include "qa_utils.h"
+#include "qa_viterbi_decoder.h"
 
 CppUnit::TestSuite *
 qa_frequencyAdaptiveOFDM::suite()
 {
   CppUnit::TestSuite *s = new CppUnit::TestSuite("frequencyAdaptiveOFDM");
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_arq::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_constellation_tap::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_counters::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_equalizer::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_frame_tracer::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_logger::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_mapper::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_ofdm_synthesizer::suite());
   s->addTest(gr::frequencyAdaptiveOFDM::qa_signal_field::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_utils::suite());
+  s->addTest(gr::frequencyAdaptiveOFDM::qa_viterbi_decoder::suite());
 
   return s;
 }
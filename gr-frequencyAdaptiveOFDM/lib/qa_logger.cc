@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_logger.h"
+#include "logger.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    void
+    qa_logger::t1()
+    {
+      char file[] = "/tmp/qa_logger_XXXXXX";
+      close(mkstemp(file));
+
+      logger log;
+      log.start(file);
+      log.stream(logger::L_DEBUG) << "first " << 1 << std::endl;
+      // a line is one message, however it is written
+      log.stream(logger::L_WARN) << "sec";
+      log.stream(logger::L_WARN) << "ond\nthird\n";
+      char bytes[] = {0, 1, 1, 0};
+      log.bytes(logger::L_TRACE, "bits:", bytes, 4);
+      // longer than half the ring
+      std::string big(logger::RING_SIZE / 2, 'x');
+      log.stream(logger::L_INFO) << big << std::endl;
+      log.stop();
+
+      std::ifstream in(file);
+      std::stringstream text;
+      text << in.rdbuf();
+      unlink(file);
+      std::string out = text.str();
+
+      size_t first = out.find(" DEBUG [0] first 1\n");
+      size_t second = out.find(" WARN  [0] second\n");
+      size_t third = out.find(" WARN  [0] third\n");
+      size_t bits = out.find(" TRACE [0] bits:\n00 01 01 00 \n\n");
+      CPPUNIT_ASSERT(first != std::string::npos);
+      CPPUNIT_ASSERT(second > first && second != std::string::npos);
+      CPPUNIT_ASSERT(third > second && third != std::string::npos);
+      CPPUNIT_ASSERT(bits > third && bits != std::string::npos);
+      CPPUNIT_ASSERT_EQUAL(uint64_t(1), log.dropped());
+      CPPUNIT_ASSERT(out.find("LOGGER: 1 messages dropped\n") != std::string::npos);
+
+      // levels above FREQUENCYADAPTIVEOFDM_LOG_LEVEL are compiled out
+      CPPUNIT_ASSERT_EQUAL(FREQUENCYADAPTIVEOFDM_LOG_LEVEL >= logger::L_TRACE,
+          bool(LOG_ENABLED(TRACE)));
+      CPPUNIT_ASSERT(LOG_ENABLED(ERROR));
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
@@ -0,0 +1,141 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_mapper.h"
+#include "utils.h"
+#include <frequencyAdaptiveOFDM/mapper.h>
+#include <gnuradio/io_signature.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/top_block.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    // keeps the first n bytes of the stream and their tags
+    class symbol_sink : public gr::sync_block
+    {
+    public:
+      symbol_sink(int n)
+        : gr::sync_block("symbol_sink",
+            gr::io_signature::make(1, 1, sizeof(char)),
+            gr::io_signature::make(0, 0, 0)),
+          d_n(n)
+      {
+      }
+
+      int
+      work(int noutput, gr_vector_const_void_star &input_items,
+          gr_vector_void_star &output_items)
+      {
+        if((int)data.size() >= d_n) {
+          return WORK_DONE;
+        }
+        const char *in = (const char*)input_items[0];
+        int n = std::min(noutput, d_n - (int)data.size());
+        std::vector<tag_t> range;
+        get_tags_in_range(range, 0, nitems_read(0), nitems_read(0) + n);
+        tags.insert(tags.end(), range.begin(), range.end());
+        data.insert(data.end(), in, in + n);
+        return n;
+      }
+
+      std::vector<char> data;
+      std::vector<tag_t> tags;
+
+    private:
+      int d_n;
+    };
+
+    static boost::shared_ptr<symbol_sink>
+    run_mapper(int workers, const std::vector<pmt::pmt_t> &pdus, int n_items)
+    {
+      char no_file[] = "";
+      gr::top_block_sptr tb = gr::make_top_block("mapper");
+      mapper::sptr map = mapper::make(false, std::vector<int>(4, BPSK),
+          false, false, no_file, true, workers);
+      boost::shared_ptr<symbol_sink> sink =
+          gnuradio::get_initial_sptr(new symbol_sink(n_items));
+
+      for(size_t i = 0; i < pdus.size(); i++) {
+        map->_post(pmt::mp("in"), pdus[i]);
+      }
+      tb->connect(map, 0, sink, 0);
+      tb->run();
+      return sink;
+    }
+
+    void
+    qa_mapper::t1()
+    {
+      // the workers of the pipelined mapper deliver the frames and tags
+      // of the serial one in the order of the PDUs. Every mapper starts
+      // with scrambler seed 1, so both runs see the same seeds whatever
+      // ran before them.
+      const int punctures[] = { P_1_2, P_3_4 };
+      std::vector<pmt::pmt_t> pdus;
+      int n_items = 0;
+
+      std::srand(29);
+      for(int i = 0; i < 127; i++) {
+        std::vector<int> encoding(4);
+        for(int r = 0; r < 4; r++) {
+          encoding[r] = std::rand() % 4;
+        }
+        int punct = punctures[std::rand() % 2];
+        std::vector<uint8_t> psdu(sizeof(mac_header) + std::rand() % 300);
+        for(size_t k = 0; k < psdu.size(); k++) {
+          psdu[k] = std::rand();
+        }
+        ((mac_header*)&psdu[0])->frame_control = 2 << 2;
+
+        ofdm_param ofdm(encoding, punct);
+        frame_param frame(ofdm, psdu.size());
+        n_items += frame.n_sym * 48;
+
+        pmt::pmt_t dict = pmt::make_dict();
+        dict = pmt::dict_add(dict, pmt::mp("encoding"),
+            pmt::init_s32vector(4, encoding));
+        dict = pmt::dict_add(dict, pmt::mp("puncturing"), pmt::from_long(punct));
+        pdus.push_back(pmt::cons(dict,
+            pmt::init_u8vector(psdu.size(), psdu)));
+      }
+
+      boost::shared_ptr<symbol_sink> serial = run_mapper(0, pdus, n_items);
+      boost::shared_ptr<symbol_sink> pipelined = run_mapper(3, pdus, n_items);
+
+      CPPUNIT_ASSERT_EQUAL((size_t)n_items, serial->data.size());
+      CPPUNIT_ASSERT(serial->data == pipelined->data);
+      // packet_len, psdu_len, encoding and puncturing of every frame
+      CPPUNIT_ASSERT_EQUAL(4 * pdus.size(), serial->tags.size());
+      CPPUNIT_ASSERT_EQUAL(serial->tags.size(), pipelined->tags.size());
+      for(size_t i = 0; i < serial->tags.size(); i++) {
+        CPPUNIT_ASSERT_EQUAL(serial->tags[i].offset, pipelined->tags[i].offset);
+        CPPUNIT_ASSERT(pmt::eqv(serial->tags[i].key, pipelined->tags[i].key));
+        CPPUNIT_ASSERT(pmt::equal(serial->tags[i].value, pipelined->tags[i].value));
+      }
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
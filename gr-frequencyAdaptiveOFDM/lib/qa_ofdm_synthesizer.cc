@@ -0,0 +1,349 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_ofdm_synthesizer.h"
+#include "ofdm_synthesizer.h"
+#include "signal_field_impl.h"
+#include <frequencyAdaptiveOFDM/constellations.h>
+#include <frequencyAdaptiveOFDM/frame_synthesizer.h>
+#include <gnuradio/io_signature.h>
+#include <gnuradio/sync_block.h>
+#include <gnuradio/top_block.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    // The TX hierarchy of wifi_freq_adap_phy_hier.grc, its parameters are
+    // copied from there and not taken from the synthesizer.
+
+    // occupied carriers of the carrier allocator, [first, last)
+    static const int OCCUPIED[6][2] = {
+      { -26, -21 }, { -20, -7 }, { -6, 0 }, { 1, 7 }, { 8, 21 }, { 22, 27 }
+    };
+    static const int PILOT_CARRIERS[4] = { -21, -7, 7, 21 };
+
+    // pilot symbols, symbol s is PILOT_POLARITY[s] times (1, 1, 1, -1)
+    static const char PILOT_POLARITY[] =
+        "++++---+----++-+--++-++-++++++-+++-++--+++-+---+-+--+--+++++--++"
+        "--+-+-++---++----+--+-++++-+-+-+-----+-++-+-+++--+---+++-------";
+
+    // sync words, character i is carrier i - 32 with 0, +1, -1, +j (j)
+    // and -j (J). The short training words are scaled by SHORT_POINT.
+    static const char *SYNC_WORDS[4] = {
+      "00000000+000-000+000-000-000+0000000-000-000+000+000+000+0000000",
+      "00000000+000-000+000-000-000+0000000-000-000+000+000+000+0000000",
+      "000000-j-j-j-J+j+J-j+j+j+j-J+J-j0J+J+J+j-J+J-j+j+j+j-J+j+J-00000",
+      "000000++--++-+-++++++--++-+-++++0+--++-+-+-----++--+-+-++++00000"
+    };
+    static const gr_complex SHORT_POINT(1.4719601443879746f, 1.4719601443879746f);
+
+    // fft_vxx backwards with shift and this window, cyclic prefixer
+    static const float WINDOW = 1 / std::sqrt(52.0f);
+    static const int CP_LEN = 16;
+    static const int ROLLOFF = 2;
+
+    static gr_complex
+    sync_carrier(int word, int i)
+    {
+      gr_complex v;
+      switch(SYNC_WORDS[word][i]) {
+      case '+': v = 1; break;
+      case '-': v = -1; break;
+      case 'j': v = gr_complex(0, 1); break;
+      case 'J': v = gr_complex(0, -1); break;
+      default: v = 0;
+      }
+      return word < 2 ? v * SHORT_POINT : v;
+    }
+
+    // one inverse DFT per symbol, index i of the carriers is carrier i - 32
+    static void
+    idft(const gr_complex *carriers, gr_complex *out)
+    {
+      for(int n = 0; n < 64; n++) {
+        std::complex<double> sum = 0;
+        for(int i = 0; i < 64; i++) {
+          sum += std::complex<double>(carriers[i] * WINDOW) *
+              std::polar(1.0, 2 * M_PI * (i - 32) * n / 64);
+        }
+        out[n] = gr_complex(sum);
+      }
+    }
+
+    // the frame as the TX hierarchy generates it: the mapper with one bit
+    // per char, packet header generator and chunks to symbols, the
+    // carrier allocator, fft_vxx and the cyclic prefixer. The prefixer
+    // fades the first ROLLOFF - 1 samples of each symbol in and the ones
+    // after the prefix of the previous symbol out, like
+    // ofdm_cyclic_prefixer of gr-digital, and flushes the last fade out at
+    // the end of the packet.
+    static std::vector<gr_complex>
+    hierarchy_frame(const char *psdu, frame_param &frame, ofdm_param &ofdm,
+        char scrambler)
+    {
+      std::vector<char> data_bits(frame.n_data_bits);
+      std::vector<char> scrambled(frame.n_data_bits);
+      std::vector<char> encoded(2 * frame.n_data_bits);
+      std::vector<char> punctured(frame.n_encoded_bits);
+      std::vector<char> interleaved(frame.n_encoded_bits);
+      std::vector<char> symbols(48 * frame.n_sym);
+
+      generate_bits(psdu, &data_bits[0], frame);
+      scramble(&data_bits[0], &scrambled[0], frame, scrambler);
+      reset_tail_bits(&scrambled[0], frame);
+      convolutional_encoding(&scrambled[0], &encoded[0], frame);
+      puncturing(&encoded[0], &punctured[0], frame, ofdm);
+      interleave(&punctured[0], &interleaved[0], frame, ofdm);
+      split_symbols(&interleaved[0], &symbols[0], frame, ofdm);
+
+      char header[96];
+      signal_field_impl::generate_signal_field(header, frame, ofdm);
+
+      std::vector<gr_complex> points[4];
+      points[BPSK] = constellation_bpsk::make()->points();
+      points[QPSK] = constellation_qpsk::make()->points();
+      points[QAM16] = constellation_16qam::make()->points();
+      points[QAM64] = constellation_64qam::make()->points();
+
+      std::vector<gr_complex> muxed;
+      for(int i = 0; i < 96; i++) {
+        muxed.push_back(header[i] ? 1 : -1);
+      }
+      for(int i = 0; i < 48 * frame.n_sym; i++) {
+        int e = ofdm.resource_blocks_e[ofdm.rb_index_from_symbols(i)];
+        muxed.push_back(points[e][symbols[i]]);
+      }
+
+      std::vector<std::vector<gr_complex> > carriers;
+      for(int w = 0; w < 4; w++) {
+        std::vector<gr_complex> symbol(64);
+        for(int i = 0; i < 64; i++) {
+          symbol[i] = sync_carrier(w, i);
+        }
+        carriers.push_back(symbol);
+      }
+      for(size_t s = 0; s < muxed.size() / 48; s++) {
+        std::vector<gr_complex> symbol(64);
+        int n = 0;
+        for(int r = 0; r < 6; r++) {
+          for(int c = OCCUPIED[r][0]; c < OCCUPIED[r][1]; c++) {
+            symbol[c + 32] = muxed[48 * s + n++];
+          }
+        }
+        float polarity = PILOT_POLARITY[s % 127] == '+' ? 1 : -1;
+        for(int i = 0; i < 4; i++) {
+          symbol[PILOT_CARRIERS[i] + 32] = polarity * (i == 3 ? -1 : 1);
+        }
+        carriers.push_back(symbol);
+      }
+
+      float up[ROLLOFF - 1];
+      float down[ROLLOFF - 1];
+      for(int i = 1; i < ROLLOFF; i++) {
+        up[i - 1] = 0.5 * (1 + std::cos(M_PI * i / ROLLOFF - M_PI));
+        down[i - 1] = 0.5 * (1 + std::cos(M_PI * (ROLLOFF - i) / ROLLOFF - M_PI));
+      }
+
+      std::vector<gr_complex> out;
+      gr_complex delay[ROLLOFF - 1] = {};
+      for(size_t s = 0; s < carriers.size(); s++) {
+        gr_complex time[64];
+        idft(&carriers[s][0], time);
+        size_t start = out.size();
+        out.insert(out.end(), time + 64 - CP_LEN, time + 64);
+        out.insert(out.end(), time, time + 64);
+        for(int i = 0; i < ROLLOFF - 1; i++) {
+          out[start + i] = out[start + i] * up[i] + delay[i];
+          delay[i] = time[i] * down[i];
+        }
+      }
+      out.insert(out.end(), delay, delay + ROLLOFF - 1);
+      return out;
+    }
+
+    // keeps the first n samples of the stream and the packet_len tags
+    class sample_sink : public gr::sync_block
+    {
+    public:
+      sample_sink(int n)
+        : gr::sync_block("sample_sink",
+            gr::io_signature::make(1, 1, sizeof(gr_complex)),
+            gr::io_signature::make(0, 0, 0)),
+          d_n(n)
+      {
+      }
+
+      int
+      work(int noutput, gr_vector_const_void_star &input_items,
+          gr_vector_void_star &output_items)
+      {
+        if((int)data.size() >= d_n) {
+          return WORK_DONE;
+        }
+        const gr_complex *in = (const gr_complex*)input_items[0];
+        int n = std::min(noutput, d_n - (int)data.size());
+        std::vector<tag_t> range;
+        get_tags_in_range(range, 0, nitems_read(0), nitems_read(0) + n,
+            pmt::mp("packet_len"));
+        tags.insert(tags.end(), range.begin(), range.end());
+        data.insert(data.end(), in, in + n);
+        return n;
+      }
+
+      std::vector<gr_complex> data;
+      std::vector<tag_t> tags;
+
+    private:
+      int d_n;
+    };
+
+    static boost::shared_ptr<sample_sink>
+    run_frame_synthesizer(int max_noutput, const std::vector<pmt::pmt_t> &pdus,
+        int n_samples)
+    {
+      char no_file[] = "";
+      gr::top_block_sptr tb = gr::make_top_block("frame_synthesizer");
+      frame_synthesizer::sptr synth = frame_synthesizer::make(false,
+          std::vector<int>(4, BPSK), false, no_file);
+      if(max_noutput) {
+        synth->set_max_noutput_items(max_noutput);
+      }
+      boost::shared_ptr<sample_sink> sink =
+          gnuradio::get_initial_sptr(new sample_sink(n_samples));
+
+      for(size_t i = 0; i < pdus.size(); i++) {
+        synth->_post(pmt::mp("in"), pdus[i]);
+      }
+      tb->connect(synth, 0, sink, 0);
+      tb->run();
+      return sink;
+    }
+
+    void
+    qa_ofdm_synthesizer::t1()
+    {
+      // the synthesizer produces the samples of the hierarchy for mixed
+      // encodings, with one instance for all frames
+      static char psdu[MAX_PSDU_SIZE];
+      static gr_complex out[(N_SYNC_SYMBOLS + N_SIGNAL_SYMBOLS + MAX_SYM) * 80 + 2];
+      const int punctures[] = { P_1_2, P_3_4 };
+      ofdm_synthesizer synth;
+
+      std::srand(41);
+      for(int f = 0; f < 40; f++) {
+        std::vector<int> encoding(4);
+        for(int r = 0; r < 4; r++) {
+          encoding[r] = std::rand() % 4;
+        }
+        int punct = punctures[std::rand() % 2];
+        // 2/3 is only defined for 64QAM
+        if(f % 8 == 7) {
+          encoding = std::vector<int>(4, QAM64);
+          punct = P_2_3;
+        }
+        int size = f == 0 ? 1 : f == 1 ? MAX_PSDU_SIZE : 1 + std::rand() % MAX_PSDU_SIZE;
+        char scrambler = 1 + f * 13 % 127;
+
+        ofdm_param ofdm(encoding, punct);
+        frame_param frame(ofdm, size);
+        for(int i = 0; i < size; i++) {
+          psdu[i] = std::rand();
+        }
+
+        std::vector<gr_complex> ref = hierarchy_frame(psdu, frame, ofdm, scrambler);
+        int n = ofdm_synthesizer::frame_samples(frame.n_sym);
+        CPPUNIT_ASSERT_EQUAL(int(ref.size()), n);
+
+        out[n] = gr_complex(42, 42);
+        synth.synthesize(psdu, frame, ofdm, scrambler, out);
+        for(int i = 0; i < n; i++) {
+          CPPUNIT_ASSERT(std::abs(ref[i] - out[i]) < 1e-4);
+        }
+        CPPUNIT_ASSERT(out[n] == gr_complex(42, 42));
+      }
+    }
+
+    void
+    qa_ofdm_synthesizer::t2()
+    {
+      // the frame_synthesizer block gives the frames of the hierarchy, its
+      // scrambler seed counts from 1. The frames fit into the output buffer
+      // and are written straight into it, with at most 100 items per call
+      // of general_work they go through the frame buffer in pieces.
+      const int punctures[] = { P_1_2, P_3_4 };
+      std::vector<pmt::pmt_t> pdus;
+      std::vector<gr_complex> ref;
+      std::vector<int> starts;
+
+      std::srand(43);
+      for(int f = 0; f < 20; f++) {
+        std::vector<int> encoding(4);
+        for(int r = 0; r < 4; r++) {
+          encoding[r] = std::rand() % 4;
+        }
+        int punct = punctures[std::rand() % 2];
+        std::vector<uint8_t> psdu(sizeof(mac_header) + std::rand() % 100);
+        for(size_t k = 0; k < psdu.size(); k++) {
+          psdu[k] = std::rand();
+        }
+        ((mac_header*)&psdu[0])->frame_control = 2 << 2;
+
+        ofdm_param ofdm(encoding, punct);
+        frame_param frame(ofdm, psdu.size());
+        std::vector<gr_complex> samples = hierarchy_frame(
+            (const char*)&psdu[0], frame, ofdm, f % 127 + 1);
+        starts.push_back(ref.size());
+        ref.insert(ref.end(), samples.begin(), samples.end());
+
+        pmt::pmt_t dict = pmt::make_dict();
+        dict = pmt::dict_add(dict, pmt::mp("encoding"),
+            pmt::init_s32vector(4, encoding));
+        dict = pmt::dict_add(dict, pmt::mp("puncturing"), pmt::from_long(punct));
+        pdus.push_back(pmt::cons(dict,
+            pmt::init_u8vector(psdu.size(), psdu)));
+      }
+
+      const int max_noutput[] = { 0, 100 };
+      for(int m = 0; m < 2; m++) {
+        boost::shared_ptr<sample_sink> sink =
+            run_frame_synthesizer(max_noutput[m], pdus, ref.size());
+
+        CPPUNIT_ASSERT_EQUAL(ref.size(), sink->data.size());
+        for(size_t i = 0; i < ref.size(); i++) {
+          CPPUNIT_ASSERT(std::abs(ref[i] - sink->data[i]) < 1e-4);
+        }
+        CPPUNIT_ASSERT_EQUAL(starts.size(), sink->tags.size());
+        for(size_t f = 0; f < starts.size(); f++) {
+          int len = (f + 1 < starts.size() ? starts[f + 1] : ref.size()) - starts[f];
+          CPPUNIT_ASSERT_EQUAL(uint64_t(starts[f]), sink->tags[f].offset);
+          CPPUNIT_ASSERT_EQUAL(long(len), pmt::to_long(sink->tags[f].value));
+        }
+      }
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
@@ -0,0 +1,431 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_utils.h"
+#include "utils.h"
+#include "crc32.h"
+#include "demapper.h"
+#include "equalizer/slicer.h"
+#include <boost/crc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    static void
+    assert_packed_equal(const char *bits, const uint64_t *packed, int n_bits)
+    {
+      std::vector<char> unpacked(n_bits);
+      unpack_bits(packed, &unpacked[0], n_bits);
+      CPPUNIT_ASSERT(std::memcmp(bits, &unpacked[0], n_bits) == 0);
+      // bits after the end of the stream are cleared
+      if(n_bits % 64) {
+        CPPUNIT_ASSERT_EQUAL((uint64_t) 0, packed[n_bits / 64] >> (n_bits % 64));
+      }
+    }
+
+    void
+    qa_utils::t1()
+    {
+      // every step of the packed TX bit pipeline is bit exact with the
+      // one bit per char version
+      static char psdu[MAX_PSDU_SIZE];
+      static char data_bits[MAX_ENCODED_BITS];
+      static char scrambled[MAX_ENCODED_BITS];
+      static char encoded[2 * MAX_ENCODED_BITS];
+      static char punctured[MAX_ENCODED_BITS];
+      static char interleaved[MAX_ENCODED_BITS];
+      static char interleaved_packed[MAX_ENCODED_BITS];
+      static uint64_t data_words[MAX_PACKED_WORDS];
+      static uint64_t scrambled_words[MAX_PACKED_WORDS];
+      static uint64_t encoded_words[2 * MAX_PACKED_WORDS];
+      static uint64_t punctured_words[MAX_PACKED_WORDS];
+
+      const int encodings[][4] = {
+        { BPSK, BPSK, BPSK, BPSK },
+        { QPSK, BPSK, QAM16, QPSK },
+        { QAM16, QAM64, QPSK, QAM16 },
+        { QAM64, QAM64, QAM64, QAM64 },
+      };
+      const int punctures[] = { P_1_2, P_3_4, P_2_3 };
+      const int sizes[] = { 0, 1, 14, 100, 333, MAX_PSDU_SIZE };
+
+      std::srand(3);
+      for(int e = 0; e < 4; e++) {
+        for(int p = 0; p < 3; p++) {
+          // 2/3 is only defined for 64QAM
+          if(punctures[p] == P_2_3 && e != 3) {
+            continue;
+          }
+          std::vector<int> encoding(encodings[e], encodings[e] + 4);
+          ofdm_param ofdm(encoding, punctures[p]);
+
+          for(int s = 0; s < 6; s++) {
+            frame_param frame(ofdm, sizes[s]);
+            char seed = 1 + (e * 37 + p * 11 + s * 23) % 127;
+
+            for(int i = 0; i < frame.psdu_size; i++) {
+              psdu[i] = std::rand();
+            }
+
+            std::memset(data_bits, 0, frame.n_data_bits);
+            generate_bits(psdu, data_bits, frame);
+            generate_bits_packed(psdu, data_words, frame);
+            assert_packed_equal(data_bits, data_words, frame.n_data_bits);
+
+            scramble(data_bits, scrambled, frame, seed);
+            scramble_packed(data_words, scrambled_words, frame, seed);
+            assert_packed_equal(scrambled, scrambled_words, frame.n_data_bits);
+
+            reset_tail_bits(scrambled, frame);
+            reset_tail_bits_packed(scrambled_words, frame);
+            assert_packed_equal(scrambled, scrambled_words, frame.n_data_bits);
+
+            convolutional_encoding(scrambled, encoded, frame);
+            convolutional_encoding_packed(scrambled_words, encoded_words, frame);
+            assert_packed_equal(encoded, encoded_words, 2 * frame.n_data_bits);
+
+            puncturing(encoded, punctured, frame, ofdm);
+            puncturing_packed(encoded_words, punctured_words, frame, ofdm);
+            assert_packed_equal(punctured, punctured_words, frame.n_encoded_bits);
+
+            interleave(punctured, interleaved, frame, ofdm);
+            interleave_packed(punctured_words, interleaved_packed, frame, ofdm);
+            CPPUNIT_ASSERT(std::memcmp(interleaved, interleaved_packed,
+                frame.n_encoded_bits) == 0);
+          }
+        }
+      }
+
+      // the scrambler has a period of 127 for every seed
+      std::vector<int> encoding(4, BPSK);
+      ofdm_param ofdm(encoding, P_1_2);
+      frame_param frame(ofdm, 100);
+      std::memset(data_bits, 0, frame.n_data_bits);
+      pack_bits(data_bits, data_words, frame.n_data_bits);
+      for(int seed = 0; seed < 128; seed++) {
+        scramble(data_bits, scrambled, frame, seed);
+        scramble_packed(data_words, scrambled_words, frame, seed);
+        assert_packed_equal(scrambled, scrambled_words, frame.n_data_bits);
+      }
+    }
+
+    void
+    qa_utils::t2()
+    {
+      // the cached permutations interleave like the 802.11 formulas for
+      // every mix of modulations, positions the reverse interleaver does
+      // not hit stay untouched
+      static char in[MAX_ENCODED_BITS];
+      static char out[MAX_ENCODED_BITS];
+      static char ref[MAX_ENCODED_BITS];
+
+      std::srand(9);
+      for(int c = 0; c < 256; c++) {
+        std::vector<int> encoding(4);
+        for(int r = 0; r < 4; r++) {
+          encoding[r] = (c >> (2 * r)) & 3;
+        }
+        ofdm_param ofdm(encoding, P_1_2);
+        frame_param frame(ofdm, 50);
+
+        int n_cbps = ofdm.n_cbps;
+        int s = std::max(int(ofdm.n_bpsc) / 2, 1);
+        std::vector<int> first(n_cbps), second(n_cbps);
+        for(int j = 0; j < n_cbps; j++) {
+          first[j] = s * (j / s) + ((j + int(floor(12.0 * j / n_cbps))) % s);
+        }
+        for(int i = 0; i < n_cbps; i++) {
+          second[i] = 12 * i - (n_cbps - 1) * int(floor(12.0 * i / n_cbps));
+        }
+
+        for(int i = 0; i < frame.n_encoded_bits; i++) {
+          in[i] = std::rand();
+        }
+
+        for(int reverse = 0; reverse < 2; reverse++) {
+          std::memset(out, 0x55, frame.n_encoded_bits);
+          std::memset(ref, 0x55, frame.n_encoded_bits);
+          for(int i = 0; i < frame.n_sym; i++) {
+            for(int k = 0; k < n_cbps; k++) {
+              if(reverse) {
+                ref[i * n_cbps + second[first[k]]] = in[i * n_cbps + k];
+              } else {
+                ref[i * n_cbps + k] = in[i * n_cbps + second[first[k]]];
+              }
+            }
+          }
+          interleave(in, out, frame, ofdm, reverse);
+          CPPUNIT_ASSERT(std::memcmp(ref, out, frame.n_encoded_bits) == 0);
+        }
+      }
+    }
+
+    void
+    qa_utils::t3()
+    {
+      // the fused RX gather equals regrouping, deinterleaving and
+      // depuncturing one after the other
+      static uint8_t symbols[48 * MAX_SYM];
+      static int8_t llr[SOFT_SYMBOL_SIZE * MAX_SYM];
+      static char regrouped[MAX_ENCODED_BITS];
+      static char deinterleaved[MAX_ENCODED_BITS];
+      static uint8_t ref[MAX_DEPUNCTURED_BITS];
+      static uint8_t out[MAX_DEPUNCTURED_BITS];
+
+      const int punctures[] = { P_1_2, P_3_4, P_2_3 };
+      const int patterns[3][6] = {
+        { 1, 1 },
+        { 1, 1, 1, 0, 0, 1 },
+        { 1, 1, 1, 0 },
+      };
+      const int periods[] = { 2, 6, 4 };
+
+      std::srand(13);
+      for(int c = 0; c < 256; c++) {
+        for(int p = 0; p < 3; p++) {
+          std::vector<int> encoding(4);
+          for(int r = 0; r < 4; r++) {
+            encoding[r] = (c >> (2 * r)) & 3;
+          }
+          // 2/3 is only defined for 64QAM
+          if(punctures[p] == P_2_3 && c != 255) {
+            continue;
+          }
+          ofdm_param ofdm(encoding, punctures[p]);
+          frame_param frame(ofdm, 40);
+          const rx_gather_table &table = get_rx_gather_table(ofdm);
+
+          for(int i = 0; i < 48 * frame.n_sym; i++) {
+            symbols[i] = std::rand() & 0x3f;
+          }
+          for(int i = 0; i < SOFT_SYMBOL_SIZE * frame.n_sym; i++) {
+            llr[i] = std::rand();
+          }
+
+          for(int soft = 0; soft < 2; soft++) {
+            int n = 0;
+            for(int i = 0; i < 48 * frame.n_sym; i++) {
+              int bpsc = ofdm.n_bpcrb[ofdm.rb_index_from_symbols(i)];
+              for(int k = 0; k < bpsc; k++) {
+                regrouped[n++] = soft ? llr[i * MAX_BITS_PER_CARRIER + k] :
+                    (symbols[i] >> k) & 1;
+              }
+            }
+
+            // positions the interleaver skips are 0 in both cases
+            std::memset(deinterleaved, 0, frame.n_encoded_bits);
+            interleave(regrouped, deinterleaved, frame, ofdm, true);
+
+            n = 0;
+            for(int i = 0; i < 2 * frame.n_data_bits; i++) {
+              if(patterns[p][i % periods[p]]) {
+                ref[i] = deinterleaved[n++];
+              } else {
+                ref[i] = soft ? 0 : 2;
+              }
+            }
+            CPPUNIT_ASSERT_EQUAL(frame.n_encoded_bits, n);
+
+            if(soft) {
+              rx_gather_soft(llr, out, frame, table);
+            } else {
+              rx_gather_hard(symbols, out, frame, table);
+            }
+            CPPUNIT_ASSERT(std::memcmp(ref, out, 2 * frame.n_data_bits) == 0);
+          }
+        }
+      }
+    }
+
+    void
+    qa_utils::t4()
+    {
+      // CRC-32 kernels give the checksum of boost, the fused descrambler
+      // the bytes of the bit wise one
+      static uint8_t data[MAX_PSDU_SIZE + 64];
+      static char psdu[MAX_PSDU_SIZE];
+      static char data_bits[MAX_ENCODED_BITS];
+      static char scrambled[MAX_ENCODED_BITS];
+      static uint8_t ref[MAX_PSDU_SIZE + 2];
+      static uint8_t out[MAX_PSDU_SIZE + 2];
+
+      std::srand(17);
+      for(int i = 0; i < MAX_PSDU_SIZE + 64; i++) {
+        data[i] = std::rand();
+      }
+      for(int len = 0; len < 300; len++) {
+        for(int offset = 0; offset < 64; offset += 13) {
+          boost::crc_32_type result;
+          result.process_bytes(data + offset, len);
+          CPPUNIT_ASSERT_EQUAL((uint32_t) result.checksum(), crc32(data + offset, len));
+          CPPUNIT_ASSERT_EQUAL((uint32_t) result.checksum(),
+              ~crc32_slicing8(0xffffffff, data + offset, len));
+        }
+      }
+      boost::crc_32_type result;
+      result.process_bytes(data, MAX_PSDU_SIZE);
+      CPPUNIT_ASSERT_EQUAL((uint32_t) result.checksum(), crc32(data, MAX_PSDU_SIZE));
+
+      std::vector<int> encoding(4, QPSK);
+      ofdm_param ofdm(encoding, P_1_2);
+      const int sizes[] = { 4, 5, 14, 28, 100, 333, MAX_PSDU_SIZE };
+
+      for(int s = 0; s < 7; s++) {
+        frame_param frame(ofdm, sizes[s]);
+        for(int seed = 0; seed < 128; seed += 21) {
+          for(int i = 0; i < frame.psdu_size - 4; i++) {
+            psdu[i] = std::rand();
+          }
+          uint32_t fcs = crc32((uint8_t *) psdu, frame.psdu_size - 4);
+          std::memcpy(psdu + frame.psdu_size - 4, &fcs, 4);
+
+          std::memset(data_bits, 0, frame.n_data_bits);
+          generate_bits(psdu, data_bits, frame);
+          scramble(data_bits, scrambled, frame, seed);
+
+          // bit wise descrambler of decode_mac
+          std::memset(ref, 0, frame.psdu_size + 2);
+          int state = 0;
+          for(int i = 0; i < 7; i++) {
+            if(scrambled[i]) {
+              state |= 1 << (6 - i);
+            }
+          }
+          ref[0] = state;
+          for(int i = 7; i < frame.psdu_size * 8 + 16; i++) {
+            int feedback = (!!(state & 64)) ^ (!!(state & 8));
+            ref[i / 8] |= (feedback ^ scrambled[i]) << (i % 8);
+            state = ((state << 1) & 0x7e) | feedback;
+          }
+
+          uint32_t crc = descramble_crc((uint8_t *) scrambled, out, frame);
+          CPPUNIT_ASSERT(std::memcmp(ref, out, frame.psdu_size + 2) == 0);
+          CPPUNIT_ASSERT(std::memcmp(psdu, out + 2, frame.psdu_size) == 0);
+          CPPUNIT_ASSERT_EQUAL((uint32_t) CRC32_RESIDUE, crc);
+
+          // a flipped bit breaks the checksum
+          scrambled[16 + std::rand() % (8 * frame.psdu_size)] ^= 1;
+          crc = descramble_crc((uint8_t *) scrambled, out, frame);
+          CPPUNIT_ASSERT(crc != CRC32_RESIDUE);
+        }
+      }
+    }
+
+    void
+    qa_utils::t5()
+    {
+      // every carrier gets the point of its resource block
+      static uint8_t symbols[48 * MAX_SYM];
+      static gr_complex out[48 * MAX_SYM + 1];
+      gr_complex lut[SYMBOL_LUT_SIZE];
+
+      std::srand(19);
+      for(int i = 0; i < SYMBOL_LUT_SIZE; i++) {
+        lut[i] = gr_complex(i, -i);
+      }
+      for(int i = 0; i < 48 * MAX_SYM; i++) {
+        symbols[i] = std::rand();
+      }
+
+      const int sizes[] = { 1, 3, 47, 48, 101, 48 * MAX_SYM };
+      for(int s = 0; s < 6; s++) {
+        std::fill(out, out + 48 * MAX_SYM + 1, gr_complex(0));
+        map_symbols(symbols, out, sizes[s], lut);
+        for(int i = 0; i < sizes[s]; i++) {
+          int rb = (i % 48) / 12;
+          CPPUNIT_ASSERT(out[i] == lut[64 * rb + (symbols[i] & 63)]);
+        }
+        CPPUNIT_ASSERT(out[sizes[s]] == gr_complex(0, 0));
+      }
+    }
+
+    template<int ENC> static void
+    demap_search(const gr_complex *symbols, const float *csi, float *llr, int n)
+    {
+      const int bits = demap_bits(ENC);
+      for(int i = 0; i < n; i++) {
+        for(int b = 0; b < bits; b++) {
+          float d[2] = { 1e30f, 1e30f };
+          for(int p = 0; p < (1 << bits); p++) {
+            float dist = std::norm(symbols[i] - equalizer::slicer<ENC>::point(p));
+            d[(p >> b) & 1] = std::min(d[(p >> b) & 1], dist);
+          }
+          *llr++ = (d[0] - d[1]) * (csi ? csi[i] : 1);
+        }
+      }
+    }
+
+    template<int ENC> static void
+    check_demap(const gr_complex *symbols, const float *csi, int n)
+    {
+      static float expected[6 * 100];
+      static float llr[6 * 100 + 1];
+      demap_search<ENC>(symbols, csi, expected, n);
+
+      for(int k = 0; k < 2; k++) {
+        llr[n * demap_bits(ENC)] = 42;
+        if(k) {
+          demap_soft_generic(ENC, symbols, csi, llr, n);
+        } else {
+          demap_soft(ENC, symbols, csi, llr, n);
+        }
+        for(int i = 0; i < n * demap_bits(ENC); i++) {
+          CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i], llr[i],
+              1e-4 * (1 + std::abs(expected[i])));
+        }
+        CPPUNIT_ASSERT_EQUAL(42.0f, llr[n * demap_bits(ENC)]);
+      }
+    }
+
+    void
+    qa_utils::t6()
+    {
+      // closed form max-log LLRs against the closest points
+      gr_complex symbols[100];
+      float csi[100];
+
+      std::srand(20);
+      for(int i = 0; i < 100; i++) {
+        float re = (std::rand() / float(RAND_MAX) - 0.5f) * 3;
+        float im = (std::rand() / float(RAND_MAX) - 0.5f) * 3;
+        symbols[i] = gr_complex(re, im);
+        csi[i] = std::rand() / float(RAND_MAX) * 100;
+      }
+
+      const int sizes[] = { 1, 7, 8, 48, 100 };
+      for(int s = 0; s < 5; s++) {
+        check_demap<BPSK>(symbols, csi, sizes[s]);
+        check_demap<QPSK>(symbols, csi, sizes[s]);
+        check_demap<QAM16>(symbols, csi, sizes[s]);
+        check_demap<QAM64>(symbols, csi, sizes[s]);
+        check_demap<QAM64>(symbols, NULL, sizes[s]);
+      }
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
@@ -0,0 +1,326 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include <gnuradio/attributes.h>
+#include <cppunit/TestAssert.h>
+#include "qa_viterbi_decoder.h"
+#include "utils.h"
+#include "viterbi_decoder/viterbi_decoder.h"
+#include "viterbi_decoder/viterbi_decoder_soft.h"
+#include "viterbi_decoder/viterbi_decoder_batch.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace gr {
+  namespace frequencyAdaptiveOFDM {
+
+    static const int PUNCTURING[3] = { P_1_2, P_3_4, P_2_3 };
+
+    // random data bits with the tail bits cleared, encoded and punctured
+    // like in the mapper
+    static void
+    encode_frame(frame_param &frame, ofdm_param &ofdm, char *data_bits, uint8_t *coded_bits)
+    {
+      std::vector<char> encoded(frame.n_data_bits * 2);
+      std::vector<char> punctured(frame.n_encoded_bits);
+
+      for(int i = 0; i < frame.n_data_bits; i++) {
+        data_bits[i] = std::rand() & 1;
+      }
+      reset_tail_bits(data_bits, frame);
+      convolutional_encoding(data_bits, &encoded[0], frame);
+      puncturing(&encoded[0], &punctured[0], frame, ofdm);
+
+      for(int i = 0; i < frame.n_encoded_bits; i++) {
+        coded_bits[i] = punctured[i];
+      }
+    }
+
+    void
+    qa_viterbi_decoder::t1()
+    {
+      // soft bits of +-1 have to decode exactly like the hard bits
+      static viterbi_decoder hard;
+      static viterbi_decoder_soft soft;
+      static char data_bits[MAX_ENCODED_BITS];
+      static uint8_t coded_bits[MAX_ENCODED_BITS];
+      static uint8_t soft_bits[MAX_ENCODED_BITS];
+
+      std::srand(42);
+      for(int p = 0; p < 3; p++) {
+        std::vector<int> encoding(4, p == P_2_3 ? QAM64 : QPSK);
+        ofdm_param ofdm(encoding, PUNCTURING[p]);
+        frame_param frame(ofdm, 1000);
+
+        encode_frame(frame, ofdm, data_bits, coded_bits);
+        // flip some bits, so that the decoders have to correct errors
+        for(int i = 0; i < frame.n_encoded_bits; i += 211) {
+          coded_bits[i] ^= 1;
+        }
+        for(int i = 0; i < frame.n_encoded_bits; i++) {
+          soft_bits[i] = coded_bits[i] ? 1 : (uint8_t) -1;
+        }
+
+        int n_bits = frame.n_data_bits - frame.n_pad;
+        std::vector<uint8_t> hard_out(n_bits);
+        std::memcpy(&hard_out[0], hard.decode(&ofdm, &frame, coded_bits), n_bits);
+        uint8_t *soft_out = soft.decode(&ofdm, &frame, soft_bits);
+
+        for(int i = 0; i < n_bits; i++) {
+          CPPUNIT_ASSERT_EQUAL((int) hard_out[i], (int) soft_out[i]);
+          CPPUNIT_ASSERT_EQUAL((int) data_bits[i], (int) soft_out[i]);
+        }
+      }
+    }
+
+    void
+    qa_viterbi_decoder::t2()
+    {
+      // unreliable bits with the wrong sign are outweighed by reliable ones
+      static viterbi_decoder_soft soft;
+      static char data_bits[MAX_ENCODED_BITS];
+      static uint8_t coded_bits[MAX_ENCODED_BITS];
+      static uint8_t soft_bits[MAX_ENCODED_BITS];
+
+      std::srand(23);
+      for(int p = 0; p < 3; p++) {
+        std::vector<int> encoding(4, p == P_2_3 ? QAM64 : QAM16);
+        ofdm_param ofdm(encoding, PUNCTURING[p]);
+        frame_param frame(ofdm, 1000);
+
+        encode_frame(frame, ofdm, data_bits, coded_bits);
+        for(int i = 0; i < frame.n_encoded_bits; i++) {
+          int8_t llr = (i % 11) ? 64 : -16;
+          soft_bits[i] = coded_bits[i] ? llr : -llr;
+        }
+
+        uint8_t *soft_out = soft.decode(&ofdm, &frame, soft_bits);
+        for(int i = 0; i < frame.n_data_bits - frame.n_pad; i++) {
+          CPPUNIT_ASSERT_EQUAL((int) data_bits[i], (int) soft_out[i]);
+        }
+      }
+    }
+
+    void
+    qa_viterbi_decoder::t3()
+    {
+      // all kernels supported by the CPU have to give the same output as
+      // the baseline one, also for noisy input
+      static viterbi_decoder hard_ref, hard;
+      static viterbi_decoder_soft soft_ref, soft;
+      static char data_bits[MAX_ENCODED_BITS];
+      static uint8_t coded_bits[MAX_ENCODED_BITS];
+      static uint8_t soft_bits[MAX_ENCODED_BITS];
+
+      if(!hard_ref.set_isa(base::ISA_SSE2)) {
+        hard_ref.set_isa(base::ISA_GENERIC);
+      }
+      if(!soft_ref.set_isa(base::ISA_SSE2)) {
+        soft_ref.set_isa(base::ISA_GENERIC);
+      }
+
+      const base::isa_t isas[] = { base::ISA_GENERIC, base::ISA_SSE2,
+          base::ISA_AVX2, base::ISA_AVX512BW };
+
+      std::srand(7);
+      for(int p = 0; p < 3; p++) {
+        std::vector<int> encoding(4, QAM64);
+        ofdm_param ofdm(encoding, PUNCTURING[p]);
+        frame_param frame(ofdm, 1500);
+
+        encode_frame(frame, ofdm, data_bits, coded_bits);
+        for(int i = 0; i < frame.n_encoded_bits; i++) {
+          int8_t llr = std::rand() % 128 - 32;
+          soft_bits[i] = coded_bits[i] ? llr : -llr;
+          coded_bits[i] = llr < 0 ? !coded_bits[i] : coded_bits[i];
+        }
+
+        int n_bits = frame.n_data_bits - frame.n_pad;
+        std::vector<uint8_t> hard_out(n_bits);
+        std::vector<uint8_t> soft_out(n_bits);
+        std::memcpy(&hard_out[0], hard_ref.decode(&ofdm, &frame, coded_bits), n_bits);
+        std::memcpy(&soft_out[0], soft_ref.decode(&ofdm, &frame, soft_bits), n_bits);
+
+        for(int k = 0; k < 4; k++) {
+          if(hard.set_isa(isas[k])) {
+            CPPUNIT_ASSERT(std::memcmp(&hard_out[0],
+                hard.decode(&ofdm, &frame, coded_bits), n_bits) == 0);
+          }
+          if(soft.set_isa(isas[k])) {
+            CPPUNIT_ASSERT(std::memcmp(&soft_out[0],
+                soft.decode(&ofdm, &frame, soft_bits), n_bits) == 0);
+          }
+        }
+      }
+    }
+
+    void
+    qa_viterbi_decoder::t4()
+    {
+      // every frame of a batch decodes like on its own, with all kernels
+      static viterbi_decoder single;
+      static viterbi_decoder_batch batch;
+      static char data_bits[viterbi_decoder_batch::MAX_BATCH][MAX_ENCODED_BITS];
+      static uint8_t coded_bits[viterbi_decoder_batch::MAX_BATCH][MAX_ENCODED_BITS];
+      uint8_t *in[viterbi_decoder_batch::MAX_BATCH];
+
+      const base::isa_t isas[] = { base::ISA_GENERIC, base::ISA_SSE2,
+          base::ISA_AVX2, base::ISA_AVX512BW };
+
+      std::srand(11);
+      for(int p = 0; p < 3; p++) {
+        std::vector<int> encoding(4, p == P_2_3 ? QAM64 : QAM16);
+        ofdm_param ofdm(encoding, PUNCTURING[p]);
+        frame_param frame(ofdm, 14 + 100 * p);
+        int n = viterbi_decoder_batch::MAX_BATCH - 7 * p;
+
+        for(int f = 0; f < n; f++) {
+          encode_frame(frame, ofdm, data_bits[f], coded_bits[f]);
+          for(int i = 3 * f; i < frame.n_encoded_bits; i += 211) {
+            coded_bits[f][i] ^= 1;
+          }
+          in[f] = coded_bits[f];
+        }
+
+        int n_bits = frame.n_data_bits - frame.n_pad;
+        for(int k = 0; k < 4; k++) {
+          if(!batch.set_isa(isas[k])) {
+            continue;
+          }
+          batch.decode(&ofdm, &frame, in, n);
+          for(int f = 0; f < n; f++) {
+            uint8_t *decoded = batch.decoded(f);
+            for(int i = 0; i < n_bits; i++) {
+              CPPUNIT_ASSERT_EQUAL((int) data_bits[f][i], (int) decoded[i]);
+            }
+          }
+        }
+
+        uint8_t *decoded = single.decode(&ofdm, &frame, coded_bits[n - 1]);
+        CPPUNIT_ASSERT(std::memcmp(decoded, batch.decoded(n - 1), n_bits) == 0);
+      }
+    }
+
+    void
+    qa_viterbi_decoder::t5()
+    {
+      // long frames decoded in windows correct the same errors as the
+      // serial decoder, short ones fall back to it
+      static viterbi_decoder hard;
+      static viterbi_decoder_soft soft;
+      static char data_bits[MAX_ENCODED_BITS];
+      static uint8_t coded_bits[MAX_ENCODED_BITS];
+      static uint8_t soft_bits[MAX_ENCODED_BITS];
+
+      std::srand(5);
+      for(int w = 2; w <= 8; w += 3) {
+        hard.set_windows(w);
+        soft.set_windows(w);
+        CPPUNIT_ASSERT_EQUAL(w, hard.windows());
+        CPPUNIT_ASSERT_EQUAL(w, soft.windows());
+
+        for(int p = 0; p < 3; p++) {
+          std::vector<int> encoding(4, p == P_2_3 ? QAM64 : QPSK);
+          ofdm_param ofdm(encoding, PUNCTURING[p]);
+          frame_param frame(ofdm, p == P_1_2 ? 20 : 1500);
+
+          encode_frame(frame, ofdm, data_bits, coded_bits);
+          for(int i = w; i < frame.n_encoded_bits; i += 211) {
+            coded_bits[i] ^= 1;
+          }
+          for(int i = 0; i < frame.n_encoded_bits; i++) {
+            soft_bits[i] = coded_bits[i] ? 1 : (uint8_t) -1;
+          }
+
+          uint8_t *hard_out = hard.decode(&ofdm, &frame, coded_bits);
+          for(int i = 0; i < frame.n_data_bits - frame.n_pad; i++) {
+            CPPUNIT_ASSERT_EQUAL((int) data_bits[i], (int) hard_out[i]);
+          }
+          uint8_t *soft_out = soft.decode(&ofdm, &frame, soft_bits);
+          for(int i = 0; i < frame.n_data_bits - frame.n_pad; i++) {
+            CPPUNIT_ASSERT_EQUAL((int) data_bits[i], (int) soft_out[i]);
+          }
+        }
+      }
+
+      hard.set_windows(1);
+      CPPUNIT_ASSERT_EQUAL(1, hard.windows());
+    }
+
+    void
+    qa_viterbi_decoder::t6()
+    {
+      // symbols of the mapper decode through the RX gather table, with
+      // the single, soft and batch decoders
+      static viterbi_decoder hard;
+      static viterbi_decoder_soft soft;
+      static viterbi_decoder_batch batch;
+      static char data_bits[MAX_ENCODED_BITS];
+      static uint8_t coded_bits[MAX_ENCODED_BITS];
+      static char interleaved[MAX_ENCODED_BITS];
+      static char symbols[48 * MAX_SYM];
+      static int8_t llr[SOFT_SYMBOL_SIZE * MAX_SYM];
+      static uint8_t depunctured[MAX_DEPUNCTURED_BITS + (TRACEBACK_MAX + 1) * 16];
+
+      std::srand(17);
+      for(int p = 0; p < 3; p++) {
+        std::vector<int> encoding(4, QAM64);
+        if(p != P_2_3) {
+          encoding[1] = QPSK;
+          encoding[2] = BPSK;
+        }
+        ofdm_param ofdm(encoding, PUNCTURING[p]);
+        frame_param frame(ofdm, 500);
+        const rx_gather_table &table = get_rx_gather_table(ofdm);
+
+        encode_frame(frame, ofdm, data_bits, coded_bits);
+        interleave((char *) coded_bits, interleaved, frame, ofdm);
+        split_symbols(interleaved, symbols, frame, ofdm);
+        for(int i = 0; i < 48 * frame.n_sym; i++) {
+          for(int k = 0; k < MAX_BITS_PER_CARRIER; k++) {
+            llr[i * MAX_BITS_PER_CARRIER + k] = (symbols[i] >> k) & 1 ? 64 : -64;
+          }
+        }
+
+        int n_bits = frame.n_data_bits - frame.n_pad;
+        rx_gather_hard((uint8_t *) symbols, depunctured, frame, table);
+        uint8_t *out = hard.decode_depunctured(&ofdm, &frame, depunctured);
+        for(int i = 0; i < n_bits; i++) {
+          CPPUNIT_ASSERT_EQUAL((int) data_bits[i], (int) out[i]);
+        }
+
+        uint8_t *in = depunctured;
+        batch.decode_depunctured(&ofdm, &frame, &in, 1);
+        for(int i = 0; i < n_bits; i++) {
+          CPPUNIT_ASSERT_EQUAL((int) data_bits[i], (int) batch.decoded(0)[i]);
+        }
+
+        rx_gather_soft(llr, depunctured, frame, table);
+        std::memset(depunctured + 2 * frame.n_data_bits, 0, (TRACEBACK_MAX + 1) * 16);
+        out = soft.decode_depunctured(&ofdm, &frame, depunctured);
+        for(int i = 0; i < n_bits; i++) {
+          CPPUNIT_ASSERT_EQUAL((int) data_bits[i], (int) out[i]);
+        }
+      }
+    }
+
+  } /* namespace frequencyAdaptiveOFDM */
+} /* namespace gr */
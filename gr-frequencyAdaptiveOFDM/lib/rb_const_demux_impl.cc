@@ -43,11 +43,13 @@ namespace gr {
               gr::io_signature::make(0, 0, 0),
               gr::io_signature::make(0, 0, 0))
     {
+      static const char *names[4] = { "rb1", "rb2", "rb3", "rb4" };
+
       message_port_register_in(pmt::mp("symbols_in"));
-      message_port_register_out(pmt::mp("rb1"));
-      message_port_register_out(pmt::mp("rb2"));
-      message_port_register_out(pmt::mp("rb3"));
-      message_port_register_out(pmt::mp("rb4"));
+      for(int rb = 0; rb < 4; rb++) {
+        d_rb_ports[rb] = pmt::mp(names[rb]);
+        message_port_register_out(d_rb_ports[rb]);
+      }
 
       set_msg_handler(pmt::mp("symbols_in"), 
             boost::bind(&rb_const_demux_impl::symbols_in, this, _1));
@@ -57,23 +59,27 @@ namespace gr {
 
     void
     rb_const_demux_impl::symbols_in(pmt::pmt_t msg){
-      std::vector<gr_complex> symbols;
+      pmt::pmt_t dict = pmt::car(msg);
+      std::vector<gr_complex> scatter = pmt::c32vector_elements(pmt::cdr(msg));
+      std::vector<float> evm = pmt::f32vector_elements(
+          pmt::dict_ref(dict, pmt::mp("evm"), pmt::PMT_NIL));
+      std::vector<uint32_t> histogram = pmt::u32vector_elements(
+          pmt::dict_ref(dict, pmt::mp("histogram"), pmt::PMT_NIL));
 
-      symbols = pmt::c32vector_elements(pmt::cdr(msg));
-      std::vector<gr_complex>::iterator it = symbols.begin();
-      std::vector<gr_complex> rb1(it, it+12);
-      std::vector<gr_complex> rb2(it+12, it+24);
-      std::vector<gr_complex> rb3(it+24, it+36);
-      std::vector<gr_complex> rb4(it+36, it+48);
+      // the snapshot has the same number of points and bins per RB
+      size_t n = scatter.size() / 4;
+      size_t bins = histogram.size() / 4;
+      pmt::pmt_t symbols = pmt::dict_ref(dict, pmt::mp("symbols"), pmt::PMT_NIL);
 
-      message_port_pub(pmt::mp("rb1"), pmt::cons(pmt::make_dict(),
-                          pmt::init_c32vector(12, rb1)));
-      message_port_pub(pmt::mp("rb2"), pmt::cons(pmt::make_dict(),
-                          pmt::init_c32vector(12, rb2)));
-      message_port_pub(pmt::mp("rb3"), pmt::cons(pmt::make_dict(),
-                          pmt::init_c32vector(12, rb3)));
-      message_port_pub(pmt::mp("rb4"), pmt::cons(pmt::make_dict(),
-                          pmt::init_c32vector(12, rb4)));
+      for(int rb = 0; rb < 4; rb++) {
+        pmt::pmt_t meta = pmt::make_dict();
+        meta = pmt::dict_add(meta, pmt::mp("symbols"), symbols);
+        meta = pmt::dict_add(meta, pmt::mp("evm"), pmt::from_double(evm[rb]));
+        meta = pmt::dict_add(meta, pmt::mp("histogram"),
+                             pmt::init_u32vector(bins, &histogram[rb * bins]));
+        message_port_pub(d_rb_ports[rb], pmt::cons(meta,
+                             pmt::init_c32vector(n, &scatter[rb * n])));
+      }
     }
 
   } /* namespace frequencyAdaptiveOFDM */
@@ -33,6 +33,9 @@ namespace gr {
       //~rb_const_demux_impl();
 
       void symbols_in(pmt::pmt_t msg);
+
+     private:
+      pmt::pmt_t d_rb_ports[4];
     };
 
   } // namespace frequencyAdaptiveOFDM
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ring_writer.h"
+#include <boost/bind.hpp>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+ring_writer::ring_writer(thread_rings::make_fn make) :
+	d_rings(make),
+	d_running(false),
+	d_attached(0),
+	d_interval(0),
+	d_writer(NULL),
+	d_stop(false) {
+}
+
+ring_writer::~ring_writer() {
+}
+
+void
+ring_writer::attach_block(const std::string &file) {
+	gr::thread::scoped_lock lock(d_attach_mutex);
+	attached(file);
+	d_attached++;
+}
+
+void
+ring_writer::detach() {
+	gr::thread::scoped_lock lock(d_attach_mutex);
+	if(--d_attached > 0) {
+		return;
+	}
+	detached();
+}
+
+void
+ring_writer::flush() {
+	gr::thread::scoped_lock lock(d_mutex);
+	drain();
+}
+
+uint64_t
+ring_writer::dropped() {
+	return d_rings.dropped();
+}
+
+void
+ring_writer::start_writer(int interval_ms) {
+	d_interval = interval_ms;
+	d_stop = false;
+	__atomic_store_n(&d_running, true, __ATOMIC_RELAXED);
+	d_writer = new boost::thread(boost::bind(&ring_writer::writer, this));
+}
+
+void
+ring_writer::stop() {
+	{
+		gr::thread::scoped_lock lock(d_mutex);
+		if(!d_writer) {
+			return;
+		}
+		__atomic_store_n(&d_running, false, __ATOMIC_RELAXED);
+		d_stop = true;
+	}
+	d_cond.notify_one();
+	d_writer->join();
+	delete d_writer;
+
+	gr::thread::scoped_lock lock(d_mutex);
+	d_writer = NULL;
+	drain();
+	stopped();
+}
+
+void
+ring_writer::writer() {
+	gr::thread::scoped_lock lock(d_mutex);
+	while(true) {
+		d_cond.timed_wait(lock, boost::posix_time::milliseconds(d_interval));
+		if(d_stop) {
+			return;
+		}
+		drain();
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_RING_WRITER_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_RING_WRITER_H
+
+#include "thread_ring.h"
+#include <gnuradio/thread/thread.h>
+#include <boost/thread/thread.hpp>
+#include <stdint.h>
+#include <string>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Writer thread of the sinks the blocks of a process share, the logger,
+ * the frame_tracer and the counters.
+ *
+ * The blocks attach and detach. attached() runs for every block that
+ * attaches, detached() when the last one is gone, both with the other
+ * blocks locked out. While the writer runs it calls drain() every
+ * interval and once more when it stops, then stopped(). The threads that
+ * feed the sink write to d_rings and never wait for the writer.
+ *
+ * drain() and stopped() run with d_mutex held. A sink has to call stop()
+ * in its destructor, the writer can not call it any more from here.
+ */
+class ring_writer
+{
+public:
+	virtual ~ring_writer();
+
+	// reference counting for the blocks
+	void detach();
+
+	// joins the writer, drains and calls stopped()
+	void stop();
+	bool running() const {
+		return __atomic_load_n(&d_running, __ATOMIC_RELAXED);
+	}
+
+	// drains now, the writer thread does it periodically
+	void flush();
+	// records dropped by the rings because they were full
+	uint64_t dropped();
+
+protected:
+	// make builds the ring of a thread, it may be empty if the sink has
+	// no rings
+	ring_writer(thread_rings::make_fn make);
+
+	// counts a block, file is the one it brings. If attached() throws
+	// the block is not counted.
+	void attach_block(const std::string &file);
+	virtual void attached(const std::string &file) = 0;
+	virtual void detached() = 0;
+
+	// d_mutex has to be held, the writer must not run
+	void start_writer(int interval_ms);
+
+	virtual void drain() = 0;
+	virtual void stopped() {}
+
+	thread_rings d_rings;
+	// d_mutex protects the writer and what drain() touches
+	gr::thread::mutex d_mutex;
+
+private:
+	void writer();
+
+	bool d_running;
+	gr::thread::mutex d_attach_mutex;
+	int d_attached;
+
+	// d_mutex protects everything below
+	int d_interval;  // ms
+	boost::thread *d_writer;
+	gr::thread::condition_variable d_cond;
+	bool d_stop;
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_RING_WRITER_H */
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "rx_engine.h"
+#include "equalizer/sta.h"
+#include "counters.h"
+#include <boost/bind.hpp>
+#include <stdexcept>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+rx_engine::worker_state::worker_state(Equalizer algo, double freq, double bw,
+		bool log, bool debug, bool debug_parity, bool debug_rx_err,
+		bool soft, int windows) :
+	decoder(algo, freq, bw, log, debug, debug_parity, debug_rx_err, soft, windows),
+	algo(algo), freq(freq), bw(bw),
+	sta_alpha(equalizer::sta::DEFAULT_ALPHA),
+	sta_beta(equalizer::sta::DEFAULT_BETA) {
+	decoder.set_count_snr(false);
+	decoder.set_keep_frame_errors(true);
+}
+
+rx_engine::rx_engine(int n_threads, deliver_fn deliver, Equalizer algo,
+		double freq, double bw, bool log, bool debug, bool debug_parity,
+		bool debug_rx_err, bool soft, int windows) :
+	d_deliver(deliver),
+	d_jobs(4 * n_threads),
+	d_delivering(false),
+	d_stop(false) {
+
+	if(n_threads < 1) {
+		throw std::invalid_argument("RX ENGINE: number of threads has to be positive");
+	}
+
+	for(size_t i = 0; i < d_jobs.size(); i++) {
+		d_free.push_back(&d_jobs[i]);
+	}
+	for(int i = 0; i < n_threads; i++) {
+		d_workers.push_back(new worker_state(algo, freq, bw, log, debug,
+				debug_parity, debug_rx_err, soft, windows));
+	}
+	for(int i = 0; i < n_threads; i++) {
+		d_threads.create_thread(boost::bind(&rx_engine::worker, this, i));
+	}
+}
+
+rx_engine::~rx_engine() {
+	{
+		gr::thread::scoped_lock lock(d_mutex);
+		d_stop = true;
+	}
+	d_work_cond.notify_all();
+	d_threads.join_all();
+
+	for(size_t i = 0; i < d_workers.size(); i++) {
+		delete d_workers[i];
+	}
+}
+
+rx_job*
+rx_engine::acquire() {
+	gr::thread::scoped_lock lock(d_mutex);
+	while(d_free.empty()) {
+		d_free_cond.wait(lock);
+	}
+	rx_job *job = d_free.back();
+	d_free.pop_back();
+
+	job->samples.clear();
+	job->n_symbols = 0;
+	job->tap = false;
+	return job;
+}
+
+void
+rx_engine::release(rx_job *job) {
+	gr::thread::scoped_lock lock(d_mutex);
+	d_free.push_back(job);
+	d_free_cond.notify_one();
+}
+
+void
+rx_engine::submit(rx_job *job) {
+	job->symbols.clear();
+	job->pdu = pmt::PMT_NIL;
+	job->done = false;
+
+	gr::thread::scoped_lock lock(d_mutex);
+	d_order.push_back(job);
+	d_queue.push_back(job);
+	d_work_cond.notify_one();
+}
+
+void
+rx_engine::worker(int index) {
+	while(true) {
+		rx_job *job;
+		{
+			gr::thread::scoped_lock lock(d_mutex);
+			while(!d_stop && d_queue.empty()) {
+				d_work_cond.wait(lock);
+			}
+			// submitted frames are still received and delivered
+			if(d_queue.empty()) {
+				return;
+			}
+			// the oldest job, it is the one that holds up the delivery
+			job = d_queue.front();
+			d_queue.pop_front();
+		}
+		process(*d_workers[index], *job);
+		finish(job);
+	}
+}
+
+void
+rx_engine::process(worker_state &w, rx_job &job) {
+	if(job.algo != w.algo) {
+		w.decoder.set_algorithm(job.algo);
+		w.algo = job.algo;
+	}
+	if(job.freq != w.freq) {
+		w.decoder.set_frequency(job.freq);
+		w.freq = job.freq;
+	}
+	if(job.bw != w.bw) {
+		w.decoder.set_bandwidth(job.bw);
+		w.bw = job.bw;
+	}
+	if(job.sta_alpha != w.sta_alpha || job.sta_beta != w.sta_beta) {
+		w.decoder.set_sta_smoothing(job.sta_alpha, job.sta_beta);
+		w.sta_alpha = job.sta_alpha;
+		w.sta_beta = job.sta_beta;
+	}
+
+	gr_complex symbols[48];
+	w.decoder.new_frame(job.cfo, job.trace);
+	for(int s = 0; s < job.n_symbols; s++) {
+		frame_decoder::symbol_type type = w.decoder.push(&job.samples[s * 64], symbols);
+		if(job.tap && (type == frame_decoder::DATA || type == frame_decoder::LAST)) {
+			job.symbols.insert(job.symbols.end(), symbols, symbols + 48);
+		}
+		if(type == frame_decoder::LAST) {
+			job.pdu = w.decoder.decode();
+		}
+	}
+	job.errors.assign(w.decoder.frame_errors().begin(), w.decoder.frame_errors().end());
+	job.snr_symbols = w.decoder.snr_symbols();
+}
+
+void
+rx_engine::finish(rx_job *job) {
+	gr::thread::scoped_lock lock(d_mutex);
+	job->done = true;
+
+	// whoever delivers picks up the jobs that finish in the meantime
+	if(d_delivering) {
+		return;
+	}
+	d_delivering = true;
+	while(!d_order.empty() && d_order.front()->done) {
+		rx_job *next = d_order.front();
+		d_order.pop_front();
+
+		lock.unlock();
+		update_snr(*next);
+		d_deliver(*next);
+		lock.lock();
+
+		d_free.push_back(next);
+		d_free_cond.notify_one();
+	}
+	d_delivering = false;
+}
+
+void
+rx_engine::update_snr(rx_job &job) {
+	int n = job.errors.size() / 48;
+	int s = 0;
+
+	if(!pmt::is_null(job.pdu)) {
+		for(; s < job.snr_symbols && s < n; s++) {
+			d_stats.add(&job.errors[48 * s]);
+		}
+		std::vector<double> snr(4, equalizer::base::NO_ESTIMATE);
+		if(d_stats.count()) {
+			d_stats.rb_snr(&snr[0]);
+		}
+		pmt::pmt_t dict = pmt::dict_add(pmt::car(job.pdu), pmt::mp("snr"),
+				pmt::init_f64vector(4, snr));
+		job.pdu = pmt::cons(dict, pmt::cdr(job.pdu));
+		counters::instance().set(counters::RX_SNR, (snr[0] + snr[1] + snr[2] + snr[3]) / 4);
+	}
+	for(; s < n; s++) {
+		d_stats.add(&job.errors[48 * s]);
+	}
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_RX_ENGINE_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_RX_ENGINE_H
+
+#include "frame_decoder.h"
+#include "equalizer/carrier_stats.h"
+#include <gnuradio/thread/thread.h>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+// a frame as it came out of the FFT, everything needed to receive it
+struct rx_job {
+	// equalizer settings when the frame arrived
+	Equalizer algo;
+	double freq;  // Hz
+	double bw;    // Hz
+	double sta_alpha;
+	int sta_beta;
+	double cfo;   // rad per sample, from sync_long
+	uint64_t trace;  // frame_tracer id
+
+	// 64 carriers per symbol, starting with the long training sequence
+	std::vector<gr_complex> samples;
+	int n_symbols;
+	// keep the equalized data carriers for the constellation tap
+	bool tap;
+	std::vector<int> encoding;
+
+	// results, the equalized data carriers (48 per symbol, only with tap)
+	// and the PDU or PMT_NIL if the frame did not decode
+	std::vector<gr_complex> symbols;
+	pmt::pmt_t pdu;
+	// error powers of the carriers, see frame_decoder::frame_errors()
+	std::vector<float> errors;
+	int snr_symbols;
+
+	bool done;
+};
+
+/* Receives frames on a pool of threads, each with its own frame_decoder.
+ * The threads share one queue of jobs and an idle thread takes the
+ * oldest, so a long 64QAM frame does not hold up the frames behind it.
+ * A job is a whole frame, the queue is locked once per frame. Results
+ * are handed to the
+ * deliver callback in the order the jobs were submitted, by the thread
+ * that finishes the oldest outstanding job.
+ *
+ * There are four jobs per thread. acquire() waits for a free one, which
+ * throttles the caller when the threads fall behind. The destructor
+ * waits for the submitted jobs.
+ *
+ * The statistics of the carriers of a thread only see the frames it
+ * received. The SNR of the PDUs and RX_SNR of counters come from
+ * statistics of all frames instead, updated in the order of delivery.
+ */
+class rx_engine
+{
+public:
+	typedef boost::function<void (rx_job &)> deliver_fn;
+
+	rx_engine(int n_threads, deliver_fn deliver, Equalizer algo, double freq,
+			double bw, bool log, bool debug, bool debug_parity,
+			bool debug_rx_err, bool soft, int windows);
+	~rx_engine();
+
+	// free job to fill, blocks until there is one
+	rx_job* acquire();
+	// returns a job that was not submitted
+	void release(rx_job *job);
+	void submit(rx_job *job);
+
+private:
+	struct worker_state {
+		frame_decoder decoder;
+		// settings of the decoder
+		Equalizer algo;
+		double freq;
+		double bw;
+		double sta_alpha;
+		int sta_beta;
+
+		worker_state(Equalizer algo, double freq, double bw, bool log,
+				bool debug, bool debug_parity, bool debug_rx_err,
+				bool soft, int windows);
+	};
+
+	deliver_fn d_deliver;
+	boost::thread_group d_threads;
+	std::vector<worker_state*> d_workers;
+
+	std::vector<rx_job> d_jobs;
+	// d_mutex protects everything below
+	gr::thread::mutex d_mutex;
+	gr::thread::condition_variable d_work_cond;
+	gr::thread::condition_variable d_free_cond;
+	std::vector<rx_job*> d_free;
+	// submitted jobs no thread took yet
+	std::deque<rx_job*> d_queue;
+	// submitted jobs in order, until they are delivered
+	std::deque<rx_job*> d_order;
+	bool d_delivering;
+	bool d_stop;
+
+	// only used by the thread that delivers
+	equalizer::carrier_stats d_stats;
+
+	void worker(int index);
+	void process(worker_state &w, rx_job &job);
+	void finish(rx_job *job);
+	void update_snr(rx_job &job);
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_RX_ENGINE_H */
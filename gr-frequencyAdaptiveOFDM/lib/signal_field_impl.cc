@@ -46,13 +46,10 @@ int signal_field_impl::get_bit(int b, int i) {
 
 void signal_field_impl::generate_signal_field(char *out, frame_param &frame, ofdm_param &ofdm) {
 	//data bits of the signal header
-	char *signal_header = (char *) malloc(sizeof(char) * 24 * 2);
+	char signal_header[24 * 2];
 
-	//signal header after...
-	//convolutional encoding
-	char *encoded_signal_header = (char *) malloc(sizeof(char) * 48 * 2);
-	//interleaving
-	char *interleaved_signal_header = (char *) malloc(sizeof(char) * 48 * 2);
+	//signal header after convolutional encoding
+	char encoded_signal_header[48 * 2];
 
 	int length = frame.psdu_size;
 
@@ -106,10 +103,6 @@ void signal_field_impl::generate_signal_field(char *out, frame_param &frame, ofd
 	convolutional_encoding(signal_header, encoded_signal_header, signal_param);
 	// interleaving
 	interleave(encoded_signal_header, out, signal_param, signal_ofdm);
-
-	free(signal_header);
-	free(encoded_signal_header);
-	free(interleaved_signal_header);
 }
 
 bool signal_field_impl::header_formatter(long packet_len, unsigned char *out, const std::vector<tag_t> &tags)
@@ -39,9 +39,13 @@ public:
 
 	bool header_parser(const unsigned char *header,
 			std::vector<tag_t> &tags);
+
+	// writes the 96 interleaved bits of the signal field of the frame,
+	// also used by frame_synthesizer
+	static void generate_signal_field(char *out, frame_param &frame, ofdm_param &ofdm);
+
 private:
-	int get_bit(int b, int i);
-	void generate_signal_field(char *out, frame_param &frame, ofdm_param &ofdm);
+	static int get_bit(int b, int i);
 };
 
 } // namespace frequencyAdaptiveOFDM
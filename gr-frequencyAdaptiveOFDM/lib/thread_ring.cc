@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "thread_ring.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+namespace {
+
+// records start at multiples of 8 bytes
+inline uint32_t
+record_bytes(uint32_t size) {
+	return (8 + size + 7) & ~uint32_t(7);
+}
+
+} // namespace
+
+thread_ring::thread_ring(uint32_t size, int thread) :
+	d_data(NULL),
+	d_size(size),
+	d_head(0),
+	d_tail(0),
+	d_next(0),
+	d_dropped(0),
+	d_thread(thread),
+	d_refs(2),
+	d_retired(false) {
+
+	if(size < 64 || (size & (size - 1))) {
+		throw std::invalid_argument("THREAD RING: size has to be a power of two of at least 64");
+	}
+	d_data = new char[size];
+}
+
+thread_ring::~thread_ring() {
+	delete [] d_data;
+}
+
+char*
+thread_ring::reserve(uint32_t size) {
+	uint32_t need = record_bytes(size);
+	uint32_t head = d_head;
+	uint32_t offset = head & (d_size - 1);
+	// a record does not wrap around, the end of the ring is skipped
+	uint32_t skip = d_size - offset < need ? d_size - offset : 0;
+	uint32_t used = head - __atomic_load_n(&d_tail, __ATOMIC_ACQUIRE);
+	if(need > d_size / 2 || used + skip + need > d_size) {
+		__atomic_fetch_add(&d_dropped, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	if(skip) {
+		header pad = {skip, 1};
+		std::memcpy(d_data + offset, &pad, sizeof(pad));
+		offset = 0;
+	}
+	header h = {size, 0};
+	std::memcpy(d_data + offset, &h, sizeof(h));
+	d_next = head + skip + need;
+	return d_data + offset + sizeof(h);
+}
+
+void
+thread_ring::commit() {
+	__atomic_store_n(&d_head, d_next, __ATOMIC_RELEASE);
+}
+
+const char*
+thread_ring::front(uint32_t *size) {
+	uint32_t head = __atomic_load_n(&d_head, __ATOMIC_ACQUIRE);
+	while(d_tail != head) {
+		const char *p = d_data + (d_tail & (d_size - 1));
+		header h;
+		std::memcpy(&h, p, sizeof(h));
+		if(h.skip) {
+			__atomic_store_n(&d_tail, d_tail + h.size, __ATOMIC_RELEASE);
+			continue;
+		}
+		*size = h.size;
+		return p + sizeof(h);
+	}
+	return NULL;
+}
+
+void
+thread_ring::pop() {
+	header h;
+	std::memcpy(&h, d_data + (d_tail & (d_size - 1)), sizeof(h));
+	__atomic_store_n(&d_tail, d_tail + record_bytes(h.size), __ATOMIC_RELEASE);
+}
+
+void
+thread_ring::clear() {
+	__atomic_store_n(&d_tail, __atomic_load_n(&d_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+	__atomic_store_n(&d_dropped, 0, __ATOMIC_RELAXED);
+}
+
+thread_rings::thread_rings(make_fn make) :
+	d_make(make),
+	d_local(&thread_rings::retire),
+	d_threads(0),
+	d_dropped(0) {
+}
+
+thread_rings::~thread_rings() {
+	// the calling thread keeps its ring
+	thread_ring *own = d_local.release();
+	if(own) {
+		release(own);
+	}
+	for(size_t i = 0; i < d_rings.size(); i++) {
+		release(d_rings[i]);
+	}
+}
+
+thread_ring*
+thread_rings::local() {
+	thread_ring *r = d_local.get();
+	if(!r) {
+		{
+			gr::thread::scoped_lock lock(d_mutex);
+			r = d_make(d_threads++);
+			d_rings.push_back(r);
+		}
+		d_local.reset(r);
+	}
+	return r;
+}
+
+void
+thread_rings::visit(visit_fn f) {
+	gr::thread::scoped_lock lock(d_mutex);
+	size_t n = 0;
+	for(size_t i = 0; i < d_rings.size(); i++) {
+		thread_ring *r = d_rings[i];
+		// retired before f, so f saw the last record
+		bool retired = __atomic_load_n(&r->d_retired, __ATOMIC_ACQUIRE);
+		f(*r);
+
+		uint32_t size;
+		if(retired && !r->front(&size)) {
+			d_dropped += r->dropped();
+			release(r);
+		} else {
+			d_rings[n++] = r;
+		}
+	}
+	d_rings.resize(n);
+}
+
+void
+thread_rings::clear() {
+	gr::thread::scoped_lock lock(d_mutex);
+	for(size_t i = 0; i < d_rings.size(); i++) {
+		d_rings[i]->clear();
+	}
+	d_dropped = 0;
+}
+
+uint64_t
+thread_rings::dropped() {
+	gr::thread::scoped_lock lock(d_mutex);
+	uint64_t n = d_dropped;
+	for(size_t i = 0; i < d_rings.size(); i++) {
+		n += d_rings[i]->dropped();
+	}
+	return n;
+}
+
+void
+thread_rings::retire(thread_ring *r) {
+	__atomic_store_n(&r->d_retired, true, __ATOMIC_RELEASE);
+	release(r);
+}
+
+void
+thread_rings::release(thread_ring *r) {
+	if(__sync_sub_and_fetch(&r->d_refs, 1) == 0) {
+		delete r;
+	}
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_THREAD_RING_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_THREAD_RING_H
+
+#include <gnuradio/thread/thread.h>
+#include <boost/function.hpp>
+#include <boost/thread/tss.hpp>
+#include <stdint.h>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Ring of records with one producer thread and one consumer, neither
+ * takes a lock. A record is a block of bytes that does not wrap around
+ * the end of the ring. If there is no room for it, it is dropped and
+ * counted, the producer never waits.
+ */
+class thread_ring
+{
+public:
+	// size in bytes, a power of two. thread numbers the rings of a set.
+	thread_ring(uint32_t size, int thread);
+	virtual ~thread_ring();
+
+	// producer: room for a record of size bytes or NULL if the ring is
+	// full, commit() hands it to the consumer
+	char* reserve(uint32_t size);
+	void commit();
+
+	// consumer: the oldest record and its size or NULL if there is none,
+	// pop() frees it
+	const char* front(uint32_t *size);
+	void pop();
+	// consumer: drops all records and the count of the dropped ones
+	void clear();
+
+	uint64_t dropped() const {
+		return __atomic_load_n(&d_dropped, __ATOMIC_RELAXED);
+	}
+	int thread() const { return d_thread; }
+
+private:
+	friend class thread_rings;
+
+	struct header {
+		uint32_t size;  // bytes of the record
+		uint32_t skip;  // the rest of the ring up to its end is unused
+	};
+
+	char *d_data;
+	uint32_t d_size;
+	uint32_t d_head;  // written by the producer
+	uint32_t d_tail;  // written by the consumer
+	uint32_t d_next;  // head after the reserved record
+	uint64_t d_dropped;
+	int d_thread;
+
+	// the thread and the set each hold a reference
+	int d_refs;
+	bool d_retired;
+};
+
+/* The rings of the threads that write to one consumer, like the logger
+ * or the frame_tracer. local() makes a ring for the calling thread the
+ * first time it is called there. When the thread exits its ring is
+ * retired: visit() hands it to the consumer once more and deletes it
+ * when it is empty.
+ */
+class thread_rings
+{
+public:
+	typedef boost::function<thread_ring* (int thread)> make_fn;
+	typedef boost::function<void (thread_ring &)> visit_fn;
+
+	thread_rings(make_fn make);
+	~thread_rings();
+
+	thread_ring* local();
+
+	// consumer: calls f for every ring, then deletes the retired rings
+	// that are empty
+	void visit(visit_fn f);
+	// consumer: clears every ring
+	void clear();
+	// records dropped by all rings, the deleted ones included
+	uint64_t dropped();
+
+private:
+	static void retire(thread_ring *r);
+	static void release(thread_ring *r);
+
+	make_fn d_make;
+	boost::thread_specific_ptr<thread_ring> d_local;
+
+	// d_mutex protects everything below
+	gr::thread::mutex d_mutex;
+	std::vector<thread_ring*> d_rings;
+	int d_threads;
+	uint64_t d_dropped;  // by rings that were deleted
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_THREAD_RING_H */
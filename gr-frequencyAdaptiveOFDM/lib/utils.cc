@@ -16,7 +16,10 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "utils.h"
+#include "crc32.h"
 
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <math.h>
@@ -142,24 +145,24 @@ ofdm_param::toFileFormat() {
 }
 
 void
-ofdm_param::print() {
-	std::cout << std::endl;
-	std::cout << "OFDM Symbol Parameters:" << std::endl;
-	std::cout << "n_bpsc: " << n_bpsc << std::endl;
-	std::cout << "n_cbps: " << n_cbps << std::endl;
-	std::cout << "n_dbps: " << n_dbps << std::endl;
-	print_encoding();
-	print_timestamp();
-	std::cout << std::endl;
+ofdm_param::print(std::ostream &out) {
+	out << std::endl;
+	out << "OFDM Symbol Parameters:" << std::endl;
+	out << "n_bpsc: " << n_bpsc << std::endl;
+	out << "n_cbps: " << n_cbps << std::endl;
+	out << "n_dbps: " << n_dbps << std::endl;
+	print_encoding(out);
+	print_timestamp(out);
+	out << std::endl;
 }
 
 void
-ofdm_param::print_timestamp(){
-	  std::cout << "Timestamp: " << timestamp/1000000 << " s " << timestamp%1000000 << " us.\n";
+ofdm_param::print_timestamp(std::ostream &out){
+	  out << "Timestamp: " << timestamp/1000000 << " s " << timestamp%1000000 << " us.\n";
 }
 
 void
-ofdm_param::print_encoding() {
+ofdm_param::print_encoding(std::ostream &out) {
 	std::string enc = "";
 	std::string punct_str = "";
 
@@ -181,7 +184,7 @@ ofdm_param::print_encoding() {
 			enc = "Unknown modulation.";
 			break;
 		}
-		std::cout << "Encoding Resource Block " << i << ": " << enc << " (" << n_bpcrb[i] << " bpcrb)\n";
+		out << "Encoding Resource Block " << i << ": " << enc << " (" << n_bpcrb[i] << " bpcrb)\n";
 	}
 	switch (punct){
 	case P_1_2:
@@ -197,8 +200,8 @@ ofdm_param::print_encoding() {
 		punct_str = "Unknown puncturing.";
 		break;
 	}
-	std::cout << "Frame Puncturing: " << punct_str << std::endl;
-	std::cout << std::endl;
+	out << "Frame Puncturing: " << punct_str << std::endl;
+	out << std::endl;
 }
 
 frame_param::frame_param(ofdm_param &ofdm, int psdu_length) {
@@ -226,14 +229,14 @@ frame_param::to_header_param() {
 }
 
 void
-frame_param::print() {
-	std::cout << std::endl;
-	std::cout << "FRAME Parameters:" << std::endl;
-	std::cout << "psdu_size (bytes): " << psdu_size << std::endl;
-	std::cout << "n_sym: " << n_sym << std::endl;
-	std::cout << "n_pad: " << n_pad << std::endl;
-	std::cout << "n_encoded_bits: " << n_encoded_bits << std::endl;
-	std::cout << "n_data_bits: " << n_data_bits << std::endl << std::endl;
+frame_param::print(std::ostream &out) {
+	out << std::endl;
+	out << "FRAME Parameters:" << std::endl;
+	out << "psdu_size (bytes): " << psdu_size << std::endl;
+	out << "n_sym: " << n_sym << std::endl;
+	out << "n_pad: " << n_pad << std::endl;
+	out << "n_encoded_bits: " << n_encoded_bits << std::endl;
+	out << "n_data_bits: " << n_data_bits << std::endl << std::endl;
 }
 
 void scramble(const char *in, char *out, frame_param &frame, char initial_state) {
@@ -301,25 +304,70 @@ void puncturing(const char *in, char *out, frame_param &frame, ofdm_param &ofdm)
 	}
 }
 
-void interleave(const char *in, char *out, frame_param &frame, ofdm_param &ofdm, bool reverse) {
-	int n_cbps = ofdm.n_cbps;
-	int first[n_cbps];
-	int second[n_cbps];
-	int s = floor(std::max(int(ofdm.n_bpsc) / 2, 1));
+namespace {
+
+// Permutations for all multiples of 12 coded bits per symbol (each
+// resource block has 12 carriers) and every column count s of the
+// first permutation, i.e. for all ofdm_param combinations.
+struct interleaver_cache {
+	interleaver_permutation permutations[MAX_CBPS / 12 + 1][3];
+
+	interleaver_cache();
+};
+
+interleaver_cache::interleaver_cache() {
+	for(int n_cbps = 12; n_cbps <= MAX_CBPS; n_cbps += 12) {
+		for(int s = 1; s <= 3; s++) {
+			interleaver_permutation &p = permutations[n_cbps / 12][s - 1];
+			int first[MAX_CBPS];
+			int second[MAX_CBPS];
 
-	for(int j = 0; j < n_cbps; j++) {
-		first[j] = s * (j / s) + ((j + int(floor(12.0 * j / n_cbps))) % s);
+			for(int j = 0; j < n_cbps; j++) {
+				first[j] = s * (j / s) + ((j + int(floor(12.0 * j / n_cbps))) % s);
+			}
+			for(int i = 0; i < n_cbps; i++) {
+				second[i] = 12 * i - (n_cbps - 1) * int(floor(12.0 * i / n_cbps));
+			}
+
+			std::fill(p.reverse, p.reverse + MAX_CBPS, -1);
+			for(int k = 0; k < n_cbps; k++) {
+				p.forward[k] = second[first[k]];
+				// the last write wins like in the scatter this replaces
+				p.reverse[second[first[k]]] = k;
+			}
+		}
 	}
-	for(int i = 0; i < n_cbps; i++) {
-		second[i] = 12 * i - (n_cbps - 1) * int(floor(12.0 * i / n_cbps));
+}
+
+const interleaver_cache interleavers;
+
+} // namespace
+
+const interleaver_permutation&
+get_interleaver_permutation(int n_cbps, float n_bpsc) {
+	int s = std::max(int(n_bpsc) / 2, 1);
+	if(n_cbps <= 0 || n_cbps > MAX_CBPS || n_cbps % 12 || s > 3) {
+		throw std::invalid_argument("INTERLEAVE: wrong number of coded bits per symbol");
 	}
+	return interleavers.permutations[n_cbps / 12][s - 1];
+}
+
+void interleave(const char *in, char *out, frame_param &frame, ofdm_param &ofdm, bool reverse) {
+	int n_cbps = ofdm.n_cbps;
+	const interleaver_permutation &p = get_interleaver_permutation(n_cbps, ofdm.n_bpsc);
 
 	for(int i = 0; i < frame.n_sym; i++) {
-		for(int k = 0; k < n_cbps; k++) {
-			if(reverse) {
-				out[i * n_cbps + second[first[k]]] = in[i * n_cbps + k];
-			} else {
-				out[i * n_cbps + k] = in[i * n_cbps + second[first[k]]];
+		const char *sym_in = in + i * n_cbps;
+		char *sym_out = out + i * n_cbps;
+		if(reverse) {
+			for(int j = 0; j < n_cbps; j++) {
+				if(p.reverse[j] >= 0) {
+					sym_out[j] = sym_in[p.reverse[j]];
+				}
+			}
+		} else {
+			for(int k = 0; k < n_cbps; k++) {
+				sym_out[k] = sym_in[p.forward[k]];
 			}
 		}
 	}
@@ -358,14 +406,454 @@ void generate_bits(const char *psdu, char *data_bits, frame_param &frame) {
 	}
 }
 
+namespace {
+
+// lookup tables of the packed bit functions, filled when the library
+// is loaded
+struct packed_tables {
+	// scrambler sequence starting at state 1, the 127 bit period is
+	// repeated so that 64 bits can be read from any position in the first
+	// period
+	uint64_t scrambler_seq[4];
+	// position of each scrambler state in the sequence
+	int scrambler_pos[128];
+
+	// The encoder is linear, the 16 output bits of one input byte are the
+	// ones of the byte from state zero xor the ones of the previous state
+	// followed by zeros. The next state only depends on the byte.
+	uint16_t conv_byte[256];
+	uint16_t conv_state[64];
+	uint8_t conv_next[256];
+
+	// kept bits of an input byte, compacted, for each puncturing and
+	// position of the byte in the puncturing pattern
+	uint8_t punct_bits[3][6][256];
+	int punct_count[3][6];
+
+	packed_tables();
+};
+
+packed_tables::packed_tables() {
+	std::memset(this, 0, sizeof(*this));
+
+	int state = 1;
+	for(int i = 0; i < 256; i++) {
+		int feedback = (!!(state & 64)) ^ (!!(state & 8));
+		if(i < 127) {
+			scrambler_pos[state] = i;
+		}
+		state = ((state << 1) & 0x7e) | feedback;
+		if(feedback) {
+			scrambler_seq[i / 64] |= (uint64_t) 1 << (i % 64);
+		}
+	}
+
+	for(int b = 0; b < 256; b++) {
+		int reg = 0;
+		for(int i = 0; i < 8; i++) {
+			reg = ((reg << 1) & 0x7e) | ((b >> i) & 1);
+			conv_byte[b] |= (ones(reg & 0155) % 2) << (2 * i);
+			conv_byte[b] |= (ones(reg & 0117) % 2) << (2 * i + 1);
+		}
+		conv_next[b] = reg & 0x3f;
+	}
+	for(int s = 0; s < 64; s++) {
+		int reg = s;
+		for(int i = 0; i < 8; i++) {
+			reg = (reg << 1) & 0x7e;
+			conv_state[s] |= (ones(reg & 0155) % 2) << (2 * i);
+			conv_state[s] |= (ones(reg & 0117) % 2) << (2 * i + 1);
+		}
+	}
+
+	for(int p = P_3_4; p <= P_2_3; p++) {
+		int period = p == P_3_4 ? 6 : 4;
+		for(int phase = 0; phase < period; phase++) {
+			int mask = 0;
+			for(int i = 0; i < 8; i++) {
+				int mod = (phase + i) % period;
+				if(p == P_3_4 ? !(mod == 3 || mod == 4) : mod != 3) {
+					mask |= 1 << i;
+				}
+			}
+			punct_count[p][phase] = ones(mask);
+			for(int b = 0; b < 256; b++) {
+				int n = 0;
+				for(int i = 0; i < 8; i++) {
+					if(mask & (1 << i)) {
+						punct_bits[p][phase][b] |= ((b >> i) & 1) << n;
+						n++;
+					}
+				}
+			}
+		}
+	}
+}
+
+const packed_tables tables;
+
+inline int
+packed_byte(const uint64_t *bits, int k) {
+	return (bits[k / 8] >> (8 * (k % 8))) & 0xff;
+}
+
+// 64 bits of the scrambler sequence from position pos
+inline uint64_t
+scrambler_key(int pos) {
+	const uint64_t *seq = tables.scrambler_seq + pos / 64;
+	uint64_t key = seq[0] >> (pos % 64);
+	if(pos % 64) {
+		key |= seq[1] << (64 - pos % 64);
+	}
+	return key;
+}
+
+// zero the bits after the end of the stream in its last word
+inline void
+clear_tail(uint64_t *bits, int n_bits) {
+	if(n_bits % 64) {
+		bits[n_bits / 64] &= ((uint64_t) 1 << (n_bits % 64)) - 1;
+	}
+}
+
+} // namespace
+
+void pack_bits(const char *in, uint64_t *out, int n_bits) {
+	std::memset(out, 0, PACKED_WORDS(n_bits) * sizeof(uint64_t));
+	for(int i = 0; i < n_bits; i++) {
+		out[i / 64] |= (uint64_t) (in[i] & 1) << (i % 64);
+	}
+}
+
+void unpack_bits(const uint64_t *in, char *out, int n_bits) {
+	for(int i = 0; i < n_bits; i++) {
+		out[i] = (in[i / 64] >> (i % 64)) & 1;
+	}
+}
+
+void generate_bits_packed(const char *psdu, uint64_t *data_bits, frame_param &frame) {
+	// first 16 bits are zero (SERVICE/DATA field), the bytes are sent
+	// LSB first, so they do not have to be split
+	std::memset(data_bits, 0, PACKED_WORDS(frame.n_data_bits) * sizeof(uint64_t));
+	for(int i = 0; i < frame.psdu_size; i++) {
+		int pos = 16 + 8 * i;
+		data_bits[pos / 64] |= (uint64_t) (uint8_t) psdu[i] << (pos % 64);
+	}
+}
+
+void scramble_packed(const uint64_t *in, uint64_t *out, frame_param &frame, char initial_state) {
+	int n_words = PACKED_WORDS(frame.n_data_bits);
+	int state = initial_state & 0x7f;
+
+	// state zero never feeds back a one
+	if(!state) {
+		std::memcpy(out, in, n_words * sizeof(uint64_t));
+		clear_tail(out, frame.n_data_bits);
+		return;
+	}
+
+	int pos = tables.scrambler_pos[state];
+	for(int w = 0; w < n_words; w++) {
+		out[w] = in[w] ^ scrambler_key(pos);
+		pos = (pos + 64) % 127;
+	}
+	clear_tail(out, frame.n_data_bits);
+}
+
+void reset_tail_bits_packed(uint64_t *scrambled_data, frame_param &frame) {
+	int start = frame.n_data_bits - frame.n_pad - 6;
+	for(int i = start; i < start + 6; i++) {
+		scrambled_data[i / 64] &= ~((uint64_t) 1 << (i % 64));
+	}
+}
+
+void convolutional_encoding_packed(const uint64_t *in, uint64_t *out, frame_param &frame) {
+	int n_bytes = (frame.n_data_bits + 7) / 8;
+	int state = 0;
+
+	std::memset(out, 0, PACKED_WORDS(2 * frame.n_data_bits) * sizeof(uint64_t));
+	for(int k = 0; k < n_bytes; k++) {
+		int b = packed_byte(in, k);
+		out[k / 4] |= (uint64_t) (tables.conv_byte[b] ^ tables.conv_state[state]) << (16 * (k % 4));
+		state = tables.conv_next[b];
+	}
+	clear_tail(out, 2 * frame.n_data_bits);
+}
+
+void puncturing_packed(const uint64_t *in, uint64_t *out, frame_param &frame, ofdm_param &ofdm) {
+	int n_words = PACKED_WORDS(frame.n_encoded_bits);
+	int period;
+
+	switch(ofdm.punct) {
+		case P_1_2:
+			std::memcpy(out, in, n_words * sizeof(uint64_t));
+			return;
+		case P_3_4:
+			period = 6;
+			break;
+		case P_2_3:
+			period = 4;
+			break;
+		default:
+			throw std::invalid_argument("PUNCTURING: wrong modulation");
+			break;
+	}
+
+	// append the kept bits of each input byte
+	int n_bytes = (2 * frame.n_data_bits + 7) / 8;
+	uint64_t acc = 0;
+	int acc_bits = 0;
+	int w = 0;
+	for(int k = 0; k < n_bytes; k++) {
+		int phase = (8 * k) % period;
+		uint64_t bits = tables.punct_bits[ofdm.punct][phase][packed_byte(in, k)];
+		int count = tables.punct_count[ofdm.punct][phase];
+
+		acc |= bits << acc_bits;
+		acc_bits += count;
+		if(acc_bits >= 64) {
+			out[w++] = acc;
+			acc_bits -= 64;
+			acc = acc_bits ? bits >> (count - acc_bits) : 0;
+		}
+	}
+	if(acc_bits && w < n_words) {
+		out[w] = acc;
+	}
+	clear_tail(out, frame.n_encoded_bits);
+}
+
+void interleave_packed(const uint64_t *in, char *out, frame_param &frame, ofdm_param &ofdm) {
+	int n_cbps = ofdm.n_cbps;
+	const interleaver_permutation &p = get_interleaver_permutation(n_cbps, ofdm.n_bpsc);
+
+	for(int i = 0; i < frame.n_sym; i++) {
+		for(int k = 0; k < n_cbps; k++) {
+			int pos = i * n_cbps + p.forward[k];
+			out[i * n_cbps + k] = (in[pos / 64] >> (pos % 64)) & 1;
+		}
+	}
+}
+
+uint32_t descramble_crc(const uint8_t *decoded_bits, uint8_t *out_bytes, frame_param &frame) {
+	int n_bytes = frame.psdu_size + 2;
+
+	// the SERVICE field starts with 7 zeros, so the first 7 bits are the
+	// scrambler state and the sequence continues from there
+	int state = 0;
+	for(int i = 0; i < 7; i++) {
+		state |= (decoded_bits[i] & 1) << (6 - i);
+	}
+	int pos = (tables.scrambler_pos[state] + 127 - 7) % 127;
+
+	// With PCLMULQDQ one pass over the bytes is faster than slicing-by-8
+	// on the words, otherwise the CRC takes the 8 bytes from byte 2 on
+	// straight from the last two words.
+	bool fused = !crc32_has_pclmul();
+	uint32_t crc = 0xffffffff;
+	int crc_bytes = 2;
+	uint64_t last = 0;
+
+	for(int w = 0; w * 8 < n_bytes; w++) {
+		int n = std::min(8, n_bytes - w * 8);
+
+		// packs 8 bits of one byte each with one multiplication, the
+		// decoded bits are in bit 0 (little endian loads)
+		uint64_t word = 0;
+		for(int b = 0; b < n; b++) {
+			uint64_t bits;
+			std::memcpy(&bits, decoded_bits + 64 * w + 8 * b, 8);
+			bits &= 0x0101010101010101ULL;
+			word |= ((bits * 0x0102040810204080ULL) >> 56) << (8 * b);
+		}
+		if(state) {
+			word ^= scrambler_key(pos);
+			pos = (pos + 64) % 127;
+		}
+		if(w == 0) {
+			word = (word & ~(uint64_t) 0x7f) | state;
+		}
+
+		for(int b = 0; b < n; b++) {
+			out_bytes[8 * w + b] = word >> (8 * b);
+		}
+
+		if(fused && w > 0 && 8 * w + 2 <= n_bytes) {
+			crc = crc32_word(crc, (last >> 16) | (word << 48));
+			crc_bytes += 8;
+		}
+		last = word;
+	}
+
+	return ~crc32_update(crc, out_bytes + crc_bytes, n_bytes - crc_bytes);
+}
+
+static void
+build_rx_gather_table(ofdm_param &ofdm, rx_gather_table &table) {
+	int n_cbps = ofdm.n_cbps;
+	const interleaver_permutation &p = get_interleaver_permutation(n_cbps, ofdm.n_bpsc);
+
+	// position of the regrouped bits in the equalizer output
+	int regrouped[MAX_CBPS];
+	int r = 0;
+	for(int c = 0; c < 48; c++) {
+		int bpsc = ofdm.n_bpcrb[ofdm.rb_index_from_symbols(c)];
+		for(int k = 0; k < bpsc; k++) {
+			regrouped[r++] = c * MAX_BITS_PER_CARRIER + k;
+		}
+	}
+
+	static const unsigned char PUNCTURE_1_2[2] = {1, 1};
+	static const unsigned char PUNCTURE_2_3[4] = {1, 1, 1, 0};
+	static const unsigned char PUNCTURE_3_4[6] = {1, 1, 1, 0, 0, 1};
+
+	const unsigned char *pattern;
+	int period;
+	switch(ofdm.punct) {
+		case P_1_2:
+			pattern = PUNCTURE_1_2;
+			period = 2;
+			break;
+		case P_3_4:
+			pattern = PUNCTURE_3_4;
+			period = 6;
+			break;
+		case P_2_3:
+			pattern = PUNCTURE_2_3;
+			period = 4;
+			break;
+		default:
+			throw std::invalid_argument("RX_GATHER: wrong puncturing");
+	}
+
+	table.n_depunctured = 2 * ofdm.n_dbps;
+	int kept = 0;
+	for(int i = 0; i < table.n_depunctured; i++) {
+		kept += pattern[i % period];
+	}
+	if(kept != n_cbps) {
+		throw std::invalid_argument("RX_GATHER: puncturing does not fit the encoding");
+	}
+
+	int j = 0;
+	for(int i = 0; i < table.n_depunctured; i++) {
+		if(!pattern[i % period]) {
+			table.source[i] = RX_PUNCTURED;
+		} else if(p.reverse[j] < 0) {
+			table.source[i] = RX_SKIPPED;
+			j++;
+		} else {
+			table.source[i] = regrouped[p.reverse[j]];
+			j++;
+		}
+	}
+}
+
+namespace {
+
+boost::mutex rx_gather_mutex;
+// indexed by the encodings of the four resource blocks and the puncturing
+rx_gather_table *rx_gather_tables[256 * 3];
+
+} // namespace
+
+const rx_gather_table&
+get_rx_gather_table(ofdm_param &ofdm) {
+	int encoding = 0;
+	for(int i = 0; i < 4; i++) {
+		encoding |= ofdm.resource_blocks_e[i] << (2 * i);
+	}
+	int index = encoding * 3 + ofdm.punct;
+
+	boost::mutex::scoped_lock lock(rx_gather_mutex);
+	if(!rx_gather_tables[index]) {
+		rx_gather_table *table = new rx_gather_table;
+		build_rx_gather_table(ofdm, *table);
+		rx_gather_tables[index] = table;
+	}
+	return *rx_gather_tables[index];
+}
+
+void rx_gather_hard(const uint8_t *symbols, uint8_t *depunctured, frame_param &frame,
+		const rx_gather_table &table) {
+	for(int s = 0; s < frame.n_sym; s++) {
+		for(int i = 0; i < table.n_depunctured; i++) {
+			int src = table.source[i];
+			if(src >= 0) {
+				int c = src / MAX_BITS_PER_CARRIER;
+				*depunctured++ = (symbols[c] >> (src - c * MAX_BITS_PER_CARRIER)) & 1;
+			} else {
+				*depunctured++ = src == RX_PUNCTURED ? 2 : 0;
+			}
+		}
+		symbols += 48;
+	}
+}
+
+void rx_gather_soft(const int8_t *llr, uint8_t *depunctured, frame_param &frame,
+		const rx_gather_table &table) {
+	for(int s = 0; s < frame.n_sym; s++) {
+		for(int i = 0; i < table.n_depunctured; i++) {
+			int src = table.source[i];
+			*depunctured++ = src >= 0 ? llr[src] : 0;
+		}
+		llr += SOFT_SYMBOL_SIZE;
+	}
+}
+
+bool
+cpu_supports(cpu_feature feature) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	switch(feature) {
+	case CPU_SSE2:
+		return __builtin_cpu_supports("sse2");
+	case CPU_AVX2:
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	case CPU_AVX512BW:
+#ifdef FREQUENCYADAPTIVEOFDM_AVX512BW
+		return __builtin_cpu_supports("avx512bw");
+#else
+		return false;
+#endif
+	case CPU_PCLMUL:
+#ifdef FREQUENCYADAPTIVEOFDM_PCLMUL
+		return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#else
+		return false;
+#endif
+	}
+#endif
+	return false;
+}
+
+namespace {
+
+const bool map_symbols_avx2_supported = cpu_supports(CPU_AVX2);
+
+} // namespace
+
+void map_symbols(const uint8_t *symbols, gr_complex *out, int n, const gr_complex *lut) {
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	if(map_symbols_avx2_supported) {
+		map_symbols_avx2(symbols, (float *) out, n, (const float *) lut);
+		return;
+	}
+#endif
+	for(int i = 0; i < n; i++) {
+		out[i] = lut[64 * ((i % 48) / 12) + (symbols[i] & 63)];
+	}
+}
+
 void
 print_bytes(std::string tag, char bytes[], int size)
 {
-    std::cout << tag << std::endl;
-    for(int i = 0; i < size; i++)
-    {
-    	std::cout << std::setw(2) << std::setfill('0') << int(bytes[i]);
-        std::cout << " ";
- 	}
-    std::cout << std::endl << std::endl;
+	if(LOG_ENABLED(TRACE)) {
+		using gr::frequencyAdaptiveOFDM::logger;
+		logger::instance().bytes(logger::L_TRACE, tag, bytes, size);
+	}
 }
@@ -20,17 +20,36 @@
 
 #include <frequencyAdaptiveOFDM/api.h>
 #include <frequencyAdaptiveOFDM/mapper.h>
+#include "logger.h"
+#include "map_symbols.h"
 #include <gnuradio/config.h>
+#include <gnuradio/gr_complex.h>
 #include <iostream>
+#include <stdint.h>
 #include <sys/time.h>
 
 #define MAX_PAYLOAD_SIZE 1500
 #define MAX_PSDU_SIZE (MAX_PAYLOAD_SIZE + 28) // MAC, CRC
 #define MAX_SYM (((16 + 8 * MAX_PSDU_SIZE + 6) / 24) + 1)
 #define MAX_ENCODED_BITS ((16 + 8 * MAX_PSDU_SIZE + 6) * 2 + 288)
+// soft decision items carry one LLR per coded bit of the 48 data carriers
+#define MAX_BITS_PER_CARRIER 6
+#define SOFT_SYMBOL_SIZE (48 * MAX_BITS_PER_CARRIER)
+#define SOFT_SCALE 16
+// coded bits of an OFDM symbol with 64QAM in all resource blocks
+#define MAX_CBPS (48 * MAX_BITS_PER_CARRIER)
+// data bits of an OFDM symbol with 64QAM 3/4 in all resource blocks
+#define MAX_DBPS 216
+// depunctured bits of the longest frame, every rate pads up to one symbol
+#define MAX_DEPUNCTURED_BITS (2 * (16 + 8 * MAX_PSDU_SIZE + 6 + MAX_DBPS))
+// packed bits, bit i of a stream is bit i % 64 of word i / 64
+#define PACKED_WORDS(n_bits) (((n_bits) + 63) / 64)
+#define MAX_PACKED_WORDS PACKED_WORDS(MAX_ENCODED_BITS)
 
-#define dout d_debug && std::cout
-#define mylog(msg) do { if(d_log) { GR_LOG_INFO(d_logger, msg); }} while(0);
+// messages go to the logger, see logger.h for the levels compiled in
+#define dout LOG_ENABLED(DEBUG) && d_debug && LOG_STREAM(DEBUG)
+#define dlog (LOG_ENABLED(TRACE) && d_log)
+#define mylog(msg) do { if(LOG_ENABLED(INFO) && d_log) { LOG_STREAM(INFO) << msg << std::endl; }} while(0);
 
 
 struct mac_header {
@@ -49,6 +68,18 @@ struct mac_ack_header {
 	uint8_t ra[6];
 }__attribute__((packed));
 
+// Block ACK, a Block ACK Request ends before the bitmap
+struct mac_block_ack_header {
+	uint16_t frame_control;
+	uint16_t duration;
+	uint8_t ra[6];
+	uint8_t ta[6];
+	uint16_t control;
+	// starting sequence number, like seq_nr
+	uint16_t ssn;
+	uint64_t bitmap;
+}__attribute__((packed));
+
 
 /**
  * WIFI parameters
@@ -93,9 +124,9 @@ public:
 	int rb_index_from_symbols(int n_symb);
 
 	std::string toFileFormat();
-	void print();
-	void print_timestamp();
-	void print_encoding();
+	void print(std::ostream &out = std::cout);
+	void print_timestamp(std::ostream &out = std::cout);
+	void print_encoding(std::ostream &out = std::cout);
 };
 
 /**
@@ -115,7 +146,7 @@ public:
 	// number of data bits, including service and padding (17-12)
 	int n_data_bits;
 
-	void print();
+	void print(std::ostream &out = std::cout);
 };
 
 /**
@@ -140,12 +171,112 @@ void convolutional_encoding(const char *input, char *out, frame_param &frame);
 
 void puncturing(const char *input, char *out, frame_param &frame, ofdm_param &ofdm);
 
+/**
+ * Interleaver permutation of one OFDM symbol size. forward[k] is the
+ * position of the k-th interleaved bit in the symbol, reverse[j] the
+ * interleaved position of bit j or -1 if the interleaver skips it (it is
+ * not one to one for every mix of modulations). The permutations of all
+ * sizes are built once when the library is loaded.
+ */
+struct interleaver_permutation {
+	int16_t forward[MAX_CBPS];
+	int16_t reverse[MAX_CBPS];
+};
+
+const interleaver_permutation& get_interleaver_permutation(int n_cbps, float n_bpsc);
+
 void interleave(const char *input, char *out, frame_param &frame, ofdm_param &ofdm, bool reverse = false);
 
 void split_symbols(const char *input, char *out, frame_param &frame, ofdm_param &ofdm);
 
+/**
+ * Gather table from the demodulated bits of one OFDM symbol straight to
+ * the depunctured input of the Viterbi decoder, i.e. regrouping,
+ * deinterleaving and depuncturing in one pass. source[i] is the position
+ * carrier * MAX_BITS_PER_CARRIER + bit of depunctured bit i,
+ * RX_PUNCTURED for punctured bits and RX_SKIPPED for bits the reverse
+ * interleaver does not hit. The puncturing pattern starts over with
+ * every symbol, so one symbol describes the whole frame.
+ */
+#define RX_PUNCTURED -1
+#define RX_SKIPPED -2
+
+struct rx_gather_table {
+	// depunctured bits per OFDM symbol, 2 * n_dbps
+	int n_depunctured;
+	int16_t source[2 * MAX_DBPS];
+};
+
+// table of an encoding and puncturing, built on first use and shared
+const rx_gather_table& get_rx_gather_table(ofdm_param &ofdm);
+
+// Hard bits, one byte per carrier with bit k of the carrier in bit k.
+// Punctured bits become erasures (2). Skipped bits become 0, the hard
+// decoder cannot take a pair of erasures.
+void rx_gather_hard(const uint8_t *symbols, uint8_t *depunctured, frame_param &frame,
+		const rx_gather_table &table);
+
+// LLRs, SOFT_SYMBOL_SIZE per OFDM symbol. Punctured and skipped bits
+// become erasures (0).
+void rx_gather_soft(const int8_t *llr, uint8_t *depunctured, frame_param &frame,
+		const rx_gather_table &table);
+
 void generate_bits(const char *psdu, char *data_bits, frame_param &frame);
 
+/**
+ * Packed bit versions of the steps above. They work on 64 bit words and
+ * give exactly the same bits. Bits past the end of a stream are zero.
+ */
+void pack_bits(const char *input, uint64_t *out, int n_bits);
+
+void unpack_bits(const uint64_t *input, char *out, int n_bits);
+
+void generate_bits_packed(const char *psdu, uint64_t *data_bits, frame_param &frame);
+
+void scramble_packed(const uint64_t *input, uint64_t *out, frame_param &frame, char initial_state);
+
+void reset_tail_bits_packed(uint64_t *scrambled_data, frame_param &frame);
+
+void convolutional_encoding_packed(const uint64_t *input, uint64_t *out, frame_param &frame);
+
+void puncturing_packed(const uint64_t *input, uint64_t *out, frame_param &frame, ofdm_param &ofdm);
+
+// interleaves and unpacks, one bit per char like interleave()
+void interleave_packed(const uint64_t *input, char *out, frame_param &frame, ofdm_param &ofdm);
+
+/**
+ * Descrambles the decoded bits of a frame, one bit per byte, 64 at a time
+ * and computes the CRC-32 of the PSDU on the way. out_bytes is the same as
+ * with the bit wise descrambler, the SERVICE field in the first two bytes
+ * (the scrambler state in the first 7 bits) and the PSDU behind it.
+ * Returns the CRC of the PSDU including the FCS, CRC32_RESIDUE if it is
+ * right.
+ */
+uint32_t descramble_crc(const uint8_t *decoded_bits, uint8_t *out_bytes, frame_param &frame);
+
+/**
+ * Instruction sets of the x86 kernels. cpu_supports() is true if the
+ * kernels for it are built and the CPU has the instructions.
+ */
+enum cpu_feature {
+	CPU_SSE2,
+	CPU_AVX2,
+	CPU_AVX512BW,
+	CPU_PCLMUL   // with SSE4.1
+};
+
+bool cpu_supports(cpu_feature feature);
+
+/**
+ * Maps the symbols of a frame, one byte per carrier, to constellation
+ * points. lut holds 64 points for each resource block, the point of
+ * symbol v on carrier k of an OFDM symbol is lut[64 * (k / 12) + (v & 63)].
+ * On x86 the points are gathered four at a time with AVX2 if the CPU
+ * supports it.
+ */
+void map_symbols(const uint8_t *symbols, gr_complex *out, int n, const gr_complex *lut);
+
+// hands the bytes to the logger at trace level, it formats them
 void print_bytes(std::string tag, char bytes[], int size);
 
 #endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_UTILS_H */
@@ -16,20 +16,155 @@
  */
 
 #include "base.h"
+#include "kernels.h"
+#include "window_pool.h"
+#include <boost/bind.hpp>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 
 using namespace gr::frequencyAdaptiveOFDM;
 
 base::base() :
-	d_store_pos(0) {
+	d_isa(ISA_GENERIC),
+	d_store_pos(0),
+	d_n_windows(1),
+	d_overlap(96),
+	d_pool(NULL) {
 }
 
 base::~base() {
+	set_windows(1, d_overlap);
 }
 
 uint8_t*
-base::depuncture(uint8_t *in) {
+base::decode_depunctured(ofdm_param *ofdm, frame_param *frame, uint8_t *depunctured) {
+	d_ofdm = ofdm;
+	d_frame = frame;
+	reset();
+	if(use_windows()) {
+		return decode_windows(depunctured);
+	}
+	run_trellis(depunctured);
+	return d_decoded;
+}
+
+void
+base::set_windows(int n_windows, int overlap) {
+	if(n_windows < 1 || overlap < 0) {
+		throw std::invalid_argument("VITERBI: wrong number of windows or overlap");
+	}
+
+	delete d_pool;
+	d_pool = NULL;
+	for(unsigned int i = 0; i < d_window_decoders.size(); i++) {
+		delete d_window_decoders[i];
+	}
+	d_window_decoders.clear();
+	d_n_windows = 1;
+	d_overlap = overlap;
+
+	if(n_windows == 1) {
+		return;
+	}
+
+	for(int i = 0; i < n_windows; i++) {
+		base *decoder = clone();
+		if(!decoder) {
+			set_windows(1, overlap);
+			return;
+		}
+		d_window_decoders.push_back(decoder);
+	}
+
+	ofdm_param ofdm(std::vector<int>(4, BPSK), P_1_2);
+	d_window_frames.assign(n_windows, frame_param(ofdm, 0));
+
+	// the calling thread decodes one of the windows
+	d_pool = new window_pool(n_windows - 1);
+	d_n_windows = n_windows;
+}
+
+bool
+base::use_windows() const {
+	// the windows have to be longer than their warm-up and traceback
+	return d_n_windows > 1 &&
+		d_frame->n_data_bits / d_n_windows > d_overlap + 8 * d_ntraceback;
+}
+
+uint8_t*
+base::decode_windows(uint8_t *depunctured) {
+	int n_data_bits = d_frame->n_data_bits;
+
+	// full output bytes per window
+	int length = ((n_data_bits + d_n_windows - 1) / d_n_windows + 7) / 8 * 8;
+
+	std::vector<boost::function<void ()> > tasks;
+	for(int w = 0; w < d_n_windows && w * length < n_data_bits; w++) {
+		tasks.push_back(boost::bind(&base::decode_window, this, w, depunctured,
+				w * length, std::min(n_data_bits, (w + 1) * length)));
+	}
+	d_pool->run(tasks);
+
+	return d_decoded;
+}
+
+void
+base::decode_window(int w, uint8_t *depunctured, int start, int end) {
+	base *decoder = d_window_decoders[w];
+	frame_param &frame = d_window_frames[w];
+
+	// start overlap bits early, the metrics of all states start equal
+	int warm_up_start = std::max(0, start - d_overlap);
+	frame = *d_frame;
+	frame.n_data_bits = end - warm_up_start;
+
+	decoder->d_ofdm = d_ofdm;
+	decoder->d_frame = &frame;
+	decoder->reset();
+	decoder->run_trellis(depunctured + 2 * warm_up_start);
+
+	std::memcpy(d_decoded + start, decoder->d_decoded + start - warm_up_start, end - start);
+}
+
+bool
+base::cpu_supports(isa_t isa) {
+	switch(isa) {
+	case ISA_GENERIC:
+		return true;
+	case ISA_SSE2:
+		return ::cpu_supports(CPU_SSE2);
+	case ISA_AVX2:
+		return ::cpu_supports(CPU_AVX2);
+	case ISA_AVX512BW:
+		return ::cpu_supports(CPU_AVX512BW);
+	}
+	return false;
+}
+
+const char*
+base::isa_name(isa_t isa) {
+	switch(isa) {
+	case ISA_GENERIC:
+		return "generic";
+	case ISA_SSE2:
+		return "sse2";
+	case ISA_AVX2:
+		return "avx2";
+	case ISA_AVX512BW:
+		return "avx512bw";
+	}
+	return "unknown";
+}
+
+unsigned char
+base::traceback(int beststate) {
+	return viterbi_traceback(d_ppresult, d_store_pos, d_ntraceback, beststate);
+}
+
+uint8_t*
+base::depuncture(uint8_t *in, uint8_t erasure) {
 	int count;
 	int n_cbps = d_ofdm->n_cbps;
 	uint8_t *depunctured;
@@ -43,7 +178,7 @@ base::depuncture(uint8_t *in) {
 		for(int i = 0; i < d_frame->n_sym; i++) {
 			for(int k = 0; k < n_cbps; k++) {
 				while (d_depuncture_pattern[count % (2 * d_k)] == 0) {
-					depunctured[count] = 2;
+					depunctured[count] = erasure;
 					count++;
 				}
 
@@ -52,7 +187,7 @@ base::depuncture(uint8_t *in) {
 				count++;
 
 				while (d_depuncture_pattern[count % (2 * d_k)] == 0) {
-					depunctured[count] = 2;
+					depunctured[count] = erasure;
 					count++;
 				}
 			}
@@ -18,6 +18,7 @@
 #define INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_BASE_H
 
 #include "utils.h"
+#include <vector>
 
 namespace gr {
 namespace frequencyAdaptiveOFDM {
@@ -25,6 +26,8 @@ namespace frequencyAdaptiveOFDM {
 // Maximum number of traceback bytes
 #define TRACEBACK_MAX 24
 
+class window_pool;
+
 /* This Viterbi decoder was taken from the gr-dvbt module of
  * GNU Radio. It is an SSE2 version of the Viterbi Decoder
  * created by Phil Karn. The SSE2 version was made by Bogdan
@@ -34,11 +37,42 @@ class base
 {
 public:
 
+	// instruction sets of the trellis kernels
+	enum isa_t {
+		ISA_GENERIC = 0,
+		ISA_SSE2,
+		ISA_AVX2,
+		ISA_AVX512BW,
+	};
+
 	base();
-	~base();
+	virtual ~base();
 	virtual uint8_t* decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) = 0;
+	// Decode input that is already depunctured, with the erasure value of
+	// the decoder in the punctured positions. The trellis reads up to
+	// (TRACEBACK_MAX + 1) * 16 symbols past the frame to flush the
+	// traceback, the caller fills them.
+	uint8_t* decode_depunctured(ofdm_param *ofdm, frame_param *frame, uint8_t *depunctured);
+
+	// Select the trellis kernel. Returns false if it is not built or not
+	// supported by the CPU. Decoders start with the widest one available.
+	virtual bool set_isa(isa_t isa) = 0;
+	isa_t isa() const { return d_isa; }
+	static bool cpu_supports(isa_t isa);
+	static const char* isa_name(isa_t isa);
+
+	// Block parallel mode: split the trellis of long frames into
+	// n_windows windows that are decoded concurrently. Each window starts
+	// overlap bits early to warm up the metrics and runs one traceback
+	// length past its end, like the serial decoder does at any point.
+	// 1 switches back to serial decoding.
+	void set_windows(int n_windows, int overlap = 96);
+	int windows() const { return d_n_windows; }
+	int overlap() const { return d_overlap; }
 
 protected:
+	isa_t d_isa;
+
 	// Position in circular buffer where the current decoded byte is stored
 	int d_store_pos;
 	// Metrics for each state
@@ -52,7 +86,7 @@ protected:
 	frame_param *d_frame;
 	const unsigned char *d_depuncture_pattern;
 
-	uint8_t d_depunctured[MAX_ENCODED_BITS];
+	uint8_t d_depunctured[MAX_DEPUNCTURED_BITS + (TRACEBACK_MAX + 1) * 16];
 	uint8_t d_decoded[MAX_ENCODED_BITS * 3 / 4];
 
 	static const unsigned char PARTAB[256];
@@ -61,7 +95,33 @@ protected:
 	static const unsigned char PUNCTURE_3_4[6];
 
 	virtual void reset() = 0;
-	uint8_t* depuncture(uint8_t *in);
+	// follow the stored paths back from beststate and return the oldest
+	// decoded byte
+	unsigned char traceback(int beststate);
+	// erasure is the value inserted for punctured bits: 2 for hard bits,
+	// 0 for soft bits
+	uint8_t* depuncture(uint8_t *in, uint8_t erasure = 2);
+
+	// decoder of the same kind for one window, NULL if the decoder does
+	// not support windows
+	virtual base* clone() const { return NULL; }
+	// run the trellis over depunctured symbols for d_frame, after reset()
+	virtual void run_trellis(uint8_t *) { }
+
+	// true if the current frame is long enough to be split
+	bool use_windows() const;
+	// decode the depunctured frame in windows, the last one reads past the
+	// end of the frame like the serial decoder
+	uint8_t* decode_windows(uint8_t *depunctured);
+
+private:
+	int d_n_windows;
+	int d_overlap;
+	std::vector<base*> d_window_decoders;
+	std::vector<frame_param> d_window_frames;
+	window_pool *d_pool;
+
+	void decode_window(int w, uint8_t *depunctured, int start, int end);
 };
 
 } // namespace frequencyAdaptiveOFDM
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_KERNELS_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_KERNELS_H
+
+#include <stdint.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Interface of the trellis kernels that are built with their own
+ * instruction set, see lib/CMakeLists.txt. The decoders pass pointers to
+ * their members, so the kernels only see plain data.
+ */
+struct viterbi_kernel_state {
+	// expected code bits of the 0 branch of states 0..31, two rows
+	const void *branchtab;
+	// metrics and paths of the 64 states, read at the start and written
+	// back at the end
+	void *metric;
+	void *path;
+	// circular buffer with the last ntraceback paths
+	unsigned char (*ppresult)[64];
+	int *store_pos;
+	int ntraceback;
+	int n_data_bits;
+	uint8_t *decoded;
+};
+
+// follow the stored paths back from beststate and return the oldest
+// decoded byte
+static inline unsigned char
+viterbi_traceback(const unsigned char (*ppresult)[64], int store_pos,
+		int ntraceback, int beststate) {
+	int pos = store_pos;
+	for(int i = 0; i < (ntraceback - 1); i++) {
+		// Obtain the state from the output bits
+		// by clocking in the output bits in reverse order.
+		// The state has only 6 bits
+		beststate = ppresult[pos][beststate] >> 2;
+		pos = (pos - 1 + ntraceback) % ntraceback;
+	}
+	return ppresult[pos][beststate];
+}
+
+// hard decisions, 8 bit metrics
+void viterbi_decode_avx2(const viterbi_kernel_state &s, const uint8_t *depunctured);
+void viterbi_decode_avx512bw(const viterbi_kernel_state &s, const uint8_t *depunctured);
+// soft decisions, 16 bit branch table, metrics and paths
+void viterbi_decode_soft_avx2(const viterbi_kernel_state &s, const uint8_t *depunctured);
+
+// frames of the batched decoder, one byte lane of a row each
+#define VITERBI_MAX_BATCH 32
+
+struct viterbi_batch_kernel_state {
+	// branch metric class (bt0 << 1 | bt1) of the 0 branch of states 0..31
+	const unsigned char *branch_class;
+	// depunctured symbols, one row per symbol
+	const uint8_t (*symbols)[VITERBI_MAX_BATCH];
+	// metrics and paths of the 64 states, the trellis alternates between
+	// the two of each
+	unsigned char (*metric)[64][VITERBI_MAX_BATCH];
+	unsigned char (*path)[64][VITERBI_MAX_BATCH];
+	// circular buffer with the last ntraceback paths
+	unsigned char (*paths)[64][VITERBI_MAX_BATCH];
+	int *store_pos;
+	int ntraceback;
+	int n_data_bits;
+	// decoded bits of frame f start at decoded + f * decoded_stride
+	uint8_t *decoded;
+	int decoded_stride;
+};
+
+// trace back the paths of the first n frames from their best states and
+// store the decoded bits of output byte pos
+static inline void
+viterbi_traceback_batch(const viterbi_batch_kernel_state &s, int store_pos,
+		const unsigned char *beststate, int n, int pos) {
+	unsigned char state[VITERBI_MAX_BATCH];
+	int f;
+
+	// all frames are at the same position of the circular buffer
+	for (f = 0; f < n; f++) {
+		state[f] = beststate[f];
+	}
+	int p = store_pos;
+	for (int i = 0; i < (s.ntraceback - 1); i++) {
+		// Obtain the state from the output bits
+		// by clocking in the output bits in reverse order.
+		// The state has only 6 bits
+		for (f = 0; f < n; f++) {
+			state[f] = s.paths[p][state[f]][f] >> 2;
+		}
+		p = p ? p - 1 : s.ntraceback - 1;
+	}
+
+	for (f = 0; f < n; f++) {
+		unsigned char c = s.paths[p][state[f]][f];
+		for (int i = 0; i < 8; i++) {
+			s.decoded[f * s.decoded_stride + pos * 8 + i] = (c >> (7 - i)) & 0x1;
+		}
+	}
+}
+
+void viterbi_decode_batch_avx2(const viterbi_batch_kernel_state &s, int n);
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_KERNELS_H */
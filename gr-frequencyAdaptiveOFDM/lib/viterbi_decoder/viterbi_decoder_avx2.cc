@@ -0,0 +1,168 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * AVX2 trellis kernel of the Viterbi decoder for K=7 rate=1/2
+ * convolutional code. Metrics and paths of all 64 states stay in two
+ * registers for the whole frame, register 0 holds states 0..31 and
+ * register 1 states 32..63. The decisions are the same as the ones of
+ * the SSE2 kernel.
+ */
+#include "kernels.h"
+#include <immintrin.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+// one trellis step for the input symbols sym0 and sym1
+static inline void
+butterfly_avx2(unsigned char sym0, unsigned char sym1,
+		__m256i branchtab0, __m256i branchtab1,
+		__m256i &metric0, __m256i &metric1,
+		__m256i &path0, __m256i &path1) {
+
+	__m256i metsv, metsvm;
+
+	// punctured symbols (2) do not contribute to the branch metrics, at
+	// most one symbol of a pair is punctured
+	unsigned char valid0 = (sym0 != 2);
+	unsigned char valid1 = (sym1 != 2);
+	metsvm = _mm256_add_epi8(
+			_mm256_and_si256(_mm256_xor_si256(branchtab0, _mm256_set1_epi8(sym0)), _mm256_set1_epi8(valid0)),
+			_mm256_and_si256(_mm256_xor_si256(branchtab1, _mm256_set1_epi8(sym1)), _mm256_set1_epi8(valid1)));
+	metsv = _mm256_sub_epi8(_mm256_set1_epi8(valid0 + valid1), metsvm);
+
+	__m256i m0 = _mm256_add_epi8(metric0, metsv);
+	__m256i m1 = _mm256_add_epi8(metric1, metsvm);
+	__m256i m2 = _mm256_add_epi8(metric0, metsvm);
+	__m256i m3 = _mm256_add_epi8(metric1, metsv);
+
+	__m256i decision0 = _mm256_cmpgt_epi8(_mm256_sub_epi8(m0, m1), _mm256_setzero_si256());
+	__m256i decision1 = _mm256_cmpgt_epi8(_mm256_sub_epi8(m2, m3), _mm256_setzero_si256());
+	__m256i survivor0 = _mm256_blendv_epi8(m1, m0, decision0);
+	__m256i survivor1 = _mm256_blendv_epi8(m3, m2, decision1);
+
+	__m256i shift0 = _mm256_slli_epi16(path0, 1);
+	__m256i shift1 = _mm256_add_epi8(_mm256_slli_epi16(path1, 1), _mm256_set1_epi8(1));
+	__m256i tmp0 = _mm256_blendv_epi8(shift1, shift0, decision0);
+	__m256i tmp1 = _mm256_blendv_epi8(shift1, shift0, decision1);
+
+	// states 2i and 2i+1 are interleaved, unpack works per 128 bit lane
+	__m256i lo = _mm256_unpacklo_epi8(survivor0, survivor1);
+	__m256i hi = _mm256_unpackhi_epi8(survivor0, survivor1);
+	metric0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+	metric1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+	lo = _mm256_unpacklo_epi8(tmp0, tmp1);
+	hi = _mm256_unpackhi_epi8(tmp0, tmp1);
+	path0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+	path1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+// horizontal maximum and minimum of the 8 bit metrics
+static inline __m256i
+broadcast_max_epu8(__m256i v) {
+	__m256i t = _mm256_max_epu8(v, _mm256_permute2x128_si256(v, v, 0x01));
+	t = _mm256_max_epu8(t, _mm256_srli_si256(t, 8));
+	t = _mm256_max_epu8(t, _mm256_srli_si256(t, 4));
+	t = _mm256_max_epu8(t, _mm256_srli_si256(t, 2));
+	t = _mm256_max_epu8(t, _mm256_srli_si256(t, 1));
+	return _mm256_broadcastb_epi8(_mm256_castsi256_si128(t));
+}
+
+static inline __m256i
+broadcast_min_epu8(__m256i v) {
+	__m256i t = _mm256_min_epu8(v, _mm256_permute2x128_si256(v, v, 0x01));
+	t = _mm256_min_epu8(t, _mm256_srli_si256(t, 8));
+	t = _mm256_min_epu8(t, _mm256_srli_si256(t, 4));
+	t = _mm256_min_epu8(t, _mm256_srli_si256(t, 2));
+	t = _mm256_min_epu8(t, _mm256_srli_si256(t, 1));
+	return _mm256_broadcastb_epi8(_mm256_castsi256_si128(t));
+}
+
+void
+viterbi_decode_avx2(const viterbi_kernel_state &s, const uint8_t *depunctured) {
+	const unsigned char *branchtab = (const unsigned char *) s.branchtab;
+	unsigned char *metric = (unsigned char *) s.metric;
+	unsigned char *path = (unsigned char *) s.path;
+
+	__m256i branchtab0 = _mm256_loadu_si256((const __m256i *) branchtab);
+	__m256i branchtab1 = _mm256_loadu_si256((const __m256i *) (branchtab + 32));
+	__m256i metric0 = _mm256_loadu_si256((const __m256i *) metric);
+	__m256i metric1 = _mm256_loadu_si256((const __m256i *) (metric + 32));
+	__m256i path0 = _mm256_loadu_si256((const __m256i *) path);
+	__m256i path1 = _mm256_loadu_si256((const __m256i *) (path + 32));
+
+	int store_pos = *s.store_pos;
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	while(n_decoded < s.n_data_bits) {
+		const uint8_t *symbols = &depunctured[in_count];
+		butterfly_avx2(symbols[0], symbols[1], branchtab0, branchtab1,
+				metric0, metric1, path0, path1);
+		butterfly_avx2(symbols[2], symbols[3], branchtab0, branchtab1,
+				metric0, metric1, path0, path1);
+
+		if ((in_count % 16) == 8) {
+			// circular buffer with the last ntraceback paths
+			store_pos = (store_pos + 1) % s.ntraceback;
+			_mm256_storeu_si256((__m256i *) &s.ppresult[store_pos][0], path0);
+			_mm256_storeu_si256((__m256i *) &s.ppresult[store_pos][32], path1);
+
+			// best state is the first one with the highest metric
+			__m256i best = broadcast_max_epu8(_mm256_max_epu8(metric0, metric1));
+			unsigned int mask0 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(metric0, best));
+			unsigned int mask1 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(metric1, best));
+			int beststate = mask0 ? __builtin_ctz(mask0) : 32 + __builtin_ctz(mask1);
+
+			unsigned char c = viterbi_traceback(s.ppresult, store_pos, s.ntraceback, beststate);
+
+			// Zero out the path variable
+			// and prevent metric overflow
+			__m256i min = broadcast_min_epu8(_mm256_min_epu8(metric0, metric1));
+			metric0 = _mm256_sub_epi8(metric0, min);
+			metric1 = _mm256_sub_epi8(metric1, min);
+			path0 = _mm256_setzero_si256();
+			path1 = _mm256_setzero_si256();
+
+			if (out_count >= s.ntraceback) {
+				for (int i= 0; i < 8; i++) {
+					s.decoded[(out_count - s.ntraceback) * 8 + i] = (c >> (7 - i)) & 0x1;
+					n_decoded++;
+				}
+			}
+			out_count++;
+		}
+		in_count += 4;
+	}
+
+	_mm256_storeu_si256((__m256i *) metric, metric0);
+	_mm256_storeu_si256((__m256i *) (metric + 32), metric1);
+	_mm256_storeu_si256((__m256i *) path, path0);
+	_mm256_storeu_si256((__m256i *) (path + 32), path1);
+	*s.store_pos = store_pos;
+}
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
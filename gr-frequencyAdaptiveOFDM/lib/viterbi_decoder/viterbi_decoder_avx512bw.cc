@@ -0,0 +1,154 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * AVX-512BW trellis kernel of the Viterbi decoder for K=7 rate=1/2
+ * convolutional code. Metrics and paths of all 64 states stay in one
+ * register each for the whole frame. The decisions are the same as the
+ * ones of the SSE2 kernel.
+ */
+#include "kernels.h"
+#include <immintrin.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+// lower half: the 32 states i, upper half: the 32 states i+32
+#define LOW_HALF  _MM_SHUFFLE(1, 0, 1, 0)
+#define HIGH_HALF _MM_SHUFFLE(3, 2, 3, 2)
+#define SWAP_HALF _MM_SHUFFLE(1, 0, 3, 2)
+
+static inline __m512i
+interleave_states(__m512i v) {
+	// v holds the new even states in the lower and the odd states in the
+	// upper half. unpack works per 128 bit lane, so the lanes are put in
+	// order afterwards.
+	__m512i swapped = _mm512_shuffle_i64x2(v, v, SWAP_HALF);
+	__m512i lo = _mm512_unpacklo_epi8(v, swapped);
+	__m512i hi = _mm512_unpackhi_epi8(v, swapped);
+	return _mm512_permutex2var_epi64(lo,
+			_mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0), hi);
+}
+
+// one trellis step for the input symbols sym0 and sym1
+static inline void
+butterfly_avx512bw(unsigned char sym0, unsigned char sym1,
+		__m512i branchtab0, __m512i branchtab1,
+		__m512i &metric, __m512i &path) {
+
+	const __mmask64 upper = 0xffffffff00000000ULL;
+	__m512i metsv, metsvm;
+
+	// punctured symbols (2) do not contribute to the branch metrics, at
+	// most one symbol of a pair is punctured
+	unsigned char valid0 = (sym0 != 2);
+	unsigned char valid1 = (sym1 != 2);
+	metsvm = _mm512_add_epi8(
+			_mm512_and_si512(_mm512_xor_si512(branchtab0, _mm512_set1_epi8(sym0)), _mm512_set1_epi8(valid0)),
+			_mm512_and_si512(_mm512_xor_si512(branchtab1, _mm512_set1_epi8(sym1)), _mm512_set1_epi8(valid1)));
+	metsv = _mm512_sub_epi8(_mm512_set1_epi8(valid0 + valid1), metsvm);
+
+	// lower half computes the even, upper half the odd new states
+	__m512i from_low = _mm512_add_epi8(_mm512_shuffle_i64x2(metric, metric, LOW_HALF),
+			_mm512_mask_blend_epi8(upper, metsv, metsvm));
+	__m512i from_high = _mm512_add_epi8(_mm512_shuffle_i64x2(metric, metric, HIGH_HALF),
+			_mm512_mask_blend_epi8(upper, metsvm, metsv));
+
+	__mmask64 decision = _mm512_cmpgt_epi8_mask(_mm512_sub_epi8(from_low, from_high),
+			_mm512_setzero_si512());
+
+	__m512i shift0 = _mm512_slli_epi16(_mm512_shuffle_i64x2(path, path, LOW_HALF), 1);
+	__m512i shift1 = _mm512_add_epi8(_mm512_slli_epi16(_mm512_shuffle_i64x2(path, path, HIGH_HALF), 1),
+			_mm512_set1_epi8(1));
+
+	metric = interleave_states(_mm512_mask_blend_epi8(decision, from_high, from_low));
+	path = interleave_states(_mm512_mask_blend_epi8(decision, shift1, shift0));
+}
+
+void
+viterbi_decode_avx512bw(const viterbi_kernel_state &s, const uint8_t *depunctured) {
+	const unsigned char *branchtab = (const unsigned char *) s.branchtab;
+	__m512i branchtab0 = _mm512_broadcast_i64x4(
+			_mm256_loadu_si256((const __m256i *) branchtab));
+	__m512i branchtab1 = _mm512_broadcast_i64x4(
+			_mm256_loadu_si256((const __m256i *) (branchtab + 32)));
+	__m512i metric = _mm512_loadu_si512(s.metric);
+	__m512i path = _mm512_loadu_si512(s.path);
+
+	int store_pos = *s.store_pos;
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	while(n_decoded < s.n_data_bits) {
+		const uint8_t *symbols = &depunctured[in_count];
+		butterfly_avx512bw(symbols[0], symbols[1], branchtab0, branchtab1, metric, path);
+		butterfly_avx512bw(symbols[2], symbols[3], branchtab0, branchtab1, metric, path);
+
+		if ((in_count % 16) == 8) {
+			// circular buffer with the last ntraceback paths
+			store_pos = (store_pos + 1) % s.ntraceback;
+			_mm512_storeu_si512((void *) s.ppresult[store_pos], path);
+
+			// best state is the first one with the highest metric
+			__m256i t = _mm256_max_epu8(_mm512_castsi512_si256(metric),
+					_mm512_extracti64x4_epi64(metric, 1));
+			__m128i h = _mm_max_epu8(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1));
+			h = _mm_max_epu8(h, _mm_srli_si128(h, 8));
+			h = _mm_max_epu8(h, _mm_srli_si128(h, 4));
+			h = _mm_max_epu8(h, _mm_srli_si128(h, 2));
+			h = _mm_max_epu8(h, _mm_srli_si128(h, 1));
+			__mmask64 best = _mm512_cmpeq_epi8_mask(metric, _mm512_broadcastb_epi8(h));
+			int beststate = __builtin_ctzll(best);
+
+			unsigned char c = viterbi_traceback(s.ppresult, store_pos, s.ntraceback, beststate);
+
+			// Zero out the path variable
+			// and prevent metric overflow
+			t = _mm256_min_epu8(_mm512_castsi512_si256(metric),
+					_mm512_extracti64x4_epi64(metric, 1));
+			h = _mm_min_epu8(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1));
+			h = _mm_min_epu8(h, _mm_srli_si128(h, 8));
+			h = _mm_min_epu8(h, _mm_srli_si128(h, 4));
+			h = _mm_min_epu8(h, _mm_srli_si128(h, 2));
+			h = _mm_min_epu8(h, _mm_srli_si128(h, 1));
+			metric = _mm512_sub_epi8(metric, _mm512_broadcastb_epi8(h));
+			path = _mm512_setzero_si512();
+
+			if (out_count >= s.ntraceback) {
+				for (int i= 0; i < 8; i++) {
+					s.decoded[(out_count - s.ntraceback) * 8 + i] = (c >> (7 - i)) & 0x1;
+					n_decoded++;
+				}
+			}
+			out_count++;
+		}
+		in_count += 4;
+	}
+
+	_mm512_storeu_si512(s.metric, metric);
+	_mm512_storeu_si512(s.path, path);
+	*s.store_pos = store_pos;
+}
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "viterbi_decoder_batch.h"
+#include <cstring>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+void
+viterbi_decoder_batch::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in[], int n) {
+	d_ofdm = ofdm;
+	d_frame = frame;
+	reset();
+	load_symbols(in, n, d_depuncture_pattern, 2 * d_k);
+	(this->*d_decode_kernel)(n);
+}
+
+void
+viterbi_decoder_batch::decode_depunctured(ofdm_param *ofdm, frame_param *frame,
+		uint8_t *in[], int n) {
+	d_ofdm = ofdm;
+	d_frame = frame;
+	reset();
+	load_symbols(in, n, PUNCTURE_1_2, 2);
+	(this->*d_decode_kernel)(n);
+}
+
+void
+viterbi_decoder_batch::run_trellis(uint8_t *depunctured) {
+	load_symbols(&depunctured, 1, PUNCTURE_1_2, 2);
+	(this->*d_decode_kernel)(1);
+	std::memcpy(d_decoded, d_decoded_batch[0], d_frame->n_data_bits);
+}
+
+void
+viterbi_decoder_batch::load_symbols(uint8_t *in[], int n, const unsigned char *pattern, int period) {
+	// depuncture all frames at once into rows of one symbol per frame,
+	// punctured rows and the flush behind the frame are erasures
+	int n_depunctured = 2 * d_frame->n_data_bits;
+	int n_symbols = n_depunctured + (d_ntraceback + 1) * 16;
+	int phase = 0;
+	int k = 0;
+	for (int i = 0; i < n_depunctured; i++) {
+		if (pattern[phase]) {
+			for (int f = 0; f < n; f++) {
+				d_symbols[i][f] = in[f][k];
+			}
+			k++;
+		} else {
+			std::memset(d_symbols[i], 2, MAX_BATCH);
+		}
+		phase = (phase + 1 == period) ? 0 : phase + 1;
+	}
+	std::memset(d_symbols[n_depunctured], 2, (n_symbols - n_depunctured) * MAX_BATCH);
+}
+
+uint8_t*
+viterbi_decoder_batch::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) {
+	decode(ofdm, frame, &in, 1);
+	return d_decoded_batch[0];
+}
+
+viterbi_batch_kernel_state
+viterbi_decoder_batch::kernel_state() {
+	viterbi_batch_kernel_state s;
+	s.branch_class = d_branch_class;
+	s.symbols = d_symbols;
+	s.metric = d_metric;
+	s.path = d_path;
+	s.paths = d_paths;
+	s.store_pos = &d_store_pos;
+	s.ntraceback = d_ntraceback;
+	s.n_data_bits = d_frame->n_data_bits;
+	s.decoded = d_decoded_batch[0];
+	s.decoded_stride = sizeof(d_decoded_batch[0]);
+	return s;
+}
+
+void
+viterbi_decoder_batch::traceback_batch(const unsigned char beststate[MAX_BATCH], int n, int pos) {
+	viterbi_traceback_batch(kernel_state(), d_store_pos, beststate, n, pos);
+}
+
+void
+viterbi_decoder_batch::reset() {
+	std::memset(d_metric[0], 0, sizeof(d_metric[0]));
+	std::memset(d_path[0], 0, sizeof(d_path[0]));
+	std::memset(d_paths, 0, sizeof(d_paths));
+
+	int polys[2] = { 0x6d, 0x4f };
+	for(int i = 0; i < 32; i++) {
+		d_branch_class[i] = (PARTAB[(2*i) & polys[0]] << 1) | PARTAB[(2*i) & polys[1]];
+	}
+
+	switch(d_ofdm->punct) {
+	case P_1_2:
+		d_ntraceback = 5;
+		d_depuncture_pattern = PUNCTURE_1_2;
+		d_k = 1;
+		break;
+	case P_3_4:
+		d_ntraceback = 10;
+		d_depuncture_pattern = PUNCTURE_3_4;
+		d_k = 3;
+		break;
+	case P_2_3:
+		d_ntraceback = 9;
+		d_depuncture_pattern = PUNCTURE_2_3;
+		d_k = 2;
+		break;
+	}
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_BATCH_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_BATCH_H
+
+#include "base.h"
+#include "kernels.h"
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Hard decision Viterbi decoder for up to MAX_BATCH frames at once. The
+ * frames are independent, but have to use the same puncturing and the
+ * same number of data bits (and therefore of coded bits). Each frame
+ * runs in its own byte lane of the SIMD registers, register i holds the
+ * metric of state i of all frames. So the depuncturing, the search for
+ * the best state and the renormalization are done once for all of them.
+ *
+ * The decisions are the same as the ones of viterbi_decoder. The trellis
+ * is flushed with erasures behind the frame.
+ *
+ * The SSE2 kernel runs 16 frames per register, the AVX2 kernel of
+ * kernels.h 32.
+ */
+class viterbi_decoder_batch : public base
+{
+public:
+
+	static const int MAX_BATCH = VITERBI_MAX_BATCH;
+
+	viterbi_decoder_batch();
+	virtual bool set_isa(isa_t isa);
+
+	// decode the frames in[0] .. in[n-1], n <= MAX_BATCH
+	void decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in[], int n);
+	// same for frames that are already depunctured
+	void decode_depunctured(ofdm_param *ofdm, frame_param *frame, uint8_t *in[], int n);
+	using base::decode_depunctured;
+	// decoded bits of frame i of the last batch
+	uint8_t* decoded(int i) { return d_decoded_batch[i]; }
+
+	// single frame, i.e. a batch of one
+	virtual uint8_t* decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in);
+
+private:
+
+	// branch metric class (bt0 << 1 | bt1) of the 0 branch of states 0..31
+	unsigned char d_branch_class[32];
+
+	// depunctured symbols, one row per symbol with one byte per frame
+	uint8_t d_symbols[MAX_DEPUNCTURED_BITS + (TRACEBACK_MAX + 1) * 16][MAX_BATCH]
+			__attribute__ ((aligned(16)));
+	unsigned char d_metric[2][64][MAX_BATCH] __attribute__ ((aligned(16)));
+	unsigned char d_path[2][64][MAX_BATCH] __attribute__ ((aligned(16)));
+	unsigned char d_paths[TRACEBACK_MAX][64][MAX_BATCH] __attribute__ ((aligned(16)));
+
+	uint8_t d_decoded_batch[MAX_BATCH][MAX_ENCODED_BITS * 3 / 4];
+
+	virtual void reset();
+	virtual void run_trellis(uint8_t *depunctured);
+
+	// transpose the frames into d_symbols, inserting erasures where the
+	// pattern has a zero, and flush with erasures
+	void load_symbols(uint8_t *in[], int n, const unsigned char *pattern, int period);
+
+	// members for the kernels of kernels.h
+	viterbi_batch_kernel_state kernel_state();
+
+	// trace back the paths of the first n frames from their best states
+	// and store the decoded bits of output byte pos
+	void traceback_batch(const unsigned char beststate[MAX_BATCH], int n, int pos);
+
+	// trellis loop of the selected instruction set for n frames
+	void (viterbi_decoder_batch::*d_decode_kernel)(int n);
+#ifdef FREQUENCYADAPTIVEOFDM_MSSE2
+	void decode_sse2(int n);
+#else
+	void decode_generic(int n);
+#endif
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	void decode_avx2(int n);
+#endif
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_BATCH_H */
@@ -0,0 +1,144 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * AVX2 kernel of the batched Viterbi decoder, 32 frames per register.
+ */
+#include "kernels.h"
+#include <immintrin.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+#define ROW(a, i) ((__m256i *) &(a)[i][0])
+
+void
+viterbi_decode_batch_avx2(const viterbi_batch_kernel_state &s, int n) {
+	const __m256i one = _mm256_set1_epi8(1);
+	int store_pos = *s.store_pos;
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	int i;
+
+	while(n_decoded < s.n_data_bits) {
+		for (int g = 0; g < 2; g++) {
+			unsigned char (*metric0)[VITERBI_MAX_BATCH] = s.metric[g];
+			unsigned char (*path0)[VITERBI_MAX_BATCH] = s.path[g];
+			unsigned char (*metric1)[VITERBI_MAX_BATCH] = s.metric[!g];
+			unsigned char (*path1)[VITERBI_MAX_BATCH] = s.path[!g];
+			const uint8_t *sym0 = s.symbols[in_count + 2 * g];
+			const uint8_t *sym1 = s.symbols[in_count + 2 * g + 1];
+			__m256i sym0v = _mm256_loadu_si256((const __m256i *) sym0);
+			__m256i sym1v = _mm256_loadu_si256((const __m256i *) sym1);
+
+			// metrics of the 0 (metsv) and 1 (metsvm) branch for the four
+			// combinations of expected code bits, all frames share the
+			// puncturing
+			__m256i metsv[4], metsvm[4];
+			for (int c = 0; c < 4; c++) {
+				__m256i x0 = (c & 2) ? _mm256_xor_si256(sym0v, one) : sym0v;
+				__m256i x1 = (c & 1) ? _mm256_xor_si256(sym1v, one) : sym1v;
+
+				if (sym0[0] == 2 && sym1[0] == 2) {
+					metsvm[c] = _mm256_setzero_si256();
+					metsv[c] = _mm256_setzero_si256();
+				} else if (sym0[0] == 2) {
+					metsvm[c] = x1;
+					metsv[c] = _mm256_sub_epi8(one, metsvm[c]);
+				} else if (sym1[0] == 2) {
+					metsvm[c] = x0;
+					metsv[c] = _mm256_sub_epi8(one, metsvm[c]);
+				} else {
+					metsvm[c] = _mm256_add_epi8(x0, x1);
+					metsv[c] = _mm256_sub_epi8(_mm256_set1_epi8(2), metsvm[c]);
+				}
+			}
+
+			for (i = 0; i < 32; i++) {
+				int c = s.branch_class[i];
+				__m256i mi = _mm256_loadu_si256(ROW(metric0, i));
+				__m256i mi32 = _mm256_loadu_si256(ROW(metric0, i+32));
+
+				__m256i m0 = _mm256_add_epi8(mi, metsv[c]);
+				__m256i m1 = _mm256_add_epi8(mi32, metsvm[c]);
+				__m256i m2 = _mm256_add_epi8(mi, metsvm[c]);
+				__m256i m3 = _mm256_add_epi8(mi32, metsv[c]);
+
+				__m256i decision0 = _mm256_cmpgt_epi8(_mm256_sub_epi8(m0, m1), _mm256_setzero_si256());
+				__m256i decision1 = _mm256_cmpgt_epi8(_mm256_sub_epi8(m2, m3), _mm256_setzero_si256());
+
+				__m256i shift0 = _mm256_slli_epi16(_mm256_loadu_si256(ROW(path0, i)), 1);
+				__m256i shift1 = _mm256_add_epi8(_mm256_slli_epi16(_mm256_loadu_si256(ROW(path0, i+32)), 1), one);
+
+				_mm256_storeu_si256(ROW(metric1, 2*i), _mm256_blendv_epi8(m1, m0, decision0));
+				_mm256_storeu_si256(ROW(metric1, 2*i+1), _mm256_blendv_epi8(m3, m2, decision1));
+				_mm256_storeu_si256(ROW(path1, 2*i), _mm256_blendv_epi8(shift1, shift0, decision0));
+				_mm256_storeu_si256(ROW(path1, 2*i+1), _mm256_blendv_epi8(shift1, shift0, decision1));
+			}
+		}
+
+		if ((in_count % 16) == 8) {
+			unsigned char (*metric)[VITERBI_MAX_BATCH] = s.metric[0];
+			unsigned char beststate[VITERBI_MAX_BATCH];
+
+			// circular buffer with the last ntraceback paths
+			store_pos = (store_pos + 1) % s.ntraceback;
+			for (i = 0; i < 64; i++) {
+				_mm256_storeu_si256(ROW(s.paths[store_pos], i), _mm256_loadu_si256(ROW(s.path[0], i)));
+				_mm256_storeu_si256(ROW(s.path[0], i), _mm256_setzero_si256());
+			}
+
+			// best state is the first one with the highest metric
+			__m256i best = _mm256_loadu_si256(ROW(metric, 0));
+			__m256i min = best;
+			__m256i state = _mm256_setzero_si256();
+			for (i = 1; i < 64; i++) {
+				__m256i m = _mm256_loadu_si256(ROW(metric, i));
+				__m256i max = _mm256_max_epu8(m, best);
+				__m256i greater = _mm256_xor_si256(_mm256_cmpeq_epi8(max, best), _mm256_set1_epi8(-1));
+				state = _mm256_blendv_epi8(state, _mm256_set1_epi8(i), greater);
+				best = max;
+				min = _mm256_min_epu8(m, min);
+			}
+			_mm256_storeu_si256((__m256i *) beststate, state);
+
+			// prevent metric overflow
+			for (i = 0; i < 64; i++) {
+				_mm256_storeu_si256(ROW(metric, i),
+						_mm256_sub_epi8(_mm256_loadu_si256(ROW(metric, i)), min));
+			}
+
+			if (out_count >= s.ntraceback) {
+				viterbi_traceback_batch(s, store_pos, beststate, n, out_count - s.ntraceback);
+				n_decoded += 8;
+			}
+			out_count++;
+		}
+		in_count += 4;
+	}
+	*s.store_pos = store_pos;
+}
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
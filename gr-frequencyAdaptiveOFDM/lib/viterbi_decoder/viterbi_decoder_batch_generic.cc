@@ -0,0 +1,144 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Batched hard decision Viterbi decoder for K=7 rate=1/2 convolutional
+ * code, generic version without SIMD instructions. The loops over the
+ * frames are left to the compiler.
+ */
+#include "viterbi_decoder_batch.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+viterbi_decoder_batch::viterbi_decoder_batch() :
+	d_decode_kernel(&viterbi_decoder_batch::decode_generic) {
+}
+
+bool
+viterbi_decoder_batch::set_isa(isa_t isa) {
+	return isa == ISA_GENERIC;
+}
+
+void
+viterbi_decoder_batch::decode_generic(int n) {
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	int i, f;
+
+	while(n_decoded < d_frame->n_data_bits) {
+		for (int s = 0; s < 2; s++) {
+			unsigned char (*metric0)[MAX_BATCH] = d_metric[s];
+			unsigned char (*path0)[MAX_BATCH] = d_path[s];
+			unsigned char (*metric1)[MAX_BATCH] = d_metric[!s];
+			unsigned char (*path1)[MAX_BATCH] = d_path[!s];
+			const uint8_t *sym0 = d_symbols[in_count + 2 * s];
+			const uint8_t *sym1 = d_symbols[in_count + 2 * s + 1];
+
+			// metrics of the 0 (metsv) and 1 (metsvm) branch for the four
+			// combinations of expected code bits, all frames share the
+			// puncturing
+			unsigned char metsv[4][MAX_BATCH], metsvm[4][MAX_BATCH];
+			for (int c = 0; c < 4; c++) {
+				int bt0 = c >> 1;
+				int bt1 = c & 1;
+				for (f = 0; f < n; f++) {
+					if (sym0[0] == 2 && sym1[0] == 2) {
+						metsvm[c][f] = 0;
+						metsv[c][f] = 0;
+					} else if (sym0[0] == 2) {
+						metsvm[c][f] = sym1[f] ^ bt1;
+						metsv[c][f] = 1 - metsvm[c][f];
+					} else if (sym1[0] == 2) {
+						metsvm[c][f] = sym0[f] ^ bt0;
+						metsv[c][f] = 1 - metsvm[c][f];
+					} else {
+						metsvm[c][f] = (sym0[f] ^ bt0) + (sym1[f] ^ bt1);
+						metsv[c][f] = 2 - metsvm[c][f];
+					}
+				}
+			}
+
+			for (i = 0; i < 32; i++) {
+				int c = d_branch_class[i];
+
+				for (f = 0; f < n; f++) {
+					unsigned char m0 = metric0[i][f] + metsv[c][f];
+					unsigned char m1 = metric0[i+32][f] + metsvm[c][f];
+					unsigned char m2 = metric0[i][f] + metsvm[c][f];
+					unsigned char m3 = metric0[i+32][f] + metsv[c][f];
+
+					// metrics wrap around, compare the signed difference
+					bool decision0 = (signed char)(m0 - m1) > 0;
+					bool decision1 = (signed char)(m2 - m3) > 0;
+
+					unsigned char shift0 = path0[i][f] << 1;
+					unsigned char shift1 = (path0[i+32][f] << 1) + 1;
+
+					metric1[2*i][f] = decision0 ? m0 : m1;
+					metric1[2*i+1][f] = decision1 ? m2 : m3;
+					path1[2*i][f] = decision0 ? shift0 : shift1;
+					path1[2*i+1][f] = decision1 ? shift0 : shift1;
+				}
+			}
+		}
+
+		if ((in_count % 16) == 8) {
+			unsigned char (*metric)[MAX_BATCH] = d_metric[0];
+			unsigned char beststate[MAX_BATCH];
+
+			// circular buffer with the last ntraceback paths
+			d_store_pos = (d_store_pos + 1) % d_ntraceback;
+			std::memcpy(d_paths[d_store_pos], d_path[0], sizeof(d_paths[0]));
+
+			for (f = 0; f < n; f++) {
+				// best state is the first one with the highest metric
+				unsigned char min = metric[0][f];
+				beststate[f] = 0;
+				for (i = 1; i < 64; i++) {
+					if (metric[i][f] > metric[beststate[f]][f]) {
+						beststate[f] = i;
+					}
+					min = std::min(min, metric[i][f]);
+				}
+
+				// prevent metric overflow
+				for (i = 0; i < 64; i++) {
+					metric[i][f] -= min;
+				}
+			}
+
+			// Zero out the path variable
+			std::memset(d_path[0], 0, sizeof(d_path[0]));
+
+			if (out_count >= d_ntraceback) {
+				traceback_batch(beststate, n, out_count - d_ntraceback);
+				n_decoded += 8;
+			}
+			out_count++;
+		}
+		in_count += 4;
+	}
+}
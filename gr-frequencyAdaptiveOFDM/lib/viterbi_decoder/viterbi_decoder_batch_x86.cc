@@ -0,0 +1,191 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Batched hard decision Viterbi decoder for K=7 rate=1/2 convolutional
+ * code, one frame per byte of the SSE2 registers.
+ */
+#include "viterbi_decoder_batch.h"
+#include <emmintrin.h>
+#include <cstring>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+viterbi_decoder_batch::viterbi_decoder_batch() :
+	d_decode_kernel(&viterbi_decoder_batch::decode_sse2) {
+	d_isa = ISA_SSE2;
+	set_isa(ISA_AVX2);
+}
+
+bool
+viterbi_decoder_batch::set_isa(isa_t isa) {
+	if(!cpu_supports(isa)) {
+		return false;
+	}
+
+	switch(isa) {
+	case ISA_SSE2:
+		d_decode_kernel = &viterbi_decoder_batch::decode_sse2;
+		break;
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	case ISA_AVX2:
+		d_decode_kernel = &viterbi_decoder_batch::decode_avx2;
+		break;
+#endif
+	default:
+		return false;
+	}
+	d_isa = isa;
+	return true;
+}
+
+#define ROW(a, i) (*(__m128i *) &(a)[i][0])
+
+// one trellis step of 16 frames, the rows of the arrays are offset to
+// the frames
+static inline void
+butterfly_sse2(const uint8_t *sym0, const uint8_t *sym1, bool erased0, bool erased1,
+		const unsigned char branch_class[32],
+		unsigned char (*metric0)[viterbi_decoder_batch::MAX_BATCH],
+		unsigned char (*path0)[viterbi_decoder_batch::MAX_BATCH],
+		unsigned char (*metric1)[viterbi_decoder_batch::MAX_BATCH],
+		unsigned char (*path1)[viterbi_decoder_batch::MAX_BATCH]) {
+
+	const __m128i one = _mm_set1_epi8(1);
+	__m128i sym0v = _mm_loadu_si128((const __m128i *) sym0);
+	__m128i sym1v = _mm_loadu_si128((const __m128i *) sym1);
+
+	// metrics of the 0 (metsv) and 1 (metsvm) branch for the four
+	// combinations of expected code bits, all frames share the puncturing
+	__m128i metsv[4], metsvm[4];
+	for (int c = 0; c < 4; c++) {
+		__m128i x0 = (c & 2) ? _mm_xor_si128(sym0v, one) : sym0v;
+		__m128i x1 = (c & 1) ? _mm_xor_si128(sym1v, one) : sym1v;
+
+		if (erased0 && erased1) {
+			metsvm[c] = _mm_setzero_si128();
+			metsv[c] = _mm_setzero_si128();
+		} else if (erased0) {
+			metsvm[c] = x1;
+			metsv[c] = _mm_sub_epi8(one, metsvm[c]);
+		} else if (erased1) {
+			metsvm[c] = x0;
+			metsv[c] = _mm_sub_epi8(one, metsvm[c]);
+		} else {
+			metsvm[c] = _mm_add_epi8(x0, x1);
+			metsv[c] = _mm_sub_epi8(_mm_set1_epi8(2), metsvm[c]);
+		}
+	}
+
+	for (int i = 0; i < 32; i++) {
+		int c = branch_class[i];
+
+		__m128i m0 = _mm_add_epi8(ROW(metric0, i), metsv[c]);
+		__m128i m1 = _mm_add_epi8(ROW(metric0, i+32), metsvm[c]);
+		__m128i m2 = _mm_add_epi8(ROW(metric0, i), metsvm[c]);
+		__m128i m3 = _mm_add_epi8(ROW(metric0, i+32), metsv[c]);
+
+		__m128i decision0 = _mm_cmpgt_epi8(_mm_sub_epi8(m0, m1), _mm_setzero_si128());
+		__m128i decision1 = _mm_cmpgt_epi8(_mm_sub_epi8(m2, m3), _mm_setzero_si128());
+
+		__m128i shift0 = _mm_slli_epi16(ROW(path0, i), 1);
+		__m128i shift1 = _mm_add_epi8(_mm_slli_epi16(ROW(path0, i+32), 1), one);
+
+		ROW(metric1, 2*i) = _mm_or_si128(_mm_and_si128(decision0, m0), _mm_andnot_si128(decision0, m1));
+		ROW(metric1, 2*i+1) = _mm_or_si128(_mm_and_si128(decision1, m2), _mm_andnot_si128(decision1, m3));
+		ROW(path1, 2*i) = _mm_or_si128(_mm_and_si128(decision0, shift0), _mm_andnot_si128(decision0, shift1));
+		ROW(path1, 2*i+1) = _mm_or_si128(_mm_and_si128(decision1, shift0), _mm_andnot_si128(decision1, shift1));
+	}
+}
+
+void
+viterbi_decoder_batch::decode_sse2(int n) {
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	int n_blocks = (n + 15) / 16;
+
+	while(n_decoded < d_frame->n_data_bits) {
+		for (int s = 0; s < 2; s++) {
+			const uint8_t *sym0 = d_symbols[in_count + 2 * s];
+			const uint8_t *sym1 = d_symbols[in_count + 2 * s + 1];
+			for (int b = 0; b < n_blocks; b++) {
+				int o = 16 * b;
+				butterfly_sse2(sym0 + o, sym1 + o, sym0[0] == 2, sym1[0] == 2, d_branch_class,
+						(unsigned char (*)[MAX_BATCH]) &d_metric[s][0][o],
+						(unsigned char (*)[MAX_BATCH]) &d_path[s][0][o],
+						(unsigned char (*)[MAX_BATCH]) &d_metric[!s][0][o],
+						(unsigned char (*)[MAX_BATCH]) &d_path[!s][0][o]);
+			}
+		}
+
+		if ((in_count % 16) == 8) {
+			unsigned char beststate[MAX_BATCH] __attribute__ ((aligned(16)));
+
+			// circular buffer with the last ntraceback paths
+			d_store_pos = (d_store_pos + 1) % d_ntraceback;
+			std::memcpy(d_paths[d_store_pos], d_path[0], sizeof(d_paths[0]));
+
+			for (int b = 0; b < n_blocks; b++) {
+				int o = 16 * b;
+				unsigned char (*metric)[MAX_BATCH] = (unsigned char (*)[MAX_BATCH]) &d_metric[0][0][o];
+
+				// best state is the first one with the highest metric
+				__m128i best = ROW(metric, 0);
+				__m128i min = ROW(metric, 0);
+				__m128i state = _mm_setzero_si128();
+				for (int i = 1; i < 64; i++) {
+					__m128i max = _mm_max_epu8(ROW(metric, i), best);
+					__m128i not_greater = _mm_cmpeq_epi8(max, best);
+					state = _mm_or_si128(_mm_and_si128(not_greater, state),
+							_mm_andnot_si128(not_greater, _mm_set1_epi8(i)));
+					best = max;
+					min = _mm_min_epu8(ROW(metric, i), min);
+				}
+				_mm_store_si128((__m128i *) &beststate[o], state);
+
+				// prevent metric overflow
+				for (int i = 0; i < 64; i++) {
+					ROW(metric, i) = _mm_sub_epi8(ROW(metric, i), min);
+				}
+			}
+
+			// Zero out the path variable
+			std::memset(d_path[0], 0, sizeof(d_path[0]));
+
+			if (out_count >= d_ntraceback) {
+				traceback_batch(beststate, n, out_count - d_ntraceback);
+				n_decoded += 8;
+			}
+			out_count++;
+		}
+		in_count += 4;
+	}
+}
+
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+void
+viterbi_decoder_batch::decode_avx2(int n) {
+	viterbi_decode_batch_avx2(kernel_state(), n);
+}
+#endif
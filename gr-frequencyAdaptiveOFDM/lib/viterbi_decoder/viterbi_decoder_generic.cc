@@ -82,6 +82,10 @@
 
 using namespace gr::frequencyAdaptiveOFDM;
 
+bool
+viterbi_decoder::set_isa(isa_t isa) {
+	return isa == ISA_GENERIC;
+}
 
 void
 viterbi_decoder::viterbi_butterfly2_generic(unsigned char *symbols,
@@ -341,7 +345,20 @@ viterbi_decoder::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) {
 
 	reset();
 	uint8_t *depunctured = depuncture(in);
+	if(use_windows()) {
+		return decode_windows(depunctured);
+	}
+	run_trellis(depunctured);
+	return d_decoded;
+}
+
+base*
+viterbi_decoder::clone() const {
+	return new viterbi_decoder();
+}
 
+void
+viterbi_decoder::run_trellis(uint8_t *depunctured) {
 	int in_count = 0;
 	int out_count = 0;
 	int n_decoded = 0;
@@ -368,8 +385,6 @@ viterbi_decoder::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) {
 		}
 		in_count++;
 	}
-
-	return d_decoded;
 }
 
 void
@@ -399,7 +414,7 @@ void
 viterbi_decoder::viterbi_chunks_init_generic() {
 	int i, j;
 
-	for (i = 0; i < 4; i++) {
+	for (i = 0; i < 64; i++) {
 		d_metric0_generic[i] = 0;
 		d_path0_generic[i] = 0;
 	}
@@ -32,6 +32,7 @@ class viterbi_decoder : public base
 public:
 
 	virtual uint8_t* decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in);
+	virtual bool set_isa(isa_t isa);
 
 private:
 
@@ -45,6 +46,8 @@ private:
 	unsigned char d_path1_generic[64] __attribute__ ((aligned(16)));
 
 	void reset();
+	virtual base* clone() const;
+	virtual void run_trellis(uint8_t *depunctured);
 
 	void viterbi_chunks_init_generic();
 	void viterbi_butterfly2_generic(unsigned char *symbols,
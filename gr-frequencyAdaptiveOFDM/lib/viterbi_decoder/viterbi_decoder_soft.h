@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_SOFT_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_SOFT_H
+
+#include "base.h"
+#include "kernels.h"
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Soft decision version of the Viterbi decoder. The input bits are
+ * signed 8 bit values (int8_t) where a positive value means that a 1 is
+ * more likely and the magnitude is the reliability of the bit. Punctured
+ * bits are inserted as 0, so they do not contribute to the metrics.
+ *
+ * Branch metrics are the correlation of the received soft bits with the
+ * expected code bits and path metrics are kept in 16 bits. The survivor
+ * paths and the trace back are the same as in the hard decision decoder,
+ * so a soft input of +-1 decodes exactly like the hard bits 1/0.
+ *
+ * On x86 there is an AVX2 kernel next to the SSE2 one, see kernels.h.
+ * It is picked at runtime if the CPU supports it.
+ */
+class viterbi_decoder_soft : public base
+{
+public:
+
+	viterbi_decoder_soft();
+	virtual uint8_t* decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in);
+	virtual bool set_isa(isa_t isa);
+
+private:
+
+	// +1/-1 expected code bits of the 0 branch of states 0..31
+	short d_branchtab_soft[2][32] __attribute__ ((aligned(16)));
+
+	short d_metric0_soft[64] __attribute__ ((aligned(16)));
+	short d_metric1_soft[64] __attribute__ ((aligned(16)));
+	short d_path0_soft[64] __attribute__ ((aligned(16)));
+	short d_path1_soft[64] __attribute__ ((aligned(16)));
+
+	virtual void reset();
+	virtual base* clone() const;
+	virtual void run_trellis(uint8_t *depunctured);
+
+	// trellis loop of the selected instruction set
+	void (viterbi_decoder_soft::*d_decode_kernel)(uint8_t *depunctured);
+#ifdef FREQUENCYADAPTIVEOFDM_MSSE2
+	void decode_sse2(uint8_t *depunctured);
+#else
+	void decode_generic(uint8_t *depunctured);
+#endif
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	viterbi_kernel_state kernel_state();
+	void decode_avx2(uint8_t *depunctured);
+#endif
+
+	void viterbi_chunks_init_soft();
+	void viterbi_butterfly2_soft(const int8_t *symbols,
+			short m0[], short m1[], short p0[], short p1[]);
+	int viterbi_get_output_soft(short *mm0, short *pp0,
+			int ntraceback, unsigned char *outbuf);
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_SOFT_H */
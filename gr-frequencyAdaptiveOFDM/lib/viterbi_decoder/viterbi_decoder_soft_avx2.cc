@@ -0,0 +1,193 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * AVX2 trellis kernel of the soft decision Viterbi decoder. The 16 bit
+ * metrics and paths of the 64 states stay in four registers of 16 states
+ * each for the whole frame. The decisions are the same as the ones of
+ * the SSE2 kernel.
+ */
+#include "kernels.h"
+#include <immintrin.h>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+// new states 2j and 2j+1 of the old states j and j+32 of one register,
+// states 2j and 2j+1 are interleaved, unpack works per 128 bit lane
+static inline void
+acs_soft_avx2(__m256i bm, __m256i metric_lo, __m256i metric_hi,
+		__m256i path_lo, __m256i path_hi,
+		__m256i &metric0, __m256i &metric1, __m256i &path0, __m256i &path1) {
+
+	__m256i m0 = _mm256_adds_epi16(metric_lo, bm);
+	__m256i m1 = _mm256_subs_epi16(metric_hi, bm);
+	__m256i m2 = _mm256_subs_epi16(metric_lo, bm);
+	__m256i m3 = _mm256_adds_epi16(metric_hi, bm);
+
+	__m256i decision0 = _mm256_cmpgt_epi16(m0, m1);
+	__m256i decision1 = _mm256_cmpgt_epi16(m2, m3);
+	__m256i survivor0 = _mm256_max_epi16(m0, m1);
+	__m256i survivor1 = _mm256_max_epi16(m2, m3);
+
+	__m256i shift0 = _mm256_slli_epi16(path_lo, 1);
+	__m256i shift1 = _mm256_or_si256(_mm256_slli_epi16(path_hi, 1), _mm256_set1_epi16(1));
+	__m256i tmp0 = _mm256_blendv_epi8(shift1, shift0, decision0);
+	__m256i tmp1 = _mm256_blendv_epi8(shift1, shift0, decision1);
+
+	__m256i lo = _mm256_unpacklo_epi16(survivor0, survivor1);
+	__m256i hi = _mm256_unpackhi_epi16(survivor0, survivor1);
+	metric0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+	metric1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+	lo = _mm256_unpacklo_epi16(tmp0, tmp1);
+	hi = _mm256_unpackhi_epi16(tmp0, tmp1);
+	path0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+	path1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+}
+
+// one trellis step for the soft symbols sym0 and sym1
+static inline void
+butterfly_soft_avx2(short sym0, short sym1,
+		const __m256i branchtab0[2], const __m256i branchtab1[2],
+		__m256i metric[4], __m256i path[4]) {
+
+	const __m256i sym0v = _mm256_set1_epi16(sym0);
+	const __m256i sym1v = _mm256_set1_epi16(sym1);
+
+	// correlation with the +-1 code bits of the 0 branch,
+	// the 1 branch is the complement, i.e. -bm
+	__m256i bm0 = _mm256_add_epi16(_mm256_sign_epi16(sym0v, branchtab0[0]),
+			_mm256_sign_epi16(sym1v, branchtab1[0]));
+	__m256i bm1 = _mm256_add_epi16(_mm256_sign_epi16(sym0v, branchtab0[1]),
+			_mm256_sign_epi16(sym1v, branchtab1[1]));
+
+	__m256i m0, m1, m2, m3, p0, p1, p2, p3;
+	acs_soft_avx2(bm0, metric[0], metric[2], path[0], path[2], m0, m1, p0, p1);
+	acs_soft_avx2(bm1, metric[1], metric[3], path[1], path[3], m2, m3, p2, p3);
+
+	metric[0] = m0; metric[1] = m1; metric[2] = m2; metric[3] = m3;
+	path[0] = p0; path[1] = p1; path[2] = p2; path[3] = p3;
+}
+
+// horizontal maximum and minimum of the 16 bit metrics
+static inline __m256i
+broadcast_max_epi16(__m256i v) {
+	__m256i t = _mm256_max_epi16(v, _mm256_permute2x128_si256(v, v, 0x01));
+	t = _mm256_max_epi16(t, _mm256_srli_si256(t, 8));
+	t = _mm256_max_epi16(t, _mm256_srli_si256(t, 4));
+	t = _mm256_max_epi16(t, _mm256_srli_si256(t, 2));
+	return _mm256_broadcastw_epi16(_mm256_castsi256_si128(t));
+}
+
+static inline __m256i
+broadcast_min_epi16(__m256i v) {
+	__m256i t = _mm256_min_epi16(v, _mm256_permute2x128_si256(v, v, 0x01));
+	t = _mm256_min_epi16(t, _mm256_srli_si256(t, 8));
+	t = _mm256_min_epi16(t, _mm256_srli_si256(t, 4));
+	t = _mm256_min_epi16(t, _mm256_srli_si256(t, 2));
+	return _mm256_broadcastw_epi16(_mm256_castsi256_si128(t));
+}
+
+void
+viterbi_decode_soft_avx2(const viterbi_kernel_state &s, const uint8_t *depunctured) {
+	const short (*branchtab)[32] = (const short (*)[32]) s.branchtab;
+	short *metric_mem = (short *) s.metric;
+	short *path_mem = (short *) s.path;
+	__m256i branchtab0[2], branchtab1[2];
+	__m256i metric[4], path[4];
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		branchtab0[i] = _mm256_loadu_si256((const __m256i *) &branchtab[0][16*i]);
+		branchtab1[i] = _mm256_loadu_si256((const __m256i *) &branchtab[1][16*i]);
+	}
+	for (i = 0; i < 4; i++) {
+		metric[i] = _mm256_loadu_si256((const __m256i *) &metric_mem[16*i]);
+		path[i] = _mm256_loadu_si256((const __m256i *) &path_mem[16*i]);
+	}
+
+	int store_pos = *s.store_pos;
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	while(n_decoded < s.n_data_bits) {
+		const int8_t *symbols = (const int8_t *) &depunctured[in_count];
+		butterfly_soft_avx2(symbols[0], symbols[1], branchtab0, branchtab1, metric, path);
+		butterfly_soft_avx2(symbols[2], symbols[3], branchtab0, branchtab1, metric, path);
+
+		if ((in_count % 16) == 8) {
+			// circular buffer with the last ntraceback paths, paths
+			// never have more than 8 bits, so they can be packed to bytes
+			store_pos = (store_pos + 1) % s.ntraceback;
+			for (i = 0; i < 2; i++) {
+				__m256i packed = _mm256_packus_epi16(path[2*i], path[2*i+1]);
+				_mm256_storeu_si256((__m256i *) &s.ppresult[store_pos][32*i],
+						_mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+			}
+
+			// best state is the first one with the highest metric
+			__m256i best = broadcast_max_epi16(_mm256_max_epi16(
+					_mm256_max_epi16(metric[0], metric[1]),
+					_mm256_max_epi16(metric[2], metric[3])));
+			int beststate = 0;
+			for (i = 0; i < 4; i++) {
+				unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi16(metric[i], best));
+				if (mask) {
+					beststate = 16 * i + __builtin_ctz(mask) / 2;
+					break;
+				}
+			}
+
+			unsigned char c = viterbi_traceback(s.ppresult, store_pos, s.ntraceback, beststate);
+
+			// Zero out the path variable
+			// and prevent metric overflow
+			__m256i min = broadcast_min_epi16(_mm256_min_epi16(
+					_mm256_min_epi16(metric[0], metric[1]),
+					_mm256_min_epi16(metric[2], metric[3])));
+			for (i = 0; i < 4; i++) {
+				metric[i] = _mm256_subs_epi16(metric[i], min);
+				path[i] = _mm256_setzero_si256();
+			}
+
+			if (out_count >= s.ntraceback) {
+				for (i = 0; i < 8; i++) {
+					s.decoded[(out_count - s.ntraceback) * 8 + i] = (c >> (7 - i)) & 0x1;
+					n_decoded++;
+				}
+			}
+			out_count++;
+		}
+		in_count += 4;
+	}
+
+	for (i = 0; i < 4; i++) {
+		_mm256_storeu_si256((__m256i *) &metric_mem[16*i], metric[i]);
+		_mm256_storeu_si256((__m256i *) &path_mem[16*i], path[i]);
+	}
+	*s.store_pos = store_pos;
+}
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
@@ -0,0 +1,253 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Soft decision Viterbi decoder for K=7 rate=1/2 convolutional code
+ * with 16 bit metrics, generic version without SIMD instructions.
+ */
+#include "viterbi_decoder_soft.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+viterbi_decoder_soft::viterbi_decoder_soft() :
+	d_decode_kernel(&viterbi_decoder_soft::decode_generic) {
+}
+
+bool
+viterbi_decoder_soft::set_isa(isa_t isa) {
+	return isa == ISA_GENERIC;
+}
+
+void
+viterbi_decoder_soft::viterbi_butterfly2_soft(const int8_t *symbols,
+		short *mm0, short *mm1, short *pp0, short *pp1) {
+	int i, s;
+
+	short *metric0, *metric1, *tmpm;
+	short *path0, *path1, *tmpp;
+
+	metric0 = mm0;
+	path0 = pp0;
+	metric1 = mm1;
+	path1 = pp1;
+
+	int m0, m1, m2, m3, bm;
+
+	// Operate on 4 symbols (2 bits) at a time, the second trellis
+	// step writes back into mm0 and pp0
+	for (s = 0; s < 2; s++) {
+		for (i = 0; i < 32; i++) {
+			// correlation with the code bits of the 0 branch,
+			// the 1 branch is the complement, i.e. -bm
+			bm = d_branchtab_soft[0][i] * symbols[2*s] +
+				d_branchtab_soft[1][i] * symbols[2*s+1];
+
+			m0 = metric0[i] + bm;
+			m1 = metric0[i+32] - bm;
+			m2 = metric0[i] - bm;
+			m3 = metric0[i+32] + bm;
+
+			if (m0 > m1) {
+				metric1[2*i] = m0;
+				path1[2*i] = path0[i] << 1;
+			} else {
+				metric1[2*i] = m1;
+				path1[2*i] = (path0[i+32] << 1) | 1;
+			}
+			if (m2 > m3) {
+				metric1[2*i+1] = m2;
+				path1[2*i+1] = path0[i] << 1;
+			} else {
+				metric1[2*i+1] = m3;
+				path1[2*i+1] = (path0[i+32] << 1) | 1;
+			}
+		}
+
+		tmpm = metric0; metric0 = metric1; metric1 = tmpm;
+		tmpp = path0; path0 = path1; path1 = tmpp;
+	}
+}
+
+//  Find current best path
+int
+viterbi_decoder_soft::viterbi_get_output_soft(short *mm0, short *pp0,
+		int ntraceback, unsigned char *outbuf) {
+	int i;
+	int bestmetric, minmetric;
+	int beststate = 0;
+	int pos = 0;
+
+	// circular buffer with the last ntraceback paths
+	d_store_pos = (d_store_pos + 1) % ntraceback;
+
+	// paths never have more than 8 bits
+	for (i = 0; i < 64; i++) {
+		d_ppresult[d_store_pos][i] = pp0[i];
+	}
+
+	// Find out the best final state
+	bestmetric = mm0[beststate];
+	minmetric = mm0[beststate];
+
+	for (i = 1; i < 64; i++) {
+		if (mm0[i] > bestmetric) {
+			bestmetric = mm0[i];
+			beststate = i;
+		}
+		if (mm0[i] < minmetric) {
+			minmetric = mm0[i];
+		}
+	}
+
+	// Trace back
+	for (i = 0, pos = d_store_pos; i < (ntraceback - 1); i++) {
+		// Obtain the state from the output bits
+		// by clocking in the output bits in reverse order.
+		// The state has only 6 bits
+		beststate = d_ppresult[pos][beststate] >> 2;
+		pos = (pos - 1 + ntraceback) % ntraceback;
+	}
+
+	// Store output byte
+	*outbuf = d_ppresult[pos][beststate];
+
+	// Zero out the path variable
+	// and prevent metric overflow
+	for (i = 0; i < 64; i++) {
+		pp0[i] = 0;
+		mm0[i] = mm0[i] - minmetric;
+	}
+
+	return bestmetric;
+}
+
+
+uint8_t*
+viterbi_decoder_soft::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) {
+	d_ofdm = ofdm;
+	d_frame = frame;
+	reset();
+	uint8_t *depunctured = depuncture(in, 0);
+
+	// The trellis is run past the end of the frame to flush the trace
+	// back. Pad with erasures so that stale LLRs from an older frame do
+	// not bias the last bits.
+	int n_depunctured = 2 * d_frame->n_data_bits;
+	if(depunctured != d_depunctured) {
+		std::memcpy(d_depunctured, depunctured, n_depunctured);
+		depunctured = d_depunctured;
+	}
+	std::memset(d_depunctured + n_depunctured, 0, (TRACEBACK_MAX + 1) * 16);
+
+	if(use_windows()) {
+		return decode_windows(depunctured);
+	}
+	(this->*d_decode_kernel)(depunctured);
+	return d_decoded;
+}
+
+base*
+viterbi_decoder_soft::clone() const {
+	viterbi_decoder_soft *decoder = new viterbi_decoder_soft();
+	decoder->set_isa(d_isa);
+	return decoder;
+}
+
+void
+viterbi_decoder_soft::run_trellis(uint8_t *depunctured) {
+	(this->*d_decode_kernel)(depunctured);
+}
+
+void
+viterbi_decoder_soft::decode_generic(uint8_t *depunctured) {
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	while(n_decoded < d_frame->n_data_bits) {
+		if ((in_count % 4) == 0) { //0 or 3
+			viterbi_butterfly2_soft((const int8_t *) &depunctured[in_count & 0xfffffffc], d_metric0_soft, d_metric1_soft, d_path0_soft, d_path1_soft);
+
+			if ((in_count > 0) && (in_count % 16) == 8) { // 8 or 11
+				unsigned char c;
+
+				viterbi_get_output_soft(d_metric0_soft, d_path0_soft, d_ntraceback, &c);
+
+				if (out_count >= d_ntraceback) {
+					for (int i= 0; i < 8; i++) {
+						d_decoded[(out_count - d_ntraceback) * 8 + i] = (c >> (7 - i)) & 0x1;
+						n_decoded++;
+					}
+				}
+				out_count++;
+			}
+		}
+		in_count++;
+	}
+}
+
+void
+viterbi_decoder_soft::reset() {
+	viterbi_chunks_init_soft();
+	switch(d_ofdm->punct) {
+	case P_1_2:
+		d_ntraceback = 5;
+		d_depuncture_pattern = PUNCTURE_1_2;
+		d_k = 1;
+		break;
+	case P_3_4:
+		d_ntraceback = 10;
+		d_depuncture_pattern = PUNCTURE_3_4;
+		d_k = 3;
+		break;
+	case P_2_3:
+		d_ntraceback = 9;
+		d_depuncture_pattern = PUNCTURE_2_3;
+		d_k = 2;
+		break;
+	}
+}
+
+// Initialize starting metrics
+void
+viterbi_decoder_soft::viterbi_chunks_init_soft() {
+	int i, j;
+
+	std::memset(d_metric0_soft, 0, sizeof(d_metric0_soft));
+	std::memset(d_path0_soft, 0, sizeof(d_path0_soft));
+
+	int polys[2] = { 0x6d, 0x4f };
+	for(i=0; i < 32; i++) {
+		d_branchtab_soft[0][i] = PARTAB[(2*i) & polys[0]] ? 1 : -1;
+		d_branchtab_soft[1][i] = PARTAB[(2*i) & polys[1]] ? 1 : -1;
+	}
+
+	for (i = 0; i < 64; i++) {
+		for (j = 0; j < TRACEBACK_MAX; j++) {
+			d_ppresult[j][i] = 0;
+		}
+	}
+}
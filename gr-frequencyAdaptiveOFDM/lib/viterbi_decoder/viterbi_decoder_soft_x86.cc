@@ -0,0 +1,306 @@
+/*
+ * Copyright 1995 Phil Karn, KA9Q
+ * Copyright 2008 Free Software Foundation, Inc.
+ * 2014 Added SSE2 implementation Bogdan Diaconescu
+ *
+ * This file is part of GNU Radio
+ *
+ * GNU Radio is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+
+ * GNU Radio is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNU Radio; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Soft decision Viterbi decoder for K=7 rate=1/2 convolutional code
+ * with 16 bit metrics, 8 states per SSE2 register.
+ */
+#include "viterbi_decoder_soft.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+viterbi_decoder_soft::viterbi_decoder_soft() :
+	d_decode_kernel(&viterbi_decoder_soft::decode_sse2) {
+	d_isa = ISA_SSE2;
+	set_isa(ISA_AVX2);
+}
+
+bool
+viterbi_decoder_soft::set_isa(isa_t isa) {
+	if(!cpu_supports(isa)) {
+		return false;
+	}
+
+	switch(isa) {
+	case ISA_SSE2:
+		d_decode_kernel = &viterbi_decoder_soft::decode_sse2;
+		break;
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	case ISA_AVX2:
+		d_decode_kernel = &viterbi_decoder_soft::decode_avx2;
+		break;
+#endif
+	default:
+		return false;
+	}
+	d_isa = isa;
+	return true;
+}
+
+void
+viterbi_decoder_soft::viterbi_butterfly2_soft(const int8_t *symbols,
+		short *mm0, short *mm1, short *pp0, short *pp1) {
+	int i, s;
+
+	__m128i *metric0, *metric1, *tmpm;
+	__m128i *path0, *path1, *tmpp;
+	const __m128i *branchtab0 = (const __m128i *) d_branchtab_soft[0];
+	const __m128i *branchtab1 = (const __m128i *) d_branchtab_soft[1];
+
+	metric0 = (__m128i *) mm0;
+	path0 = (__m128i *) pp0;
+	metric1 = (__m128i *) mm1;
+	path1 = (__m128i *) pp1;
+
+	__m128i m0, m1, m2, m3, decision0, decision1, survivor0, survivor1;
+	__m128i bm, sym0v, sym1v;
+	__m128i shift0, shift1, tmp0, tmp1;
+	const __m128i one = _mm_set1_epi16(1);
+
+	// Operate on 4 symbols (2 bits) at a time, the second trellis
+	// step writes back into mm0 and pp0
+	for (s = 0; s < 2; s++) {
+		sym0v = _mm_set1_epi16(symbols[2*s]);
+		sym1v = _mm_set1_epi16(symbols[2*s+1]);
+
+		for (i = 0; i < 4; i++) {
+			// correlation with the code bits of the 0 branch,
+			// the 1 branch is the complement, i.e. -bm
+			bm = _mm_add_epi16(_mm_mullo_epi16(branchtab0[i], sym0v),
+					_mm_mullo_epi16(branchtab1[i], sym1v));
+
+			m0 = _mm_adds_epi16(metric0[i], bm);
+			m1 = _mm_subs_epi16(metric0[i+4], bm);
+			m2 = _mm_subs_epi16(metric0[i], bm);
+			m3 = _mm_adds_epi16(metric0[i+4], bm);
+
+			decision0 = _mm_cmpgt_epi16(m0, m1);
+			decision1 = _mm_cmpgt_epi16(m2, m3);
+			survivor0 = _mm_max_epi16(m0, m1);
+			survivor1 = _mm_max_epi16(m2, m3);
+
+			shift0 = _mm_slli_epi16(path0[i], 1);
+			shift1 = _mm_or_si128(_mm_slli_epi16(path0[i+4], 1), one);
+
+			tmp0 = _mm_or_si128(_mm_and_si128(decision0, shift0), _mm_andnot_si128(decision0, shift1));
+			tmp1 = _mm_or_si128(_mm_and_si128(decision1, shift0), _mm_andnot_si128(decision1, shift1));
+
+			metric1[2*i]   = _mm_unpacklo_epi16(survivor0, survivor1);
+			metric1[2*i+1] = _mm_unpackhi_epi16(survivor0, survivor1);
+			path1[2*i]     = _mm_unpacklo_epi16(tmp0, tmp1);
+			path1[2*i+1]   = _mm_unpackhi_epi16(tmp0, tmp1);
+		}
+
+		tmpm = metric0; metric0 = metric1; metric1 = tmpm;
+		tmpp = path0; path0 = path1; path1 = tmpp;
+	}
+}
+
+//  Find current best path
+int
+viterbi_decoder_soft::viterbi_get_output_soft(short *mm0, short *pp0,
+		int ntraceback, unsigned char *outbuf) {
+	int i;
+	int bestmetric, minmetric;
+	int beststate = 0;
+	int pos = 0;
+	__m128i *metric = (__m128i *) mm0;
+	__m128i *path = (__m128i *) pp0;
+
+	// circular buffer with the last ntraceback paths
+	d_store_pos = (d_store_pos + 1) % ntraceback;
+
+	// paths never have more than 8 bits, so they can be packed to bytes
+	for (i = 0; i < 4; i++) {
+		_mm_store_si128((__m128i *) &d_ppresult[d_store_pos][i*16],
+				_mm_packus_epi16(path[2*i], path[2*i+1]));
+	}
+
+	// Find out the best final state
+	bestmetric = mm0[beststate];
+	minmetric = mm0[beststate];
+
+	for (i = 1; i < 64; i++) {
+		if (mm0[i] > bestmetric) {
+			bestmetric = mm0[i];
+			beststate = i;
+		}
+		if (mm0[i] < minmetric) {
+			minmetric = mm0[i];
+		}
+	}
+
+	// Trace back
+	for (i = 0, pos = d_store_pos; i < (ntraceback - 1); i++) {
+		// Obtain the state from the output bits
+		// by clocking in the output bits in reverse order.
+		// The state has only 6 bits
+		beststate = d_ppresult[pos][beststate] >> 2;
+		pos = (pos - 1 + ntraceback) % ntraceback;
+	}
+
+	// Store output byte
+	*outbuf = d_ppresult[pos][beststate];
+
+	// Zero out the path variable
+	// and prevent metric overflow
+	for (i = 0; i < 8; i++) {
+		path[i] = _mm_setzero_si128();
+		metric[i] = _mm_subs_epi16(metric[i], _mm_set1_epi16(minmetric));
+	}
+
+	return bestmetric;
+}
+
+
+uint8_t*
+viterbi_decoder_soft::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) {
+	d_ofdm = ofdm;
+	d_frame = frame;
+	reset();
+	uint8_t *depunctured = depuncture(in, 0);
+
+	// The trellis is run past the end of the frame to flush the trace
+	// back. Pad with erasures so that stale LLRs from an older frame do
+	// not bias the last bits.
+	int n_depunctured = 2 * d_frame->n_data_bits;
+	if(depunctured != d_depunctured) {
+		std::memcpy(d_depunctured, depunctured, n_depunctured);
+		depunctured = d_depunctured;
+	}
+	std::memset(d_depunctured + n_depunctured, 0, (TRACEBACK_MAX + 1) * 16);
+
+	if(use_windows()) {
+		return decode_windows(depunctured);
+	}
+	(this->*d_decode_kernel)(depunctured);
+	return d_decoded;
+}
+
+base*
+viterbi_decoder_soft::clone() const {
+	viterbi_decoder_soft *decoder = new viterbi_decoder_soft();
+	decoder->set_isa(d_isa);
+	return decoder;
+}
+
+void
+viterbi_decoder_soft::run_trellis(uint8_t *depunctured) {
+	(this->*d_decode_kernel)(depunctured);
+}
+
+void
+viterbi_decoder_soft::decode_sse2(uint8_t *depunctured) {
+	int in_count = 0;
+	int out_count = 0;
+	int n_decoded = 0;
+	while(n_decoded < d_frame->n_data_bits) {
+		if ((in_count % 4) == 0) { //0 or 3
+			viterbi_butterfly2_soft((const int8_t *) &depunctured[in_count & 0xfffffffc], d_metric0_soft, d_metric1_soft, d_path0_soft, d_path1_soft);
+
+			if ((in_count > 0) && (in_count % 16) == 8) { // 8 or 11
+				unsigned char c;
+
+				viterbi_get_output_soft(d_metric0_soft, d_path0_soft, d_ntraceback, &c);
+
+				if (out_count >= d_ntraceback) {
+					for (int i= 0; i < 8; i++) {
+						d_decoded[(out_count - d_ntraceback) * 8 + i] = (c >> (7 - i)) & 0x1;
+						n_decoded++;
+					}
+				}
+				out_count++;
+			}
+		}
+		in_count++;
+	}
+}
+
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+viterbi_kernel_state
+viterbi_decoder_soft::kernel_state() {
+	viterbi_kernel_state s;
+	s.branchtab = d_branchtab_soft;
+	s.metric = d_metric0_soft;
+	s.path = d_path0_soft;
+	s.ppresult = d_ppresult;
+	s.store_pos = &d_store_pos;
+	s.ntraceback = d_ntraceback;
+	s.n_data_bits = d_frame->n_data_bits;
+	s.decoded = d_decoded;
+	return s;
+}
+
+void
+viterbi_decoder_soft::decode_avx2(uint8_t *depunctured) {
+	viterbi_decode_soft_avx2(kernel_state(), depunctured);
+}
+#endif
+
+void
+viterbi_decoder_soft::reset() {
+	viterbi_chunks_init_soft();
+	switch(d_ofdm->punct) {
+	case P_1_2:
+		d_ntraceback = 5;
+		d_depuncture_pattern = PUNCTURE_1_2;
+		d_k = 1;
+		break;
+	case P_3_4:
+		d_ntraceback = 10;
+		d_depuncture_pattern = PUNCTURE_3_4;
+		d_k = 3;
+		break;
+	case P_2_3:
+		d_ntraceback = 9;
+		d_depuncture_pattern = PUNCTURE_2_3;
+		d_k = 2;
+		break;
+	}
+}
+
+// Initialize starting metrics
+void
+viterbi_decoder_soft::viterbi_chunks_init_soft() {
+	int i, j;
+
+	std::memset(d_metric0_soft, 0, sizeof(d_metric0_soft));
+	std::memset(d_path0_soft, 0, sizeof(d_path0_soft));
+
+	int polys[2] = { 0x6d, 0x4f };
+	for(i=0; i < 32; i++) {
+		d_branchtab_soft[0][i] = PARTAB[(2*i) & polys[0]] ? 1 : -1;
+		d_branchtab_soft[1][i] = PARTAB[(2*i) & polys[1]] ? 1 : -1;
+	}
+
+	for (i = 0; i < 64; i++) {
+		for (j = 0; j < TRACEBACK_MAX; j++) {
+			d_ppresult[j][i] = 0;
+		}
+	}
+}
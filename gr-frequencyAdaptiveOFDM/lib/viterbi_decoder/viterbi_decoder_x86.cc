@@ -82,6 +82,41 @@
 
 using namespace gr::frequencyAdaptiveOFDM;
 
+viterbi_decoder::viterbi_decoder() :
+	d_decode_kernel(&viterbi_decoder::decode_sse2) {
+	d_isa = ISA_SSE2;
+	if(!set_isa(ISA_AVX512BW)) {
+		set_isa(ISA_AVX2);
+	}
+}
+
+bool
+viterbi_decoder::set_isa(isa_t isa) {
+	if(!cpu_supports(isa)) {
+		return false;
+	}
+
+	switch(isa) {
+	case ISA_SSE2:
+		d_decode_kernel = &viterbi_decoder::decode_sse2;
+		break;
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	case ISA_AVX2:
+		d_decode_kernel = &viterbi_decoder::decode_avx2;
+		break;
+#endif
+#ifdef FREQUENCYADAPTIVEOFDM_AVX512BW
+	case ISA_AVX512BW:
+		d_decode_kernel = &viterbi_decoder::decode_avx512bw;
+		break;
+#endif
+	default:
+		return false;
+	}
+	d_isa = isa;
+	return true;
+}
+
 void
 viterbi_decoder::viterbi_butterfly2_sse2(unsigned char *symbols,
 		__m128i *mm0, __m128i *mm1, __m128i *pp0, __m128i *pp1) {
@@ -249,7 +284,27 @@ viterbi_decoder::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) {
 	d_frame = frame;
 	reset();
 	uint8_t *depunctured = depuncture(in);
+	if(use_windows()) {
+		return decode_windows(depunctured);
+	}
+	(this->*d_decode_kernel)(depunctured);
+	return d_decoded;
+}
 
+base*
+viterbi_decoder::clone() const {
+	viterbi_decoder *decoder = new viterbi_decoder();
+	decoder->set_isa(d_isa);
+	return decoder;
+}
+
+void
+viterbi_decoder::run_trellis(uint8_t *depunctured) {
+	(this->*d_decode_kernel)(depunctured);
+}
+
+void
+viterbi_decoder::decode_sse2(uint8_t *depunctured) {
 	int in_count = 0;
 	int out_count = 0;
 	int n_decoded = 0;
@@ -273,9 +328,38 @@ viterbi_decoder::decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in) {
 		}
 		in_count++;
 	}
-	return d_decoded;
 }
 
+#if defined(FREQUENCYADAPTIVEOFDM_AVX2) || defined(FREQUENCYADAPTIVEOFDM_AVX512BW)
+viterbi_kernel_state
+viterbi_decoder::kernel_state() {
+	viterbi_kernel_state s;
+	s.branchtab = d_branchtab27_sse2;
+	s.metric = d_metric0;
+	s.path = d_path0;
+	s.ppresult = d_ppresult;
+	s.store_pos = &d_store_pos;
+	s.ntraceback = d_ntraceback;
+	s.n_data_bits = d_frame->n_data_bits;
+	s.decoded = d_decoded;
+	return s;
+}
+#endif
+
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+void
+viterbi_decoder::decode_avx2(uint8_t *depunctured) {
+	viterbi_decode_avx2(kernel_state(), depunctured);
+}
+#endif
+
+#ifdef FREQUENCYADAPTIVEOFDM_AVX512BW
+void
+viterbi_decoder::decode_avx512bw(uint8_t *depunctured) {
+	viterbi_decode_avx512bw(kernel_state(), depunctured);
+}
+#endif
+
 void
 viterbi_decoder::reset() {
 	viterbi_chunks_init_sse2();
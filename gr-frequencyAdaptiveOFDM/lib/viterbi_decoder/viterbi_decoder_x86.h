@@ -19,6 +19,7 @@
 
 #include <xmmintrin.h>
 #include "base.h"
+#include "kernels.h"
 
 namespace gr {
 namespace frequencyAdaptiveOFDM {
@@ -27,12 +28,18 @@ namespace frequencyAdaptiveOFDM {
  * GNU Radio. It is an SSE2 version of the Viterbi Decoder
  * created by Phil Karn. The SSE2 version was made by Bogdan
  * Diaconescu. For more info see: gr-dvbt/lib/d_viterbi.h
+ *
+ * The AVX2 and AVX-512BW kernels keep all 64 states in two or one
+ * registers. They are built if the compiler supports them and picked at
+ * runtime from the CPU flags, see kernels.h.
  */
 class viterbi_decoder : public base
 {
 public:
 
+	viterbi_decoder();
 	virtual uint8_t* decode(ofdm_param *ofdm, frame_param *frame, uint8_t *in);
+	virtual bool set_isa(isa_t isa);
 
 private:
 
@@ -47,6 +54,21 @@ private:
 	__m128i d_path1[4] __attribute__ ((aligned(16)));
 
 	virtual void reset();
+	virtual base* clone() const;
+	virtual void run_trellis(uint8_t *depunctured);
+
+	// trellis loop of the selected instruction set
+	void (viterbi_decoder::*d_decode_kernel)(uint8_t *depunctured);
+	void decode_sse2(uint8_t *depunctured);
+#if defined(FREQUENCYADAPTIVEOFDM_AVX2) || defined(FREQUENCYADAPTIVEOFDM_AVX512BW)
+	viterbi_kernel_state kernel_state();
+#endif
+#ifdef FREQUENCYADAPTIVEOFDM_AVX2
+	void decode_avx2(uint8_t *depunctured);
+#endif
+#ifdef FREQUENCYADAPTIVEOFDM_AVX512BW
+	void decode_avx512bw(uint8_t *depunctured);
+#endif
 
 	void viterbi_chunks_init_sse2();
 	void viterbi_butterfly2_sse2(unsigned char *symbols,
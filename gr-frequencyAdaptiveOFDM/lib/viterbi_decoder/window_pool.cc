@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "window_pool.h"
+#include <boost/bind.hpp>
+
+using namespace gr::frequencyAdaptiveOFDM;
+
+window_pool::window_pool(int n_threads) :
+	d_pending(0),
+	d_stop(false) {
+	for(int i = 0; i < n_threads; i++) {
+		d_threads.create_thread(boost::bind(&window_pool::worker, this));
+	}
+}
+
+window_pool::~window_pool() {
+	{
+		gr::thread::scoped_lock lock(d_mutex);
+		d_stop = true;
+	}
+	d_task_cond.notify_all();
+	d_threads.join_all();
+}
+
+void
+window_pool::run(const std::vector<boost::function<void ()> > &tasks) {
+	gr::thread::scoped_lock lock(d_mutex);
+	d_tasks.insert(d_tasks.end(), tasks.begin(), tasks.end());
+	d_pending += tasks.size();
+	d_task_cond.notify_all();
+
+	while(run_one(lock)) {
+	}
+	while(d_pending) {
+		d_done_cond.wait(lock);
+	}
+}
+
+bool
+window_pool::run_one(gr::thread::scoped_lock &lock) {
+	if(d_tasks.empty()) {
+		return false;
+	}
+
+	boost::function<void ()> task = d_tasks.front();
+	d_tasks.pop_front();
+
+	lock.unlock();
+	task();
+	lock.lock();
+
+	d_pending--;
+	if(!d_pending) {
+		d_done_cond.notify_all();
+	}
+	return true;
+}
+
+void
+window_pool::worker() {
+	gr::thread::scoped_lock lock(d_mutex);
+	while(true) {
+		while(!d_stop && d_tasks.empty()) {
+			d_task_cond.wait(lock);
+		}
+		if(d_stop) {
+			return;
+		}
+		run_one(lock);
+	}
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016 Bastian Bloessl <bloessl@ccs-labs.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_WINDOW_POOL_H
+#define INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_WINDOW_POOL_H
+
+#include <gnuradio/thread/thread.h>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <vector>
+
+namespace gr {
+namespace frequencyAdaptiveOFDM {
+
+/* Small thread pool for the windows of the block parallel Viterbi
+ * decoder. run() hands the tasks to the threads, works on them itself
+ * and returns once all of them are done.
+ */
+class window_pool
+{
+public:
+	window_pool(int n_threads);
+	~window_pool();
+
+	void run(const std::vector<boost::function<void ()> > &tasks);
+
+private:
+	boost::thread_group d_threads;
+	gr::thread::mutex d_mutex;
+	gr::thread::condition_variable d_task_cond;
+	gr::thread::condition_variable d_done_cond;
+
+	std::deque<boost::function<void ()> > d_tasks;
+	int d_pending;
+	bool d_stop;
+
+	void worker();
+	// take one task if there is any, d_mutex has to be locked
+	bool run_one(gr::thread::scoped_lock &lock);
+};
+
+} // namespace frequencyAdaptiveOFDM
+} // namespace gr
+
+#endif /* INCLUDED_FREQUENCYADAPTIVEOFDM_VITERBI_DECODER_WINDOW_POOL_H */
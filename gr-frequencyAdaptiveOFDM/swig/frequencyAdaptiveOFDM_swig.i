@@ -11,11 +11,13 @@
 
 %{
 #include "frequencyAdaptiveOFDM/mapper.h"
+#include "frequencyAdaptiveOFDM/frame_synthesizer.h"
 #include "frequencyAdaptiveOFDM/signal_field.h"
 #include "frequencyAdaptiveOFDM/chunks_to_symbols.h"
 #include "frequencyAdaptiveOFDM/constellations.h"
 #include "frequencyAdaptiveOFDM/frame_equalizer.h"
 #include "frequencyAdaptiveOFDM/decode_mac.h"
+#include "frequencyAdaptiveOFDM/equalize_and_decode.h"
 #include "frequencyAdaptiveOFDM/mac.h"
 #include "frequencyAdaptiveOFDM/parse_mac.h"
 #include "frequencyAdaptiveOFDM/rb_const_demux.h"
@@ -31,15 +33,19 @@
 
 
 %include "frequencyAdaptiveOFDM/mapper.h"
+%include "frequencyAdaptiveOFDM/frame_synthesizer.h"
 %include "frequencyAdaptiveOFDM/signal_field.h"
 %include "frequencyAdaptiveOFDM/chunks_to_symbols.h"
 %include "frequencyAdaptiveOFDM/constellations.h"
 %include "frequencyAdaptiveOFDM/decode_mac.h"
+%include "frequencyAdaptiveOFDM/equalize_and_decode.h"
 
 GR_SWIG_BLOCK_MAGIC2(frequencyAdaptiveOFDM, mapper);
+GR_SWIG_BLOCK_MAGIC2(frequencyAdaptiveOFDM, frame_synthesizer);
 GR_SWIG_BLOCK_MAGIC2(frequencyAdaptiveOFDM, chunks_to_symbols);
 GR_SWIG_BLOCK_MAGIC2(frequencyAdaptiveOFDM, frame_equalizer);
 GR_SWIG_BLOCK_MAGIC2(frequencyAdaptiveOFDM, decode_mac);
+GR_SWIG_BLOCK_MAGIC2(frequencyAdaptiveOFDM, equalize_and_decode);
 
 %template(signal_field_sptr) boost::shared_ptr<gr::frequencyAdaptiveOFDM::signal_field>;
 %pythoncode %{